@@ -0,0 +1,151 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Compares synchronous and io_uring based asynchronous writes of several
+ * File:// streams in parallel, the way a recorder stores its channels.
+ *
+ * usage: IOChannelAsyncPerformance [directory]
+ */
+
+
+#include <Any.h>
+#include <IOChannel.h>
+#include <RTTimer.h>
+
+
+#define NUM_STREAMS     ( 4 )
+#define RECORD_SIZE     ( 4096 )
+#define NUM_RECORDS     ( 8192 )
+
+
+static void TestWrite( const char *directory, const char *title, bool useAsync );
+
+
+int main( int argc, char *argv[] )
+{
+    const char *directory = argc > 1 ? argv[ 1 ] : ".";
+
+    TestWrite( directory, "Synchronous write()", false );
+    TestWrite( directory, "Asynchronous io_uring", true );
+
+    return EXIT_SUCCESS;
+}
+
+
+static void TestWrite( const char *directory, const char *title, bool useAsync )
+{
+    IOChannel          *streams[NUM_STREAMS];
+    RTTimer            *timer    = NULL;
+    char               *record   = NULL;
+    char               url[256];
+    char               timef[64];
+    double             megaBytes = 0.0;
+    unsigned long long elapsed   = 0;
+    bool               isAsync   = false;
+    int                i         = 0;
+    int                j         = 0;
+
+    record = (char *)ANY_BALLOC( RECORD_SIZE );
+    ANY_REQUIRE( record );
+
+    for( i = 0; i < NUM_STREAMS; i++ )
+    {
+        streams[ i ] = IOChannel_new();
+        ANY_REQUIRE( streams[ i ] );
+        IOChannel_init( streams[ i ] );
+
+        Any_snprintf( url, sizeof( url ), "File://%s/IOChannelAsyncPerformance-%d.tmp", directory, i );
+
+        if( !IOChannel_open( streams[ i ], url,
+                             IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                             IOCHANNEL_PERMISSIONS_ALL ) )
+        {
+            ANY_LOG( 0, "Unable to open %s", ANY_LOG_ERROR, url );
+            exit( EXIT_FAILURE );
+        }
+
+        if( useAsync )
+        {
+            isAsync = IOChannel_setProperty( streams[ i ], "AsyncIO", (void *)true );
+        }
+    }
+
+    if( useAsync && !isAsync )
+    {
+        ANY_LOG( 0, "io_uring not available, the following figures are synchronous", ANY_LOG_WARNING );
+    }
+
+    timer = RTTimer_new();
+    ANY_REQUIRE( timer );
+    RTTimer_init( timer );
+
+    RTTimer_start( timer );
+
+    for( j = 0; j < NUM_RECORDS; j++ )
+    {
+        for( i = 0; i < NUM_STREAMS; i++ )
+        {
+            record[ 0 ] = (char)j;
+
+            if( IOChannel_write( streams[ i ], record, RECORD_SIZE ) != RECORD_SIZE )
+            {
+                ANY_LOG( 0, "Write error: %s", ANY_LOG_ERROR,
+                         IOChannel_getErrorDescription( streams[ i ] ) );
+                exit( EXIT_FAILURE );
+            }
+        }
+    }
+
+    /* closing waits for all the data to be written */
+    for( i = 0; i < NUM_STREAMS; i++ )
+    {
+        IOChannel_close( streams[ i ] );
+        IOChannel_clear( streams[ i ] );
+        IOChannel_delete( streams[ i ] );
+
+        Any_snprintf( url, sizeof( url ), "%s/IOChannelAsyncPerformance-%d.tmp", directory, i );
+        unlink( url );
+    }
+
+    RTTimer_stop( timer );
+
+    elapsed = RTTimer_getElapsed( timer );
+    megaBytes = (double)NUM_STREAMS * NUM_RECORDS * RECORD_SIZE / ( 1024.0 * 1024.0 );
+
+    RTTimer_format( timef, (double)elapsed );
+
+    ANY_LOG( 0, "Performace Statistics: %s", ANY_LOG_INFO, title );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+    ANY_LOG( 0, "%d streams, %d records of %d bytes each", ANY_LOG_INFO,
+             NUM_STREAMS, NUM_RECORDS, RECORD_SIZE );
+    ANY_LOG( 0, "Elapsed time is %llu nanosecs (%s)", ANY_LOG_INFO, elapsed, timef );
+    ANY_LOG( 0, "Throughput is %.1f MB/s", ANY_LOG_INFO,
+             elapsed > 0 ? megaBytes * 1000000000.0 / elapsed : 0.0 );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    RTTimer_clear( timer );
+    RTTimer_delete( timer );
+
+    ANY_FREE( record );
+}
+
+
+/* EOF */
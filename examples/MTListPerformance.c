@@ -0,0 +1,203 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Looks up the elements of a small registry from a growing number of
+ * reader threads, once with the locked MTList and once with a read-mostly
+ * one, while another thread now and then replaces an element.
+ *
+ * usage: MTListPerformance [maxReaders]
+ */
+
+
+#include <Any.h>
+#include <AnyTime.h>
+#include <MTList.h>
+#include <RTTimer.h>
+#include <Threads.h>
+
+
+#define NUM_ELEMENTS    ( 32 )
+#define NUM_LOOKUPS     ( 200000 )
+#define MAX_READERS     ( 64 )
+
+
+typedef struct Benchmark
+{
+    MTList    *list;
+    long      keys[NUM_ELEMENTS];
+    AnyAtomic stop;
+}
+Benchmark;
+
+
+static void TestList( const char *title, bool readMostly, int maxReaders );
+
+static void *ReaderFn( void *arg );
+
+static void *WriterFn( void *arg );
+
+static int CompareFn( void *element, void *searched );
+
+
+int main( int argc, char *argv[] )
+{
+    int maxReaders = argc > 1 ? atoi( argv[ 1 ] ) : 8;
+
+    if( maxReaders < 1 || maxReaders > MAX_READERS )
+    {
+        ANY_LOG( 0, "maxReaders must be within 1 and %d", ANY_LOG_ERROR, MAX_READERS );
+        return EXIT_FAILURE;
+    }
+
+    TestList( "MTList", false, maxReaders );
+    TestList( "MTList, read-mostly", true, maxReaders );
+
+    return EXIT_SUCCESS;
+}
+
+
+static void TestList( const char *title, bool readMostly, int maxReaders )
+{
+    Benchmark          bench;
+    Threads            *readers[MAX_READERS];
+    Threads            *writer = NULL;
+    RTTimer            *timer = NULL;
+    unsigned long long elapsed = 0;
+    int                numReaders;
+    int                i;
+
+    bench.list = MTList_new();
+    ANY_REQUIRE( bench.list );
+
+    if( readMostly )
+    {
+        MTList_initReadMostly( bench.list );
+    }
+    else
+    {
+        MTList_init( bench.list );
+    }
+
+    MTList_setDeleteMode( bench.list, MTLIST_DELETEMODE_MANUAL );
+
+    for( i = 0; i < NUM_ELEMENTS; i++ )
+    {
+        bench.keys[ i ] = i;
+        MTList_add( bench.list, &bench.keys[ i ] );
+    }
+
+    timer = RTTimer_new();
+    ANY_REQUIRE( timer );
+    RTTimer_init( timer );
+
+    ANY_LOG( 0, "Performace Statistics: %s", ANY_LOG_INFO, title );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    for( numReaders = 1; numReaders <= maxReaders; numReaders *= 2 )
+    {
+        bench.stop = 0;
+
+        writer = Threads_new();
+        ANY_REQUIRE( writer );
+        Threads_init( writer, true );
+        Threads_start( writer, WriterFn, &bench );
+
+        RTTimer_reset( timer );
+        RTTimer_start( timer );
+
+        for( i = 0; i < numReaders; i++ )
+        {
+            readers[ i ] = Threads_new();
+            ANY_REQUIRE( readers[ i ] );
+            Threads_init( readers[ i ], true );
+            Threads_start( readers[ i ], ReaderFn, &bench );
+        }
+
+        for( i = 0; i < numReaders; i++ )
+        {
+            Threads_join( readers[ i ], NULL );
+            Threads_clear( readers[ i ] );
+            Threads_delete( readers[ i ] );
+        }
+
+        RTTimer_stop( timer );
+        elapsed = RTTimer_getElapsed( timer );
+
+        Atomic_set( &bench.stop, 1 );
+        Threads_join( writer, NULL );
+        Threads_clear( writer );
+        Threads_delete( writer );
+
+        ANY_LOG( 0, "%2d readers: %.2f million lookups/s", ANY_LOG_INFO, numReaders,
+                 elapsed > 0 ? (double)numReaders * NUM_LOOKUPS * 1000.0 / elapsed : 0.0 );
+    }
+
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    RTTimer_clear( timer );
+    RTTimer_delete( timer );
+
+    MTList_clear( bench.list );
+    MTList_delete( bench.list );
+}
+
+
+static void *ReaderFn( void *arg )
+{
+    Benchmark *bench = (Benchmark *)arg;
+    long      key;
+    long      i;
+
+    for( i = 0; i < NUM_LOOKUPS; i++ )
+    {
+        key = i % NUM_ELEMENTS;
+        ANY_REQUIRE( MTList_search( bench->list, CompareFn, &key ) );
+    }
+
+    return NULL;
+}
+
+
+static void *WriterFn( void *arg )
+{
+    Benchmark *bench = (Benchmark *)arg;
+    int       i = 0;
+
+    /* a registry changes rarely */
+    while( !Atomic_get( &bench->stop ))
+    {
+        MTList_set( bench->list, &bench->keys[ i ], &bench->keys[ i ] );
+        i = ( i + 1 ) % NUM_ELEMENTS;
+
+        Any_sleepMilliSeconds( 1 );
+    }
+
+    return NULL;
+}
+
+
+static int CompareFn( void *element, void *searched )
+{
+    return *(long *)element == *(long *)searched ? 0 : 1;
+}
+
+
+/* EOF */
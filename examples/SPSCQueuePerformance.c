@@ -0,0 +1,387 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Passes pointers from one producer thread to one consumer thread through
+ * the locked MTQueue, the bounded MTQueue and the SPSCQueue, the latter
+ * one element at a time and in batches. Both threads are pinned to their
+ * own CPU when there are at least two, otherwise the figures are the ones
+ * of a single shared CPU. At last one element bounces between two threads
+ * through a pair of SPSCQueues, each side waiting for it in
+ * SPSCQueue_popWait(), to time the wake-ups.
+ *
+ * usage: SPSCQueuePerformance [numElements]
+ */
+
+
+#include <Any.h>
+#include <MTQueue.h>
+#include <RTTimer.h>
+#include <SPSCQueue.h>
+#include <Threads.h>
+
+
+#define QUEUE_CAPACITY  ( 4096 )
+#define BATCH_SIZE      ( 64 )
+
+
+typedef enum QueueKind
+{
+    QUEUE_MTQUEUE,
+    QUEUE_MTQUEUE_BOUNDED,
+    QUEUE_SPSC,
+    QUEUE_SPSC_BATCH
+}
+QueueKind;
+
+
+typedef struct Benchmark
+{
+    QueueKind kind;
+    MTQueue   *mtQueue;
+    SPSCQueue *spscQueue;
+    long      numElements;
+}
+Benchmark;
+
+
+static void TestQueue( const char *title, QueueKind kind, long numElements );
+
+static void TestRoundTrips( long numRoundTrips );
+
+static void *ProducerFn( void *arg );
+
+static void *EchoFn( void *arg );
+
+static void Consume( Benchmark *bench );
+
+static void PinCurrentThread( int nth );
+
+
+int main( int argc, char *argv[] )
+{
+    long numElements = argc > 1 ? atol( argv[ 1 ] ) : 10000000;
+    ThreadsCpuSet cpus;
+
+    Threads_getAvailableCpus( &cpus );
+
+    if( ThreadsCpuSet_count( &cpus ) < 2 )
+    {
+        ANY_LOG( 0, "Only one CPU available, producer and consumer share it", ANY_LOG_WARNING );
+    }
+    else
+    {
+        ANY_LOG( 0, "Consumer on CPU %d, producer on CPU %d", ANY_LOG_INFO,
+                 ThreadsCpuSet_getNth( &cpus, 0 ), ThreadsCpuSet_getNth( &cpus, 1 ) );
+    }
+
+    TestQueue( "MTQueue", QUEUE_MTQUEUE, numElements );
+    TestQueue( "MTQueue, bounded", QUEUE_MTQUEUE_BOUNDED, numElements );
+    TestQueue( "SPSCQueue", QUEUE_SPSC, numElements );
+    TestQueue( "SPSCQueue, batches of 64", QUEUE_SPSC_BATCH, numElements );
+    TestRoundTrips( numElements / 100 > 0 ? numElements / 100 : 1 );
+
+    return EXIT_SUCCESS;
+}
+
+
+static void TestQueue( const char *title, QueueKind kind, long numElements )
+{
+    Benchmark          bench;
+    Threads            *producer = NULL;
+    RTTimer            *timer = NULL;
+    unsigned long long elapsed = 0;
+    char               timef[64];
+
+    bench.kind        = kind;
+    bench.mtQueue     = NULL;
+    bench.spscQueue   = NULL;
+    bench.numElements = numElements;
+
+    if( kind == QUEUE_SPSC || kind == QUEUE_SPSC_BATCH )
+    {
+        bench.spscQueue = SPSCQueue_new();
+        ANY_REQUIRE( bench.spscQueue );
+        SPSCQueue_init( bench.spscQueue, QUEUE_CAPACITY );
+    }
+    else
+    {
+        bench.mtQueue = MTQueue_new();
+        ANY_REQUIRE( bench.mtQueue );
+
+        if( kind == QUEUE_MTQUEUE_BOUNDED )
+        {
+            MTQueue_initBounded( bench.mtQueue, QUEUE_CAPACITY );
+        }
+        else
+        {
+            MTQueue_init( bench.mtQueue, MTQUEUE_FIFO, true );
+        }
+    }
+
+    timer = RTTimer_new();
+    ANY_REQUIRE( timer );
+    RTTimer_init( timer );
+
+    producer = Threads_new();
+    ANY_REQUIRE( producer );
+    Threads_init( producer, true );
+
+    PinCurrentThread( 0 );
+
+    RTTimer_start( timer );
+
+    Threads_start( producer, ProducerFn, &bench );
+    Consume( &bench );
+    Threads_join( producer, NULL );
+
+    RTTimer_stop( timer );
+
+    elapsed = RTTimer_getElapsed( timer );
+    RTTimer_format( timef, (double)elapsed );
+
+    ANY_LOG( 0, "Performace Statistics: %s", ANY_LOG_INFO, title );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+    ANY_LOG( 0, "%ld elements, capacity %d", ANY_LOG_INFO, numElements, QUEUE_CAPACITY );
+    ANY_LOG( 0, "Elapsed time is %llu nanosecs (%s)", ANY_LOG_INFO, elapsed, timef );
+    ANY_LOG( 0, "Throughput is %.1f million elements/s", ANY_LOG_INFO,
+             elapsed > 0 ? numElements * 1000.0 / elapsed : 0.0 );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    Threads_clear( producer );
+    Threads_delete( producer );
+
+    RTTimer_clear( timer );
+    RTTimer_delete( timer );
+
+    if( bench.spscQueue )
+    {
+        SPSCQueue_clear( bench.spscQueue );
+        SPSCQueue_delete( bench.spscQueue );
+    }
+    else
+    {
+        MTQueue_clear( bench.mtQueue );
+        MTQueue_delete( bench.mtQueue );
+    }
+}
+
+
+static void TestRoundTrips( long numRoundTrips )
+{
+    SPSCQueue          *queues[2];
+    Threads            *echo = NULL;
+    RTTimer            *timer = NULL;
+    unsigned long long elapsed = 0;
+    char               timef[64];
+    long               i;
+    int                j;
+
+    for( j = 0; j < 2; j++ )
+    {
+        queues[ j ] = SPSCQueue_new();
+        ANY_REQUIRE( queues[ j ] );
+        SPSCQueue_init( queues[ j ], QUEUE_CAPACITY );
+    }
+
+    timer = RTTimer_new();
+    ANY_REQUIRE( timer );
+    RTTimer_init( timer );
+
+    echo = Threads_new();
+    ANY_REQUIRE( echo );
+    Threads_init( echo, true );
+
+    PinCurrentThread( 0 );
+
+    RTTimer_start( timer );
+
+    Threads_start( echo, EchoFn, queues );
+
+    for( i = 1; i <= numRoundTrips; i++ )
+    {
+        SPSCQueue_pushWait( queues[ 0 ], (void *)i, 0 );
+        ANY_REQUIRE( (long)SPSCQueue_popWait( queues[ 1 ], 0 ) == i );
+    }
+
+    SPSCQueue_setQuit( queues[ 0 ], true );
+    Threads_join( echo, NULL );
+
+    RTTimer_stop( timer );
+
+    elapsed = RTTimer_getElapsed( timer );
+    RTTimer_format( timef, (double)elapsed );
+
+    ANY_LOG( 0, "Performace Statistics: SPSCQueue, round trips", ANY_LOG_INFO );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+    ANY_LOG( 0, "%ld round trips", ANY_LOG_INFO, numRoundTrips );
+    ANY_LOG( 0, "Elapsed time is %llu nanosecs (%s)", ANY_LOG_INFO, elapsed, timef );
+    ANY_LOG( 0, "One round trip takes %.0f nanosecs", ANY_LOG_INFO,
+             numRoundTrips > 0 ? (double)elapsed / numRoundTrips : 0.0 );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    Threads_clear( echo );
+    Threads_delete( echo );
+
+    RTTimer_clear( timer );
+    RTTimer_delete( timer );
+
+    for( j = 0; j < 2; j++ )
+    {
+        SPSCQueue_clear( queues[ j ] );
+        SPSCQueue_delete( queues[ j ] );
+    }
+}
+
+
+static void *ProducerFn( void *arg )
+{
+    Benchmark     *bench = (Benchmark *)arg;
+    void          *batch[BATCH_SIZE];
+    unsigned long pushed;
+    long          n;
+    long          i;
+
+    PinCurrentThread( 1 );
+
+    /* the elements are 1 .. numElements, NULL cannot be queued */
+    for( i = 1; i <= bench->numElements; )
+    {
+        switch( bench->kind )
+        {
+            case QUEUE_MTQUEUE:
+            case QUEUE_MTQUEUE_BOUNDED:
+                MTQueue_push( bench->mtQueue, (void *)i, MTQUEUE_NOCLASS );
+                i++;
+                break;
+
+            case QUEUE_SPSC:
+                SPSCQueue_pushWait( bench->spscQueue, (void *)i, 0 );
+                i++;
+                break;
+
+            case QUEUE_SPSC_BATCH:
+                for( n = 0; n < BATCH_SIZE && i + n <= bench->numElements; n++ )
+                {
+                    batch[ n ] = (void *)( i + n );
+                }
+
+                pushed = SPSCQueue_pushMany( bench->spscQueue, batch, n );
+
+                /* the rest one by one, waiting for room if needed */
+                for( ; (long)pushed < n; pushed++ )
+                {
+                    SPSCQueue_pushWait( bench->spscQueue, batch[ pushed ], 0 );
+                }
+
+                i += n;
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void *EchoFn( void *arg )
+{
+    SPSCQueue **queues = (SPSCQueue **)arg;
+    void      *data;
+
+    PinCurrentThread( 1 );
+
+    /* NULL once the queue quits */
+    while( ( data = SPSCQueue_popWait( queues[ 0 ], 0 ) ) != NULL )
+    {
+        SPSCQueue_pushWait( queues[ 1 ], data, 0 );
+    }
+
+    return NULL;
+}
+
+
+static void Consume( Benchmark *bench )
+{
+    void          *batch[BATCH_SIZE];
+    unsigned long n;
+    unsigned long j;
+    long          expected = 1;
+    void          *data;
+
+    while( expected <= bench->numElements )
+    {
+        switch( bench->kind )
+        {
+            case QUEUE_MTQUEUE:
+            case QUEUE_MTQUEUE_BOUNDED:
+                data = MTQueue_popWait( bench->mtQueue, NULL, 0 );
+                break;
+
+            case QUEUE_SPSC:
+                data = SPSCQueue_popWait( bench->spscQueue, 0 );
+                break;
+
+            default:
+                n = SPSCQueue_popMany( bench->spscQueue, batch, BATCH_SIZE );
+
+                if( n == 0 )
+                {
+                    batch[ 0 ] = SPSCQueue_popWait( bench->spscQueue, 0 );
+                    n = 1;
+                }
+
+                for( j = 0; j < n; j++ )
+                {
+                    ANY_REQUIRE( (long)batch[ j ] == expected );
+                    expected++;
+                }
+
+                continue;
+        }
+
+        /* the locked MTQueue may wake up without an element */
+        if( data )
+        {
+            ANY_REQUIRE( (long)data == expected );
+            expected++;
+        }
+    }
+}
+
+
+static void PinCurrentThread( int nth )
+{
+    ThreadsCpuSet cpus;
+    ThreadsCpuSet cpu;
+
+    Threads_getAvailableCpus( &cpus );
+
+    if( ThreadsCpuSet_count( &cpus ) < 2 )
+    {
+        return;
+    }
+
+    ThreadsCpuSet_zero( &cpu );
+    ThreadsCpuSet_add( &cpu, ThreadsCpuSet_getNth( &cpus, nth ) );
+    Threads_setCurrentAffinity( &cpu );
+}
+
+
+/* EOF */
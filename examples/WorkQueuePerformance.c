@@ -0,0 +1,286 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Compares the shared queue and the work stealing scheduler of WorkQueue
+ * on many short tasks, each one processing a small image tile. The tiles
+ * are enqueued by a few tasks, the way a tile based filter splits a frame.
+ *
+ * The work stealing one runs again with the workers pinned to the NUMA
+ * nodes, which avoids migrations between the sockets of larger machines.
+ *
+ * Then measures the fork/join overhead of splitting a frame in a few
+ * tiles, with one WorkQueueTask per tile and with WorkQueue_parallelFor().
+ *
+ * usage: WorkQueuePerformance [numWorkers]
+ */
+
+
+#include <Any.h>
+#include <RTTimer.h>
+#include <WorkQueue.h>
+
+
+#define TILE_SIZE       ( 32 * 32 )
+#define NUM_TILES       ( 65536 )
+#define NUM_SPAWNERS    ( 16 )
+#define NUM_FRAMES      ( 2000 )
+#define FRAME_TILES     ( 16 )
+
+
+typedef struct Spawner
+{
+    WorkQueue     *queue;
+    WorkQueueTask **tiles;
+    int           numTiles;
+}
+Spawner;
+
+
+static void TestScheduler( const char *title, WorkQueueScheduler scheduler,
+                           WorkQueuePinning pinning, int numWorkers );
+
+static WorkQueueTaskStatus TileFn( void *instance, void *userData );
+
+static WorkQueueTaskStatus SpawnFn( void *instance, void *userData );
+
+static void TestForkJoin( int numWorkers );
+
+static void TileRangeFn( long begin, long end, void *context );
+
+
+static unsigned char *image = NULL;
+
+
+int main( int argc, char *argv[] )
+{
+    int numWorkers = argc > 1 ? atoi( argv[ 1 ] ) : 8;
+
+    image = (unsigned char *)ANY_BALLOC( (long)NUM_TILES * TILE_SIZE );
+    ANY_REQUIRE( image );
+
+    TestScheduler( "Shared queue", WORKQUEUE_SCHEDULER_SHARED, WORKQUEUE_PINNING_NONE, numWorkers );
+    TestScheduler( "Work stealing", WORKQUEUE_SCHEDULER_WORKSTEALING, WORKQUEUE_PINNING_NONE, numWorkers );
+    TestScheduler( "Work stealing, pinned to NUMA nodes", WORKQUEUE_SCHEDULER_WORKSTEALING,
+                   WORKQUEUE_PINNING_NUMANODE, numWorkers );
+    TestForkJoin( numWorkers );
+
+    ANY_FREE( image );
+
+    return EXIT_SUCCESS;
+}
+
+
+static WorkQueueTaskStatus TileFn( void *instance, void *userData )
+{
+    unsigned char *tile = (unsigned char *)instance;
+    int           i;
+
+    for( i = 0; i < TILE_SIZE; i++ )
+    {
+        tile[ i ] = (unsigned char)( tile[ i ] * 3 + 1 );
+    }
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+
+static WorkQueueTaskStatus SpawnFn( void *instance, void *userData )
+{
+    Spawner *spawner = (Spawner *)instance;
+    int     i;
+
+    for( i = 0; i < spawner->numTiles; i++ )
+    {
+        WorkQueue_enqueue( spawner->queue, spawner->tiles[ i ] );
+    }
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+
+static void TestScheduler( const char *title, WorkQueueScheduler scheduler,
+                           WorkQueuePinning pinning, int numWorkers )
+{
+    WorkQueue          *queue = NULL;
+    WorkQueueTask      **tiles = NULL;
+    WorkQueueTask      *spawnerTasks[NUM_SPAWNERS];
+    Spawner            spawners[NUM_SPAWNERS];
+    RTTimer            *timer = NULL;
+    unsigned long long elapsed = 0;
+    char               timef[64];
+    int                i;
+
+    queue = WorkQueue_new();
+    ANY_REQUIRE( queue );
+    WorkQueue_initPinned( queue, numWorkers, numWorkers, scheduler, pinning, "WQPerf" );
+
+    tiles = ANY_NTALLOC( NUM_TILES, WorkQueueTask * );
+    ANY_REQUIRE( tiles );
+
+    for( i = 0; i < NUM_TILES; i++ )
+    {
+        tiles[ i ] = WorkQueue_getTask( queue );
+        WorkQueueTask_init( tiles[ i ], TileFn, image + (long)i * TILE_SIZE, NULL, NULL );
+    }
+
+    for( i = 0; i < NUM_SPAWNERS; i++ )
+    {
+        spawners[ i ].queue    = queue;
+        spawners[ i ].tiles    = tiles + i * ( NUM_TILES / NUM_SPAWNERS );
+        spawners[ i ].numTiles = NUM_TILES / NUM_SPAWNERS;
+
+        spawnerTasks[ i ] = WorkQueue_getTask( queue );
+        WorkQueueTask_init( spawnerTasks[ i ], SpawnFn, &spawners[ i ], NULL, NULL );
+    }
+
+    timer = RTTimer_new();
+    ANY_REQUIRE( timer );
+    RTTimer_init( timer );
+
+    RTTimer_start( timer );
+
+    for( i = 0; i < NUM_SPAWNERS; i++ )
+    {
+        WorkQueue_enqueue( queue, spawnerTasks[ i ] );
+    }
+
+    for( i = 0; i < NUM_SPAWNERS; i++ )
+    {
+        WorkQueueTask_wait( spawnerTasks[ i ] );
+    }
+
+    for( i = 0; i < NUM_TILES; i++ )
+    {
+        WorkQueueTask_wait( tiles[ i ] );
+    }
+
+    RTTimer_stop( timer );
+
+    elapsed = RTTimer_getElapsed( timer );
+    RTTimer_format( timef, (double)elapsed );
+
+    ANY_LOG( 0, "Performace Statistics: %s", ANY_LOG_INFO, title );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+    ANY_LOG( 0, "%d workers, %d tiles of %d bytes", ANY_LOG_INFO, numWorkers, NUM_TILES, TILE_SIZE );
+    ANY_LOG( 0, "Elapsed time is %llu nanosecs (%s)", ANY_LOG_INFO, elapsed, timef );
+    ANY_LOG( 0, "Throughput is %.0f tiles/s", ANY_LOG_INFO,
+             elapsed > 0 ? NUM_TILES * 1000000000.0 / elapsed : 0.0 );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    for( i = 0; i < NUM_SPAWNERS; i++ )
+    {
+        WorkQueue_disposeTask( queue, spawnerTasks[ i ] );
+    }
+
+    for( i = 0; i < NUM_TILES; i++ )
+    {
+        WorkQueue_disposeTask( queue, tiles[ i ] );
+    }
+
+    WorkQueue_clear( queue );
+    WorkQueue_delete( queue );
+
+    RTTimer_clear( timer );
+    RTTimer_delete( timer );
+
+    ANY_FREE( tiles );
+}
+
+
+static void TileRangeFn( long begin, long end, void *context )
+{
+    long i;
+
+    for( i = begin; i < end; i++ )
+    {
+        TileFn( image + i * TILE_SIZE, NULL );
+    }
+}
+
+
+static void TestForkJoin( int numWorkers )
+{
+    WorkQueue          *queue = NULL;
+    WorkQueueTask      *tiles[FRAME_TILES];
+    RTTimer            *timer = NULL;
+    unsigned long long perTasks = 0;
+    unsigned long long perParallelFor = 0;
+    long               i;
+    int                frame;
+
+    queue = WorkQueue_new();
+    ANY_REQUIRE( queue );
+    WorkQueue_init( queue, numWorkers, numWorkers );
+
+    timer = RTTimer_new();
+    ANY_REQUIRE( timer );
+    RTTimer_init( timer );
+
+    /* one pooled task per tile, each signalled on its own */
+    RTTimer_start( timer );
+
+    for( frame = 0; frame < NUM_FRAMES; frame++ )
+    {
+        for( i = 0; i < FRAME_TILES; i++ )
+        {
+            tiles[ i ] = WorkQueue_getTask( queue );
+            WorkQueueTask_init( tiles[ i ], TileFn, image + i * TILE_SIZE, NULL, NULL );
+            WorkQueue_enqueue( queue, tiles[ i ] );
+        }
+
+        for( i = 0; i < FRAME_TILES; i++ )
+        {
+            WorkQueueTask_wait( tiles[ i ] );
+            WorkQueue_disposeTask( queue, tiles[ i ] );
+        }
+    }
+
+    RTTimer_stop( timer );
+    perTasks = RTTimer_getElapsed( timer ) / NUM_FRAMES;
+
+    RTTimer_reset( timer );
+
+    /* the same split with a shared completion counter */
+    RTTimer_start( timer );
+
+    for( frame = 0; frame < NUM_FRAMES; frame++ )
+    {
+        WorkQueue_parallelFor( queue, 0, FRAME_TILES, 1, TileRangeFn, NULL );
+    }
+
+    RTTimer_stop( timer );
+    perParallelFor = RTTimer_getElapsed( timer ) / NUM_FRAMES;
+
+    ANY_LOG( 0, "Performace Statistics: fork/join of %d tiles", ANY_LOG_INFO, FRAME_TILES );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+    ANY_LOG( 0, "One task per tile:       %llu nanosecs per frame", ANY_LOG_INFO, perTasks );
+    ANY_LOG( 0, "WorkQueue_parallelFor(): %llu nanosecs per frame", ANY_LOG_INFO, perParallelFor );
+    ANY_LOG( 0, "------------------------------------------------------", ANY_LOG_INFO );
+
+    WorkQueue_clear( queue );
+    WorkQueue_delete( queue );
+
+    RTTimer_clear( timer );
+    RTTimer_delete( timer );
+}
+
+
+/* EOF */
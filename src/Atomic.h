@@ -116,6 +116,14 @@ do {\
 
 #define AtomicPointer_get( __self ) Atomic_get( __self )
 
+/* full memory barrier, orders the loads and stores around it */
+#define Atomic_memoryBarrier() __sync_synchronize()
+
+/* one way barriers, enough to hand data over from one thread to another */
+#define Atomic_getAcquire( __self ) __atomic_load_n( __self, __ATOMIC_ACQUIRE )
+
+#define Atomic_setRelease( __self, __value ) __atomic_store_n( __self, __value, __ATOMIC_RELEASE )
+
 
 #endif /* __GNUC__ */
 
@@ -155,6 +163,21 @@ typedef AnyAtomic AnyAtomic64;
 
 #define Atomic_testAndSetBool( __self, __testValue, __newValue ) ( _InterlockedCompareExchange( __self, __newValue, __testValue ) == __testValue )
 
+#define Atomic_memoryBarrier() MemoryBarrier()
+
+/*
+ * plain x86 loads and stores are ordered that way already, the compiler
+ * must not move later accesses before the load either: volatile loads
+ * have acquire semantics with /volatile:ms, the default on x86 and x64
+ */
+#define Atomic_getAcquire( __self ) ( *(volatile __typeof__( *(__self) ) *)(__self) )
+
+#define Atomic_setRelease( __self, __value )\
+do {\
+  _ReadWriteBarrier();\
+  *__self = __value;\
+} while( 0 )
+
 /* Atomic64 64bits (long long) */
 #if defined(__64BIT__)
 
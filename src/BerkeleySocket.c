@@ -1461,6 +1461,191 @@ int BerkeleySocket_readBlock( BerkeleySocket *self, BaseUI8 *poReadBuffer, int s
 }
 
 
+int BerkeleySocket_readDatagrams( BerkeleySocket *self, BerkeleySocketDatagram *datagrams, int count )
+{
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+    struct mmsghdr msgs[BERKELEYSOCKET_DATAGRAMS_MAX];
+    struct iovec iov[BERKELEYSOCKET_DATAGRAMS_MAX];
+#else
+    unsigned int len = 0;
+#endif
+    int retVal = -1;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKET_VALID );
+    ANY_REQUIRE( datagrams );
+    ANY_REQUIRE( count > 0 );
+
+    if( self->type != BERKELEYSOCKET_UDP ||
+        self->socketFd == BERKELEYSOCKETHANDLE_INVALID )
+    {
+        ANY_LOG( 0, "The socket is not an UDP one or the channel is Invalid", ANY_LOG_WARNING );
+        goto out;
+    }
+
+    if( count > BERKELEYSOCKET_DATAGRAMS_MAX )
+    {
+        count = BERKELEYSOCKET_DATAGRAMS_MAX;
+    }
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+    Any_memset( msgs, 0, count * sizeof( struct mmsghdr ));
+
+    for( i = 0; i < count; i++ )
+    {
+        iov[i].iov_base = datagrams[i].buffer;
+        iov[i].iov_len = datagrams[i].size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &datagrams[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof( datagrams[i].addr );
+    }
+
+    /* blocks for the first datagram only, then takes what is already queued */
+    retVal = recvmmsg( self->socketFd, msgs, count, MSG_WAITFORONE | MSG_NOSIGNAL, NULL );
+
+    for( i = 0; i < retVal; i++ )
+    {
+        datagrams[i].length = (int)msgs[i].msg_len;
+        datagrams[i].truncated = ( msgs[i].msg_hdr.msg_flags & MSG_TRUNC ) != 0;
+    }
+#else
+    /* no batching available, take one datagram per call */
+    len = sizeof( datagrams[0].addr );
+
+    retVal = recvfrom( self->socketFd, datagrams[0].buffer, datagrams[0].size, MSG_NOSIGNAL,
+                       (struct sockaddr *)&datagrams[0].addr, &len );
+
+    if( retVal >= 0 )
+    {
+        datagrams[0].length = retVal;
+        datagrams[0].truncated = false;
+        retVal = 1;
+    }
+#endif
+
+    if( retVal > 0 && !BERKELEYSOCKET_OPTION_GET( self, BROADCAST ) )
+    {
+        Any_memcpy( &self->remoteAddr, &datagrams[retVal - 1].addr, sizeof( self->remoteAddr ));
+    }
+
+    /* a single check for the whole batch */
+    if( BerkeleySocket_checkUDPClosed( self ) )
+    {
+        retVal = -1;
+    }
+
+    out:
+
+    return retVal;
+}
+
+
+int BerkeleySocket_writeDatagrams( BerkeleySocket *self, BerkeleySocketDatagram *datagrams, int count )
+{
+    struct sockaddr_in broadcastAddr;
+    struct sockaddr_in *defaultAddr = (struct sockaddr_in *)NULL;
+    struct sockaddr_in *addr = (struct sockaddr_in *)NULL;
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+    struct mmsghdr msgs[BERKELEYSOCKET_DATAGRAMS_MAX];
+    struct iovec iov[BERKELEYSOCKET_DATAGRAMS_MAX];
+    int chunk = 0;
+    int j = 0;
+#endif
+    int sent = 0;
+    int i = 0;
+    int retVal = -1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKET_VALID );
+    ANY_REQUIRE( datagrams );
+    ANY_REQUIRE( count > 0 );
+
+    if( self->type != BERKELEYSOCKET_UDP ||
+        self->socketFd == BERKELEYSOCKETHANDLE_INVALID )
+    {
+        ANY_LOG( 5, "The socket is not an UDP one or the channel is Invalid", ANY_LOG_WARNING );
+        goto out;
+    }
+
+    defaultAddr = &self->remoteAddr;
+
+    if( BERKELEYSOCKET_OPTION_GET( self, BROADCAST ) )
+    {
+        Any_memset( &broadcastAddr, 0, sizeof( broadcastAddr ));
+
+        broadcastAddr.sin_family = AF_INET;
+        broadcastAddr.sin_addr.s_addr = INADDR_BROADCAST;
+        broadcastAddr.sin_port = htons( self->port );
+
+        defaultAddr = &broadcastAddr;
+    }
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+    while( sent < count )
+    {
+        chunk = count - sent < BERKELEYSOCKET_DATAGRAMS_MAX ? count - sent : BERKELEYSOCKET_DATAGRAMS_MAX;
+
+        Any_memset( msgs, 0, chunk * sizeof( struct mmsghdr ));
+
+        for( i = 0; i < chunk; i++ )
+        {
+            addr = datagrams[sent + i].addr.sin_family != 0 ? &datagrams[sent + i].addr : defaultAddr;
+
+            iov[i].iov_base = datagrams[sent + i].buffer;
+            iov[i].iov_len = datagrams[sent + i].size;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof( *addr );
+        }
+
+        j = sendmmsg( self->socketFd, msgs, chunk, MSG_NOSIGNAL );
+
+        if( j <= 0 )
+        {
+            break;
+        }
+
+        for( i = 0; i < j; i++ )
+        {
+            datagrams[sent + i].length = (int)msgs[i].msg_len;
+        }
+
+        sent += j;
+    }
+#else
+    for( sent = 0; sent < count; sent++ )
+    {
+        addr = datagrams[sent].addr.sin_family != 0 ? &datagrams[sent].addr : defaultAddr;
+
+        i = sendto( self->socketFd, datagrams[sent].buffer, datagrams[sent].size, MSG_NOSIGNAL,
+                    (struct sockaddr *)addr, sizeof( *addr ));
+
+        if( i < 0 )
+        {
+            break;
+        }
+
+        datagrams[sent].length = i;
+    }
+#endif
+
+    retVal = sent > 0 ? sent : -1;
+
+    /* a single check for the whole batch */
+    if( BerkeleySocket_checkUDPClosed( self ) )
+    {
+        retVal = -1;
+    }
+
+    out:
+
+    return retVal;
+}
+
+
 int BerkeleySocket_readUrgent( BerkeleySocket *self, BaseUI8 *poReadBuffer, int bufferSize )
 {
     unsigned int len = 0;
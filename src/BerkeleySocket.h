@@ -701,6 +701,55 @@ int BerkeleySocket_read( BerkeleySocket *self, BaseUI8 *poReadBuffer, int buffer
 
 int BerkeleySocket_readBlock( BerkeleySocket *self, BaseUI8 *poReadBuffer, int size );
 
+/*!
+ * \brief Maximum number of datagrams moved by a single system call
+ */
+#define BERKELEYSOCKET_DATAGRAMS_MAX 64
+
+/*!
+ * \brief One datagram of a batch, see BerkeleySocket_readDatagrams()
+ */
+typedef struct BerkeleySocketDatagram
+{
+    BaseUI8 *buffer;          /**< Payload of the datagram */
+    int size;                 /**< Bytes to send, or room in \a buffer when receiving */
+    int length;               /**< Bytes actually sent or received */
+    bool truncated;           /**< The received datagram was longer than \a size */
+    struct sockaddr_in addr;  /**< Sender when receiving, destination when sending (if sin_family is set) */
+}
+BerkeleySocketDatagram;
+
+/*!
+ * \brief Receives a batch of datagrams from an UDP BerkeleySocket
+ * \param self BerkeleySocket instance pointer
+ * \param datagrams Array of \a count datagrams to be filled
+ * \param count Number of entries in \a datagrams
+ *
+ * Waits like \a BerkeleySocket_read() for the first datagram, then takes all the datagrams
+ * already queued on the socket up to \a count (at most \a BERKELEYSOCKET_DATAGRAMS_MAX), with
+ * a single \a recvmmsg() system call where available. For each datagram the sender address is
+ * stored in \a addr and the received bytes in \a length. Like \a BerkeleySocket_read() the
+ * sender of the last datagram also becomes the remote address of the BerkeleySocket.
+ *
+ * \return Return the number of datagrams received, -1 in case of failure
+ */
+int BerkeleySocket_readDatagrams( BerkeleySocket *self, BerkeleySocketDatagram *datagrams, int count );
+
+/*!
+ * \brief Sends a batch of datagrams over an UDP BerkeleySocket
+ * \param self BerkeleySocket instance pointer
+ * \param datagrams Array of \a count datagrams to be sent
+ * \param count Number of entries in \a datagrams
+ *
+ * Sends \a size bytes of each datagram, using \a sendmmsg() to pass up to
+ * \a BERKELEYSOCKET_DATAGRAMS_MAX datagrams per system call where available. A datagram whose
+ * \a addr.sin_family is \a 0 goes to the remote address of the BerkeleySocket, like with
+ * \a BerkeleySocket_write().
+ *
+ * \return Return the number of datagrams sent, -1 if not even the first could be sent
+ */
+int BerkeleySocket_writeDatagrams( BerkeleySocket *self, BerkeleySocketDatagram *datagrams, int count );
+
 int BerkeleySocket_readUrgent( BerkeleySocket *self, BaseUI8 *poReadBuffer, int bufferSize );
 
 /*!
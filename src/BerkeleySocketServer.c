@@ -35,10 +35,62 @@
     #include <ctype.h>
 #endif
 
+#if defined(__linux__)
+    #include <errno.h>
+    #include <limits.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <Atomic.h>
+#endif
+
 
 #define BERKELEYSOCKETSERVER_VALID  0xc980b3a8
 #define BERKELEYSOCKETSERVER_INVALID  0x9e5285c4
 
+#define BERKELEYSOCKETSERVERCONNECTION_VALID  0x5d13a7e1
+#define BERKELEYSOCKETSERVERCONNECTION_INVALID  0x1b6c40f9
+
+/* number of ready descriptors fetched by a single epoll_wait() */
+#define BERKELEYSOCKETSERVER_EVENTLOOP_MAXEVENTS  256
+
+
+#if defined(__linux__)
+
+/*
+ * per client state of the event loop, the BerkeleySocket must stay the first
+ * member because the callbacks only get a pointer to it
+ */
+typedef struct BerkeleySocketServerConnection
+{
+    BerkeleySocket socket;
+    unsigned long valid;
+    struct BerkeleySocketServerConnection *prev;
+    struct BerkeleySocketServerConnection *next;
+    unsigned int events;
+    unsigned int armedEvents;
+    bool connected;
+    bool registered;
+    bool writeEvents;
+}
+BerkeleySocketServerConnection;
+
+
+struct BerkeleySocketServerEventLoop
+{
+    int epollFd;
+    int wakeFd;
+    AnyAtomic quit;
+    BerkeleySocketServerEventCallBack eventCallBack;
+    void *data;
+    WorkQueue *workQueue;
+    Mutex *mutex;
+    Cond *idleCond;
+    long numDispatching;
+    BerkeleySocketServerConnection *connections;
+};
+
+#endif
+
 
 static int BerkeleySocketServer_initTcpServer( BerkeleySocketServer *self, int serverPortNo, int maxClient );
 
@@ -50,6 +102,22 @@ static BerkeleySocketHandle BerkeleySocketServer_acceptTcpClient( BerkeleySocket
 static BerkeleySocketHandle BerkeleySocketServer_acceptUdpClient( BerkeleySocketServer *self,
                                                                   BerkeleySocket *newBerkeleySocket );
 
+#if defined(__linux__)
+
+static struct BerkeleySocketServerEventLoop *BerkeleySocketServer_getEventLoop( BerkeleySocketServer *self );
+
+static void BerkeleySocketServer_freeEventLoop( BerkeleySocketServer *self );
+
+static void BerkeleySocketServer_acceptConnections( BerkeleySocketServer *self );
+
+static void BerkeleySocketServer_serveConnection( struct BerkeleySocketServerEventLoop *loop,
+                                                  BerkeleySocketServerConnection *conn );
+
+static void BerkeleySocketServer_closeConnection( struct BerkeleySocketServerEventLoop *loop,
+                                                  BerkeleySocketServerConnection *conn );
+
+#endif
+
 
 BerkeleySocketServer *BerkeleySocketServer_new( void )
 {
@@ -92,6 +160,7 @@ bool BerkeleySocketServer_init( BerkeleySocketServer *self, BerkeleySocket *sock
     }
 
     self->broadcast = false;
+    self->eventLoop = (struct BerkeleySocketServerEventLoop *)NULL;
 
     self->valid = BERKELEYSOCKETSERVER_VALID;
     result = true;
@@ -281,6 +350,566 @@ void BerkeleySocketServer_loop( BerkeleySocketServer *self,
 }
 
 
+#if defined(__linux__)
+
+static WorkQueueTaskStatus BerkeleySocketServer_connectionTask( void *instance, void *userData )
+{
+    struct BerkeleySocketServerEventLoop *loop = (struct BerkeleySocketServerEventLoop *)userData;
+    int status = 0;
+
+    BerkeleySocketServer_serveConnection( loop, (BerkeleySocketServerConnection *)instance );
+
+    /* the connection may be re-armed and handed to another worker from now on */
+    status = Mutex_lock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    loop->numDispatching--;
+
+    if( loop->numDispatching == 0 )
+    {
+        Cond_broadcast( loop->idleCond );
+    }
+
+    status = Mutex_unlock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+
+static void BerkeleySocketServer_dispatchConnection( struct BerkeleySocketServerEventLoop *loop,
+                                                     BerkeleySocketServerConnection *conn )
+{
+    WorkQueueTask *task = (WorkQueueTask *)NULL;
+    int status = 0;
+
+    if( loop->workQueue == (WorkQueue *)NULL )
+    {
+        BerkeleySocketServer_serveConnection( loop, conn );
+        return;
+    }
+
+    status = Mutex_lock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+    loop->numDispatching++;
+    status = Mutex_unlock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    task = WorkQueue_getTask( loop->workQueue );
+    ANY_REQUIRE( task );
+
+    if( !WorkQueueTask_init( task, BerkeleySocketServer_connectionTask, conn, loop, NULL ) )
+    {
+        ANY_LOG( 0, "Unable to initialize a WorkQueueTask, serving the client inline", ANY_LOG_WARNING );
+        WorkQueue_disposeTask( loop->workQueue, task );
+        BerkeleySocketServer_connectionTask( conn, loop );
+        return;
+    }
+
+    WorkQueue_enqueue( loop->workQueue, task );
+    WorkQueue_disposeTask( loop->workQueue, task );
+}
+
+
+bool BerkeleySocketServer_eventLoop( BerkeleySocketServer *self,
+                                     BerkeleySocketServerEventCallBack eventCallBack,
+                                     void *data1,
+                                     bool (*timeoutCallBack)( BerkeleySocket *, void * ),
+                                     void *data2,
+                                     long timeout,
+                                     WorkQueue *workQueue )
+{
+    struct BerkeleySocketServerEventLoop *loop = (struct BerkeleySocketServerEventLoop *)NULL;
+    struct epoll_event listenEvent;
+    struct epoll_event events[BERKELEYSOCKETSERVER_EVENTLOOP_MAXEVENTS];
+    BerkeleySocketServerConnection *conn = (BerkeleySocketServerConnection *)NULL;
+    uint64_t wakeCount = 0;
+    bool retVal = false;
+    bool quit = false;
+    int timeoutMs = -1;
+    int numEvents = 0;
+    int status = 0;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
+    ANY_REQUIRE( eventCallBack );
+
+    if( BerkeleySocket_getType( self->socket ) != BERKELEYSOCKET_TCP ||
+        BerkeleySocket_getFd( self->socket ) == BERKELEYSOCKETHANDLE_INVALID )
+    {
+        ANY_LOG( 0, "The event loop requires a connected TCP BerkeleySocketServer", ANY_LOG_ERROR );
+        goto out;
+    }
+
+    loop = BerkeleySocketServer_getEventLoop( self );
+
+    if( loop == (struct BerkeleySocketServerEventLoop *)NULL )
+    {
+        goto out;
+    }
+
+    loop->eventCallBack = eventCallBack;
+    loop->data = data1;
+    loop->workQueue = workQueue;
+    Atomic_set( &loop->quit, false );
+
+    if( timeout > 0 )
+    {
+        timeoutMs = ( timeout / 1000L < INT_MAX - 1 ) ? (int)( ( timeout + 999L ) / 1000L ) : INT_MAX;
+    }
+
+    /* the listener is drained on each edge, so it must never block in accept() */
+    BerkeleySocket_setBlocking( self->socket, false );
+
+    Any_memset( &listenEvent, 0, sizeof( listenEvent ));
+    listenEvent.events = EPOLLIN | EPOLLET;
+    listenEvent.data.ptr = NULL;
+
+    if( epoll_ctl( loop->epollFd, EPOLL_CTL_ADD, BerkeleySocket_getFd( self->socket ), &listenEvent ) == -1 )
+    {
+        ANY_LOG( 0, "Unable to watch the listening socket, error: '%s'", ANY_LOG_ERROR, strerror( errno ));
+        goto out;
+    }
+
+    /* catch up with the clients queued before the listener was watched */
+    BerkeleySocketServer_acceptConnections( self );
+
+    while( !quit && !Atomic_get( &loop->quit ) )
+    {
+        numEvents = epoll_wait( loop->epollFd, events, BERKELEYSOCKETSERVER_EVENTLOOP_MAXEVENTS, timeoutMs );
+
+        if( numEvents == -1 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            ANY_LOG( 0, "Error on epoll_wait(), error: '%s'", ANY_LOG_ERROR, strerror( errno ));
+            break;
+        }
+
+        if( numEvents == 0 )
+        {
+            if( timeoutCallBack )
+            {
+                quit = ( *timeoutCallBack )( self->socket, data2 );
+            }
+            else
+            {
+                ANY_LOG( 5, "Got a timeout but timeoutCallBack function undefined", ANY_LOG_INFO );
+            }
+            continue;
+        }
+
+        for( i = 0; i < numEvents; i++ )
+        {
+            if( events[i].data.ptr == NULL )
+            {
+                BerkeleySocketServer_acceptConnections( self );
+            }
+            else if( events[i].data.ptr == (void *)loop )
+            {
+                while( read( loop->wakeFd, &wakeCount, sizeof( wakeCount )) > 0 )
+                {
+                }
+            }
+            else
+            {
+                conn = (BerkeleySocketServerConnection *)events[i].data.ptr;
+                conn->events = events[i].events;
+
+                BerkeleySocketServer_dispatchConnection( loop, conn );
+            }
+        }
+    }
+
+    retVal = ( numEvents != -1 );
+
+    epoll_ctl( loop->epollFd, EPOLL_CTL_DEL, BerkeleySocket_getFd( self->socket ), &listenEvent );
+
+    /* wait until no worker is serving a client anymore */
+    status = Mutex_lock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    while( loop->numDispatching > 0 )
+    {
+        Cond_wait( loop->idleCond, 0 );
+    }
+
+    status = Mutex_unlock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    while( loop->connections != (BerkeleySocketServerConnection *)NULL )
+    {
+        BerkeleySocketServer_closeConnection( loop, loop->connections );
+    }
+
+    loop->eventCallBack = (BerkeleySocketServerEventCallBack)NULL;
+    loop->data = NULL;
+    loop->workQueue = (WorkQueue *)NULL;
+
+    out:
+
+    return retVal;
+}
+
+
+bool BerkeleySocketServer_stopEventLoop( BerkeleySocketServer *self )
+{
+    uint64_t one = 1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
+
+    if( self->eventLoop == (struct BerkeleySocketServerEventLoop *)NULL )
+    {
+        ANY_LOG( 5, "The event loop has never been started", ANY_LOG_WARNING );
+        return false;
+    }
+
+    Atomic_set( &self->eventLoop->quit, true );
+
+    return write( self->eventLoop->wakeFd, &one, sizeof( one )) == sizeof( one );
+}
+
+
+void BerkeleySocketServer_setWriteEvents( BerkeleySocketServer *self, BerkeleySocket *client, bool enable )
+{
+    BerkeleySocketServerConnection *conn = (BerkeleySocketServerConnection *)client;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
+    ANY_REQUIRE( conn );
+    ANY_REQUIRE( conn->valid == BERKELEYSOCKETSERVERCONNECTION_VALID );
+
+    /* applied when the callback returns */
+    conn->writeEvents = enable;
+}
+
+
+static struct BerkeleySocketServerEventLoop *BerkeleySocketServer_getEventLoop( BerkeleySocketServer *self )
+{
+    struct BerkeleySocketServerEventLoop *loop = (struct BerkeleySocketServerEventLoop *)NULL;
+    struct epoll_event wakeEvent;
+
+    if( self->eventLoop != (struct BerkeleySocketServerEventLoop *)NULL )
+    {
+        return self->eventLoop;
+    }
+
+    loop = ANY_TALLOC( struct BerkeleySocketServerEventLoop );
+    ANY_REQUIRE( loop );
+
+    loop->epollFd = -1;
+    loop->wakeFd = -1;
+
+    loop->epollFd = epoll_create1( EPOLL_CLOEXEC );
+
+    if( loop->epollFd == -1 )
+    {
+        ANY_LOG( 0, "Unable to create the epoll instance, error: '%s'", ANY_LOG_ERROR, strerror( errno ));
+        goto failed;
+    }
+
+    loop->wakeFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    if( loop->wakeFd == -1 )
+    {
+        ANY_LOG( 0, "Unable to create the wake up eventfd, error: '%s'", ANY_LOG_ERROR, strerror( errno ));
+        goto failed;
+    }
+
+    Any_memset( &wakeEvent, 0, sizeof( wakeEvent ));
+    wakeEvent.events = EPOLLIN | EPOLLET;
+    wakeEvent.data.ptr = loop;
+
+    if( epoll_ctl( loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &wakeEvent ) == -1 )
+    {
+        ANY_LOG( 0, "Unable to watch the wake up eventfd, error: '%s'", ANY_LOG_ERROR, strerror( errno ));
+        goto failed;
+    }
+
+    loop->mutex = Mutex_new();
+    ANY_REQUIRE( loop->mutex );
+    Mutex_init( loop->mutex, MUTEX_PRIVATE );
+
+    loop->idleCond = Cond_new();
+    ANY_REQUIRE( loop->idleCond );
+    Cond_init( loop->idleCond, COND_PRIVATE );
+    Cond_setMutex( loop->idleCond, loop->mutex );
+
+    self->eventLoop = loop;
+
+    return loop;
+
+    failed:
+
+    if( loop->wakeFd != -1 )
+    {
+        close( loop->wakeFd );
+    }
+
+    if( loop->epollFd != -1 )
+    {
+        close( loop->epollFd );
+    }
+
+    ANY_FREE( loop );
+
+    return (struct BerkeleySocketServerEventLoop *)NULL;
+}
+
+
+static void BerkeleySocketServer_freeEventLoop( BerkeleySocketServer *self )
+{
+    struct BerkeleySocketServerEventLoop *loop = self->eventLoop;
+
+    if( loop == (struct BerkeleySocketServerEventLoop *)NULL )
+    {
+        return;
+    }
+
+    ANY_REQUIRE( loop->connections == (BerkeleySocketServerConnection *)NULL );
+
+    Cond_clear( loop->idleCond );
+    Cond_delete( loop->idleCond );
+
+    Mutex_clear( loop->mutex );
+    Mutex_delete( loop->mutex );
+
+    close( loop->wakeFd );
+    close( loop->epollFd );
+
+    ANY_FREE( loop );
+    self->eventLoop = (struct BerkeleySocketServerEventLoop *)NULL;
+}
+
+
+static void BerkeleySocketServer_acceptConnections( BerkeleySocketServer *self )
+{
+    struct BerkeleySocketServerEventLoop *loop = self->eventLoop;
+    BerkeleySocketServerConnection *conn = (BerkeleySocketServerConnection *)NULL;
+    struct sockaddr_in remoteAddr;
+    socklen_t addrLength = 0;
+    int fd = -1;
+    int status = 0;
+
+    while( true )
+    {
+        addrLength = sizeof( remoteAddr );
+
+        fd = accept4( BerkeleySocket_getFd( self->socket ), (struct sockaddr *)&remoteAddr, &addrLength,
+                      SOCK_NONBLOCK | SOCK_CLOEXEC );
+
+        if( fd == -1 )
+        {
+            if( errno == EINTR || errno == ECONNABORTED )
+            {
+                continue;
+            }
+
+            if( errno != EAGAIN && errno != EWOULDBLOCK )
+            {
+                /* i.e. EMFILE, the pending clients are retried on the next connection */
+                ANY_LOG( 0, "Error on accept(), error: '%s'", ANY_LOG_WARNING, strerror( errno ));
+            }
+            break;
+        }
+
+        conn = ANY_TALLOC( BerkeleySocketServerConnection );
+        ANY_REQUIRE( conn );
+
+        BerkeleySocket_init( &conn->socket );
+        BerkeleySocket_cloneProperties( self->socket, &conn->socket );
+        conn->socket.socketFd = fd;
+        conn->socket.remoteAddr = remoteAddr;
+        conn->valid = BERKELEYSOCKETSERVERCONNECTION_VALID;
+
+        status = Mutex_lock( loop->mutex );
+        ANY_REQUIRE( status == 0 );
+
+        conn->next = loop->connections;
+
+        if( loop->connections != (BerkeleySocketServerConnection *)NULL )
+        {
+            loop->connections->prev = conn;
+        }
+
+        loop->connections = conn;
+
+        status = Mutex_unlock( loop->mutex );
+        ANY_REQUIRE( status == 0 );
+
+        /* delivers the connect event and adds the client to the epoll set */
+        BerkeleySocketServer_dispatchConnection( loop, conn );
+    }
+}
+
+
+static void BerkeleySocketServer_serveConnection( struct BerkeleySocketServerEventLoop *loop,
+                                                  BerkeleySocketServerConnection *conn )
+{
+    struct epoll_event event;
+    unsigned int events = conn->events;
+    bool keep = true;
+
+    conn->events = 0;
+
+    if( !conn->connected )
+    {
+        conn->connected = true;
+        keep = ( *loop->eventCallBack )( &conn->socket, BERKELEYSOCKETSERVER_EVENT_CONNECT, loop->data );
+    }
+
+    /* a peer's shutdown is reported as readable, the callback then reads 0 bytes */
+    if( keep && ( events & ( EPOLLIN | EPOLLRDHUP )))
+    {
+        keep = ( *loop->eventCallBack )( &conn->socket, BERKELEYSOCKETSERVER_EVENT_READ, loop->data );
+    }
+
+    if( keep && ( events & EPOLLOUT ) && conn->writeEvents )
+    {
+        keep = ( *loop->eventCallBack )( &conn->socket, BERKELEYSOCKETSERVER_EVENT_WRITE, loop->data );
+    }
+
+    if( keep && ( events & ( EPOLLHUP | EPOLLERR )))
+    {
+        keep = false;
+    }
+
+    if( keep )
+    {
+        Any_memset( &event, 0, sizeof( event ));
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = conn;
+
+        if( conn->writeEvents )
+        {
+            event.events |= EPOLLOUT;
+        }
+
+        /* one shot makes sure a client is never served by two workers at once */
+        if( loop->workQueue != (WorkQueue *)NULL )
+        {
+            event.events |= EPOLLONESHOT;
+        }
+
+        /*
+         * once armed the client may be dispatched to another worker, so all the
+         * bookkeeping has to be done before epoll_ctl()
+         */
+        if( !conn->registered )
+        {
+            conn->registered = true;
+            conn->armedEvents = event.events;
+
+            if( epoll_ctl( loop->epollFd, EPOLL_CTL_ADD, conn->socket.socketFd, &event ) == -1 )
+            {
+                conn->registered = false;
+                keep = false;
+            }
+        }
+        else if( event.events != conn->armedEvents || ( event.events & EPOLLONESHOT ))
+        {
+            conn->armedEvents = event.events;
+
+            keep = ( epoll_ctl( loop->epollFd, EPOLL_CTL_MOD, conn->socket.socketFd, &event ) == 0 );
+        }
+
+        if( !keep )
+        {
+            ANY_LOG( 0, "Unable to watch a client socket, error: '%s'", ANY_LOG_WARNING, strerror( errno ));
+        }
+    }
+
+    if( !keep )
+    {
+        BerkeleySocketServer_closeConnection( loop, conn );
+    }
+}
+
+
+static void BerkeleySocketServer_closeConnection( struct BerkeleySocketServerEventLoop *loop,
+                                                  BerkeleySocketServerConnection *conn )
+{
+    int status = 0;
+
+    if( conn->connected )
+    {
+        ( *loop->eventCallBack )( &conn->socket, BERKELEYSOCKETSERVER_EVENT_CLOSE, loop->data );
+    }
+
+    if( conn->registered )
+    {
+        epoll_ctl( loop->epollFd, EPOLL_CTL_DEL, conn->socket.socketFd, NULL );
+    }
+
+    BerkeleySocket_disconnect( &conn->socket );
+    BerkeleySocket_clear( &conn->socket );
+
+    status = Mutex_lock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    if( conn->prev != (BerkeleySocketServerConnection *)NULL )
+    {
+        conn->prev->next = conn->next;
+    }
+    else
+    {
+        loop->connections = conn->next;
+    }
+
+    if( conn->next != (BerkeleySocketServerConnection *)NULL )
+    {
+        conn->next->prev = conn->prev;
+    }
+
+    status = Mutex_unlock( loop->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    conn->valid = BERKELEYSOCKETSERVERCONNECTION_INVALID;
+    ANY_FREE( conn );
+}
+
+#else
+
+bool BerkeleySocketServer_eventLoop( BerkeleySocketServer *self,
+                                     BerkeleySocketServerEventCallBack eventCallBack,
+                                     void *data1,
+                                     bool (*timeoutCallBack)( BerkeleySocket *, void * ),
+                                     void *data2,
+                                     long timeout,
+                                     WorkQueue *workQueue )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
+
+    ANY_LOG( 0, "BerkeleySocketServer_eventLoop() is not supported on this platform", ANY_LOG_ERROR );
+
+    return false;
+}
+
+
+bool BerkeleySocketServer_stopEventLoop( BerkeleySocketServer *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
+
+    return false;
+}
+
+
+void BerkeleySocketServer_setWriteEvents( BerkeleySocketServer *self, BerkeleySocket *client, bool enable )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
+}
+
+#endif
+
+
 void BerkeleySocketServer_disconnect( BerkeleySocketServer *self )
 {
     ANY_REQUIRE( self );
@@ -297,6 +926,10 @@ void BerkeleySocketServer_clear( BerkeleySocketServer *self )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == BERKELEYSOCKETSERVER_VALID );
 
+#if defined(__linux__)
+    BerkeleySocketServer_freeEventLoop( self );
+#endif
+
     BerkeleySocket_disconnect( self->socket );
     BerkeleySocket_clear( self->socket );
 
@@ -23,12 +23,15 @@
 
 #include <Any.h>
 #include <BerkeleySocket.h>
+#include <WorkQueue.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 
+struct BerkeleySocketServerEventLoop;
+
 typedef struct BerkeleySocketServer
 {
     unsigned long valid;
@@ -36,10 +39,29 @@ typedef struct BerkeleySocketServer
     int serverAddr;
     BerkeleySocket *socket;
     bool broadcast;
+    struct BerkeleySocketServerEventLoop *eventLoop;
 }
 BerkeleySocketServer;
 
 
+/*!
+ * \brief Events reported by \a BerkeleySocketServer_eventLoop()
+ */
+typedef enum BerkeleySocketServerEvent
+{
+    BERKELEYSOCKETSERVER_EVENT_CONNECT,  /**< A new client has been accepted */
+    BERKELEYSOCKETSERVER_EVENT_READ,     /**< Data (or the peer's shutdown) is available for reading */
+    BERKELEYSOCKETSERVER_EVENT_WRITE,    /**< The socket is writable again, see BerkeleySocketServer_setWriteEvents() */
+    BERKELEYSOCKETSERVER_EVENT_CLOSE     /**< The client is going to be closed and released */
+}
+BerkeleySocketServerEvent;
+
+
+typedef bool (*BerkeleySocketServerEventCallBack)( BerkeleySocket *client,
+                                                    BerkeleySocketServerEvent event,
+                                                    void *data );
+
+
 BerkeleySocketServer *BerkeleySocketServer_new( void );
 
 /*!
@@ -166,6 +188,76 @@ void BerkeleySocketServer_loop( BerkeleySocketServer *self,
                                 void *data2,
                                 long timeout );
 
+/*!
+ * \brief Event driven server loop multiplexing many clients
+ * \param self BerkeleySocketServer instance pointer
+ * \param eventCallBack Function called for each event of each client
+ * \param data1 User's data for the \a eventCallBack function
+ * \param timeoutCallBack Function call back when no event occurs within \a timeout
+ * \param data2 User's data for the \a timeoutCallBack function
+ * \param timeout Timeout expressed in microseconds, \a 0 waits forever
+ * \param workQueue Optional WorkQueue where to dispatch the client events, or \a NULL
+ *
+ * Unlike \a BerkeleySocketServer_loop(), which serves one client after the other, this
+ * loop keeps all the accepted TCP clients open and waits for all of them at once by
+ * using the Linux epoll facility in edge-triggered mode, so there is no limit on the
+ * number of clients apart from the process' file descriptors. The listening socket and
+ * all the clients are switched to non-blocking mode.
+ *
+ * Each client is represented by a BerkeleySocket owned by the loop, which is passed to
+ * \a eventCallBack together with the \a BerkeleySocketServerEvent that occurred. The
+ * \a BERKELEYSOCKETSERVER_EVENT_CONNECT is always the first and the
+ * \a BERKELEYSOCKETSERVER_EVENT_CLOSE always the last event of a client; after the latter
+ * the BerkeleySocket is released and must not be used anymore. Returning \a false from
+ * \a eventCallBack closes the client. Because the events are edge-triggered, on
+ * \a BERKELEYSOCKETSERVER_EVENT_READ the callback should read until \a BerkeleySocket_read()
+ * fails with \a EAGAIN, otherwise it is not called again until new data arrives.
+ *
+ * If \a workQueue is \a NULL all the callbacks run in the calling thread, so a slow
+ * callback still delays the other clients. Otherwise every ready client is handed over
+ * to \a workQueue and the callbacks of different clients run in parallel, while the events
+ * of the same client are never delivered concurrently.
+ *
+ * If no event occurs within \a timeout the \a timeoutCallBack is called with the listening
+ * BerkeleySocket, like in \a BerkeleySocketServer_loop(). The loop quits when
+ * \a timeoutCallBack returns \a true or \a BerkeleySocketServer_stopEventLoop() is called.
+ * On exit all the remaining clients receive a \a BERKELEYSOCKETSERVER_EVENT_CLOSE and are closed.
+ *
+ * \return Return \a true if the loop quit regularly, \a false on error or if the
+ *         platform does not support it
+ */
+bool BerkeleySocketServer_eventLoop( BerkeleySocketServer *self,
+                                     BerkeleySocketServerEventCallBack eventCallBack,
+                                     void *data1,
+                                     bool (*timeoutCallBack)( BerkeleySocket *, void * ),
+                                     void *data2,
+                                     long timeout,
+                                     WorkQueue *workQueue );
+
+/*!
+ * \brief Makes \a BerkeleySocketServer_eventLoop() return
+ * \param self BerkeleySocketServer instance pointer
+ *
+ * This function may be called from any thread, including the event callbacks, while the
+ * \a BerkeleySocketServer_eventLoop() is running.
+ *
+ * \return Return \a true on success, \a false if the event loop was never started
+ */
+bool BerkeleySocketServer_stopEventLoop( BerkeleySocketServer *self );
+
+/*!
+ * \brief Enables the BERKELEYSOCKETSERVER_EVENT_WRITE events of a client
+ * \param self BerkeleySocketServer instance pointer
+ * \param client Client BerkeleySocket as passed to the event callback
+ * \param enable \a true to get notified when \a client becomes writable
+ *
+ * By default clients only report readability. A callback which got \a EAGAIN from
+ * \a BerkeleySocket_write() enables the write events to resume sending later on, and
+ * disables them again once its output is flushed. This function may only be called from
+ * the event callback of \a client.
+ */
+void BerkeleySocketServer_setWriteEvents( BerkeleySocketServer *self, BerkeleySocket *client, bool enable );
+
 void BerkeleySocketServer_disconnect( BerkeleySocketServer *self );
 
 void BerkeleySocketServer_clear( BerkeleySocketServer *self );
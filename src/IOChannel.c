@@ -30,6 +30,15 @@
 
 #include <unistd.h>
 #include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#endif
+
+#if defined(__linux__)
+
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
 
 #else
 
@@ -62,6 +71,16 @@
 
 #define IOCHANNEL_WRITEBUFFER_DEFAULT         ( 1024 )
 #define IOCHANNEL_UNGETBUFFER_DEFAULT         ( 1024 )
+#define IOCHANNEL_READBUFFER_DEFAULT          ( 4096 )
+
+/* elements submitted per writev()/readv() call, well below IOV_MAX */
+#define IOCHANNEL_IOVEC_MAX                   ( 64 )
+
+/* buffer used by IOChannel_transfer() when the kernel cannot do the copy */
+#define IOCHANNEL_TRANSFER_BUFFERSIZE         ( 64 * 1024 )
+
+/* largest chunk given to a single sendfile()/splice() call */
+#define IOCHANNEL_TRANSFER_CHUNK              ( 1024 * 1024 * 1024 )
 
 #define IOCHANNEL_SELECT_TIMEOUT_USEC         ( 1000 )
 
@@ -361,6 +380,20 @@ static long IOChannel_popFromUngetBuffer( IOChannel *self, void *buff, long size
 
 static long IOChannel_pushIntoUngetBuffer( IOChannel *self, void *buff, long size );
 
+static long IOChannel_readFromReadBuffer( IOChannel *self, void *buffer, long size );
+
+static long IOChannel_streamRead( IOChannel *self, void *buffer, long size );
+
+static long IOChannel_streamWrite( IOChannel *self, const void *buffer, long size );
+
+static long IOChannel_streamFlush( IOChannel *self );
+
+static void IOChannelStats_addLatency( unsigned long long *histogram, unsigned long long start );
+
+static void IOChannel_moveReadBufferIntoUngetBuffer( IOChannel *self );
+
+static bool IOChannel_alignReadBufferForWrite( IOChannel *self );
+
 static IOChannelBuffer *IOChannelBuffer_new( void );
 
 static bool IOChannelBuffer_init( IOChannelBuffer *self, long defaultSize );
@@ -400,6 +433,22 @@ static void IOChannel_scanItemInternal( IOChannel *self, char *buffer, bool isFl
 static long IOChannel_readInternal( IOChannel *self, void *buffer, long size );
 static long IOChannel_writeInternal( IOChannel *self, const void *buffer, long size );
 
+static int IOChannel_getVectorIOFd( IOChannel *self );
+static long IOChannel_writevEmulated( IOChannel *self, const IOChannelIOVec *vector, int count );
+static long IOChannel_readvEmulated( IOChannel *self, const IOChannelIOVec *vector, int count );
+
+#if !defined(__windows__)
+static long IOChannel_writevFd( IOChannel *self, int fd, const IOChannelIOVec *vector, int count );
+static long IOChannel_readvFd( IOChannel *self, int fd, const IOChannelIOVec *vector, int count );
+#endif
+
+static long long IOChannel_transferEmulated( IOChannel *self, IOChannel *source, long long size );
+
+#if defined(__linux__)
+static long long IOChannel_transferFd( IOChannel *self, int fd, IOChannel *source, int sourceFd,
+                                       long long size, bool *isSupported );
+#endif
+
 #if defined(__windows__)
 static int IOChannel_isSocket( int fd );
 #endif
@@ -415,6 +464,7 @@ extern IOCHANNELINTERFACE_DECLARE_OPTIONS( AnsiFILE );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Calc );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Fd );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( File );
+extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Filter );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Mem );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( MemMapFd );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Null );
@@ -423,13 +473,16 @@ extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Rand );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( RTBOS );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( ServerTcp );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( ServerUdp );
+extern IOCHANNELINTERFACE_DECLARE_OPTIONS( ServerUnix );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Shm );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Socket );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( StdErr );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( StdIn );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( StdOut );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Tcp );
+extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Tee );
 extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Udp );
+extern IOCHANNELINTERFACE_DECLARE_OPTIONS( Unix );
 
 /*
  * Declare a static vector of pointer to Ops
@@ -440,6 +493,7 @@ static IOChannelInterface *IOChannel_internalStreams[] =
                 &IOCHANNELINTERFACE_OPTIONS( Calc ),
                 &IOCHANNELINTERFACE_OPTIONS( Fd ),
                 &IOCHANNELINTERFACE_OPTIONS( File ),
+                &IOCHANNELINTERFACE_OPTIONS( Filter ),
                 &IOCHANNELINTERFACE_OPTIONS( Mem ),
                 &IOCHANNELINTERFACE_OPTIONS( MemMapFd ),
                 &IOCHANNELINTERFACE_OPTIONS( Null ),
@@ -448,13 +502,16 @@ static IOChannelInterface *IOChannel_internalStreams[] =
                 &IOCHANNELINTERFACE_OPTIONS( RTBOS ),
                 &IOCHANNELINTERFACE_OPTIONS( ServerTcp ),
                 &IOCHANNELINTERFACE_OPTIONS( ServerUdp ),
+                &IOCHANNELINTERFACE_OPTIONS( ServerUnix ),
                 &IOCHANNELINTERFACE_OPTIONS( Shm ),
                 &IOCHANNELINTERFACE_OPTIONS( Socket ),
                 &IOCHANNELINTERFACE_OPTIONS( StdErr ),
                 &IOCHANNELINTERFACE_OPTIONS( StdIn ),
                 &IOCHANNELINTERFACE_OPTIONS( StdOut ),
                 &IOCHANNELINTERFACE_OPTIONS( Tcp ),
+                &IOCHANNELINTERFACE_OPTIONS( Tee ),
                 &IOCHANNELINTERFACE_OPTIONS( Udp ),
+                &IOCHANNELINTERFACE_OPTIONS( Unix ),
 
                 /* termination */
                 NULL
@@ -490,6 +547,11 @@ bool IOChannel_init( IOChannel *self )
     self->writeBuffer = IOChannelBuffer_new();
     IOChannelBuffer_init( self->writeBuffer, IOCHANNEL_WRITEBUFFER_DEFAULT);
 
+    self->readBuffer = IOChannelBuffer_new();
+    IOChannelBuffer_init( self->readBuffer, IOCHANNEL_READBUFFER_DEFAULT);
+
+    self->stats = (IOChannelStats *)NULL;
+
     self->valid = IOCHANNEL_VALID;
 
     IOChannel_resetValuesForNewOpen( self );
@@ -523,6 +585,7 @@ bool IOChannel_open( IOChannel *self,
 
     IOChannelBuffer_atOpen( self->ungetBuffer );
     IOChannelBuffer_atOpen( self->writeBuffer );
+    IOChannelBuffer_atOpen( self->readBuffer );
 
     va_start( varArg, permissions );
     /* Vararg is needed to load an user interface argument */
@@ -644,6 +707,7 @@ bool IOChannel_openFromString( IOChannel *self, const char *openString, ... )
 
     IOChannelBuffer_atOpen( self->ungetBuffer );
     IOChannelBuffer_atOpen( self->writeBuffer );
+    IOChannelBuffer_atOpen( self->readBuffer );
 
     self->currInterface = IOChannel_findInterface( self, typeStream, &subInfoString );
 
@@ -1198,6 +1262,202 @@ long IOChannel_writeBlock( IOChannel *self, const void *buffer, long size )
 }
 
 
+long IOChannel_writev( IOChannel *self, const IOChannelIOVec *vector, int count )
+{
+    IOChannelBuffer *writeBuffer = (IOChannelBuffer *)NULL;
+    long totalSize = 0;
+    long retVal = -1;
+    int fd = -1;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+    ANY_REQUIRE_MSG( count >= 0, "Count must be a positive number" );
+    ANY_REQUIRE( vector || count == 0 );
+    ANY_REQUIRE( self->writeBuffer );
+    ANY_REQUIRE( self->ungetBuffer );
+    IOCHANNEL_REQUIRE_INTERFACE( self, indirectWrite );
+
+    if( IOChannel_isCallAllowedCheck( self ) && IOChannel_isNotRdOnlyCheck( self ) )
+    {
+        writeBuffer = self->writeBuffer;
+
+        for( i = 0; i < count; i++ )
+        {
+            ANY_REQUIRE_MSG( vector[ i ].size >= 0, "Size must be a positive number" );
+            totalSize += vector[ i ].size;
+        }
+
+        fd = IOChannel_getVectorIOFd( self );
+
+        if( fd != -1 && self->readBuffer->index < self->readBuffer->length )
+        {
+            if( IOChannel_alignReadBufferForWrite( self ) == false )
+            {
+                ANY_LOG( 0, "IOChannel_writev. Unable to discard read-ahead data before write", ANY_LOG_ERROR );
+                goto outLabel;
+            }
+        }
+
+        /*
+         * Writing to a file with ungetted bytes requires to seek back first,
+         * and auto-resized buffers must keep all the data until flush,
+         * leave both to the plain write path
+         */
+        if(( fd == -1 ) ||
+           ( self->type == IOCHANNELTYPE_FD && self->ungetBuffer->index > 0 ) ||
+           ( IOChannel_usesWriteBuffering( self ) &&
+             (( self->writeBufferIsExternal == false && self->autoResize ) ||
+              totalSize <= (long)( writeBuffer->size - writeBuffer->index ))))
+        {
+            retVal = IOChannel_writevEmulated( self, vector, count );
+        }
+#if !defined(__windows__)
+        else
+        {
+            retVal = IOChannel_writevFd( self, fd, vector, count );
+        }
+#endif
+    }
+
+    outLabel:
+    return retVal;
+}
+
+
+long IOChannel_readv( IOChannel *self, const IOChannelIOVec *vector, int count )
+{
+    long retVal = -1;
+    int fd = -1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+    ANY_REQUIRE_MSG( count >= 0, "Count must be a positive number" );
+    ANY_REQUIRE( vector || count == 0 );
+    ANY_REQUIRE( self->ungetBuffer );
+    IOCHANNEL_REQUIRE_INTERFACE( self, indirectRead );
+
+    if( IOChannel_isCallAllowedCheck( self ) && IOChannel_isNotWrOnlyCheck( self ) )
+    {
+        fd = IOChannel_getVectorIOFd( self );
+
+        if(( fd == -1 ) ||
+           ( self->ungetBuffer->index > 0 ) ||
+           ( self->readBuffer->index < self->readBuffer->length ))
+        {
+            retVal = IOChannel_readvEmulated( self, vector, count );
+        }
+#if !defined(__windows__)
+        else
+        {
+            retVal = IOChannel_readvFd( self, fd, vector, count );
+        }
+#endif
+    }
+
+    return retVal;
+}
+
+
+long long IOChannel_transfer( IOChannel *self, IOChannel *source, long long size )
+{
+    long long retVal = -1;
+    long long buffered = 0;
+    long long nBytes = 0;
+    bool isSupported = false;
+    int sourceFd = -1;
+    int fd = -1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+    ANY_REQUIRE( source );
+    ANY_REQUIRE( source->valid == IOCHANNEL_VALID );
+    ANY_REQUIRE( self != source );
+    ANY_REQUIRE_MSG( size >= 0, "Size must be a positive number" );
+
+    if( !IOChannel_isCallAllowedCheck( self ) || !IOChannel_isNotRdOnlyCheck( self ) ||
+        !IOChannel_isCallAllowedCheck( source ) || !IOChannel_isNotWrOnlyCheck( source ))
+    {
+        goto outLabel;
+    }
+
+    retVal = 0;
+
+#if defined(__linux__)
+    fd = IOChannel_getVectorIOFd( self );
+    sourceFd = IOChannel_getVectorIOFd( source );
+
+    if( fd != -1 && sourceFd != -1 )
+    {
+        /* bytes already in user space go first, through the buffer */
+        buffered = source->ungetBuffer->index;
+
+        if( source->readBuffer->index < source->readBuffer->length )
+        {
+            buffered += source->readBuffer->length - source->readBuffer->index;
+        }
+
+        if( buffered > 0 )
+        {
+            nBytes = IOChannel_transferEmulated( self, source, buffered < size ? buffered : size );
+
+            if( nBytes < ( buffered < size ? buffered : size ))
+            {
+                retVal = nBytes;
+                goto outLabel;
+            }
+
+            retVal = nBytes;
+        }
+
+        /* the kernel writes behind the write buffers, empty them first */
+        if(( self->writeBuffer->index > 0 && IOChannel_flush( self ) == -1 ) ||
+           ( !IOCHANNEL_MODEIS_R_ONLY( source->mode ) && source->writeBuffer->index > 0 &&
+             IOChannel_flush( source ) == -1 ))
+        {
+            goto outLabel;
+        }
+
+        if( retVal < size )
+        {
+            nBytes = IOChannel_transferFd( self, fd, source, sourceFd, size - retVal, &isSupported );
+
+            if( nBytes > 0 )
+            {
+                retVal += nBytes;
+            }
+
+            if( isSupported )
+            {
+                if( nBytes == -1 && retVal == 0 )
+                {
+                    retVal = -1;
+                }
+                goto outLabel;
+            }
+        }
+    }
+#endif
+
+    if( retVal < size )
+    {
+        nBytes = IOChannel_transferEmulated( self, source, size - retVal );
+
+        if( nBytes > 0 )
+        {
+            retVal += nBytes;
+        }
+        else if( nBytes == -1 && retVal == 0 )
+        {
+            retVal = -1;
+        }
+    }
+
+    outLabel:
+    return retVal;
+}
+
+
 long IOChannel_unget( IOChannel *self, void *buffer, long size )
 {
     long retVal = -1;
@@ -1252,12 +1512,18 @@ long IOChannel_flush( IOChannel *self )
 {
     IOChannelBuffer *writeBuffer = (IOChannelBuffer *)NULL;
     long retVal = 0;
+    bool flushed = false;
 
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
 
     if( IOChannel_isOpenCheck( self ) )
     {
+        if( self->stats )
+        {
+            self->stats->flushCalls++;
+        }
+
         if( IOChannel_usesWriteBuffering( self ) )
         {
             writeBuffer = self->writeBuffer;
@@ -1270,9 +1536,14 @@ long IOChannel_flush( IOChannel *self )
                 ANY_LOG( 12, "Flushing The buffer..", ANY_LOG_INFO );
 
                 IOCHANNEL_REQUIRE_INTERFACE( self, indirectFlush );
-                retVal = IOCHANNELINTERFACE_FLUSH( self );
+                retVal = IOChannel_streamFlush( self );
                 if( retVal != -1 )
                 {
+                    if( self->stats )
+                    {
+                        self->stats->flushBytes += writeBuffer->index;
+                    }
+
                     writeBuffer->index = 0;
                 }
                 else
@@ -1280,8 +1551,19 @@ long IOChannel_flush( IOChannel *self )
                     ANY_REQUIRE_MSG( IOChannel_isErrorSet( self ),
                                      "Low Level Flush returned -1, but error was not set!" );
                 }
+                flushed = true;
             }
         }
+
+        if( ( self->usesAsyncIO || self->usesBatching ) && !flushed )
+        {
+            /* nothing buffered here, but the stream must drain its in-flight or batched I/O */
+            IOCHANNEL_REQUIRE_INTERFACE( self, indirectFlush );
+            retVal = IOChannel_streamFlush( self );
+
+            ANY_REQUIRE_MSG( retVal != -1 || IOChannel_isErrorSet( self ),
+                             "Low Level Flush returned -1, but error was not set!" );
+        }
     }
     return retVal;
 }
@@ -1319,7 +1601,11 @@ bool IOChannel_isReadDataAvailable( IOChannel *self )
     {
         if( IOChannel_isNotWrOnlyCheck( self ) )
         {
-            if( IOChannel_hasFd( self ) )
+            if( IOChannel_getReadBufferedBytes( self ) > 0 )
+            {
+                retVal = true;
+            }
+            else if( IOChannel_hasFd( self ) )
             {
                 sockFdPtr = NULL;
 
@@ -1523,6 +1809,7 @@ long IOChannel_getReadBytes( IOChannel *self )
 
 long IOChannel_seek( IOChannel *self, long offset, IOChannelWhence whence )
 {
+    IOChannelBuffer *readBuffer = (IOChannelBuffer *)NULL;
     long retVal = -1;
 
     ANY_REQUIRE( self );
@@ -1532,6 +1819,28 @@ long IOChannel_seek( IOChannel *self, long offset, IOChannelWhence whence )
     {
         if( IOChannel_flush( self ) != -1 )
         {
+            readBuffer = self->readBuffer;
+            ANY_REQUIRE( readBuffer );
+
+            if( ( whence == IOCHANNELWHENCE_CUR ) &&
+                ( readBuffer->length > 0 ) &&
+                ( self->ungetBuffer->index == 0 ) &&
+                ( offset >= -readBuffer->index ) &&
+                ( offset <= readBuffer->length - readBuffer->index ) )
+            {
+                /* target lies within the read-ahead data, no need to call the stream */
+                readBuffer->index += offset;
+                self->currentIndexPosition += offset;
+                retVal = (long)self->currentIndexPosition;
+                goto outLabel;
+            }
+
+            /*
+             * from the stream's point of view read-ahead data has been read
+             * and ungetted, so its seek implementation takes care of it
+             */
+            IOChannel_moveReadBufferIntoUngetBuffer( self );
+
             IOCHANNEL_REQUIRE_INTERFACE( self, indirectSeek );
             retVal = (long)IOCHANNELINTERFACE_SEEK( self, offset, whence );
 
@@ -1552,6 +1861,7 @@ long IOChannel_seek( IOChannel *self, long offset, IOChannelWhence whence )
         }
     }
 
+    outLabel:
     return retVal;
 }
 
@@ -1611,8 +1921,10 @@ bool IOChannel_eof( IOChannel *self )
         ungetBuffer = self->ungetBuffer;
         ANY_REQUIRE( ungetBuffer );
         ANY_REQUIRE( ungetBuffer->index >= 0 );
+        ANY_REQUIRE( self->readBuffer );
 
-        if(( self->foundEof ) && ( ungetBuffer->index == 0 ))
+        if(( self->foundEof ) && ( ungetBuffer->index == 0 ) &&
+           ( self->readBuffer->index == self->readBuffer->length ))
         {
             retVal = true;
         }
@@ -1864,6 +2176,7 @@ bool IOChannel_close( IOChannel *self )
         {
             IOChannelBuffer_atClose( self->ungetBuffer );
             IOChannelBuffer_atClose( self->writeBuffer );
+            IOChannelBuffer_atClose( self->readBuffer );
 
             /* Closing stream and relasing resouces */
             retVal = IOCHANNELINTERFACE_CLOSE( self );
@@ -1914,7 +2227,12 @@ void *IOChannel_getProperty( IOChannel *self, const char *propertyName )
     ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
     ANY_REQUIRE_MSG( propertyName, "Not Valid Property Name To Get" );
 
-    if( IOChannel_isOpenCheck( self ) )
+    /* available for any stream, also when closed */
+    if( Any_strcasecmp( propertyName, "Stats" ) == 0 )
+    {
+        retVal = self->stats;
+    }
+    else if( IOChannel_isOpenCheck( self ) )
     {
         IOCHANNEL_REQUIRE_INTERFACE( self, indirectGetProperty );
         retVal = IOCHANNELINTERFACE_GETPROPERTY( self, propertyName );
@@ -1933,7 +2251,29 @@ bool IOChannel_setProperty( IOChannel *self, const char *propertyName,
     ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
     ANY_REQUIRE_MSG( propertyName, "Not Valid Property Name To Set" );
 
-    if( IOChannel_isOpenCheck( self ) )
+    if( Any_strcasecmp( propertyName, "Stats" ) == 0 )
+    {
+        if( propertyValue )
+        {
+            if( !self->stats )
+            {
+                self->stats = ANY_TALLOC( IOChannelStats );
+                ANY_REQUIRE_MSG( self->stats, "Unable to allocate memory for the statistics" );
+            }
+            else
+            {
+                Any_memset( self->stats, 0, sizeof( IOChannelStats ));
+            }
+        }
+        else
+        {
+            ANY_FREE( self->stats );
+            self->stats = (IOChannelStats *)NULL;
+        }
+
+        retVal = true;
+    }
+    else if( IOChannel_isOpenCheck( self ) )
     {
         IOCHANNEL_REQUIRE_INTERFACE( self, indirectGetProperty );
         retVal = IOCHANNELINTERFACE_SETPROPERTY( self, propertyName, propertyValue );
@@ -2122,6 +2462,73 @@ void *IOChannel_getInternalWriteBufferPtr( IOChannel *self )
 }
 
 
+void IOChannel_setReadBuffer( IOChannel *self, void *buffer, long size )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+    ANY_REQUIRE_MSG( size > 0, "IOChannel_setReadBuffer: bad buffer size!" );
+
+    if( IOChannel_hasPointer( self ) == false )
+    {
+        ANY_REQUIRE( self->readBuffer );
+
+        /* do not lose data which was already read ahead */
+        IOChannel_moveReadBufferIntoUngetBuffer( self );
+
+        if( self->readBuffer->freeOnExit )
+        {
+            ANY_FREE( self->readBuffer->ptr );
+        }
+
+        IOChannelBuffer_set( self->readBuffer, buffer, size );
+    }
+}
+
+
+bool IOChannel_setUseReadBuffering( IOChannel *self, bool useBuffering )
+{
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+
+    if( IOChannel_hasPointer( self ) == false )
+    {
+        if( useBuffering == false )
+        {
+            IOChannel_moveReadBufferIntoUngetBuffer( self );
+        }
+        self->usesReadBuffering = useBuffering;
+        retVal = true;
+    }
+
+    return retVal;
+}
+
+
+bool IOChannel_usesReadBuffering( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+
+    return self->usesReadBuffering;
+}
+
+
+long IOChannel_getReadBufferedBytes( IOChannel *self )
+{
+    IOChannelBuffer *readBuffer = (IOChannelBuffer *)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == IOCHANNEL_VALID );
+
+    readBuffer = self->readBuffer;
+    ANY_REQUIRE( readBuffer );
+
+    return (long)( readBuffer->length - readBuffer->index );
+}
+
+
 long long IOChannel_getStreamPosition( IOChannel *self )
 {
     ANY_REQUIRE( self );
@@ -2158,6 +2565,11 @@ void IOChannel_clear( IOChannel *self )
     IOChannelBuffer_clear( self->writeBuffer );
     IOChannelBuffer_delete( self->writeBuffer );
 
+    IOChannelBuffer_clear( self->readBuffer );
+    IOChannelBuffer_delete( self->readBuffer );
+
+    ANY_FREE( self->stats );
+
     IOChannel_resetObject( self );
 }
 
@@ -3581,7 +3993,7 @@ static long IOChannel_popFromUngetBuffer( IOChannel *self,
      */
     /* ANY_REQUIRE( ptr ); */
 
-    while(( i < size ) && ( i <= ungetBuffer->index ))
+    while(( i < size ) && ( i < ungetBuffer->index ))
     {
         *ptr++ = *--stackTop;
         i++;
@@ -3648,6 +4060,9 @@ static void IOChannel_resetValuesForNewOpen( IOChannel *self )
     self->streamPtr = (void *)NULL;
     self->isOpen = false;
     self->usesWriteBuffering = false;
+    self->usesReadBuffering = false;
+    self->usesAsyncIO = false;
+    self->usesBatching = false;
     self->writeBufferIsExternal = false;
     self->autoResize = false;
     self->mode = 0;
@@ -3669,6 +4084,7 @@ static void IOChannel_resetObject( IOChannel *self )
     IOChannel_resetValuesForNewOpen( self );
 
     self->userStream = (MTList *)NULL;
+    self->stats = (IOChannelStats *)NULL;
 }
 
 
@@ -3696,6 +4112,7 @@ static bool IOChannelBuffer_init( IOChannelBuffer *self, long defaultSize )
     self->ptr = NULL;
     self->size = 0;
     self->index = 0;
+    self->length = 0;
     self->freeOnExit = false;
 
     return retVal;
@@ -3709,6 +4126,7 @@ static void IOChannelBuffer_atOpen( IOChannelBuffer *self )
     self->ptr = self->defaultBuffer;
     self->size = self->defaultSize;
     self->index = 0;
+    self->length = 0;
     self->freeOnExit = false;
 }
 
@@ -3731,6 +4149,7 @@ static void IOChannelBuffer_set( IOChannelBuffer *self, void *ptr, long size )
     }
 
     self->index = 0;
+    self->length = 0;
     self->size = size;
 }
 
@@ -3748,6 +4167,7 @@ static void IOChannelBuffer_atClose( IOChannelBuffer *self )
     self->ptr = self->defaultBuffer;
     self->size = self->defaultSize;
     self->index = 0;
+    self->length = 0;
     self->freeOnExit = false;
 }
 
@@ -3764,6 +4184,7 @@ static void IOChannelBuffer_clear( IOChannelBuffer *self )
     self->ptr = (void *)NULL;
     self->size = 0;
     self->index = 0;
+    self->length = 0;
     self->freeOnExit = false;
 }
 
@@ -4114,35 +4535,293 @@ static int IOChannel_writeEscapedChar( IOChannel *self, char ch )
 }
 
 
-static long IOChannel_readInternal( IOChannel *self, void *buffer, long size )
+static long IOChannel_readFromReadBuffer( IOChannel *self, void *buffer, long size )
 {
-    IOChannelBuffer *ungetBuffer = (IOChannelBuffer *)NULL;
+    IOChannelBuffer *readBuffer = (IOChannelBuffer *)NULL;
+    long available = 0;
     long retVal = -1;
-    long rdFromUngetBuff = 0;
-    long rdFromStream = 0;
-    long bytesToRead = 0;
-    char *ptr = (char *)NULL;
+    bool foundEof = false;
 
-    ungetBuffer = self->ungetBuffer;
-    /* The following check has been removed to avoid performing it multiple
-     *  times inside loops. It is required that functions calling this one
-     *  perform this check.
-     */
-    /* ANY_REQUIRE( ungetBuffer ); */
+    readBuffer = self->readBuffer;
 
-    if( size == 0 )
-    {
-        ANY_LOG( 5, "IOChannel_readInternal was called with size = 0...", ANY_LOG_WARNING );
-        retVal = 0;
-        goto outLabel;
-    }
+    available = (long)( readBuffer->length - readBuffer->index );
 
-    /* If R_ONLY, do not need flushing.. */
-    if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    if( available == 0 )
     {
-        if( IOChannel_flush( self ) == -1 )
+        readBuffer->index = 0;
+        readBuffer->length = 0;
+
+        /* Large requests bypass the buffer, avoiding one extra copy */
+        if( size >= readBuffer->size )
         {
-            ANY_LOG( 5, "IOChannel_readInternal. Unable to flush write buffer before read data", ANY_LOG_ERROR );
+            retVal = IOChannel_streamRead( self, buffer, size );
+            goto outLabel;
+        }
+
+        /*
+         * Streams flag EOF upon short reads, but a short refill only means
+         * that less than a whole buffer was available. EOF is raised again
+         * by the refill which does not deliver any data at all.
+         */
+        foundEof = self->foundEof;
+
+        available = IOChannel_streamRead( self, readBuffer->ptr, readBuffer->size );
+
+        if( available <= 0 )
+        {
+            retVal = available;
+            goto outLabel;
+        }
+
+        self->foundEof = foundEof;
+        readBuffer->length = available;
+    }
+
+    retVal = size < available ? size : available;
+
+    Any_memcpy( buffer, (char *)readBuffer->ptr + readBuffer->index, retVal );
+    readBuffer->index += retVal;
+
+    outLabel:
+    return retVal;
+}
+
+
+static long IOChannel_streamRead( IOChannel *self, void *buffer, long size )
+{
+    unsigned long long start = 0;
+    long retVal = -1;
+
+    if( !self->stats )
+    {
+        return IOCHANNELINTERFACE_READ( self, buffer, size );
+    }
+
+    start = Any_getTime();
+
+    retVal = IOCHANNELINTERFACE_READ( self, buffer, size );
+
+    IOChannelStats_addLatency( self->stats->readLatency, start );
+    self->stats->streamReads++;
+
+    if( retVal >= 0 && retVal < size )
+    {
+        self->stats->shortReads++;
+    }
+
+    return retVal;
+}
+
+
+static long IOChannel_streamWrite( IOChannel *self, const void *buffer, long size )
+{
+    unsigned long long start = 0;
+    long retVal = -1;
+
+    if( !self->stats )
+    {
+        return IOCHANNELINTERFACE_WRITE( self, buffer, size );
+    }
+
+    start = Any_getTime();
+
+    retVal = IOCHANNELINTERFACE_WRITE( self, buffer, size );
+
+    IOChannelStats_addLatency( self->stats->writeLatency, start );
+    self->stats->streamWrites++;
+
+    if( retVal >= 0 && retVal < size )
+    {
+        self->stats->shortWrites++;
+    }
+
+    return retVal;
+}
+
+
+static long IOChannel_streamFlush( IOChannel *self )
+{
+    unsigned long long start = 0;
+    long retVal = -1;
+
+    if( !self->stats )
+    {
+        return IOCHANNELINTERFACE_FLUSH( self );
+    }
+
+    start = Any_getTime();
+
+    retVal = IOCHANNELINTERFACE_FLUSH( self );
+
+    IOChannelStats_addLatency( self->stats->flushLatency, start );
+    self->stats->streamFlushes++;
+
+    return retVal;
+}
+
+
+static void IOChannelStats_addLatency( unsigned long long *histogram, unsigned long long start )
+{
+    unsigned long long elapsed = Any_getTime() - start;
+    int bucket = 0;
+
+    /* log2 of the nanoseconds */
+    while( elapsed > 1 && bucket < IOCHANNELSTATS_HISTOGRAM_BUCKETS - 1 )
+    {
+        elapsed >>= 1;
+        bucket++;
+    }
+
+    histogram[bucket]++;
+}
+
+
+static void IOChannel_moveReadBufferIntoUngetBuffer( IOChannel *self )
+{
+    IOChannelBuffer *readBuffer = (IOChannelBuffer *)NULL;
+    IOChannelBuffer *ungetBuffer = (IOChannelBuffer *)NULL;
+    char *src = (char *)NULL;
+    char *dst = (char *)NULL;
+    void *newBuffer = (void *)NULL;
+    long available = 0;
+    long i = 0;
+
+    readBuffer = self->readBuffer;
+    ANY_REQUIRE( readBuffer );
+
+    ungetBuffer = self->ungetBuffer;
+    ANY_REQUIRE( ungetBuffer );
+
+    available = (long)( readBuffer->length - readBuffer->index );
+
+    if( available > 0 )
+    {
+        if( ungetBuffer->index + available > ungetBuffer->size )
+        {
+            newBuffer = ANY_BALLOC( ungetBuffer->index + available );
+            ANY_REQUIRE( newBuffer );
+
+            ANY_LOG( 12, "Growing unget buffer to take read-ahead data "
+                         "(oldBufferSize[%ld], newBufferSize[%ld])",
+                     ANY_LOG_INFO, ungetBuffer->size, (long)( ungetBuffer->index + available ) );
+
+            Any_memcpy( newBuffer, ungetBuffer->ptr, ungetBuffer->index );
+
+            if( ungetBuffer->freeOnExit )
+            {
+                ANY_FREE( ungetBuffer->ptr );
+            }
+
+            ungetBuffer->ptr = newBuffer;
+            ungetBuffer->size = ungetBuffer->index + available;
+            ungetBuffer->freeOnExit = true;
+        }
+
+        /*
+         * Ungetted bytes are read before the read-ahead data, so they are
+         * moved up and stay on top of the stack
+         */
+        dst = (char *)ungetBuffer->ptr;
+        Any_memmove( dst + available, dst, ungetBuffer->index );
+
+        src = (char *)readBuffer->ptr + readBuffer->index;
+
+        for( i = 0; i < available; i++ )
+        {
+            dst[ available - 1 - i ] = src[ i ];
+        }
+
+        ungetBuffer->index += available;
+        self->currentIndexPosition += available;
+    }
+
+    readBuffer->index = 0;
+    readBuffer->length = 0;
+}
+
+
+static bool IOChannel_alignReadBufferForWrite( IOChannel *self )
+{
+    IOChannelBuffer *readBuffer = (IOChannelBuffer *)NULL;
+    int *fdPtr = (int *)NULL;
+    long long position = -1;
+    long available = 0;
+    bool retVal = true;
+
+    readBuffer = self->readBuffer;
+    ANY_REQUIRE( readBuffer );
+
+    available = (long)( readBuffer->length - readBuffer->index );
+
+    /*
+     * Sockets and pipes have independent read and write directions, but on
+     * regular files the fd offset is ahead of the logical position by the
+     * amount of read-ahead data, so we must rewind it before writing.
+     * Ungetted bytes are left to the write path as without read-ahead.
+     */
+    if( self->type == IOCHANNELTYPE_FD )
+    {
+        fdPtr = (int *)IOChannel_getProperty( self, "Fd" );
+
+        if( fdPtr )
+        {
+#if !defined(__windows__)
+            position = lseek( *fdPtr, -available, SEEK_CUR );
+#else
+            position = _lseeki64( *fdPtr, -available, SEEK_CUR );
+#endif
+            if( position == -1 && errno != ESPIPE )
+            {
+                IOChannel_setSysError( self, errno );
+                retVal = false;
+            }
+        }
+    }
+
+    if( position != -1 )
+    {
+        /* the file delivers the read-ahead data again on the next read */
+        readBuffer->index = 0;
+        readBuffer->length = 0;
+    }
+    else
+    {
+        IOChannel_moveReadBufferIntoUngetBuffer( self );
+    }
+
+    return retVal;
+}
+
+
+static long IOChannel_readInternal( IOChannel *self, void *buffer, long size )
+{
+    IOChannelBuffer *ungetBuffer = (IOChannelBuffer *)NULL;
+    long retVal = -1;
+    long rdFromUngetBuff = 0;
+    long rdFromStream = 0;
+    long bytesToRead = 0;
+    char *ptr = (char *)NULL;
+
+    ungetBuffer = self->ungetBuffer;
+    /* The following check has been removed to avoid performing it multiple
+     *  times inside loops. It is required that functions calling this one
+     *  perform this check.
+     */
+    /* ANY_REQUIRE( ungetBuffer ); */
+
+    if( size == 0 )
+    {
+        ANY_LOG( 5, "IOChannel_readInternal was called with size = 0...", ANY_LOG_WARNING );
+        retVal = 0;
+        goto outLabel;
+    }
+
+    /* If R_ONLY, do not need flushing.. */
+    if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    {
+        if( IOChannel_flush( self ) == -1 )
+        {
+            ANY_LOG( 5, "IOChannel_readInternal. Unable to flush write buffer before read data", ANY_LOG_ERROR );
             ANY_REQUIRE_MSG( IOChannel_isErrorSet( self ),
                              "Low Level Flush returned -1, but error was not set!" );
             goto outLabel;
@@ -4166,8 +4845,16 @@ static long IOChannel_readInternal( IOChannel *self, void *buffer, long size )
     {
         ptr = (char *)buffer;
         ptr += rdFromUngetBuff;
-        /* Calling Low Level Read */
-        rdFromStream = IOCHANNELINTERFACE_READ( self, ptr, bytesToRead );
+
+        if( self->usesReadBuffering )
+        {
+            rdFromStream = IOChannel_readFromReadBuffer( self, ptr, bytesToRead );
+        }
+        else
+        {
+            /* Calling Low Level Read */
+            rdFromStream = IOChannel_streamRead( self, ptr, bytesToRead );
+        }
         /* write( STDOUT_FILENO, buffer, size ); */
         if( rdFromStream == -1 )
         {
@@ -4183,6 +4870,12 @@ static long IOChannel_readInternal( IOChannel *self, void *buffer, long size )
     self->rdDeployedBytes += rdFromStream;
     self->rdBytesFromLastWrite += retVal;
 
+    if( self->stats )
+    {
+        self->stats->readCalls++;
+        self->stats->readBytes += retVal;
+    }
+
     outLabel:
     return retVal;
 }
@@ -4283,6 +4976,15 @@ static long IOChannel_writeInternal( IOChannel *self, const void *buffer, long s
      */
     /* ANY_REQUIRE( ungetBuffer ); */
 
+    if( self->readBuffer->index < self->readBuffer->length )
+    {
+        if( IOChannel_alignReadBufferForWrite( self ) == false )
+        {
+            ANY_LOG( 0, "IOChannel_write. Unable to discard read-ahead data before write", ANY_LOG_ERROR );
+            goto outLabel;
+        }
+    }
+
     if(( writeBuffer->index > 0 ) && ( ungetBuffer->index > 0 ))
     {
         bytesBack = (long)( -ungetBuffer->index );
@@ -4299,12 +5001,18 @@ static long IOChannel_writeInternal( IOChannel *self, const void *buffer, long s
     }
 
     /* write( STDOUT_FILENO, buffer, size ); */
-    retVal = IOCHANNELINTERFACE_WRITE( self, buffer, size );
+    retVal = IOChannel_streamWrite( self, buffer, size );
     if( retVal != -1 )
     {
         self->rdBytesFromLastWrite = 0;
         self->wrDeployedBytes += retVal;
         self->currentIndexPosition += retVal;
+
+        if( self->stats )
+        {
+            self->stats->writeCalls++;
+            self->stats->writeBytes += retVal;
+        }
     }
     else
     {
@@ -4315,3 +5023,567 @@ static long IOChannel_writeInternal( IOChannel *self, const void *buffer, long s
     outLabel:
     return retVal;
 }
+
+
+static int IOChannel_getVectorIOFd( IOChannel *self )
+{
+    /* streams whose read()/write() map 1:1 onto their file descriptor */
+    static const char *vectorIOStreams[] = { "Fd", "File", "StdIn", "StdOut", "StdErr",
+                                             "Socket", "Tcp", "ServerTcp", (char *)NULL };
+    int retVal = -1;
+#if !defined(__windows__)
+    const char *streamName = (char *)NULL;
+    int *fdPtr = (int *)NULL;
+    int socketType = 0;
+    socklen_t optionLength = sizeof( socketType );
+    int i = 0;
+
+    if( IOChannel_hasFd( self ) == false )
+    {
+        goto outLabel;
+    }
+
+    streamName = IOChannel_getStreamType( self );
+    ANY_REQUIRE( streamName );
+
+    for( i = 0; vectorIOStreams[ i ]; i++ )
+    {
+        if( Any_strcmp( streamName, vectorIOStreams[ i ] ) == 0 )
+        {
+            break;
+        }
+    }
+
+    if( vectorIOStreams[ i ] == (char *)NULL )
+    {
+        goto outLabel;
+    }
+
+    fdPtr = (int *)IOChannel_getProperty( self, (char *)"Fd" );
+
+    if( fdPtr == (int *)NULL || *fdPtr < 0 )
+    {
+        goto outLabel;
+    }
+
+    /* Socket:// may wrap a datagram socket, which must keep its framing */
+    if( Any_strcmp( streamName, "Socket" ) == 0 )
+    {
+        if( getsockopt( *fdPtr, SOL_SOCKET, SO_TYPE, &socketType, &optionLength ) == -1 ||
+            socketType != SOCK_STREAM )
+        {
+            goto outLabel;
+        }
+    }
+
+    retVal = *fdPtr;
+
+    outLabel:
+#endif
+    return retVal;
+}
+
+
+static long long IOChannel_transferEmulated( IOChannel *self, IOChannel *source, long long size )
+{
+    char *buffer = (char *)NULL;
+    long long retVal = 0;
+    long chunk = 0;
+    long nBytes = 0;
+    long written = 0;
+
+    buffer = (char *)ANY_BALLOC( IOCHANNEL_TRANSFER_BUFFERSIZE );
+    ANY_REQUIRE( buffer );
+
+    while( retVal < size )
+    {
+        chunk = size - retVal < IOCHANNEL_TRANSFER_BUFFERSIZE ?
+                (long)( size - retVal ) : IOCHANNEL_TRANSFER_BUFFERSIZE;
+
+        nBytes = IOChannel_read( source, buffer, chunk );
+
+        if( nBytes <= 0 )
+        {
+            if( nBytes == -1 && retVal == 0 )
+            {
+                retVal = -1;
+            }
+            break;
+        }
+
+        written = IOChannel_writeBlock( self, buffer, nBytes );
+
+        if( written > 0 )
+        {
+            retVal += written;
+        }
+
+        if( written != nBytes )
+        {
+            if( retVal == 0 )
+            {
+                retVal = -1;
+            }
+            break;
+        }
+
+        if( IOChannel_eof( source ))
+        {
+            break;
+        }
+    }
+
+    ANY_FREE( buffer );
+
+    return retVal;
+}
+
+
+#if defined(__linux__)
+
+static long long IOChannel_transferFd( IOChannel *self, int fd, IOChannel *source, int sourceFd,
+                                       long long size, bool *isSupported )
+{
+    enum
+    {
+        TRANSFER_COPYFILERANGE,
+        TRANSFER_SENDFILE,
+        TRANSFER_SPLICE,
+        TRANSFER_NONE
+    } method = TRANSFER_NONE;
+
+    struct stat status;
+    struct stat sourceStatus;
+    long long retVal = 0;
+    long long chunk = 0;
+    ssize_t nBytes = 0;
+    ssize_t moved = 0;
+    ssize_t out = 0;
+    int pipeFds[2] = { -1, -1 };
+    bool isPipe = false;
+    bool isSourcePipe = false;
+    IOChannel *failed = self;
+
+    *isSupported = false;
+
+    if( fstat( fd, &status ) == -1 || fstat( sourceFd, &sourceStatus ) == -1 )
+    {
+        goto outLabel;
+    }
+
+    isPipe = S_ISFIFO( status.st_mode );
+    isSourcePipe = S_ISFIFO( sourceStatus.st_mode );
+
+    /* the best method is tried first, the next one if the kernel refuses it */
+    if( S_ISREG( sourceStatus.st_mode ))
+    {
+        method = S_ISREG( status.st_mode ) ? TRANSFER_COPYFILERANGE : TRANSFER_SENDFILE;
+    }
+    else
+    {
+        method = TRANSFER_SPLICE;
+    }
+
+    while( retVal < size && method != TRANSFER_NONE )
+    {
+        chunk = size - retVal < IOCHANNEL_TRANSFER_CHUNK ? size - retVal : IOCHANNEL_TRANSFER_CHUNK;
+        failed = self;
+
+        switch( method )
+        {
+            case TRANSFER_COPYFILERANGE:
+#if defined(__NR_copy_file_range)
+                nBytes = syscall( __NR_copy_file_range, sourceFd, NULL, fd, NULL, (size_t)chunk, 0 );
+#else
+                nBytes = -1;
+                errno = ENOSYS;
+#endif
+                break;
+
+            case TRANSFER_SENDFILE:
+                nBytes = sendfile( fd, sourceFd, NULL, (size_t)chunk );
+                break;
+
+            case TRANSFER_SPLICE:
+                if( isPipe || isSourcePipe )
+                {
+                    nBytes = splice( sourceFd, NULL, fd, NULL, (size_t)chunk, SPLICE_F_MOVE | SPLICE_F_MORE );
+                    break;
+                }
+
+                /* neither end is a pipe: go through one */
+                if( pipeFds[ 0 ] == -1 && pipe2( pipeFds, O_CLOEXEC ) == -1 )
+                {
+                    failed = source;
+                    nBytes = -1;
+                    break;
+                }
+
+                nBytes = splice( sourceFd, NULL, pipeFds[ 1 ], NULL, (size_t)chunk,
+                                 SPLICE_F_MOVE | SPLICE_F_MORE );
+
+                if( nBytes == -1 )
+                {
+                    failed = source;
+                    break;
+                }
+
+                for( moved = 0; moved < nBytes; moved += out )
+                {
+                    out = splice( pipeFds[ 0 ], NULL, fd, NULL, (size_t)( nBytes - moved ),
+                                  SPLICE_F_MOVE | SPLICE_F_MORE );
+
+                    if( out == -1 && errno == EINTR )
+                    {
+                        out = 0;
+                    }
+                    else if( out <= 0 )
+                    {
+                        break;
+                    }
+                }
+
+                if( moved < nBytes )
+                {
+                    /* the bytes left in the pipe are lost, report the error */
+                    retVal += moved;
+                    IOCHANNEL_SETSYSERRORFROMERRNO( self );
+                    *isSupported = true;
+                    goto outLabel;
+                }
+                break;
+
+            default:
+                nBytes = -1;
+                errno = ENOSYS;
+                break;
+        }
+
+        if( nBytes == -1 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            /* refused before anything was copied: try the next method */
+            if( retVal == 0 && !*isSupported &&
+                ( errno == EINVAL || errno == ENOSYS || errno == EXDEV ||
+                  errno == EOPNOTSUPP || errno == EBADF ))
+            {
+                method = ( method == TRANSFER_COPYFILERANGE ) ? TRANSFER_SENDFILE :
+                         ( method == TRANSFER_SENDFILE ) ? TRANSFER_SPLICE : TRANSFER_NONE;
+                continue;
+            }
+
+            *isSupported = true;
+            IOCHANNEL_SETSYSERRORFROMERRNO( failed );
+            break;
+        }
+
+        *isSupported = true;
+
+        if( nBytes == 0 )
+        {
+            IOCHANNEL_SET_EOF( source );
+            break;
+        }
+
+        retVal += nBytes;
+    }
+
+    if( retVal > 0 )
+    {
+        source->rdDeployedBytes += (long)retVal;
+        source->currentIndexPosition += retVal;
+
+        self->rdBytesFromLastWrite = 0;
+        self->wrDeployedBytes += (long)retVal;
+        self->currentIndexPosition += retVal;
+    }
+
+    outLabel:
+    if( pipeFds[ 0 ] != -1 )
+    {
+        close( pipeFds[ 0 ] );
+        close( pipeFds[ 1 ] );
+    }
+
+    return ( retVal == 0 && *isSupported && ( IOChannel_isErrorOccurred( self ) ||
+                                              IOChannel_isErrorOccurred( source ))) ? -1 : retVal;
+}
+
+#endif
+
+
+static long IOChannel_writevEmulated( IOChannel *self, const IOChannelIOVec *vector, int count )
+{
+    const char *ptr = (char *)NULL;
+    long leftBytes = 0;
+    long written = 0;
+    long sent = 0;
+    int i = 0;
+
+    for( i = 0; i < count; i++ )
+    {
+        ptr = (char *)vector[ i ].buffer;
+        leftBytes = vector[ i ].size;
+
+        while( leftBytes > 0 )
+        {
+            sent = IOChannel_writeInternal( self, ptr, leftBytes );
+
+            if( sent > 0 )
+            {
+                ptr += sent;
+                leftBytes -= sent;
+                written += sent;
+            }
+
+            if( sent <= 0 || IOChannel_eof( self ) || IOChannel_isErrorOccurred( self ) )
+            {
+                goto outLabel;
+            }
+        }
+    }
+
+    outLabel:
+    return ( written == 0 && IOChannel_isErrorOccurred( self ) ) ? -1 : written;
+}
+
+
+static long IOChannel_readvEmulated( IOChannel *self, const IOChannelIOVec *vector, int count )
+{
+    long received = 0;
+    long retVal = 0;
+    int i = 0;
+
+    for( i = 0; i < count; i++ )
+    {
+        if( vector[ i ].size == 0 )
+        {
+            continue;
+        }
+
+        ANY_REQUIRE( vector[ i ].buffer );
+
+        received = IOChannel_readInternal( self, vector[ i ].buffer, vector[ i ].size );
+
+        if( received < 0 )
+        {
+            retVal = ( retVal == 0 ) ? -1 : retVal;
+            break;
+        }
+
+        retVal += received;
+
+        if( received < vector[ i ].size )
+        {
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+
+#if !defined(__windows__)
+
+static long IOChannel_writevFd( IOChannel *self, int fd, const IOChannelIOVec *vector, int count )
+{
+    IOChannelBuffer *writeBuffer = (IOChannelBuffer *)NULL;
+    struct iovec iov[IOCHANNEL_IOVEC_MAX];
+    struct msghdr message;
+    long pending = 0;
+    long flushed = 0;
+    long written = 0;
+    long offset = 0;
+    long nBytes = 0;
+    long chunk = 0;
+    int next = 0;
+    int n = 0;
+    int i = 0;
+
+    writeBuffer = self->writeBuffer;
+
+    /* data still in the write buffer goes out first, in the same call */
+    if( IOChannel_usesWriteBuffering( self ) )
+    {
+        pending = (long)writeBuffer->index;
+    }
+
+    while( flushed < pending || next < count )
+    {
+        n = 0;
+
+        if( flushed < pending )
+        {
+            iov[ n ].iov_base = (char *)writeBuffer->ptr + flushed;
+            iov[ n ].iov_len = pending - flushed;
+            n++;
+        }
+
+        for( i = next; i < count && n < IOCHANNEL_IOVEC_MAX; i++ )
+        {
+            chunk = vector[ i ].size - ( i == next ? offset : 0 );
+
+            if( chunk > 0 )
+            {
+                iov[ n ].iov_base = (char *)vector[ i ].buffer + ( i == next ? offset : 0 );
+                iov[ n ].iov_len = chunk;
+                n++;
+            }
+        }
+
+        if( n == 0 )
+        {
+            break;
+        }
+
+        do
+        {
+            if( self->type == IOCHANNELTYPE_SOCKET )
+            {
+                Any_memset( &message, 0, sizeof( message ) );
+                message.msg_iov = iov;
+                message.msg_iovlen = n;
+
+                nBytes = sendmsg( fd, &message, MSG_NOSIGNAL );
+            }
+            else
+            {
+                nBytes = writev( fd, iov, n );
+            }
+        }
+        while( nBytes == -1 && errno == EINTR );
+
+        if( nBytes == -1 )
+        {
+            IOCHANNEL_SETSYSERRORFROMERRNO( self );
+            break;
+        }
+
+        if( nBytes == 0 )
+        {
+            IOChannel_setError( self, IOCHANNELERROR_BLLW );
+            break;
+        }
+
+        if( flushed < pending )
+        {
+            chunk = ( nBytes < pending - flushed ) ? nBytes : pending - flushed;
+            flushed += chunk;
+            nBytes -= chunk;
+        }
+
+        /* advance over the elements written, skipping the empty ones */
+        while( next < count && nBytes >= vector[ next ].size - offset )
+        {
+            nBytes -= vector[ next ].size - offset;
+            written += vector[ next ].size - offset;
+            offset = 0;
+            next++;
+        }
+
+        offset += nBytes;
+        written += nBytes;
+    }
+
+    if( flushed > 0 )
+    {
+        if( flushed < pending )
+        {
+            Any_memmove( writeBuffer->ptr, (char *)writeBuffer->ptr + flushed, pending - flushed );
+        }
+        writeBuffer->index = pending - flushed;
+    }
+
+    if( written > 0 )
+    {
+        self->rdBytesFromLastWrite = 0;
+        self->wrDeployedBytes += written;
+        self->currentIndexPosition += written;
+    }
+
+    return ( written == 0 && IOChannel_isErrorOccurred( self ) ) ? -1 : written;
+}
+
+
+static long IOChannel_readvFd( IOChannel *self, int fd, const IOChannelIOVec *vector, int count )
+{
+    struct iovec iov[IOCHANNEL_IOVEC_MAX];
+    struct msghdr message;
+    long requested = 0;
+    long retVal = -1;
+    int n = 0;
+    int i = 0;
+
+    /* If R_ONLY, do not need flushing.. */
+    if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    {
+        if( IOChannel_flush( self ) == -1 )
+        {
+            ANY_LOG( 5, "IOChannel_readv. Unable to flush write buffer before read data", ANY_LOG_ERROR );
+            goto outLabel;
+        }
+    }
+
+    /* like read(), a single call which may return less than requested */
+    for( i = 0; i < count && n < IOCHANNEL_IOVEC_MAX; i++ )
+    {
+        if( vector[ i ].size > 0 )
+        {
+            ANY_REQUIRE( vector[ i ].buffer );
+
+            iov[ n ].iov_base = vector[ i ].buffer;
+            iov[ n ].iov_len = vector[ i ].size;
+            requested += vector[ i ].size;
+            n++;
+        }
+    }
+
+    if( n == 0 )
+    {
+        retVal = 0;
+        goto outLabel;
+    }
+
+    do
+    {
+        if( self->type == IOCHANNELTYPE_SOCKET )
+        {
+            Any_memset( &message, 0, sizeof( message ) );
+            message.msg_iov = iov;
+            message.msg_iovlen = n;
+
+            retVal = recvmsg( fd, &message, MSG_NOSIGNAL );
+        }
+        else
+        {
+            retVal = readv( fd, iov, n );
+        }
+    }
+    while( retVal == -1 && errno == EINTR );
+
+    if( retVal == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+    /* same EOF policy as the plain read() of the fd and socket streams */
+    if(( self->type == IOCHANNELTYPE_SOCKET && retVal == 0 ) ||
+       ( self->type == IOCHANNELTYPE_FD && retVal < requested ))
+    {
+        IOCHANNEL_SET_EOF( self );
+    }
+
+    self->currentIndexPosition += retVal;
+    self->rdDeployedBytes += retVal;
+    self->rdBytesFromLastWrite += retVal;
+
+    outLabel:
+    return retVal;
+}
+
+#endif
@@ -112,7 +112,9 @@
  *        host = %%s<br>
  *        port = %%d<br>
  *        mode = 'IOCHANNEL_MODE_RW'<br>
- *        perm = 'IOCHANNEL_PERMISSIONS_ALL'
+ *        perm = 'IOCHANNEL_PERMISSIONS_ALL'<br>
+ *        batch = %%d<br>
+ *        fragment = %%d
  *     </td>
  *     <td><br></td>
  *   </tr>
@@ -135,11 +137,41 @@
  *     <td>
  *        port = %%d<br>
  *        mode = 'IOCHANNEL_MODE_RW'<br>
- *        perm = 'IOCHANNEL_PERMISSIONS_ALL'
+ *        perm = 'IOCHANNEL_PERMISSIONS_ALL'<br>
+ *        batch = %%d<br>
+ *        fragment = %%d
  *     </td>
  *     <td><br></td>
  *   </tr>
  *   <tr>
+ *     <td>Unix domain socket</td>
+ *     <td>Unix:///tmp/server.sock</td>
+ *     <td>
+ *        name = %%s<br>
+ *        mode = 'IOCHANNEL_MODE_RW'<br>
+ *        type = 'stream' | 'seqpacket'
+ *     </td>
+ *     <td>
+ *        Names starting with '@' are in the Linux abstract namespace.<p>
+ *
+ *        Set the "SendFd" property to pass a descriptor to the peer,
+ *        see IOChannel_setProperty()
+ *     </td>
+ *   </tr>
+ *   <tr>
+ *     <td>Unix domain server socket</td>
+ *     <td>ServerUnix:///tmp/server.sock</td>
+ *     <td>
+ *        name = %%s<br>
+ *        mode = 'IOCHANNEL_MODE_RW'<br>
+ *        type = 'stream' | 'seqpacket'<br>
+ *        waitClientTimeout = %%s [usec]
+ *     </td>
+ *     <td>
+ *        Waits for one client, then removes the socket file.
+ *     </td>
+ *   </tr>
+ *   <tr>
  *     <td>memory pointer</td>
  *     <td>Mem://</td>
  *     <td>
@@ -243,7 +275,10 @@
  *        IOCHANNEL_MODE_CREAT: not supported<p>
  *
  *        IOCHANNEL_MODE_CLOSE: unmap the fd when closing, by default it
- *        is kept
+ *        is kept<p>
+ *
+ *        Set the "Growable" property to write beyond the initial size,
+ *        see IOChannel_setProperty()
  *     </td>
  *   </tr>
  *
@@ -263,7 +298,11 @@
  *        IOCHANNEL_MODE_CLOSE: unmap the shared memory when closing,
  *        by default it is kept
  *
- *        Use ftok() to create a SysV IPC key.
+ *        Use ftok() to create a SysV IPC key.<p>
+ *
+ *        Set the "RingBuffer" property to stream messages to another
+ *        process, or the "Broadcast" one to stream them to many, see
+ *        IOChannel_setProperty()
  *     </td>
  *   </tr>
  *   <tr>
@@ -276,7 +315,11 @@
  *        perm = 'IOCHANNEL_PERMISSIONS_ALL'
  *     </td>
  *     <td>
- *        Named shared memories appear as files under /dev/shm.
+ *        Named shared memories appear as files under /dev/shm.<p>
+ *
+ *        Set the "RingBuffer" property to stream messages to another
+ *        process, or the "Broadcast" one to stream them to many, see
+ *        IOChannel_setProperty()
  *     </td>
  *   </tr>
  *   <tr>
@@ -314,10 +357,76 @@
  *        perm = 'IOCHANNEL_PERMISSIONS_ALL'<br>
  *     </td>
  *     <td>
- *        Opens a process by creating a pipe, forking, and invoking the
- *        shell (/bin/sh with -c flag).<p>
- *
- *        IOCHANNEL_MODE_RW: not supported (pipes are unidirectional)
+ *        Starts the command with posix_spawn() and connects it with
+ *        pipes. Commands using shell syntax (quotes, redirections,
+ *        wildcards, ...) are invoked via /bin/sh -c, all others are
+ *        split at blanks and executed directly.<p>
+ *
+ *        IOCHANNEL_MODE_R_ONLY reads the standard output of the command,
+ *        IOCHANNEL_MODE_W_ONLY writes its standard input and
+ *        IOCHANNEL_MODE_RW does both. Set the "CloseWrite" property to
+ *        send EOF to the command while still reading its output.
+ *        "Pid" returns the process ID, "AnsiFile" a FILE on the same
+ *        pipe as "Fd". Closing waits for the command to terminate,
+ *        also with IOCHANNEL_MODE_NOTCLOSE.
+ *     </td>
+ *   </tr>
+ *   <tr>
+ *     <td>filters on another stream</td>
+ *     <td>Filter://frame,crc32</td>
+ *     <td>
+ *        name = %%s (comma-separated filters)<br>
+ *        pointer = %%p (IOChannel to filter)<br>
+ *        mode = 'IOCHANNEL_MODE_RW'<br>
+ *        perm = 'IOCHANNEL_PERMISSIONS_ALL'
+ *     </td>
+ *     <td>
+ *        Data written goes through the filters from left to right and
+ *        then into the given IOChannel, passed after the permissions to
+ *        IOChannel_open(), data read the other way round. That IOChannel
+ *        must stay open until the filter stream is closed, and is then
+ *        closed by the caller.<p>
+ *
+ *        Built-in filters: "frame" (messages, i.e. the data up to each
+ *        IOChannel_flush(), made of size-prefixed chunks, a read never
+ *        returns bytes of two messages), "crc32" ("WriteCrc32" and
+ *        "ReadCrc32" properties of the data so far) and "hex". Further
+ *        filters can be added with IOChannelFilter_register().<p>
+ *
+ *        Each filter gathers small writes in a buffer of its own, do not
+ *        enable write buffering on top of it. Unknown properties are
+ *        looked up down the chain.
+ *     </td>
+ *   </tr>
+ *   <tr>
+ *     <td>same data to several streams</td>
+ *     <td>Tee://block</td>
+ *     <td>
+ *        policy = {block,drop,buffer}<br>
+ *        limit = %%ld (bytes queued per sink, default 4 MiB)<br>
+ *        threads = {0,1}<br>
+ *        mode = 'IOCHANNEL_MODE_W_ONLY'<br>
+ *        perm = 'IOCHANNEL_PERMISSIONS_ALL'
+ *     </td>
+ *     <td>
+ *        Each write goes to all the IOChannels added with the "AddSink"
+ *        property, flushing flushes all of them. The sinks belong to the
+ *        caller, which closes them after the Tee.<p>
+ *
+ *        With threads=1 each sink is written by a thread of its own from
+ *        a queue. A write is copied once, whatever the number of sinks, and
+ *        returns after queueing it. For sinks with data still queued,
+ *        "block" waits until the write fits within the limit, "buffer"
+ *        drops it if it does not fit, and "drop" drops it in any case.
+ *        A write larger than the limit is still queued for an idle sink.
+ *        IOChannel_flush() waits for all the sinks to be written and
+ *        flushed.<p>
+ *
+ *        Without threads the sinks are written in turn. With "block" the
+ *        write fails if one of them fails. With the other policies a
+ *        failing sink is skipped from then on, as with threads.
+ *        "DroppedBytes" points to a long counting the bytes not delivered,
+ *        once per sink.
  *     </td>
  *   </tr>
  *   <tr>
@@ -350,6 +459,13 @@
 
    // retrieve command output:
    "PipeCmd://'ls -lh'"
+
+   // feed data to a filter and read back its output:
+   "PipeCmd:// name='sort -u' mode='IOCHANNEL_MODE_RW'"
+
+   // send messages with a checksum over tcp, an IOChannel already open:
+   IOChannel_open( stream, "Filter://frame,crc32", IOCHANNEL_MODE_RW,
+                   IOCHANNEL_PERMISSIONS_ALL, tcp );
    \endcode
  *
  */
@@ -773,10 +889,56 @@ typedef struct IOChannelBuffer
     void *ptr;
     long size;
     long long index;
+    long long length;
     bool freeOnExit;
 }
         IOChannelBuffer;
 
+/*!
+ * \brief Element of a scatter/gather vector
+ *
+ * Used by IOChannel_writev() and IOChannel_readv() to describe one of the
+ * memory areas to write from or to read into.
+ */
+typedef struct IOChannelIOVec
+{
+    void *buffer;
+    long size;
+}
+        IOChannelIOVec;
+
+/* latencies up to 2^31 nanoseconds (about 2 s), the last bucket holds the slower ones */
+#define IOCHANNELSTATS_HISTOGRAM_BUCKETS  ( 32 )
+
+/*!
+ * \brief I/O statistics of a stream
+ *
+ * Collected once enabled with the "Stats" property, see
+ * IOChannel_setProperty(). The "read", "write" and "flush" counters refer
+ * to the calls of the application, the "stream" ones to the calls which
+ * reach the underlying stream, e.g. the read()/write() syscalls of an Fd
+ * or a socket. Bucket i of a latency histogram counts the stream calls
+ * which took from 2^i to 2^(i+1) - 1 nanoseconds.
+ */
+typedef struct IOChannelStats
+{
+    unsigned long long readCalls;
+    unsigned long long readBytes;
+    unsigned long long writeCalls;
+    unsigned long long writeBytes;
+    unsigned long long flushCalls;
+    unsigned long long flushBytes;
+    unsigned long long streamReads;
+    unsigned long long streamWrites;
+    unsigned long long streamFlushes;
+    unsigned long long shortReads;
+    unsigned long long shortWrites;
+    unsigned long long readLatency[IOCHANNELSTATS_HISTOGRAM_BUCKETS];
+    unsigned long long writeLatency[IOCHANNELSTATS_HISTOGRAM_BUCKETS];
+    unsigned long long flushLatency[IOCHANNELSTATS_HISTOGRAM_BUCKETS];
+}
+        IOChannelStats;
+
 typedef struct IOChannel
 {
     unsigned long valid;
@@ -785,6 +947,9 @@ typedef struct IOChannel
     bool isOpen;
     bool foundEof;
     bool usesWriteBuffering;
+    bool usesReadBuffering;
+    bool usesAsyncIO;
+    bool usesBatching;
     IOChannelMode mode;
     IOChannelType type;
     long readTimeout;
@@ -795,12 +960,14 @@ typedef struct IOChannel
     int errnoValue;
     IOChannelBuffer *ungetBuffer;
     IOChannelBuffer *writeBuffer;
+    IOChannelBuffer *readBuffer;
     bool writeBufferIsExternal;
     bool autoResize;
     long long currentIndexPosition;
     long rdBytesFromLastWrite;
     long rdBytesFromLastUnget;
     MTList *userStream;
+    IOChannelStats *stats;
 }
         IOChannel;
 
@@ -1118,6 +1285,72 @@ long IOChannel_write( IOChannel *self, const void *buffer, long size );
 long IOChannel_writeBlock( IOChannel *self, const void *buffer, long size );
 
 
+/*! \brief Write a list of buffers on a stream (gather write)
+ *
+ * \param vector Array of buffers to write, in order
+ * \param count Number of elements in \a vector
+ *
+ * Writes all the buffers described by \a vector as if they were one
+ * contiguous block, e.g. a message header followed by its payload.
+ * Like IOChannel_writeBlock() it returns only when all the data has been
+ * written or an error occurred.
+ *
+ * Fd, File, StdOut/StdErr, Socket and Tcp streams submit the whole vector
+ * with a single writev()/sendmsg() call, together with any data still
+ * pending in the write buffer, so that the buffers are never copied.
+ * Small vectors which fit into the write buffer are just appended to it.
+ * All the other streams fall back to one IOChannel_write() per element.
+ *
+ * \return The number of written bytes, less in case of error
+ *         or -1 if nothing was written because an error occurred
+ */
+long IOChannel_writev( IOChannel *self, const IOChannelIOVec *vector, int count );
+
+
+/*! \brief Read from a stream into a list of buffers (scatter read)
+ *
+ * \param vector Array of buffers to fill, in order
+ * \param count Number of elements in \a vector
+ *
+ * Fills the buffers described by \a vector one after the other, as
+ * IOChannel_read() does for a single buffer: the return value may be less
+ * than the total size of the vector without an error being set.
+ *
+ * Fd, File, StdIn, Socket and Tcp streams use a single readv()/recvmsg()
+ * call when neither ungetted nor read-ahead data is pending. All the
+ * other streams fall back to one IOChannel_read() per element.
+ *
+ * \return The number of read bytes, -1 if no bytes were read
+ *        (because an error occurred).
+ */
+long IOChannel_readv( IOChannel *self, const IOChannelIOVec *vector, int count );
+
+
+/*! \brief Copy data from one stream into another
+ *
+ * \param self Stream to write to
+ * \param source Stream to read from
+ * \param size Maximum number of bytes to copy
+ *
+ * Reads up to \a size bytes from \a source and writes them into \a self,
+ * stopping earlier if \a source reaches EOF.
+ *
+ * When both streams are Fd, File, Socket, Tcp or ServerTcp streams
+ * (see IOChannel_writev()), the bytes are moved inside the kernel without
+ * going through user space: copy_file_range() between regular files,
+ * sendfile() from a regular file, splice() otherwise (Linux only).
+ * Ungetted or read-ahead data of \a source and pending data in the write
+ * buffer of \a self are handled first. All the other streams, or kernels
+ * refusing the fast path, fall back to IOChannel_read()/IOChannel_write()
+ * through an internal buffer.
+ *
+ * \return The number of copied bytes, less than \a size on EOF or error,
+ *         or -1 if nothing was copied because an error occurred (set on
+ *         the stream which failed)
+ */
+long long IOChannel_transfer( IOChannel *self, IOChannel *source, long long size );
+
+
 long IOChannel_unget( IOChannel *self, void *buffer, long size );
 
 
@@ -1276,12 +1509,140 @@ void *IOChannel_getStreamPtr( IOChannel *self );
  * to get the pointer to the socket used
  * internally.
  *
+ * \code
+ * IOChannelStats *stats = IOChannel_getProperty( self, "Stats" );
+ * \endcode
+ * to get the I/O statistics of any stream, NULL unless they were enabled
+ * with IOChannel_setProperty(). They remain available after closing.
+ *
  * \return The pointer to the property, or NULL if
  *        property doesn't exist
  */
 void *IOChannel_getProperty( IOChannel *self, const char *propertyName );
 
 
+/*! \brief Set Stream properties
+ *
+ * \param propertyName The character string of the property to set
+ * \param propertyValue The new value of the property
+ *
+ * \code
+ * IOChannel_setProperty( self, "AsyncIO", (void *)true );
+ * \endcode
+ * lets "File://" and "Fd://" streams on regular files submit reads and
+ * writes asynchronously through io_uring (Linux only). Writes are copied
+ * into a bounded set of in-flight buffers and IOChannel_write() returns
+ * without waiting for the disk; IOChannel_flush() and IOChannel_close()
+ * wait for all of them to complete. Errors of asynchronous requests are
+ * reported by the next call on the stream. Passing NULL switches back to
+ * synchronous I/O. Write buffering is not needed on top of it, as every
+ * flush of the write buffer waits for the completions.
+ *
+ * \code
+ * IOChannel_setProperty( self, "Growable", (void *)true );
+ * \endcode
+ * lets a writable "MemMapFd://" stream write past the size given at
+ * opening: the file and the mapping are grown in large steps (ftruncate()
+ * plus mremap()), and closing truncates the file to the bytes actually
+ * written. The mapping is advised for sequential access and huge pages,
+ * and the pages ahead of the data are prefaulted. As the mapping may move
+ * while growing, the "MemPointer" property must be read again after
+ * writing.
+ *
+ * \code
+ * IOChannel_setProperty( self, "RingBuffer", (void *)true );
+ * \endcode
+ * turns a "Shm://" stream into a single-producer/single-consumer ring
+ * buffer (Linux only): both processes open the same shared memory with the
+ * same size and set the property, one of them only writes and the other
+ * only reads. Each IOChannel_write() becomes a message, and a read never
+ * returns bytes of two different messages, so a buffer as big as the
+ * largest message reads one message per call. Writes larger than the ring
+ * are split. Reads block while the ring is empty, writes block while it is
+ * full, waiting on a futex after a short spin. Once the writer closes, the
+ * reader gets the remaining messages and then EOF; once the reader closes,
+ * writes fail with EPIPE. The ring header takes the first 192 bytes of the
+ * memory, which must be zeroed on first use (e.g. by opening with
+ * IOCHANNEL_MODE_TRUNC). Seeking is not possible.
+ *
+ * \code
+ * IOChannel_setProperty( self, "Broadcast", (void *)true );
+ * \endcode
+ * turns a "Shm://" stream into a broadcast ring (Linux only): one process
+ * writes each message once, and any number of processes read all of them
+ * independently. The memory is divided into 64 slots, each holding one
+ * message (larger writes are split). Readers can open the memory with
+ * IOCHANNEL_MODE_R_ONLY, they start with the next message published after
+ * setting the property and never slow down the writer. A reader which
+ * falls behind by more than 64 slots gets -1 with IOCHANNELERROR_EOVERFLOW
+ * and, after IOChannel_cleanError(), continues with the oldest message
+ * still available, dropping what it already read of an incomplete one and
+ * never returning the tail of a message whose start is lost; the
+ * "BroadcastLost" property points to a long counting the slots it skipped.
+ * Readers with write access sleep until the writer publishes, read-only
+ * ones cannot register as waiters and check again every millisecond. The
+ * writer must set the property first, readers get EOF once it closes.
+ *
+ * \code
+ * int batch = 32;
+ * IOChannel_setProperty( self, "Batch", &batch );
+ * \endcode
+ * lets "Udp://" and "ServerUdp://" streams move up to \a batch datagrams
+ * (at most 64) per system call with sendmmsg() and recvmmsg(). Each
+ * IOChannel_write() still is a datagram on its own, but it is queued and
+ * sent when \a batch datagrams are pending or at the next IOChannel_flush(),
+ * so a periodic sender should flush once per period. A read takes all the
+ * datagrams already queued on the socket and returns them one per
+ * IOChannel_read(). A batch of 1 or NULL switches back to one datagram per
+ * system call. The same is obtained with the "batch" open option.
+ *
+ * \code
+ * int fragmentSize = 1400;
+ * IOChannel_setProperty( self, "Fragment", &fragmentSize );
+ * \endcode
+ * lets "Udp://" and "ServerUdp://" streams carry messages larger than a
+ * datagram, e.g. Binary-serialized data, both sides must set it. All the
+ * writes up to the next IOChannel_flush() make up one message (up to
+ * 64 MiB), which is sent as fragments of \a fragmentSize bytes plus a
+ * 28 bytes header with the message and fragment numbers (1400 bytes keep
+ * each fragment within an Ethernet MTU). The receiver
+ * reassembles up to 8 messages at a time, and a read returns bytes of one
+ * message only, the rest of it being returned by the following reads.
+ * Messages still incomplete after one second, or pushed out by newer ones,
+ * are dropped as a whole: the "FragmentDropped" property points to a long
+ * counting them. NULL switches back to one datagram per write. The same is
+ * obtained with the "fragment" open option.
+ *
+ * \code
+ * int fd = memfd_create( "frame", 0 );
+ * IOChannel_setProperty( self, "SendFd", &fd );
+ * \endcode
+ * queues a descriptor (e.g. of a shared memory or a memfd) on a "Unix://"
+ * or "ServerUnix://" stream: it is duplicated into the peer along with the
+ * bytes of the next write (or flush), so at least one byte must follow. Up
+ * to 16 descriptors can be queued, the caller keeps its own copy. The peer
+ * gets them in order from the "ReceivedFd" property, which points to the
+ * next descriptor once the bytes sent with it have been read, or is NULL.
+ * Fetched descriptors belong to the caller, the others are closed with the
+ * stream.
+ *
+ * IOChannel_setProperty( self, "Stats", (void *)true ) enables the
+ * IOChannelStats of any stream, or resets them if already enabled, NULL
+ * disables them. Besides the counters, each call reaching the stream is
+ * timed with Any_getTime(); the statistics are kept without locking, like
+ * the rest of the IOChannel, by the thread which uses it. They are kept
+ * across IOChannel_close() and IOChannel_open(), so that they can be read
+ * at any time.
+ *
+ * IOChannel_setProperty( self, "CloseWrite", (void *)true ) flushes a
+ * "PipeCmd://" stream opened with IOCHANNEL_MODE_RW and closes the standard
+ * input of the command, so that filters like sort see EOF and write their
+ * output, which is then read until EOF.
+ *
+ * \return True if the property was set, false if it is unknown or not
+ *         supported (e.g. io_uring is unavailable, and the stream keeps
+ *         working synchronously)
+ */
 bool IOChannel_setProperty( IOChannel *self, const char *propertyName, void *propertyValue );
 
 
@@ -1352,6 +1713,51 @@ bool IOChannel_setUseWriteBuffering( IOChannel *self, bool useBuffering, bool au
 bool IOChannel_usesWriteBuffering( IOChannel *self );
 
 
+/*! \brief Set an internal buffer for read-ahead mode
+ *
+ * \param buffer Pointer to the memory buffer
+ * \param size Size of the buffer
+ *
+ * This is the counterpart of IOChannel_setWriteBuffer() for reading:
+ * when read buffering is enabled, small reads (e.g. IOChannel_getc(),
+ * IOChannel_gets() and IOChannel_scanf()) are served from this buffer,
+ * which is refilled with one low level read of up to <em>size</em> bytes.
+ *
+ * If <em>buffer</em> is NULL, an internal buffer of <em>size</em> length is
+ * allocated and freed when IOChannel_close() is called. Data still pending
+ * in the previous read buffer is preserved.
+ *
+ * Important: for memory streams, no buffering is used!
+ */
+void IOChannel_setReadBuffer( IOChannel *self, void *buffer, long size );
+
+
+/*! \brief Enable/disable read-ahead mode
+ *
+ * \attention This function must be called after \c IOChannel_open() resp.
+ *            \c IOChannel_openFromString().
+ *
+ * When enabled, the IOChannel reads ahead from the underlying stream into
+ * its read buffer (see IOChannel_setReadBuffer()) and serves subsequent
+ * small reads from memory. Requests larger than the buffer bypass it.
+ *
+ * Read-ahead data is transparently taken into account by IOChannel_unget(),
+ * IOChannel_seek() and IOChannel_eof(). Note that the end of the stream is
+ * reported once the stream did not deliver any more data, not already upon
+ * the first short read. Disabling the mode keeps pending data readable.
+ *
+ * \return True on success, false on memory streams.
+ */
+bool IOChannel_setUseReadBuffering( IOChannel *self, bool useBuffering );
+
+
+bool IOChannel_usesReadBuffering( IOChannel *self );
+
+
+/*! \brief Number of read-ahead bytes not yet consumed */
+long IOChannel_getReadBufferedBytes( IOChannel *self );
+
+
 /*! \brief Add data on the internal write buffer */
 long IOChannel_addToWriteBuffer( IOChannel *self, const void *buffer, long size );
 
@@ -193,13 +193,25 @@ static long IOChannelFd_flush( IOChannel *self )
 {
     void *ptr = (void *)NULL;
     long nBytes = 0;
+    long retVal = 0;
 
     ANY_REQUIRE( self );
 
     nBytes = IOChannel_getWriteBufferedBytes( self );
     ptr = IOChannel_getInternalWriteBufferPtr( self );
 
-    return IOChannelGenericFd_write( self, ptr, nBytes );
+    if( nBytes > 0 )
+    {
+        retVal = IOChannelGenericFd_write( self, ptr, nBytes );
+    }
+
+    /* asynchronous writes are complete only once flush returns */
+    if( retVal != -1 && IOChannelGenericFd_waitAsync( self ) == false )
+    {
+        retVal = -1;
+    }
+
+    return retVal;
 }
 
 
@@ -257,7 +269,23 @@ static void *IOChannelFd_getProperty( IOChannel *self, const char *propertyName
 static bool IOChannelFd_setProperty( IOChannel *self, const char *propertyName,
                                      void *propertyValue )
 {
-    return false;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* (void *)true enables the asynchronous engine, NULL disables it */
+        IOCHANNELPROPERTY_PARSE_BEGIN( AsyncIO )
+        {
+            retVal = IOChannelGenericFd_setAsync( self, propertyValue != NULL );
+        }
+        IOCHANNELPROPERTY_PARSE_END( AsyncIO )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
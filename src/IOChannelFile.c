@@ -180,13 +180,25 @@ static long IOChannelFile_flush( IOChannel *self )
 {
     void *ptr = (void *)NULL;
     long nBytes = 0;
+    long retVal = 0;
 
     ANY_REQUIRE( self );
 
     nBytes = IOChannel_getWriteBufferedBytes( self );
     ptr = IOChannel_getInternalWriteBufferPtr( self );
 
-    return IOChannelGenericFd_write( self, ptr, nBytes );
+    if( nBytes > 0 )
+    {
+        retVal = IOChannelGenericFd_write( self, ptr, nBytes );
+    }
+
+    /* asynchronous writes are complete only once flush returns */
+    if( retVal != -1 && IOChannelGenericFd_waitAsync( self ) == false )
+    {
+        retVal = -1;
+    }
+
+    return retVal;
 }
 
 
@@ -243,7 +255,23 @@ static void *IOChannelFile_getProperty( IOChannel *self, const char *propertyNam
 static bool IOChannelFile_setProperty( IOChannel *self, const char *propertyName,
                                        void *property )
 {
-    return false;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* (void *)true enables the asynchronous engine, NULL disables it */
+        IOCHANNELPROPERTY_PARSE_BEGIN( AsyncIO )
+        {
+            retVal = IOChannelGenericFd_setAsync( self, property != NULL );
+        }
+        IOCHANNELPROPERTY_PARSE_END( AsyncIO )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
@@ -0,0 +1,930 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/* some API parameters unused but kept for polymorphism */
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+
+#include <Base.h>
+#include <IOChannelFilter.h>
+#include <IOChannelReferenceValue.h>
+
+
+IOCHANNELINTERFACE_CREATE_PLUGIN( Filter );
+
+
+/* writes smaller than this are gathered before being passed to the filter */
+#define IOCHANNELFILTER_BUFFERSIZE       ( 4096 )
+
+#define IOCHANNELFILTER_NAME_MAXLEN      ( 64 )
+
+/* the "frame" filter prefixes chunks with their size, 0 ending a message */
+#define IOCHANNELFILTER_FRAME_HEADERSIZE ( 4 )
+#define IOCHANNELFILTER_FRAME_MAXCHUNK   ( 0x40000000L )
+
+/* bytes encoded or decoded at once by the "hex" filter */
+#define IOCHANNELFILTER_HEX_CHUNK        ( 512 )
+
+
+typedef struct IOChannelFilterStream
+{
+    const IOChannelFilter *filter;
+    void *state;
+    IOChannel *next;
+    bool ownsNext;
+    char *buffer;
+    long index;
+}
+        IOChannelFilterStream;
+
+
+typedef struct IOChannelFilterFrame
+{
+    bool inMessage;
+    long remaining;
+}
+        IOChannelFilterFrame;
+
+
+typedef struct IOChannelFilterCrc32
+{
+    BaseUI32 writeCrc32;
+    BaseUI32 readCrc32;
+}
+        IOChannelFilterCrc32;
+
+
+typedef struct IOChannelFilterHex
+{
+    int pendingNibble;
+    bool hasPendingNibble;
+}
+        IOChannelFilterHex;
+
+
+static long IOChannelFilter_writeStage( IOChannel *self, const void *buffer, long size );
+
+static void IOChannelFilter_setErrorFromNext( IOChannel *self );
+
+static const IOChannelFilter *IOChannelFilter_find( const char *name );
+
+static bool IOChannelFilter_writeAll( IOChannel *next, const void *buffer, long size );
+
+static long IOChannelFilterFrame_write( void *state, IOChannel *next, const void *buffer, long size );
+
+static long IOChannelFilterFrame_read( void *state, IOChannel *next, void *buffer, long size );
+
+static long IOChannelFilterFrame_flush( void *state, IOChannel *next );
+
+static BaseUI32 IOChannelFilterCrc32_update( BaseUI32 crc32, const void *buffer, long size );
+
+static long IOChannelFilterCrc32_write( void *state, IOChannel *next, const void *buffer, long size );
+
+static long IOChannelFilterCrc32_read( void *state, IOChannel *next, void *buffer, long size );
+
+static void *IOChannelFilterCrc32_getProperty( void *state, const char *propertyName );
+
+static long IOChannelFilterHex_write( void *state, IOChannel *next, const void *buffer, long size );
+
+static long IOChannelFilterHex_read( void *state, IOChannel *next, void *buffer, long size );
+
+
+static const IOChannelFilter IOChannelFilter_builtIn[] =
+        {
+                { "crc32", sizeof( IOChannelFilterCrc32 ),
+                  IOChannelFilterCrc32_write, IOChannelFilterCrc32_read,
+                  NULL, IOChannelFilterCrc32_getProperty },
+                { "frame", sizeof( IOChannelFilterFrame ),
+                  IOChannelFilterFrame_write, IOChannelFilterFrame_read,
+                  IOChannelFilterFrame_flush, NULL },
+                { "hex", sizeof( IOChannelFilterHex ),
+                  IOChannelFilterHex_write, IOChannelFilterHex_read,
+                  NULL, NULL },
+
+                /* termination */
+                { NULL, 0, NULL, NULL, NULL, NULL }
+        };
+
+static const IOChannelFilter *IOChannelFilter_registered[IOCHANNELFILTER_MAXREGISTERED];
+
+static int IOChannelFilter_numRegistered = 0;
+
+
+bool IOChannelFilter_register( const IOChannelFilter *filter )
+{
+    bool retVal = false;
+
+    ANY_REQUIRE( filter );
+    ANY_REQUIRE( filter->name );
+    ANY_REQUIRE( filter->write );
+    ANY_REQUIRE( filter->read );
+
+    if( IOChannelFilter_find( filter->name ))
+    {
+        ANY_LOG( 5, "A filter named '%s' already exists", ANY_LOG_ERROR, filter->name );
+    }
+    else if( IOChannelFilter_numRegistered >= IOCHANNELFILTER_MAXREGISTERED )
+    {
+        ANY_LOG( 5, "Too many filters registered, unable to add '%s'", ANY_LOG_ERROR, filter->name );
+    }
+    else
+    {
+        IOChannelFilter_registered[IOChannelFilter_numRegistered++] = filter;
+        retVal = true;
+    }
+
+    return retVal;
+}
+
+
+static void *IOChannelFilter_new( void )
+{
+    IOChannelFilterStream *self = (IOChannelFilterStream *)NULL;
+
+    self = ANY_TALLOC( IOChannelFilterStream );
+
+    ANY_REQUIRE( self );
+
+    return self;
+}
+
+
+static bool IOChannelFilter_init( IOChannel *self )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+
+    ANY_REQUIRE( self );
+    IOChannel_valid( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    streamPtr->filter = (const IOChannelFilter *)NULL;
+    streamPtr->state = NULL;
+    streamPtr->next = (IOChannel *)NULL;
+    streamPtr->ownsNext = false;
+    streamPtr->buffer = (char *)NULL;
+    streamPtr->index = 0;
+
+    return true;
+}
+
+
+static bool IOChannelFilter_open( IOChannel *self, char *infoString,
+                                  IOChannelMode mode,
+                                  IOChannelPermissions permissions, va_list varArg )
+{
+    bool retVal = false;
+    IOChannel *next = (IOChannel *)NULL;
+    IOChannelReferenceValue **vect = (IOChannelReferenceValue **)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( infoString );
+
+    IOChannel_valid( self );
+
+    IOCHANNEL_GET_ARGUMENT( next, IOChannel *, varArg );
+
+    IOCHANNELREFERENCEVALUE_BEGINSET( &vect )
+
+    IOCHANNELREFERENCEVALUE_ADDSET( name, "%s", infoString );
+    IOCHANNELREFERENCEVALUE_ADDSET( pointer, "%p", (void *)next );
+
+    IOCHANNELREFERENCEVALUE_ENDSET( &vect );
+
+    retVal = IOChannelFilter_openFromString( self, vect );
+
+    IOCHANNELREFERENCEVALUE_FREESET( &vect );
+
+    return retVal;
+}
+
+
+static bool IOChannelFilter_openFromString( IOChannel *self,
+                                            IOChannelReferenceValue **referenceVector )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    IOChannel *next = (IOChannel *)NULL;
+    char *names = (char *)NULL;
+    char *separator = (char *)NULL;
+    char name[IOCHANNELFILTER_NAME_MAXLEN];
+    char rest[IOCHANNEL_INFOSTRING_MAXLEN];
+    long length = 0;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( referenceVector );
+
+    IOChannel_valid( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( !IOCHANNEL_MODEIS_DEFINED( self->mode ))
+    {
+        self->mode = IOCHANNEL_MODE_RW;
+    }
+
+    names = IOChannelReferenceValue_getString( referenceVector, IOCHANNELREFERENCEVALUE_NAME );
+    next = (IOChannel *)IOChannelReferenceValue_getPtr( referenceVector,
+                                                         IOCHANNELREFERENCEVALUE_POINTER );
+
+    if( !names || !next )
+    {
+        ANY_LOG( 5, "Error. A \"Filter://\" stream needs filter names and the stream to filter",
+                 ANY_LOG_ERROR );
+        IOChannel_setError( self, IOCHANNELERROR_BOARG );
+        goto outLabel;
+    }
+
+    /* "a,b,c" writes through a, then b, then c, and finally into next */
+    separator = strchr( names, ',' );
+    length = separator ? (long)( separator - names ) : (long)Any_strlen( names );
+
+    if( length <= 0 || length >= IOCHANNELFILTER_NAME_MAXLEN )
+    {
+        ANY_LOG( 5, "Error. Bad filter name in '%s'", ANY_LOG_ERROR, names );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    Any_memcpy( name, names, length );
+    name[length] = '\0';
+
+    streamPtr->filter = IOChannelFilter_find( name );
+
+    if( !streamPtr->filter )
+    {
+        ANY_LOG( 5, "Error. Unknown filter '%s'", ANY_LOG_ERROR, name );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    if( separator )
+    {
+        /* the rest of the chain is a stream of our own */
+        Any_snprintf( rest, sizeof( rest ), "Filter://%s", separator + 1 );
+
+        streamPtr->next = IOChannel_new();
+        ANY_REQUIRE( streamPtr->next );
+        IOChannel_init( streamPtr->next );
+        streamPtr->ownsNext = true;
+
+        if( !IOChannel_open( streamPtr->next, rest, self->mode & IOCHANNEL_ACCESSMODES,
+                             IOCHANNEL_PERMISSIONS_ALL, next ))
+        {
+            IOChannelFilter_setErrorFromNext( self );
+
+            IOChannel_clear( streamPtr->next );
+            IOChannel_delete( streamPtr->next );
+            streamPtr->next = (IOChannel *)NULL;
+            streamPtr->ownsNext = false;
+            goto outLabel;
+        }
+    }
+    else
+    {
+        streamPtr->next = next;
+        streamPtr->ownsNext = false;
+    }
+
+    streamPtr->state = streamPtr->filter->stateSize > 0 ?
+                       ANY_BALLOC( streamPtr->filter->stateSize ) : NULL;
+    ANY_REQUIRE( streamPtr->filter->stateSize <= 0 || streamPtr->state );
+
+    streamPtr->buffer = (char *)ANY_BALLOC( IOCHANNELFILTER_BUFFERSIZE );
+    ANY_REQUIRE( streamPtr->buffer );
+    streamPtr->index = 0;
+
+    /*
+     * we gather writes ourselves, as core buffering would flush, i.e. end
+     * the message, whenever its buffer is full, but flushes must reach us
+     * also when nothing is in the core buffer
+     */
+    self->usesBatching = true;
+
+    retVal = true;
+
+    outLabel:
+    return retVal;
+}
+
+
+static long IOChannelFilter_read( IOChannel *self, void *buffer, long size )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    long retVal = -1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    retVal = ( *streamPtr->filter->read )( streamPtr->state, streamPtr->next, buffer, size );
+
+    if( retVal == -1 )
+    {
+        IOChannelFilter_setErrorFromNext( self );
+    }
+    else if( retVal == 0 )
+    {
+        IOCHANNEL_SET_EOF( self );
+    }
+
+    return retVal;
+}
+
+
+static long IOChannelFilter_write( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    long retVal = size;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->index + size <= IOCHANNELFILTER_BUFFERSIZE )
+    {
+        Any_memcpy( streamPtr->buffer + streamPtr->index, buffer, size );
+        streamPtr->index += size;
+    }
+    else
+    {
+        /* large writes go to the filter as they are, once the buffer is out */
+        if( streamPtr->index > 0 )
+        {
+            if( IOChannelFilter_writeStage( self, streamPtr->buffer, streamPtr->index ) == -1 )
+            {
+                return -1;
+            }
+
+            streamPtr->index = 0;
+        }
+
+        if( size < IOCHANNELFILTER_BUFFERSIZE )
+        {
+            Any_memcpy( streamPtr->buffer, buffer, size );
+            streamPtr->index = size;
+        }
+        else
+        {
+            retVal = IOChannelFilter_writeStage( self, buffer, size );
+        }
+    }
+
+    return retVal;
+}
+
+
+static long IOChannelFilter_flush( IOChannel *self )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    long retVal = 0;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->index > 0 )
+    {
+        retVal = IOChannelFilter_writeStage( self, streamPtr->buffer, streamPtr->index );
+
+        if( retVal == -1 )
+        {
+            goto outLabel;
+        }
+
+        streamPtr->index = 0;
+    }
+
+    if( streamPtr->filter->flush &&
+        ( *streamPtr->filter->flush )( streamPtr->state, streamPtr->next ) == -1 )
+    {
+        IOChannelFilter_setErrorFromNext( self );
+        retVal = -1;
+        goto outLabel;
+    }
+
+    if( IOChannel_flush( streamPtr->next ) == -1 )
+    {
+        IOChannelFilter_setErrorFromNext( self );
+        retVal = -1;
+    }
+
+    outLabel:
+    return retVal;
+}
+
+
+static long long IOChannelFilter_seek( IOChannel *self, long long offset, IOChannelWhence whence )
+{
+    return 0;
+}
+
+
+static bool IOChannelFilter_close( IOChannel *self )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    bool retVal = true;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    /* the stream given at open belongs to the caller, which closes it */
+    if( streamPtr->ownsNext )
+    {
+        retVal = IOChannel_close( streamPtr->next );
+
+        if( !retVal )
+        {
+            IOChannelFilter_setErrorFromNext( self );
+        }
+
+        IOChannel_clear( streamPtr->next );
+        IOChannel_delete( streamPtr->next );
+    }
+
+    ANY_FREE( streamPtr->state );
+    ANY_FREE( streamPtr->buffer );
+
+    streamPtr->filter = (const IOChannelFilter *)NULL;
+    streamPtr->state = NULL;
+    streamPtr->next = (IOChannel *)NULL;
+    streamPtr->ownsNext = false;
+    streamPtr->buffer = (char *)NULL;
+    streamPtr->index = 0;
+
+    return retVal;
+}
+
+
+static void *IOChannelFilter_getProperty( IOChannel *self, const char *propertyName )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    void *retVal = (void *)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    IOCHANNELPROPERTY_START
+    {
+        IOCHANNELPROPERTY_PARSE_BEGIN( Next )
+        {
+            retVal = streamPtr->next;
+        }
+        IOCHANNELPROPERTY_PARSE_END( Next )
+
+        /* properties of the filters down the chain, then of the filtered stream */
+        if( streamPtr->filter->getProperty )
+        {
+            retVal = ( *streamPtr->filter->getProperty )( streamPtr->state, propertyName );
+        }
+
+        if( !retVal )
+        {
+            retVal = IOChannel_getProperty( streamPtr->next, propertyName );
+        }
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
+}
+
+
+static bool IOChannelFilter_setProperty( IOChannel *self, const char *propertyName,
+                                         void *property )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    return IOChannel_setProperty( streamPtr->next, propertyName, property );
+}
+
+
+static void IOChannelFilter_clear( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+}
+
+
+static void IOChannelFilter_delete( IOChannel *self )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+    ANY_FREE( streamPtr );
+}
+
+
+static long IOChannelFilter_writeStage( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+    long retVal = -1;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+
+    retVal = ( *streamPtr->filter->write )( streamPtr->state, streamPtr->next, buffer, size );
+
+    if( retVal == -1 )
+    {
+        IOChannelFilter_setErrorFromNext( self );
+    }
+
+    return retVal;
+}
+
+
+static void IOChannelFilter_setErrorFromNext( IOChannel *self )
+{
+    IOChannelFilterStream *streamPtr = (IOChannelFilterStream *)NULL;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+
+    if( streamPtr->next && IOChannel_isErrorOccurred( streamPtr->next ))
+    {
+        self->errnoValue = IOChannel_getErrnoValue( streamPtr->next );
+        IOChannel_setError( self, IOChannel_getErrorNumber( streamPtr->next ));
+    }
+    else
+    {
+        ANY_LOG( 5, "Filter '%s' got invalid data", ANY_LOG_ERROR,
+                 streamPtr->filter ? streamPtr->filter->name : "?" );
+        IOChannel_setError( self, IOCHANNELERROR_EIO );
+    }
+}
+
+
+static const IOChannelFilter *IOChannelFilter_find( const char *name )
+{
+    const IOChannelFilter *retVal = (const IOChannelFilter *)NULL;
+    int i = 0;
+
+    for( i = 0; IOChannelFilter_builtIn[i].name && !retVal; i++ )
+    {
+        if( Any_strcasecmp( IOChannelFilter_builtIn[i].name, name ) == 0 )
+        {
+            retVal = &IOChannelFilter_builtIn[i];
+        }
+    }
+
+    for( i = 0; i < IOChannelFilter_numRegistered && !retVal; i++ )
+    {
+        if( Any_strcasecmp( IOChannelFilter_registered[i]->name, name ) == 0 )
+        {
+            retVal = IOChannelFilter_registered[i];
+        }
+    }
+
+    return retVal;
+}
+
+
+static bool IOChannelFilter_writeAll( IOChannel *next, const void *buffer, long size )
+{
+    return IOChannel_writeBlock( next, buffer, size ) == size && !IOChannel_isErrorOccurred( next );
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* "frame": messages made of chunks, each prefixed by its size               */
+/*---------------------------------------------------------------------------*/
+
+
+static long IOChannelFilterFrame_write( void *state, IOChannel *next, const void *buffer, long size )
+{
+    IOChannelFilterFrame *frame = (IOChannelFilterFrame *)state;
+    unsigned char header[IOCHANNELFILTER_FRAME_HEADERSIZE];
+    const char *ptr = (const char *)buffer;
+    long left = size;
+    long chunk = 0;
+
+    while( left > 0 )
+    {
+        chunk = left < IOCHANNELFILTER_FRAME_MAXCHUNK ? left : IOCHANNELFILTER_FRAME_MAXCHUNK;
+
+        /* big endian */
+        header[0] = (unsigned char)( chunk >> 24 );
+        header[1] = (unsigned char)( chunk >> 16 );
+        header[2] = (unsigned char)( chunk >> 8 );
+        header[3] = (unsigned char)chunk;
+
+        if( !IOChannelFilter_writeAll( next, header, sizeof( header )) ||
+            !IOChannelFilter_writeAll( next, ptr, chunk ))
+        {
+            return -1;
+        }
+
+        frame->inMessage = true;
+        ptr += chunk;
+        left -= chunk;
+    }
+
+    return size;
+}
+
+
+static long IOChannelFilterFrame_read( void *state, IOChannel *next, void *buffer, long size )
+{
+    IOChannelFilterFrame *frame = (IOChannelFilterFrame *)state;
+    unsigned char header[IOCHANNELFILTER_FRAME_HEADERSIZE];
+    long retVal = 0;
+
+    /* a read never returns bytes of two messages */
+    while( frame->remaining == 0 )
+    {
+        if( IOChannel_eof( next ))
+        {
+            return 0;
+        }
+
+        retVal = IOChannel_readBlock( next, header, sizeof( header ));
+
+        if( retVal == 0 && IOChannel_eof( next ))
+        {
+            return 0;
+        }
+
+        if( retVal != sizeof( header ))
+        {
+            return -1;
+        }
+
+        frame->remaining = ( (long)header[0] << 24 ) | ( (long)header[1] << 16 ) |
+                           ( (long)header[2] << 8 ) | (long)header[3];
+
+        if( frame->remaining > IOCHANNELFILTER_FRAME_MAXCHUNK )
+        {
+            frame->remaining = 0;
+            return -1;
+        }
+    }
+
+    retVal = IOChannel_eof( next ) ? 0 :
+             IOChannel_read( next, buffer, size < frame->remaining ? size : frame->remaining );
+
+    if( retVal == 0 )
+    {
+        /* truncated chunk */
+        return -1;
+    }
+
+    if( retVal > 0 )
+    {
+        frame->remaining -= retVal;
+    }
+
+    return retVal;
+}
+
+
+static long IOChannelFilterFrame_flush( void *state, IOChannel *next )
+{
+    IOChannelFilterFrame *frame = (IOChannelFilterFrame *)state;
+    unsigned char header[IOCHANNELFILTER_FRAME_HEADERSIZE] = { 0, 0, 0, 0 };
+
+    if( frame->inMessage )
+    {
+        if( !IOChannelFilter_writeAll( next, header, sizeof( header )))
+        {
+            return -1;
+        }
+
+        frame->inMessage = false;
+    }
+
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* "crc32": CRC-32 (IEEE 802.3) of the bytes written and read so far         */
+/*---------------------------------------------------------------------------*/
+
+
+static BaseUI32 IOChannelFilterCrc32_update( BaseUI32 crc32, const void *buffer, long size )
+{
+    static const BaseUI32 table[16] =
+            {
+                    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+                    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+                    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+                    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+            };
+    const unsigned char *ptr = (const unsigned char *)buffer;
+    BaseUI32 crc = ~crc32;
+    long i = 0;
+
+    /* four bits at a time keeps the table within a cache line */
+    for( i = 0; i < size; i++ )
+    {
+        crc ^= ptr[i];
+        crc = ( crc >> 4 ) ^ table[crc & 0x0f];
+        crc = ( crc >> 4 ) ^ table[crc & 0x0f];
+    }
+
+    return ~crc;
+}
+
+
+static long IOChannelFilterCrc32_write( void *state, IOChannel *next, const void *buffer, long size )
+{
+    IOChannelFilterCrc32 *crc32 = (IOChannelFilterCrc32 *)state;
+
+    if( !IOChannelFilter_writeAll( next, buffer, size ))
+    {
+        return -1;
+    }
+
+    crc32->writeCrc32 = IOChannelFilterCrc32_update( crc32->writeCrc32, buffer, size );
+
+    return size;
+}
+
+
+static long IOChannelFilterCrc32_read( void *state, IOChannel *next, void *buffer, long size )
+{
+    IOChannelFilterCrc32 *crc32 = (IOChannelFilterCrc32 *)state;
+    long retVal = 0;
+
+    /* some streams, e.g. "Mem://", flag EOF along with the last bytes */
+    if( IOChannel_eof( next ))
+    {
+        return 0;
+    }
+
+    retVal = IOChannel_read( next, buffer, size );
+
+    if( retVal > 0 )
+    {
+        crc32->readCrc32 = IOChannelFilterCrc32_update( crc32->readCrc32, buffer, retVal );
+    }
+
+    return retVal;
+}
+
+
+static void *IOChannelFilterCrc32_getProperty( void *state, const char *propertyName )
+{
+    IOChannelFilterCrc32 *crc32 = (IOChannelFilterCrc32 *)state;
+    void *retVal = (void *)NULL;
+
+    IOCHANNELPROPERTY_START
+    {
+        IOCHANNELPROPERTY_PARSE_BEGIN( WriteCrc32 )
+        {
+            retVal = &crc32->writeCrc32;
+        }
+        IOCHANNELPROPERTY_PARSE_END( WriteCrc32 )
+
+        IOCHANNELPROPERTY_PARSE_BEGIN( ReadCrc32 )
+        {
+            retVal = &crc32->readCrc32;
+        }
+        IOCHANNELPROPERTY_PARSE_END( ReadCrc32 )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* "hex": two lowercase hexadecimal digits per byte                          */
+/*---------------------------------------------------------------------------*/
+
+
+static long IOChannelFilterHex_write( void *state, IOChannel *next, const void *buffer, long size )
+{
+    static const char digits[] = "0123456789abcdef";
+    const unsigned char *ptr = (const unsigned char *)buffer;
+    char encoded[IOCHANNELFILTER_HEX_CHUNK * 2];
+    long done = 0;
+    long chunk = 0;
+    long i = 0;
+
+    while( done < size )
+    {
+        chunk = size - done < IOCHANNELFILTER_HEX_CHUNK ? size - done : IOCHANNELFILTER_HEX_CHUNK;
+
+        for( i = 0; i < chunk; i++ )
+        {
+            encoded[2 * i] = digits[ptr[done + i] >> 4];
+            encoded[2 * i + 1] = digits[ptr[done + i] & 0x0f];
+        }
+
+        if( !IOChannelFilter_writeAll( next, encoded, chunk * 2 ))
+        {
+            return -1;
+        }
+
+        done += chunk;
+    }
+
+    return size;
+}
+
+
+static long IOChannelFilterHex_read( void *state, IOChannel *next, void *buffer, long size )
+{
+    IOChannelFilterHex *hex = (IOChannelFilterHex *)state;
+    unsigned char *ptr = (unsigned char *)buffer;
+    char encoded[IOCHANNELFILTER_HEX_CHUNK * 2];
+    long retVal = 0;
+    long nBytes = 0;
+    long i = 0;
+    int nibble = 0;
+    char ch = 0;
+
+    /* a single digit is all we may get, keep reading until a byte is complete */
+    while( retVal == 0 )
+    {
+        nBytes = size * 2 - ( hex->hasPendingNibble ? 1 : 0 );
+        nBytes = nBytes < (long)sizeof( encoded ) ? nBytes : (long)sizeof( encoded );
+
+        nBytes = IOChannel_eof( next ) ? 0 : IOChannel_read( next, encoded, nBytes );
+
+        if( nBytes <= 0 )
+        {
+            /* EOF within a byte is an error */
+            return nBytes == 0 && hex->hasPendingNibble ? -1 : nBytes;
+        }
+
+        for( i = 0; i < nBytes; i++ )
+        {
+            ch = encoded[i];
+
+            if( ch >= '0' && ch <= '9' )
+            {
+                nibble = ch - '0';
+            }
+            else if( ch >= 'a' && ch <= 'f' )
+            {
+                nibble = ch - 'a' + 10;
+            }
+            else if( ch >= 'A' && ch <= 'F' )
+            {
+                nibble = ch - 'A' + 10;
+            }
+            else
+            {
+                return -1;
+            }
+
+            if( hex->hasPendingNibble )
+            {
+                ptr[retVal++] = (unsigned char)(( hex->pendingNibble << 4 ) | nibble );
+                hex->hasPendingNibble = false;
+            }
+            else
+            {
+                hex->pendingNibble = nibble;
+                hex->hasPendingNibble = true;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+
+/* EOF */
@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef IOCHANNELFILTER_H
+#define IOCHANNELFILTER_H
+
+
+#include <IOChannel.h>
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* filters which can be added by the application to the built-in ones */
+#define IOCHANNELFILTER_MAXREGISTERED  ( 16 )
+
+/*!
+ * \brief Transform applied by a "Filter://" stream
+ *
+ * A filter sits between the stream it was opened on, \a next, and the
+ * application. Its state is \a stateSize zeroed bytes, private to each
+ * stream. Functions return like the corresponding IOChannel ones, -1
+ * meaning an error of \a next or, if none is set, invalid data.
+ * \a flush and \a getProperty may be NULL.
+ */
+typedef struct IOChannelFilter
+{
+    const char *name;
+    long stateSize;
+
+    /* transforms size bytes and writes them into next, returns size */
+    long (*write)( void *state, IOChannel *next, const void *buffer, long size );
+
+    /* reads from next and returns up to size transformed bytes, 0 at EOF */
+    long (*read)( void *state, IOChannel *next, void *buffer, long size );
+
+    /* called by IOChannel_flush(), ends the message written so far */
+    long (*flush)( void *state, IOChannel *next );
+
+    void *(*getProperty)( void *state, const char *propertyName );
+}
+        IOChannelFilter;
+
+
+/*!
+ * \brief Makes a filter available to "Filter://" streams by its name
+ *
+ * The filter must stay valid for the rest of the process. Filters are
+ * meant to be registered at startup, before streams are opened from other
+ * threads.
+ *
+ * \return False if the name is in use or too many filters are registered
+ */
+bool IOChannelFilter_register( const IOChannelFilter *filter );
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
+
+/* EOF */
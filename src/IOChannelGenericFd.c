@@ -50,6 +50,99 @@ static int internal_fstat( int fd, struct stat *buf );
 
 #include <IOChannelGenericFd.h>
 
+/*
+ * The asynchronous engine talks to io_uring via the raw system calls, so
+ * only the kernel headers are needed. Define IOCHANNELGENERICFD_NO_IOURING
+ * to leave it out.
+ */
+#if defined(__linux__) && !defined(IOCHANNELGENERICFD_NO_IOURING)
+
+#include <sys/syscall.h>
+
+#if defined(__NR_io_uring_setup)
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#define IOCHANNELGENERICFD_HAVE_IOURING
+
+#endif
+#endif
+
+
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+
+/* number of write buffers which can be in flight at the same time */
+#define IOCHANNELGENERICFD_ASYNC_DEPTH      ( 8 )
+
+/* size of each write buffer and of the read-ahead buffer */
+#define IOCHANNELGENERICFD_ASYNC_BLOCKSIZE  ( 64 * 1024 )
+
+/* the read-ahead buffer follows the write buffers */
+#define IOCHANNELGENERICFD_ASYNC_READBLOCK  IOCHANNELGENERICFD_ASYNC_DEPTH
+
+typedef struct IOChannelGenericFdAsync
+{
+    int ringFd;
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+
+    char *blocks;
+    struct iovec iov[IOCHANNELGENERICFD_ASYNC_DEPTH + 1];
+    long long blockOffset[IOCHANNELGENERICFD_ASYNC_DEPTH];
+    bool blockBusy[IOCHANNELGENERICFD_ASYNC_DEPTH];
+    int fillBlock;          /* write buffer being filled, -1 if none */
+    int inFlight;           /* submitted writes not completed yet */
+
+    long long offset;       /* logical file position */
+    bool offsetValid;       /* false when the fd offset is authoritative */
+    int error;              /* first errno reported by a completion */
+
+    bool readPending;
+    bool readEof;
+    long readLength;
+    long readIndex;
+}
+        IOChannelGenericFdAsync;
+
+
+static IOChannelGenericFdAsync *IOChannelGenericFdAsync_create( void );
+
+static void IOChannelGenericFdAsync_destroy( IOChannelGenericFdAsync *self );
+
+static bool IOChannelGenericFdAsync_submit( IOChannelGenericFdAsync *self, int fd,
+                                            int opcode, int block, long long offset );
+
+static void IOChannelGenericFdAsync_reap( IOChannelGenericFdAsync *self, int fd, bool wait );
+
+static void IOChannelGenericFdAsync_submitFillBlock( IOChannelGenericFdAsync *self, int fd );
+
+static void IOChannelGenericFdAsync_waitWrites( IOChannelGenericFdAsync *self, int fd );
+
+static void IOChannelGenericFdAsync_discardRead( IOChannelGenericFdAsync *self, int fd );
+
+static long IOChannelGenericFd_asyncRead( IOChannel *self, void *buffer, long size );
+
+static long IOChannelGenericFd_asyncWrite( IOChannel *self, const void *buffer, long size );
+
+#endif
+
+static bool IOChannelGenericFd_syncAsync( IOChannel *self );
+
+static bool IOChannelGenericFd_checkAsyncError( IOChannel *self );
 
 static long long IOChannelGenericFd_seekBack( IOChannel *self, long long offset );
 
@@ -80,6 +173,7 @@ bool IOChannelGenericFd_init( IOChannel *self )
     /* Don' use, IOChannelGenericFd_setFd, which checks fd validity! */
     streamPtr->fd = -1;
     streamPtr->isRegularFile = false;
+    streamPtr->async = NULL;
 
     return true;
 }
@@ -135,6 +229,9 @@ int IOChannelGenericFd_getFd( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    /* whoever uses the fd directly must find it at the logical position */
+    IOChannelGenericFd_syncAsync( self );
+
     retVal = streamPtr->fd;
 
     return retVal;
@@ -149,6 +246,9 @@ int *IOChannelGenericFd_getFdPtr( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    /* whoever uses the fd directly must find it at the logical position */
+    IOChannelGenericFd_syncAsync( self );
+
     retVal = &( streamPtr->fd );
 
     return retVal;
@@ -163,6 +263,8 @@ bool IOChannelGenericFd_unSet( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    retVal = IOChannelGenericFd_setAsync( self, false );
+
     streamPtr->fd = -1;
 
     return retVal;
@@ -181,6 +283,13 @@ long IOChannelGenericFd_read( IOChannel *self, void *buffer, long size )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    if( streamPtr->async )
+    {
+        return IOChannelGenericFd_asyncRead( self, buffer, size );
+    }
+#endif
+
 #if !defined(__windows__)
     retVal = read( streamPtr->fd, buffer, size );
 #else
@@ -212,6 +321,13 @@ long IOChannelGenericFd_write( IOChannel *self, const void *buffer, long size )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    if( streamPtr->async )
+    {
+        return IOChannelGenericFd_asyncWrite( self, buffer, size );
+    }
+#endif
+
 #if !defined(__windows__)
     retVal = write( streamPtr->fd, buffer, size );
 #else
@@ -264,6 +380,11 @@ long long IOChannelGenericFd_seek( IOChannel *self,
         goto outLabel;
     }
 
+    if( IOChannelGenericFd_syncAsync( self ) == false )
+    {
+        goto outLabel;
+    }
+
     switch( whence )
     {
         case IOCHANNELWHENCE_SET:
@@ -332,6 +453,11 @@ bool IOChannelGenericFd_truncate( IOChannel *self, long size )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    if( IOChannelGenericFd_syncAsync( self ) == false )
+    {
+        goto outLabel;
+    }
+
     status = ftruncate( streamPtr->fd, size );
 
     /*
@@ -351,10 +477,86 @@ bool IOChannelGenericFd_truncate( IOChannel *self, long size )
         retVal = true;
     }
 
+    outLabel:
     return retVal;
 }
 
 
+bool IOChannelGenericFd_setAsync( IOChannel *self, bool useAsync )
+{
+    IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( useAsync == false )
+    {
+        retVal = IOChannelGenericFd_syncAsync( self );
+
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+        if( streamPtr->async )
+        {
+            IOChannelGenericFdAsync_destroy( streamPtr->async );
+            streamPtr->async = NULL;
+        }
+#endif
+        self->usesAsyncIO = false;
+        goto outLabel;
+    }
+
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    if( streamPtr->async )
+    {
+        retVal = true;
+        goto outLabel;
+    }
+
+    /* explicit offsets are meaningless on pipes, ttys and sockets */
+    if( streamPtr->fd < 0 || streamPtr->isRegularFile == false )
+    {
+        ANY_LOG( 5, "Asynchronous I/O is only supported on regular files", ANY_LOG_WARNING );
+        goto outLabel;
+    }
+
+    streamPtr->async = IOChannelGenericFdAsync_create();
+
+    if( streamPtr->async )
+    {
+        self->usesAsyncIO = true;
+        retVal = true;
+    }
+#else
+    ANY_LOG( 5, "Asynchronous I/O is not available on this platform", ANY_LOG_WARNING );
+#endif
+
+    outLabel:
+    return retVal;
+}
+
+
+bool IOChannelGenericFd_waitAsync( IOChannel *self )
+{
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->async )
+    {
+        IOChannelGenericFdAsync_waitWrites( streamPtr->async, streamPtr->fd );
+    }
+#endif
+
+    return IOChannelGenericFd_checkAsyncError( self );
+}
+
+
 bool IOChannelGenericFd_close( IOChannel *self )
 {
     IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
@@ -365,6 +567,11 @@ bool IOChannelGenericFd_close( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    if( IOChannelGenericFd_setAsync( self, false ) == false )
+    {
+        ANY_LOG( 5, "Asynchronous I/O failed, closing fd anyway", ANY_LOG_WARNING );
+    }
+
 #if !defined(__windows__)
     status = close( streamPtr->fd );
 #else
@@ -393,6 +600,17 @@ void IOChannelGenericFd_clear( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    if( streamPtr->async )
+    {
+        IOChannelGenericFdAsync_waitWrites( streamPtr->async, streamPtr->fd );
+        IOChannelGenericFdAsync_discardRead( streamPtr->async, streamPtr->fd );
+        IOChannelGenericFdAsync_destroy( streamPtr->async );
+        streamPtr->async = NULL;
+        self->usesAsyncIO = false;
+    }
+#endif
+
     streamPtr->fd = -1;
 }
 
@@ -488,6 +706,593 @@ static long long IOChannelGenericFd_seekForward( IOChannel *self, long long offs
 }
 
 
+/*
+ * Brings the fd back to the state the synchronous path expects: all
+ * writes completed, no read-ahead pending and the fd offset at the
+ * logical position.
+ */
+static bool IOChannelGenericFd_syncAsync( IOChannel *self )
+{
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
+    IOChannelGenericFdAsync *async = (IOChannelGenericFdAsync *)NULL;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    async = streamPtr->async;
+
+    if( async )
+    {
+        IOChannelGenericFdAsync_waitWrites( async, streamPtr->fd );
+        IOChannelGenericFdAsync_discardRead( async, streamPtr->fd );
+
+        if( async->offsetValid )
+        {
+            if( lseek( streamPtr->fd, async->offset, SEEK_SET ) == -1 && async->error == 0 )
+            {
+                async->error = errno;
+            }
+            async->offsetValid = false;
+        }
+    }
+#endif
+
+    return IOChannelGenericFd_checkAsyncError( self );
+}
+
+
+/* Reports, once, the first error of the completed asynchronous requests */
+static bool IOChannelGenericFd_checkAsyncError( IOChannel *self )
+{
+    bool retVal = true;
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+    IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->async && streamPtr->async->error != 0 )
+    {
+        errno = streamPtr->async->error;
+        streamPtr->async->error = 0;
+
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        retVal = false;
+    }
+#endif
+
+    return retVal;
+}
+
+
+#if defined(IOCHANNELGENERICFD_HAVE_IOURING)
+
+static long IOChannelGenericFd_asyncRead( IOChannel *self, void *buffer, long size )
+{
+    IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
+    IOChannelGenericFdAsync *async = (IOChannelGenericFdAsync *)NULL;
+    char *ptr = (char *)buffer;
+    long retVal = 0;
+    long chunk = 0;
+    long nBytes = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    async = streamPtr->async;
+    ANY_REQUIRE( async );
+
+    /* reads must see the data written before */
+    IOChannelGenericFdAsync_waitWrites( async, streamPtr->fd );
+
+    if( IOChannelGenericFd_checkAsyncError( self ) == false )
+    {
+        retVal = -1;
+        goto outLabel;
+    }
+
+    if( async->offsetValid == false )
+    {
+        async->offset = lseek( streamPtr->fd, 0, SEEK_CUR );
+        async->offsetValid = true;
+    }
+
+    while( retVal < size )
+    {
+        if( async->readPending == false && async->readIndex == async->readLength )
+        {
+            /* large requests are read straight into the caller's buffer */
+            if( size - retVal >= IOCHANNELGENERICFD_ASYNC_BLOCKSIZE )
+            {
+                do
+                {
+                    nBytes = pread( streamPtr->fd, ptr, size - retVal, async->offset );
+                }
+                while( nBytes == -1 && errno == EINTR );
+
+                if( nBytes == -1 )
+                {
+                    async->error = errno;
+                    break;
+                }
+
+                ptr += nBytes;
+                retVal += nBytes;
+                async->offset += nBytes;
+
+                if( nBytes == 0 )
+                {
+                    break;
+                }
+                continue;
+            }
+
+            async->readIndex = 0;
+            async->readLength = 0;
+
+            if( IOChannelGenericFdAsync_submit( async, streamPtr->fd, IORING_OP_READV,
+                                                IOCHANNELGENERICFD_ASYNC_READBLOCK,
+                                                async->offset ) == false )
+            {
+                break;
+            }
+            async->readPending = true;
+        }
+
+        while( async->readPending )
+        {
+            IOChannelGenericFdAsync_reap( async, streamPtr->fd, true );
+        }
+
+        if( async->error != 0 || async->readLength == 0 )
+        {
+            break;
+        }
+
+        chunk = async->readLength - async->readIndex;
+        chunk = ( chunk < size - retVal ) ? chunk : size - retVal;
+
+        Any_memcpy( ptr, (char *)async->iov[ IOCHANNELGENERICFD_ASYNC_READBLOCK ].iov_base + async->readIndex,
+                    chunk );
+
+        ptr += chunk;
+        retVal += chunk;
+        async->readIndex += chunk;
+        async->offset += chunk;
+    }
+
+    /* fetch the next block while the caller is busy with this one */
+    if( retVal == size && async->readPending == false && async->readIndex == async->readLength )
+    {
+        async->readIndex = 0;
+        async->readLength = 0;
+
+        async->readPending = IOChannelGenericFdAsync_submit( async, streamPtr->fd, IORING_OP_READV,
+                                                             IOCHANNELGENERICFD_ASYNC_READBLOCK,
+                                                             async->offset );
+    }
+
+    if( IOChannelGenericFd_checkAsyncError( self ) == false && retVal == 0 )
+    {
+        retVal = -1;
+        goto outLabel;
+    }
+
+    if( retVal < size )
+    {
+        IOCHANNEL_SET_EOF( self );
+    }
+
+    outLabel:
+    return retVal;
+}
+
+
+static long IOChannelGenericFd_asyncWrite( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelGenericFd *streamPtr = (IOChannelGenericFd *)NULL;
+    IOChannelGenericFdAsync *async = (IOChannelGenericFdAsync *)NULL;
+    const char *ptr = (const char *)buffer;
+    struct iovec *iov = (struct iovec *)NULL;
+    long retVal = 0;
+    long chunk = 0;
+    int i = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    async = streamPtr->async;
+    ANY_REQUIRE( async );
+
+    IOChannelGenericFdAsync_discardRead( async, streamPtr->fd );
+
+    if( IOChannelGenericFd_checkAsyncError( self ) == false )
+    {
+        retVal = -1;
+        goto outLabel;
+    }
+
+    if( async->offsetValid == false )
+    {
+        async->offset = lseek( streamPtr->fd, 0, SEEK_CUR );
+        async->offsetValid = true;
+    }
+
+    while( retVal < size )
+    {
+        if( async->fillBlock == -1 )
+        {
+            /* bounded in-flight data: wait for a buffer to complete */
+            for( ;; )
+            {
+                for( i = 0; i < IOCHANNELGENERICFD_ASYNC_DEPTH; i++ )
+                {
+                    if( async->blockBusy[ i ] == false )
+                    {
+                        break;
+                    }
+                }
+
+                if( i < IOCHANNELGENERICFD_ASYNC_DEPTH )
+                {
+                    break;
+                }
+
+                IOChannelGenericFdAsync_reap( async, streamPtr->fd, true );
+            }
+
+            async->fillBlock = i;
+            async->blockBusy[ i ] = true;
+            async->blockOffset[ i ] = async->offset;
+            async->iov[ i ].iov_len = 0;
+        }
+
+        iov = &async->iov[ async->fillBlock ];
+
+        chunk = IOCHANNELGENERICFD_ASYNC_BLOCKSIZE - (long)iov->iov_len;
+        chunk = ( chunk < size - retVal ) ? chunk : size - retVal;
+
+        Any_memcpy( (char *)iov->iov_base + iov->iov_len, ptr, chunk );
+        iov->iov_len += chunk;
+
+        ptr += chunk;
+        retVal += chunk;
+        async->offset += chunk;
+
+        if( iov->iov_len == IOCHANNELGENERICFD_ASYNC_BLOCKSIZE )
+        {
+            IOChannelGenericFdAsync_submitFillBlock( async, streamPtr->fd );
+        }
+    }
+
+    /* collect what has already completed, without waiting */
+    IOChannelGenericFdAsync_reap( async, streamPtr->fd, false );
+
+    IOChannelGenericFd_checkAsyncError( self );
+
+    outLabel:
+    return retVal;
+}
+
+
+static IOChannelGenericFdAsync *IOChannelGenericFdAsync_create( void )
+{
+    IOChannelGenericFdAsync *self = (IOChannelGenericFdAsync *)NULL;
+    struct io_uring_params params;
+    char *ring = (char *)NULL;
+    int i = 0;
+
+    self = ANY_TALLOC( IOChannelGenericFdAsync );
+    ANY_REQUIRE( self );
+
+    self->ringFd = -1;
+    self->sqRing = MAP_FAILED;
+    self->cqRing = MAP_FAILED;
+    self->sqes = (struct io_uring_sqe *)MAP_FAILED;
+    self->fillBlock = -1;
+
+    Any_memset( &params, 0, sizeof( params ) );
+
+    self->ringFd = (int)syscall( __NR_io_uring_setup, 2 * ( IOCHANNELGENERICFD_ASYNC_DEPTH + 1 ), &params );
+
+    if( self->ringFd == -1 )
+    {
+        ANY_LOG( 5, "io_uring is not available (%s), using synchronous I/O",
+                 ANY_LOG_WARNING, strerror( errno ) );
+        goto failLabel;
+    }
+
+    self->sqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+    self->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( struct io_uring_cqe );
+
+#if defined(IORING_FEAT_SINGLE_MMAP)
+    if( params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        if( self->cqRingSize > self->sqRingSize )
+        {
+            self->sqRingSize = self->cqRingSize;
+        }
+        self->cqRingSize = 0;
+    }
+#endif
+
+    self->sqRing = mmap( NULL, self->sqRingSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, self->ringFd, IORING_OFF_SQ_RING );
+
+    if( self->sqRing == MAP_FAILED )
+    {
+        goto mmapFailLabel;
+    }
+
+    if( self->cqRingSize == 0 )
+    {
+        self->cqRing = self->sqRing;
+    }
+    else
+    {
+        self->cqRing = mmap( NULL, self->cqRingSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, self->ringFd, IORING_OFF_CQ_RING );
+
+        if( self->cqRing == MAP_FAILED )
+        {
+            goto mmapFailLabel;
+        }
+    }
+
+    self->sqesSize = params.sq_entries * sizeof( struct io_uring_sqe );
+    self->sqes = (struct io_uring_sqe *)mmap( NULL, self->sqesSize, PROT_READ | PROT_WRITE,
+                                              MAP_SHARED | MAP_POPULATE, self->ringFd, IORING_OFF_SQES );
+
+    if( self->sqes == MAP_FAILED )
+    {
+        goto mmapFailLabel;
+    }
+
+    ring = (char *)self->sqRing;
+    self->sqTail = (unsigned *)( ring + params.sq_off.tail );
+    self->sqMask = (unsigned *)( ring + params.sq_off.ring_mask );
+    self->sqArray = (unsigned *)( ring + params.sq_off.array );
+
+    ring = (char *)self->cqRing;
+    self->cqHead = (unsigned *)( ring + params.cq_off.head );
+    self->cqTail = (unsigned *)( ring + params.cq_off.tail );
+    self->cqMask = (unsigned *)( ring + params.cq_off.ring_mask );
+    self->cqes = (struct io_uring_cqe *)( ring + params.cq_off.cqes );
+
+    self->blocks = (char *)ANY_BALLOC( ( IOCHANNELGENERICFD_ASYNC_DEPTH + 1 ) *
+                                       IOCHANNELGENERICFD_ASYNC_BLOCKSIZE );
+    ANY_REQUIRE( self->blocks );
+
+    for( i = 0; i <= IOCHANNELGENERICFD_ASYNC_DEPTH; i++ )
+    {
+        self->iov[ i ].iov_base = self->blocks + i * IOCHANNELGENERICFD_ASYNC_BLOCKSIZE;
+        self->iov[ i ].iov_len = 0;
+    }
+
+    return self;
+
+    mmapFailLabel:
+    ANY_LOG( 5, "Unable to map the io_uring rings (%s), using synchronous I/O",
+             ANY_LOG_WARNING, strerror( errno ) );
+
+    failLabel:
+    IOChannelGenericFdAsync_destroy( self );
+
+    return (IOChannelGenericFdAsync *)NULL;
+}
+
+
+static void IOChannelGenericFdAsync_destroy( IOChannelGenericFdAsync *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->inFlight == 0 && self->readPending == false );
+
+    if( self->sqes != MAP_FAILED )
+    {
+        munmap( self->sqes, self->sqesSize );
+    }
+
+    if( self->cqRing != MAP_FAILED && self->cqRing != self->sqRing )
+    {
+        munmap( self->cqRing, self->cqRingSize );
+    }
+
+    if( self->sqRing != MAP_FAILED )
+    {
+        munmap( self->sqRing, self->sqRingSize );
+    }
+
+    if( self->ringFd != -1 )
+    {
+        close( self->ringFd );
+    }
+
+    if( self->blocks )
+    {
+        ANY_FREE( self->blocks );
+    }
+
+    ANY_FREE( self );
+}
+
+
+static bool IOChannelGenericFdAsync_submit( IOChannelGenericFdAsync *self, int fd,
+                                            int opcode, int block, long long offset )
+{
+    struct io_uring_sqe *sqe = (struct io_uring_sqe *)NULL;
+    unsigned tail = 0;
+    unsigned index = 0;
+    int status = -1;
+
+    /* we are the only producer, and never have more requests than entries */
+    tail = *self->sqTail;
+    index = tail & *self->sqMask;
+
+    sqe = &self->sqes[ index ];
+    Any_memset( sqe, 0, sizeof( *sqe ) );
+
+    sqe->opcode = (unsigned char)opcode;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)&self->iov[ block ];
+    sqe->len = 1;
+    sqe->off = (unsigned long long)offset;
+    sqe->user_data = (unsigned long long)block;
+
+    if( opcode == IORING_OP_READV )
+    {
+        self->iov[ block ].iov_len = IOCHANNELGENERICFD_ASYNC_BLOCKSIZE;
+    }
+
+    self->sqArray[ index ] = index;
+    __atomic_store_n( self->sqTail, tail + 1, __ATOMIC_RELEASE );
+
+    do
+    {
+        status = (int)syscall( __NR_io_uring_enter, self->ringFd, 1, 0, 0, NULL, 0 );
+    }
+    while( status == -1 && errno == EINTR );
+
+    if( status != 1 )
+    {
+        /* the kernel did not take the entry, withdraw it */
+        __atomic_store_n( self->sqTail, tail, __ATOMIC_RELEASE );
+
+        if( self->error == 0 )
+        {
+            self->error = ( status == -1 ) ? errno : EAGAIN;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+
+static void IOChannelGenericFdAsync_reap( IOChannelGenericFdAsync *self, int fd, bool wait )
+{
+    struct io_uring_cqe *cqe = (struct io_uring_cqe *)NULL;
+    struct iovec *iov = (struct iovec *)NULL;
+    unsigned head = 0;
+    long done = 0;
+    long nBytes = 0;
+    int block = 0;
+    int status = 0;
+
+    head = *self->cqHead;
+
+    if( wait && head == __atomic_load_n( self->cqTail, __ATOMIC_ACQUIRE ) )
+    {
+        do
+        {
+            status = (int)syscall( __NR_io_uring_enter, self->ringFd, 0, 1,
+                                   IORING_ENTER_GETEVENTS, NULL, 0 );
+        }
+        while( status == -1 && errno == EINTR );
+    }
+
+    while( head != __atomic_load_n( self->cqTail, __ATOMIC_ACQUIRE ) )
+    {
+        cqe = &self->cqes[ head & *self->cqMask ];
+        block = (int)cqe->user_data;
+
+        if( block == IOCHANNELGENERICFD_ASYNC_READBLOCK )
+        {
+            self->readPending = false;
+
+            if( cqe->res < 0 )
+            {
+                self->error = ( self->error == 0 ) ? -cqe->res : self->error;
+                self->readLength = 0;
+            }
+            else
+            {
+                self->readLength = cqe->res;
+            }
+        }
+        else
+        {
+            iov = &self->iov[ block ];
+            done = cqe->res;
+
+            if( done < 0 )
+            {
+                self->error = ( self->error == 0 ) ? -cqe->res : self->error;
+            }
+            else
+            {
+                /* short writes are rare on regular files, finish them here */
+                while( done < (long)iov->iov_len )
+                {
+                    nBytes = pwrite( fd, (char *)iov->iov_base + done, iov->iov_len - done,
+                                     self->blockOffset[ block ] + done );
+
+                    if( nBytes <= 0 && !( nBytes == -1 && errno == EINTR ) )
+                    {
+                        self->error = ( self->error == 0 ) ? ( nBytes == 0 ? ENOSPC : errno ) : self->error;
+                        break;
+                    }
+                    done += ( nBytes > 0 ) ? nBytes : 0;
+                }
+            }
+
+            self->blockBusy[ block ] = false;
+            self->inFlight--;
+        }
+
+        head++;
+        __atomic_store_n( self->cqHead, head, __ATOMIC_RELEASE );
+    }
+}
+
+
+static void IOChannelGenericFdAsync_submitFillBlock( IOChannelGenericFdAsync *self, int fd )
+{
+    int block = self->fillBlock;
+
+    if( block != -1 )
+    {
+        self->fillBlock = -1;
+
+        if( IOChannelGenericFdAsync_submit( self, fd, IORING_OP_WRITEV, block,
+                                            self->blockOffset[ block ] ) )
+        {
+            self->inFlight++;
+        }
+        else
+        {
+            self->blockBusy[ block ] = false;
+        }
+    }
+}
+
+
+static void IOChannelGenericFdAsync_waitWrites( IOChannelGenericFdAsync *self, int fd )
+{
+    IOChannelGenericFdAsync_submitFillBlock( self, fd );
+
+    while( self->inFlight > 0 )
+    {
+        IOChannelGenericFdAsync_reap( self, fd, true );
+    }
+}
+
+
+static void IOChannelGenericFdAsync_discardRead( IOChannelGenericFdAsync *self, int fd )
+{
+    while( self->readPending )
+    {
+        IOChannelGenericFdAsync_reap( self, fd, true );
+    }
+
+    /* the logical offset already excludes the unconsumed read-ahead data */
+    self->readIndex = 0;
+    self->readLength = 0;
+}
+
+#endif
+
+
 #if defined(__windows__)
 static int ftruncate( int fd, off_t where )
 {
@@ -29,10 +29,13 @@
 extern "C" {
 #endif
 
+struct IOChannelGenericFdAsync;
+
 typedef struct IOChannelGenericFd
 {
     bool isRegularFile;
     int fd;
+    struct IOChannelGenericFdAsync *async;
 }
         IOChannelGenericFd;
 
@@ -58,6 +61,16 @@ long long IOChannelGenericFd_seek( IOChannel *self,
 
 bool IOChannelGenericFd_truncate( IOChannel *self, long size );
 
+/*
+ * Switches the fd to the asynchronous io_uring engine (Linux only, regular
+ * files only). Returns false and keeps the synchronous path if the engine
+ * is not available.
+ */
+bool IOChannelGenericFd_setAsync( IOChannel *self, bool useAsync );
+
+/* Waits until all the asynchronous writes have completed */
+bool IOChannelGenericFd_waitAsync( IOChannel *self );
+
 bool IOChannelGenericFd_close( IOChannel *self );
 
 void IOChannelGenericFd_clear( IOChannel *self );
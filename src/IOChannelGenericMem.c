@@ -18,15 +18,209 @@
  */
 
 
+#include <limits.h>
+
 #include <IOChannelGenericMem.h>
 
 
+#if defined(__linux__) && !defined(IOCHANNELGENERICMEM_NO_RING)
+
+#include <errno.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#if defined(SYS_futex)
+
+#include <Atomic.h>
+
+#define IOCHANNELGENERICMEM_HAVE_RING
+
+#endif
+
+#endif
+
+
+/* growable mappings double their size, but never by more than this */
+#define IOCHANNELGENERICMEM_GROWSTEP_MAX  ( 64 * 1024 * 1024 )
+
+/* grown sizes are multiples of this, so huge pages can back the mapping */
+#define IOCHANNELGENERICMEM_GROWALIGN     ( 2 * 1024 * 1024 )
+
+
 #if !defined(__windows__)
 
 static bool IOChannel_setProtection( IOChannel *self, int *protection );
 
+static bool IOChannelGenericMem_grow( IOChannel *self, long long minSize );
+
+static void IOChannelGenericMem_adviseSequential( IOChannel *self );
+
+#endif
+
+
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+
+#define IOCHANNELGENERICMEM_CACHELINE     ( 64 )
+
+/* header state of a ring which is ready to be used */
+#define IOCHANNELGENERICMEM_RINGREADY     ( 0x52494e47 )
+
+/* header state while the first opener sets the ring up */
+#define IOCHANNELGENERICMEM_RINGINIT      ( 1 )
+
+/* polls before going to sleep on the futex, to keep the latency low */
+#define IOCHANNELGENERICMEM_RINGSPIN      ( 2000 )
+
+/* each message is preceded by its length */
+#define IOCHANNELGENERICMEM_FRAMEHEADER   ( (long long)sizeof( int ) )
+
+/*
+ * Lives at the start of the shared memory. The indices are free running
+ * byte counters, written by one side only and kept on separate cache lines
+ * to avoid false sharing between producer and consumer.
+ */
+typedef struct IOChannelGenericMemRingHeader
+{
+    int state;
+    int writerClosed;
+    int readerClosed;
+    int unused;
+    long long capacity;
+    char pad0[IOCHANNELGENERICMEM_CACHELINE - 4 * sizeof( int ) - sizeof( long long )];
+
+    /* producer side */
+    long long head;
+    int dataSeq;            /* futex, bumped at every publication */
+    int readerWaiting;
+    char pad1[IOCHANNELGENERICMEM_CACHELINE - 2 * sizeof( int ) - sizeof( long long )];
+
+    /* consumer side */
+    long long tail;
+    int spaceSeq;           /* futex, bumped at every consumption */
+    int writerWaiting;
+    char pad2[IOCHANNELGENERICMEM_CACHELINE - 2 * sizeof( int ) - sizeof( long long )];
+}
+        IOChannelGenericMemRingHeader;
+
+
+typedef struct IOChannelGenericMemRing
+{
+    IOChannelGenericMemRingHeader *header;
+    char *data;
+    long long capacity;
+    long frameLeft;         /* payload of the current message still to be read */
+    bool hasRead;
+    bool hasWritten;
+}
+        IOChannelGenericMemRing;
+
+
+/* header state of a broadcast ring which is ready to be used */
+#define IOCHANNELGENERICMEM_BROADCASTREADY  ( 0x42435354 )
+
+/* slots a broadcast reader may fall behind before an overrun */
+#define IOCHANNELGENERICMEM_BROADCASTSLOTS  ( 64 )
+
+/* sleep of the readers which cannot tell the writer they wait, in microseconds */
+#define IOCHANNELGENERICMEM_BROADCASTPOLL   ( 1000 )
+
+/*
+ * Lives at the start of the shared memory of a broadcast ring, followed by
+ * the slots. Only the writer changes the first two cache lines, the readers
+ * keep their cursors in private memory and can map the memory read-only.
+ * Readers with write access count themselves in the waiters while sleeping,
+ * so that the writer skips the futex wake-up when nobody sleeps.
+ */
+typedef struct IOChannelGenericMemBroadcastHeader
+{
+    int state;
+    int writerClosed;
+    long long slotCount;
+    long long slotSize;     /* distance between two slots, slot header included */
+    char pad0[IOCHANNELGENERICMEM_CACHELINE - 2 * sizeof( int ) - 2 * sizeof( long long )];
+
+    long long head;         /* slots published so far */
+    int dataSeq;            /* futex, bumped at every publication */
+    int unused;
+    char pad1[IOCHANNELGENERICMEM_CACHELINE - 2 * sizeof( int ) - sizeof( long long )];
+
+    int waiters;            /* readers sleeping on dataSeq */
+    char pad2[IOCHANNELGENERICMEM_CACHELINE - sizeof( int )];
+}
+        IOChannelGenericMemBroadcastHeader;
+
+
+/*
+ * Seqlock versioning: the version is odd while slot i is written, and
+ * 2 * i + 2 once it is published. A message bigger than a slot is split
+ * into consecutive fragments, so that a reader which lost some of them
+ * can resume at the start of the next message.
+ */
+typedef struct IOChannelGenericMemBroadcastSlot
+{
+    long long version;
+    long long length;
+    long long fragment;     /* index of the fragment within its message */
+    long long fragments;    /* fragments of the whole message */
+    char pad[IOCHANNELGENERICMEM_CACHELINE - 4 * sizeof( long long )];
+}
+        IOChannelGenericMemBroadcastSlot;
+
+
+typedef struct IOChannelGenericMemBroadcast
+{
+    IOChannelGenericMemBroadcastHeader *header;
+    char *slots;
+    long long slotCount;
+    long long slotSize;
+    long long next;         /* slot to be read next */
+    long long offset;       /* bytes of it already read */
+    long long fragment;     /* fragment expected in it, 0 at a message start */
+    long lost;              /* slots skipped because of overruns */
+    bool hasWritten;
+}
+        IOChannelGenericMemBroadcast;
+
+
+static long IOChannelGenericMem_ringRead( IOChannel *self, void *buffer, long size );
+
+static long IOChannelGenericMem_ringWrite( IOChannel *self, const void *buffer, long size );
+
+static void IOChannelGenericMem_ringCopyIn( IOChannelGenericMemRing *ring, long long position,
+                                            const void *buffer, long long size );
+
+static void IOChannelGenericMem_ringCopyOut( IOChannelGenericMemRing *ring, long long position,
+                                             void *buffer, long long size );
+
+static long IOChannelGenericMem_broadcastRead( IOChannel *self, void *buffer, long size );
+
+static long IOChannelGenericMem_broadcastWrite( IOChannel *self, const void *buffer, long size );
+
+static long IOChannelGenericMem_broadcastOverrun( IOChannel *self );
+
+static void IOChannelGenericMem_futexWait( int *address, int value, long microsecs );
+
+static void IOChannelGenericMem_futexWake( int *address, int count );
+
+#else
+
+/* never instantiated, keep the struct IOChannelGenericMem layout portable */
+typedef struct IOChannelGenericMemRing
+{
+    int unused;
+}
+        IOChannelGenericMemRing;
+
+typedef struct IOChannelGenericMemBroadcast
+{
+    long lost;
+}
+        IOChannelGenericMemBroadcast;
+
 #endif
 
+
 static long long IOChannelGenericMem_seekBack( IOChannel *self, long long offset );
 
 static long long IOChannelGenericMem_seekForward( IOChannel *self, long long offset );
@@ -58,6 +252,10 @@ bool IOChannelGenericMem_init( IOChannel *self )
     streamPtr->fd = -1;
     streamPtr->size = 0;
     streamPtr->isMapped = false;
+    streamPtr->isGrowable = false;
+    streamPtr->writtenSize = 0;
+    streamPtr->ring = (IOChannelGenericMemRing *)NULL;
+    streamPtr->broadcast = (IOChannelGenericMemBroadcast *)NULL;
 
     return true;
 }
@@ -79,6 +277,18 @@ void IOChannelGenericMem_setPtr( IOChannel *self,
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    if( streamPtr->ring )
+    {
+        ANY_FREE( streamPtr->ring );
+        streamPtr->ring = (IOChannelGenericMemRing *)NULL;
+    }
+
+    if( streamPtr->broadcast )
+    {
+        ANY_FREE( streamPtr->broadcast );
+        streamPtr->broadcast = (IOChannelGenericMemBroadcast *)NULL;
+    }
+
     streamPtr->ptr = ptr;
     streamPtr->fd = fd;
     streamPtr->size = size;
@@ -100,6 +310,18 @@ long IOChannelGenericMem_read( IOChannel *self, void *buffer, long size )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+    if( streamPtr->ring )
+    {
+        return IOChannelGenericMem_ringRead( self, buffer, size );
+    }
+
+    if( streamPtr->broadcast )
+    {
+        return IOChannelGenericMem_broadcastRead( self, buffer, size );
+    }
+#endif
+
     ptr = (char *)streamPtr->ptr;
     ptr += self->currentIndexPosition;
 
@@ -121,7 +343,8 @@ long IOChannelGenericMem_read( IOChannel *self, void *buffer, long size )
     }
     else
     {
-        nBytes = -1;
+        /* at the end, like any other stream, -1 would need an error */
+        nBytes = 0;
         IOCHANNEL_SET_EOF( self );
     }
 
@@ -142,6 +365,28 @@ long IOChannelGenericMem_write( IOChannel *self, const void *buffer, long size )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+    if( streamPtr->ring )
+    {
+        return IOChannelGenericMem_ringWrite( self, buffer, size );
+    }
+
+    if( streamPtr->broadcast )
+    {
+        return IOChannelGenericMem_broadcastWrite( self, buffer, size );
+    }
+#endif
+
+#if !defined(__windows__)
+    if( streamPtr->isGrowable && ( self->currentIndexPosition + size ) > streamPtr->size )
+    {
+        if( !IOChannelGenericMem_grow( self, self->currentIndexPosition + size ))
+        {
+            return -1;
+        }
+    }
+#endif
+
     ptr = (char *)streamPtr->ptr;
     ptr += self->currentIndexPosition;
 
@@ -162,6 +407,11 @@ long IOChannelGenericMem_write( IOChannel *self, const void *buffer, long size )
         /* When Buffer is full, nBytes == 0 */
         ANY_REQUIRE( nBytes >= 0 );
         Any_memcpy( ptr, buffer, nBytes );
+
+        if( self->currentIndexPosition + nBytes > streamPtr->writtenSize )
+        {
+            streamPtr->writtenSize = (long)( self->currentIndexPosition + nBytes );
+        }
     }
     else
     {
@@ -197,6 +447,18 @@ long long IOChannelGenericMem_seek( IOChannel *self, long long offset, IOChannel
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    if( streamPtr->ring || streamPtr->broadcast )
+    {
+        /* a ring is a stream, only asking the position makes sense */
+        if( whence == IOCHANNELWHENCE_CUR && offset == 0 )
+        {
+            return self->currentIndexPosition;
+        }
+
+        IOChannel_setError( self, IOCHANNELERROR_BSEK );
+        return -1;
+    }
+
     switch( whence )
     {
         case IOCHANNELWHENCE_SET:
@@ -354,6 +616,7 @@ bool IOChannelGenericMem_unmapFd( IOChannel *self )
 #else
 
     IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    long long length = 0;
     int status = -1;
 
     ANY_REQUIRE( self );
@@ -361,11 +624,23 @@ bool IOChannelGenericMem_unmapFd( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
-    if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    if( streamPtr->ring || streamPtr->broadcast )
+    {
+        /* the other side still uses the memory, its size must not change */
+        IOChannelGenericMem_setRing( self, false );
+        IOChannelGenericMem_setBroadcast( self, false );
+    }
+    else if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
     {
         ANY_REQUIRE( streamPtr->fd != -1 );
 
-        status = ftruncate( streamPtr->fd, self->currentIndexPosition );
+        /*
+         * a growable mapping is always larger than the data, and may have
+         * been seeked back before closing: keep everything written so far
+         */
+        length = streamPtr->isGrowable ? streamPtr->writtenSize : self->currentIndexPosition;
+
+        status = ftruncate( streamPtr->fd, length );
         if( status == -1 )
         {
             IOCHANNEL_SETSYSERRORFROMERRNO( self );
@@ -386,12 +661,56 @@ bool IOChannelGenericMem_unmapFd( IOChannel *self )
         retVal = true;
     }
 
+    streamPtr->isGrowable = false;
+
     outLabel:
 #endif
     return retVal;
 }
 
 
+bool IOChannelGenericMem_setGrowable( IOChannel *self, bool growable )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    IOChannel_valid( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+#if defined(__windows__)
+
+    ANY_LOG( 1, "Growable mappings are not available on windows at moment", ANY_LOG_WARNING );
+    IOChannel_setError( self, IOCHANNELERROR_ENOTSUP );
+
+#else
+
+    if( !growable )
+    {
+        streamPtr->isGrowable = false;
+        retVal = true;
+    }
+    else if( !streamPtr->isMapped || streamPtr->fd == -1 ||
+             IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    {
+        ANY_LOG( 5, "Only writable mappings of a file can grow", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_BMODE );
+    }
+    else
+    {
+        streamPtr->isGrowable = true;
+        IOChannelGenericMem_adviseSequential( self );
+        retVal = true;
+    }
+
+#endif
+
+    return retVal;
+}
+
+
 void IOChannelGenericMem_clear( IOChannel *self )
 {
     IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
@@ -401,6 +720,13 @@ void IOChannelGenericMem_clear( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    /* the memory may be gone already, just forget the local ring state */
+    ANY_FREE( streamPtr->ring );
+    streamPtr->ring = (IOChannelGenericMemRing *)NULL;
+
+    ANY_FREE( streamPtr->broadcast );
+    streamPtr->broadcast = (IOChannelGenericMemBroadcast *)NULL;
+
     streamPtr->ptr = (void *)NULL;
 }
 
@@ -418,41 +744,958 @@ void IOChannelGenericMem_delete( IOChannel *self )
 }
 
 
-#if !defined(__windows__)
-
-
-static bool IOChannel_setProtection( IOChannel *self, int *protection )
+bool IOChannelGenericMem_setRing( IOChannel *self, bool useRing )
 {
-    bool retVal = true;
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    bool retVal = false;
+
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+    IOChannelGenericMemRingHeader *header = (IOChannelGenericMemRingHeader *)NULL;
+    IOChannelGenericMemRing *ring = (IOChannelGenericMemRing *)NULL;
+    long long capacity = 0;
+    int state = 0;
+#endif
 
     ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid );
+    IOChannel_valid( self );
 
-    /* Modes must be compatible with prewious fd mode definition */
-    switch( IOCHANNEL_GET_ACCESS_MODE( self->mode ))
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+
+    if( !useRing )
     {
-        case IOCHANNEL_MODE_R_ONLY:
-            *protection = PROT_READ;
-            break;
+        ring = streamPtr->ring;
 
-        case IOCHANNEL_MODE_W_ONLY:
-            *protection = PROT_WRITE;
-            break;
+        if( ring )
+        {
+            header = ring->header;
 
-        case IOCHANNEL_MODE_RW:
-            *protection = ( PROT_READ | PROT_WRITE );
-            break;
+            /* wake up the other side, it would wait forever otherwise */
+            if( ring->hasWritten || IOCHANNEL_MODEIS_W_ONLY( self->mode ))
+            {
+                Atomic_set( &header->writerClosed, 1 );
+                Atomic_inc( &header->dataSeq );
+                IOChannelGenericMem_futexWake( &header->dataSeq, 1 );
+            }
 
-        default :
-            IOChannel_setError( self, IOCHANNELERROR_BMODE );
-            retVal = false;
-            break;
+            if( ring->hasRead || IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+            {
+                Atomic_set( &header->readerClosed, 1 );
+                Atomic_inc( &header->spaceSeq );
+                IOChannelGenericMem_futexWake( &header->spaceSeq, 1 );
+            }
+
+            ANY_FREE( ring );
+            streamPtr->ring = (IOChannelGenericMemRing *)NULL;
+        }
+
+        retVal = true;
+        goto outLabel;
+    }
+
+    if( streamPtr->ring )
+    {
+        retVal = true;
+        goto outLabel;
+    }
+
+    if( streamPtr->broadcast )
+    {
+        ANY_LOG( 5, "The memory is already used as a broadcast ring", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_BMMFL );
+        goto outLabel;
+    }
+
+    capacity = (long long)streamPtr->size - (long long)sizeof( IOChannelGenericMemRingHeader );
+
+    if( !streamPtr->ptr || capacity <= IOCHANNELGENERICMEM_FRAMEHEADER )
+    {
+        ANY_LOG( 5, "The memory is too small to hold a ring buffer", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_BSIZE );
+        goto outLabel;
+    }
+
+    header = (IOChannelGenericMemRingHeader *)streamPtr->ptr;
+
+    /* the first one coming sets the ring up, the others wait for it */
+    state = Atomic_testAndSetValue( &header->state, 0, IOCHANNELGENERICMEM_RINGINIT );
+
+    if( state == 0 )
+    {
+        header->writerClosed = 0;
+        header->readerClosed = 0;
+        header->capacity = capacity;
+        header->head = 0;
+        header->dataSeq = 0;
+        header->readerWaiting = 0;
+        header->tail = 0;
+        header->spaceSeq = 0;
+        header->writerWaiting = 0;
+
+        Atomic_set( &header->state, IOCHANNELGENERICMEM_RINGREADY );
+    }
+    else
+    {
+        while( state == IOCHANNELGENERICMEM_RINGINIT )
+        {
+            sched_yield();
+            state = Atomic_get( &header->state );
+        }
+
+        if( state != IOCHANNELGENERICMEM_RINGREADY || header->capacity != capacity )
+        {
+            ANY_LOG( 5, "The memory is already used by another protocol or with another size",
+                     ANY_LOG_WARNING );
+            IOChannel_setError( self, IOCHANNELERROR_BMMFL );
+            goto outLabel;
+        }
+    }
+
+    ring = ANY_TALLOC( IOChannelGenericMemRing );
+    ANY_REQUIRE( ring );
+
+    ring->header = header;
+    ring->data = (char *)streamPtr->ptr + sizeof( IOChannelGenericMemRingHeader );
+    ring->capacity = capacity;
+    ring->frameLeft = 0;
+    ring->hasRead = false;
+    ring->hasWritten = false;
+
+    /* a new producer or consumer takes over a ring closed by its predecessor */
+    if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    {
+        Atomic_set( &header->writerClosed, 0 );
+    }
+
+    if( !IOCHANNEL_MODEIS_W_ONLY( self->mode ))
+    {
+        Atomic_set( &header->readerClosed, 0 );
+    }
+
+    streamPtr->ring = ring;
+    retVal = true;
+
+    outLabel:;
+
+#else
+
+    if( useRing )
+    {
+        ANY_LOG( 1, "Ring buffers on shared memory are only available on Linux", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_ENOTSUP );
+    }
+    else
+    {
+        retVal = true;
     }
 
+#endif
+
     return retVal;
 }
 
 
+bool IOChannelGenericMem_setBroadcast( IOChannel *self, bool useBroadcast )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    bool retVal = false;
+
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+    IOChannelGenericMemBroadcastHeader *header = (IOChannelGenericMemBroadcastHeader *)NULL;
+    IOChannelGenericMemBroadcast *broadcast = (IOChannelGenericMemBroadcast *)NULL;
+    long long slotSize = 0;
+    int state = 0;
+#endif
+
+    ANY_REQUIRE( self );
+    IOChannel_valid( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+
+    if( !useBroadcast )
+    {
+        broadcast = streamPtr->broadcast;
+
+        if( broadcast )
+        {
+            header = broadcast->header;
+
+            /* let the readers get EOF once they are done */
+            if( broadcast->hasWritten || IOCHANNEL_MODEIS_W_ONLY( self->mode ))
+            {
+                Atomic_set( &header->writerClosed, 1 );
+                Atomic_inc( &header->dataSeq );
+                IOChannelGenericMem_futexWake( &header->dataSeq, INT_MAX );
+            }
+
+            ANY_FREE( broadcast );
+            streamPtr->broadcast = (IOChannelGenericMemBroadcast *)NULL;
+        }
+
+        retVal = true;
+        goto outLabel;
+    }
+
+    if( streamPtr->broadcast )
+    {
+        retVal = true;
+        goto outLabel;
+    }
+
+    if( streamPtr->ring )
+    {
+        ANY_LOG( 5, "The memory is already used as a ring buffer", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_BMMFL );
+        goto outLabel;
+    }
+
+    /* slots start on a cache line, the payload follows the slot header */
+    slotSize = ( (long long)streamPtr->size - (long long)sizeof( IOChannelGenericMemBroadcastHeader )) /
+               IOCHANNELGENERICMEM_BROADCASTSLOTS;
+    slotSize &= ~( (long long)IOCHANNELGENERICMEM_CACHELINE - 1 );
+
+    if( !streamPtr->ptr || slotSize <= (long long)sizeof( IOChannelGenericMemBroadcastSlot ))
+    {
+        ANY_LOG( 5, "The memory is too small to hold a broadcast ring", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_BSIZE );
+        goto outLabel;
+    }
+
+    header = (IOChannelGenericMemBroadcastHeader *)streamPtr->ptr;
+
+    if( IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    {
+        /* read-only readers cannot set the ring up */
+        state = Atomic_get( &header->state );
+
+        if( state == 0 || state == IOCHANNELGENERICMEM_RINGINIT )
+        {
+            ANY_LOG( 5, "The broadcast ring has not been set up by a writer yet", ANY_LOG_WARNING );
+            IOChannel_setError( self, IOCHANNELERROR_EAGAIN );
+            goto outLabel;
+        }
+    }
+    else
+    {
+        state = Atomic_testAndSetValue( &header->state, 0, IOCHANNELGENERICMEM_RINGINIT );
+
+        if( state == 0 )
+        {
+            header->writerClosed = 0;
+            header->slotCount = IOCHANNELGENERICMEM_BROADCASTSLOTS;
+            header->slotSize = slotSize;
+            header->head = 0;
+            header->dataSeq = 0;
+            header->waiters = 0;
+
+            Any_memset( (char *)streamPtr->ptr + sizeof( IOChannelGenericMemBroadcastHeader ), 0,
+                        slotSize * IOCHANNELGENERICMEM_BROADCASTSLOTS );
+
+            Atomic_set( &header->state, IOCHANNELGENERICMEM_BROADCASTREADY );
+            state = IOCHANNELGENERICMEM_BROADCASTREADY;
+        }
+
+        while( state == IOCHANNELGENERICMEM_RINGINIT )
+        {
+            sched_yield();
+            state = Atomic_get( &header->state );
+        }
+    }
+
+    if( state != IOCHANNELGENERICMEM_BROADCASTREADY ||
+        header->slotCount != IOCHANNELGENERICMEM_BROADCASTSLOTS || header->slotSize != slotSize )
+    {
+        ANY_LOG( 5, "The memory is already used by another protocol or with another size",
+                 ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_BMMFL );
+        goto outLabel;
+    }
+
+    broadcast = ANY_TALLOC( IOChannelGenericMemBroadcast );
+    ANY_REQUIRE( broadcast );
+
+    broadcast->header = header;
+    broadcast->slots = (char *)streamPtr->ptr + sizeof( IOChannelGenericMemBroadcastHeader );
+    broadcast->slotCount = IOCHANNELGENERICMEM_BROADCASTSLOTS;
+    broadcast->slotSize = slotSize;
+    broadcast->offset = 0;
+    broadcast->fragment = 0;
+    broadcast->lost = 0;
+    broadcast->hasWritten = false;
+
+    /*
+     * readers join the stream live, without the messages published before,
+     * and skip the rest of a message the writer is in the middle of
+     */
+    broadcast->next = Atomic64_get( &header->head );
+
+    if( !IOCHANNEL_MODEIS_R_ONLY( self->mode ))
+    {
+        Atomic_set( &header->writerClosed, 0 );
+    }
+
+    streamPtr->broadcast = broadcast;
+    retVal = true;
+
+    outLabel:;
+
+#else
+
+    if( useBroadcast )
+    {
+        ANY_LOG( 1, "Broadcast rings on shared memory are only available on Linux", ANY_LOG_WARNING );
+        IOChannel_setError( self, IOCHANNELERROR_ENOTSUP );
+    }
+    else
+    {
+        retVal = true;
+    }
+
+#endif
+
+    return retVal;
+}
+
+
+long *IOChannelGenericMem_getBroadcastLostPtr( IOChannel *self )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    return streamPtr->broadcast ? &streamPtr->broadcast->lost : (long *)NULL;
+}
+
+
+#if !defined(__windows__)
+
+
+static bool IOChannel_setProtection( IOChannel *self, int *protection )
+{
+    bool retVal = true;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid );
+
+    /* Modes must be compatible with prewious fd mode definition */
+    switch( IOCHANNEL_GET_ACCESS_MODE( self->mode ))
+    {
+        case IOCHANNEL_MODE_R_ONLY:
+            *protection = PROT_READ;
+            break;
+
+        case IOCHANNEL_MODE_W_ONLY:
+            *protection = PROT_WRITE;
+            break;
+
+        case IOCHANNEL_MODE_RW:
+            *protection = ( PROT_READ | PROT_WRITE );
+            break;
+
+        default :
+            IOChannel_setError( self, IOCHANNELERROR_BMODE );
+            retVal = false;
+            break;
+    }
+
+    return retVal;
+}
+
+
+static bool IOChannelGenericMem_grow( IOChannel *self, long long minSize )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    long long newSize = 0;
+    long long step = 0;
+    void *ptr = (void *)NULL;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+    ANY_REQUIRE( streamPtr->isMapped );
+
+    /* grow geometrically to keep the number of remaps low on long streams */
+    step = streamPtr->size < IOCHANNELGENERICMEM_GROWSTEP_MAX ?
+           streamPtr->size : IOCHANNELGENERICMEM_GROWSTEP_MAX;
+
+    newSize = streamPtr->size + step;
+
+    if( newSize < minSize )
+    {
+        newSize = minSize;
+    }
+
+    newSize = ( newSize + IOCHANNELGENERICMEM_GROWALIGN - 1 ) &
+              ~( (long long)IOCHANNELGENERICMEM_GROWALIGN - 1 );
+
+    if( newSize > LONG_MAX )
+    {
+        IOChannel_setError( self, IOCHANNELERROR_EOVERFLOW );
+        goto outLabel;
+    }
+
+    if( ftruncate( streamPtr->fd, (off_t)newSize ) == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+#if defined(MREMAP_MAYMOVE)
+
+    ptr = mremap( streamPtr->ptr, streamPtr->size, (size_t)newSize, MREMAP_MAYMOVE );
+
+    if( ptr == MAP_FAILED )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+#else
+
+    {
+        int protection = 0;
+
+        if( !IOChannel_setProtection( self, &protection ))
+        {
+            goto outLabel;
+        }
+
+        ptr = mmap( NULL, (size_t)newSize, protection, MAP_SHARED, streamPtr->fd, 0 );
+
+        if( ptr == MAP_FAILED )
+        {
+            IOCHANNEL_SETSYSERRORFROMERRNO( self );
+            goto outLabel;
+        }
+
+        munmap( streamPtr->ptr, streamPtr->size );
+    }
+
+#endif
+
+    ANY_LOG( 7, "Mapping of fd %d grown from %ld to %lld bytes", ANY_LOG_INFO,
+             streamPtr->fd, streamPtr->size, newSize );
+
+    streamPtr->ptr = ptr;
+    streamPtr->size = (long)newSize;
+
+    IOChannelGenericMem_adviseSequential( self );
+
+    retVal = true;
+
+    outLabel:
+    return retVal;
+}
+
+
+static void IOChannelGenericMem_adviseSequential( IOChannel *self )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    /* hints only, the mapping works the same when the kernel ignores them */
+#if defined(MADV_SEQUENTIAL)
+    madvise( streamPtr->ptr, streamPtr->size, MADV_SEQUENTIAL );
+#endif
+
+#if defined(MADV_HUGEPAGE)
+    madvise( streamPtr->ptr, streamPtr->size, MADV_HUGEPAGE );
+#endif
+
+    /*
+     * prefault the pages still to be written, as MAP_POPULATE would do on
+     * mmap(), to avoid one page fault per page while streaming
+     */
+#if defined(MADV_POPULATE_WRITE)
+    if( streamPtr->size > streamPtr->writtenSize )
+    {
+        long pageSize = sysconf( _SC_PAGESIZE );
+        long start = ( streamPtr->writtenSize / pageSize ) * pageSize;
+
+        madvise( (char *)streamPtr->ptr + start, streamPtr->size - start, MADV_POPULATE_WRITE );
+    }
+#endif
+}
+
+
+#endif
+
+
+#if defined(IOCHANNELGENERICMEM_HAVE_RING)
+
+
+static long IOChannelGenericMem_ringRead( IOChannel *self, void *buffer, long size )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    IOChannelGenericMemRingHeader *header = (IOChannelGenericMemRingHeader *)NULL;
+    IOChannelGenericMemRing *ring = (IOChannelGenericMemRing *)NULL;
+    long long tail = 0;
+    long long head = 0;
+    long nBytes = 0;
+    int frameSize = 0;
+    int seq = 0;
+    int spin = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ring = streamPtr->ring;
+    header = ring->header;
+
+    ring->hasRead = true;
+    tail = header->tail;
+
+    if( ring->frameLeft == 0 )
+    {
+        /* wait for the next message */
+        for( ;; )
+        {
+            head = Atomic64_get( &header->head );
+
+            if( head != tail )
+            {
+                break;
+            }
+
+            /* the last messages may have been published right before closing */
+            if( Atomic_get( &header->writerClosed ) && Atomic64_get( &header->head ) == tail )
+            {
+                IOCHANNEL_SET_EOF( self );
+                return 0;
+            }
+
+            if( spin < IOCHANNELGENERICMEM_RINGSPIN )
+            {
+                spin++;
+                continue;
+            }
+
+            seq = Atomic_get( &header->dataSeq );
+            Atomic_set( &header->readerWaiting, 1 );
+
+            /* the writer may have published meanwhile, without waking us */
+            if( Atomic64_get( &header->head ) == tail && !Atomic_get( &header->writerClosed ))
+            {
+                IOChannelGenericMem_futexWait( &header->dataSeq, seq, 0 );
+            }
+
+            Atomic_set( &header->readerWaiting, 0 );
+        }
+
+        /* do not look at the message before having seen it published */
+        __sync_synchronize();
+
+        IOChannelGenericMem_ringCopyOut( ring, tail, &frameSize, IOCHANNELGENERICMEM_FRAMEHEADER );
+        tail += IOCHANNELGENERICMEM_FRAMEHEADER;
+
+        /* the header comes from another process, do not trust it */
+        if( frameSize <= 0 || frameSize > head - tail )
+        {
+            ANY_LOG( 0, "Corrupted message header in the ring, size %d", ANY_LOG_ERROR, frameSize );
+            IOChannel_setError( self, IOCHANNELERROR_EIO );
+            return -1;
+        }
+
+        ring->frameLeft = frameSize;
+    }
+
+    /* never read across two messages, so each one can be read on its own */
+    nBytes = size < ring->frameLeft ? size : ring->frameLeft;
+
+    IOChannelGenericMem_ringCopyOut( ring, tail, buffer, nBytes );
+    ring->frameLeft -= nBytes;
+
+    /* full barrier: the bytes are copied out before the writer may reuse them */
+    Atomic64_add( &header->tail, tail + nBytes - header->tail );
+    Atomic_inc( &header->spaceSeq );
+
+    if( Atomic_get( &header->writerWaiting ))
+    {
+        IOChannelGenericMem_futexWake( &header->spaceSeq, 1 );
+    }
+
+    return nBytes;
+}
+
+
+static long IOChannelGenericMem_ringWrite( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    IOChannelGenericMemRingHeader *header = (IOChannelGenericMemRingHeader *)NULL;
+    IOChannelGenericMemRing *ring = (IOChannelGenericMemRing *)NULL;
+    const char *ptr = (const char *)buffer;
+    long long head = 0;
+    long long tail = 0;
+    long long needed = 0;
+    long written = 0;
+    int frameSize = 0;
+    int seq = 0;
+    int spin = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ring = streamPtr->ring;
+    header = ring->header;
+
+    ring->hasWritten = true;
+    head = header->head;
+
+    while( written < size )
+    {
+        /* messages bigger than the ring are split */
+        frameSize = (int)( ring->capacity - IOCHANNELGENERICMEM_FRAMEHEADER < size - written ?
+                           ring->capacity - IOCHANNELGENERICMEM_FRAMEHEADER : size - written );
+        needed = frameSize + IOCHANNELGENERICMEM_FRAMEHEADER;
+        spin = 0;
+
+        for( ;; )
+        {
+            if( Atomic_get( &header->readerClosed ))
+            {
+                errno = EPIPE;
+                IOCHANNEL_SETSYSERRORFROMERRNO( self );
+                return written > 0 ? written : -1;
+            }
+
+            tail = Atomic64_get( &header->tail );
+
+            if( ring->capacity - ( head - tail ) >= needed )
+            {
+                break;
+            }
+
+            if( spin < IOCHANNELGENERICMEM_RINGSPIN )
+            {
+                spin++;
+                continue;
+            }
+
+            seq = Atomic_get( &header->spaceSeq );
+            Atomic_set( &header->writerWaiting, 1 );
+
+            tail = Atomic64_get( &header->tail );
+
+            if( ring->capacity - ( head - tail ) < needed && !Atomic_get( &header->readerClosed ))
+            {
+                IOChannelGenericMem_futexWait( &header->spaceSeq, seq, 0 );
+            }
+
+            Atomic_set( &header->writerWaiting, 0 );
+        }
+
+        /* do not overwrite the space before having seen it released */
+        __sync_synchronize();
+
+        IOChannelGenericMem_ringCopyIn( ring, head, &frameSize, IOCHANNELGENERICMEM_FRAMEHEADER );
+        IOChannelGenericMem_ringCopyIn( ring, head + IOCHANNELGENERICMEM_FRAMEHEADER, ptr + written, frameSize );
+
+        head += needed;
+        written += frameSize;
+
+        /* full barrier: the message is complete before it gets published */
+        Atomic64_add( &header->head, needed );
+        Atomic_inc( &header->dataSeq );
+
+        if( Atomic_get( &header->readerWaiting ))
+        {
+            IOChannelGenericMem_futexWake( &header->dataSeq, 1 );
+        }
+    }
+
+    return written;
+}
+
+
+static void IOChannelGenericMem_ringCopyIn( IOChannelGenericMemRing *ring, long long position,
+                                            const void *buffer, long long size )
+{
+    long long index = position % ring->capacity;
+    long long first = ring->capacity - index < size ? ring->capacity - index : size;
+
+    Any_memcpy( ring->data + index, buffer, first );
+
+    if( first < size )
+    {
+        Any_memcpy( ring->data, (const char *)buffer + first, size - first );
+    }
+}
+
+
+static void IOChannelGenericMem_ringCopyOut( IOChannelGenericMemRing *ring, long long position,
+                                             void *buffer, long long size )
+{
+    long long index = position % ring->capacity;
+    long long first = ring->capacity - index < size ? ring->capacity - index : size;
+
+    Any_memcpy( buffer, ring->data + index, first );
+
+    if( first < size )
+    {
+        Any_memcpy( (char *)buffer + first, ring->data, size - first );
+    }
+}
+
+
+static long IOChannelGenericMem_broadcastRead( IOChannel *self, void *buffer, long size )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    IOChannelGenericMemBroadcastHeader *header = (IOChannelGenericMemBroadcastHeader *)NULL;
+    IOChannelGenericMemBroadcastSlot *slot = (IOChannelGenericMemBroadcastSlot *)NULL;
+    IOChannelGenericMemBroadcast *broadcast = (IOChannelGenericMemBroadcast *)NULL;
+    long long version = 0;
+    long long length = 0;
+    long long fragment = 0;
+    long long fragments = 0;
+    long long head = 0;
+    long nBytes = 0;
+    bool canRegister = false;
+    int seq = 0;
+    int spin = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    broadcast = streamPtr->broadcast;
+    header = broadcast->header;
+
+    /* the memory of read-only readers is mapped read-only */
+    canRegister = !IOCHANNEL_MODEIS_R_ONLY( self->mode );
+
+    for( ;; )
+    {
+        head = Atomic64_get( &header->head );
+
+        if( broadcast->next == head )
+        {
+            /* the last messages may have been published right before closing */
+            if( Atomic_get( &header->writerClosed ) && Atomic64_get( &header->head ) == broadcast->next )
+            {
+                IOCHANNEL_SET_EOF( self );
+                return 0;
+            }
+
+            if( spin < IOCHANNELGENERICMEM_RINGSPIN )
+            {
+                spin++;
+                continue;
+            }
+
+            seq = Atomic_get( &header->dataSeq );
+
+            /*
+             * full barrier between counting us and looking at the head, the
+             * writer does the opposite, so one of the two sees the other
+             */
+            if( canRegister )
+            {
+                Atomic_inc( &header->waiters );
+            }
+
+            /* unknown to the writer, a read-only reader only sleeps a while */
+            if( Atomic64_get( &header->head ) == broadcast->next && !Atomic_get( &header->writerClosed ))
+            {
+                IOChannelGenericMem_futexWait( &header->dataSeq, seq,
+                                               canRegister ? 0 : IOCHANNELGENERICMEM_BROADCASTPOLL );
+            }
+
+            if( canRegister )
+            {
+                Atomic_dec( &header->waiters );
+            }
+
+            continue;
+        }
+
+        if( head - broadcast->next > broadcast->slotCount )
+        {
+            return IOChannelGenericMem_broadcastOverrun( self );
+        }
+
+        slot = (IOChannelGenericMemBroadcastSlot *)( broadcast->slots +
+                                                     ( broadcast->next % broadcast->slotCount ) *
+                                                     broadcast->slotSize );
+
+        version = Atomic64_get( &slot->version );
+
+        if( version != 2 * broadcast->next + 2 )
+        {
+            return IOChannelGenericMem_broadcastOverrun( self );
+        }
+
+        __sync_synchronize();
+
+        length = slot->length;
+        fragment = slot->fragment;
+        fragments = slot->fragments;
+
+        /* torn by a concurrent write, or not written by a writer of ours */
+        if( length <= 0 || length > broadcast->slotSize - (long long)sizeof( IOChannelGenericMemBroadcastSlot ) ||
+            fragment < 0 || fragment >= fragments )
+        {
+            return IOChannelGenericMem_broadcastOverrun( self );
+        }
+
+        if( fragment != broadcast->fragment )
+        {
+            /* the start of the message got lost, do not return its tail */
+            if( broadcast->fragment == 0 && Atomic64_get( &slot->version ) == version )
+            {
+                broadcast->next++;
+                continue;
+            }
+
+            return IOChannelGenericMem_broadcastOverrun( self );
+        }
+
+        nBytes = (long)( size < length - broadcast->offset ? size : length - broadcast->offset );
+
+        if( nBytes > 0 )
+        {
+            Any_memcpy( buffer, (char *)( slot + 1 ) + broadcast->offset, nBytes );
+        }
+
+        /* the writer may have reused the slot while copying */
+        if( Atomic64_get( &slot->version ) != version || nBytes <= 0 )
+        {
+            return IOChannelGenericMem_broadcastOverrun( self );
+        }
+
+        broadcast->offset += nBytes;
+
+        if( broadcast->offset == length )
+        {
+            broadcast->next++;
+            broadcast->offset = 0;
+            broadcast->fragment = fragment + 1 < fragments ? fragment + 1 : 0;
+        }
+
+        return nBytes;
+    }
+}
+
+
+static long IOChannelGenericMem_broadcastWrite( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    IOChannelGenericMemBroadcastHeader *header = (IOChannelGenericMemBroadcastHeader *)NULL;
+    IOChannelGenericMemBroadcastSlot *slot = (IOChannelGenericMemBroadcastSlot *)NULL;
+    IOChannelGenericMemBroadcast *broadcast = (IOChannelGenericMemBroadcast *)NULL;
+    long long payload = 0;
+    long long fragments = 0;
+    long long fragment = 0;
+    long long index = 0;
+    long long chunk = 0;
+    long written = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    broadcast = streamPtr->broadcast;
+    header = broadcast->header;
+
+    broadcast->hasWritten = true;
+    payload = broadcast->slotSize - (long long)sizeof( IOChannelGenericMemBroadcastSlot );
+
+    /* messages bigger than a slot are split */
+    fragments = ( (long long)size + payload - 1 ) / payload;
+
+    for( fragment = 0; written < size; fragment++ )
+    {
+        chunk = size - written < payload ? size - written : payload;
+        index = header->head;
+
+        slot = (IOChannelGenericMemBroadcastSlot *)( broadcast->slots +
+                                                     ( index % broadcast->slotCount ) *
+                                                     broadcast->slotSize );
+
+        /* full barriers around the copy, as readers may look at it meanwhile */
+        Atomic64_set( &slot->version, 2 * index + 1 );
+
+        Any_memcpy( slot + 1, (const char *)buffer + written, chunk );
+        slot->length = chunk;
+        slot->fragment = fragment;
+        slot->fragments = fragments;
+
+        Atomic64_add( &slot->version, 1 );
+        Atomic64_add( &header->head, 1 );
+
+        written += (long)chunk;
+    }
+
+    Atomic_inc( &header->dataSeq );
+
+    /*
+     * only readers with write access count themselves, the read-only ones
+     * sleep with a timeout instead
+     */
+    if( Atomic_get( &header->waiters ) )
+    {
+        IOChannelGenericMem_futexWake( &header->dataSeq, INT_MAX );
+    }
+
+    return written;
+}
+
+
+static long IOChannelGenericMem_broadcastOverrun( IOChannel *self )
+{
+    IOChannelGenericMem *streamPtr = (IOChannelGenericMem *)NULL;
+    IOChannelGenericMemBroadcast *broadcast = (IOChannelGenericMemBroadcast *)NULL;
+    long long oldest = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    broadcast = streamPtr->broadcast;
+
+    /* skip to the oldest slot, plus one the writer might be filling right now */
+    oldest = Atomic64_get( &broadcast->header->head ) - broadcast->slotCount + 1;
+
+    if( oldest <= broadcast->next )
+    {
+        oldest = broadcast->next + 1;
+    }
+
+    ANY_LOG( 5, "Broadcast reader overrun, %lld slot(s) lost", ANY_LOG_WARNING,
+             oldest - broadcast->next );
+
+    broadcast->lost += (long)( oldest - broadcast->next );
+    broadcast->next = oldest;
+    broadcast->offset = 0;
+
+    /* what was read of the current message is incomplete, resume at the next one */
+    broadcast->fragment = 0;
+
+    IOChannel_setError( self, IOCHANNELERROR_EOVERFLOW );
+
+    return -1;
+}
+
+
+/* returns when the word changes or the time is over, 0 waits forever */
+static void IOChannelGenericMem_futexWait( int *address, int value, long microsecs )
+{
+    struct timespec timeout;
+
+    timeout.tv_sec = microsecs / 1000000;
+    timeout.tv_nsec = ( microsecs % 1000000 ) * 1000;
+
+    /* not private: the futex is shared between processes */
+    syscall( SYS_futex, address, FUTEX_WAIT, value, microsecs > 0 ? &timeout : NULL, NULL, 0 );
+}
+
+
+static void IOChannelGenericMem_futexWake( int *address, int count )
+{
+    syscall( SYS_futex, address, FUTEX_WAKE, count, NULL, NULL, 0 );
+}
+
+
 #endif
 
 
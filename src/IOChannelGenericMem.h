@@ -35,12 +35,20 @@
 extern "C" {
 #endif
 
+struct IOChannelGenericMemRing;
+
+struct IOChannelGenericMemBroadcast;
+
 typedef struct IOChannelGenericMem
 {
     int fd;
     void *ptr;
     long size;
     bool isMapped;
+    bool isGrowable;
+    long writtenSize;
+    struct IOChannelGenericMemRing *ring;
+    struct IOChannelGenericMemBroadcast *broadcast;
 }
         IOChannelGenericMem;
 
@@ -64,6 +72,25 @@ bool IOChannelGenericMem_mapFd( IOChannel *self, int fd, long size );
 
 bool IOChannelGenericMem_unmapFd( IOChannel *self );
 
+bool IOChannelGenericMem_setGrowable( IOChannel *self, bool growable );
+
+/*
+ * Streams through the memory as a single-producer/single-consumer ring
+ * buffer shared with another process (Linux only). Returns false if the
+ * memory is too small or already used by another protocol.
+ */
+bool IOChannelGenericMem_setRing( IOChannel *self, bool useRing );
+
+/*
+ * Streams through the memory from one writer to any number of readers
+ * (Linux only). The writer never waits for the readers, a reader which
+ * falls behind by more than the slots in the memory gets an overrun.
+ */
+bool IOChannelGenericMem_setBroadcast( IOChannel *self, bool useBroadcast );
+
+/* Number of messages a broadcast reader lost because of overruns */
+long *IOChannelGenericMem_getBroadcastLostPtr( IOChannel *self );
+
 void IOChannelGenericMem_clear( IOChannel *self );
 
 void IOChannelGenericMem_delete( IOChannel *self );
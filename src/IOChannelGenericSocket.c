@@ -27,8 +27,97 @@
 #include <IOChannelGenericSocket.h>
 
 
+/*
+ * datagrams waiting to be sent, or received but not yet read, when the
+ * stream moves several of them per system call
+ */
+struct IOChannelGenericSocketBatch
+{
+    int count;
+    long datagramSize;
+    BerkeleySocketDatagram *rx;
+    BaseUI8 *rxStorage;
+    int rxCount;
+    int rxNext;
+    BerkeleySocketDatagram *tx;
+    BaseUI8 *txStorage;
+    int txCount;
+};
+
+
+/*
+ * every fragment starts with this header, all fields in network byte order
+ */
+#define IOCHANNELGENERICSOCKET_FRAGMENT_MAGIC       ( 0x4652474dU )
+#define IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE  ( (long)sizeof( IOChannelGenericSocketFragmentHeader ) )
+#define IOCHANNELGENERICSOCKET_DATAGRAM_MAXSIZE     ( 65507 )
+
+typedef struct IOChannelGenericSocketFragmentHeader
+{
+    BaseUI32 magic;
+    BaseUI32 sender;
+    BaseUI32 messageId;
+    BaseUI32 messageSize;
+    BaseUI32 offset;
+    BaseUI32 index;
+    BaseUI32 count;
+}
+IOChannelGenericSocketFragmentHeader;
+
+
+/*
+ * a message whose fragments are still arriving
+ */
+struct IOChannelGenericSocketReassembly
+{
+    bool used;
+    BaseUI32 sender;
+    BaseUI32 messageId;
+    BaseUI32 messageSize;
+    BaseUI32 count;
+    BaseUI32 received;
+    BaseUI32 receivedBytes;
+    BaseUI8 *data;
+    BaseUI8 *seen;
+    unsigned long long started;
+};
+
+
+/*
+ * messages split into fragments on write and reassembled on read
+ */
+struct IOChannelGenericSocketFragment
+{
+    long fragmentSize;
+    BaseUI32 sender;
+    BaseUI32 nextMessageId;
+    BaseUI8 *tx;
+    long txLength;
+    long txCapacity;
+    BerkeleySocketDatagram *txDatagrams;
+    BaseUI8 *txStorage;
+    BaseUI8 *rxDatagram;
+    struct IOChannelGenericSocketReassembly slots[IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS];
+    long reassemblyBytes;
+    BaseUI32 completedSender[IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS];
+    BaseUI32 completedId[IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS];
+    int completedNext;
+    BaseUI8 *message;
+    long messageLength;
+    long messageNext;
+    long dropped;
+};
+
+
 long long IOChannelGenericSocket_seekBack( IOChannel *self, long long offset );
 
+static void IOChannelGenericSocket_freeBatch( IOChannel *self );
+
+static void IOChannelGenericSocket_reassemble( struct IOChannelGenericSocketFragment *fragment,
+                                               const BaseUI8 *datagram, long length );
+
+static void IOChannelGenericSocket_freeFragment( IOChannel *self );
+
 long long IOChannelGenericSocket_seekForward( IOChannel *self, long long offset );
 
 
@@ -59,6 +148,8 @@ bool IOChannelGenericSocket_init( IOChannel *self )
     streamPtr->socket = (BerkeleySocket *)NULL;
     streamPtr->socketClient = (BerkeleySocketClient *)NULL;
     streamPtr->socketServer = (BerkeleySocketServer *)NULL;
+    streamPtr->batch = (struct IOChannelGenericSocketBatch *)NULL;
+    streamPtr->fragment = (struct IOChannelGenericSocketFragment *)NULL;
 
     streamPtr->socketClient = BerkeleySocketClient_new();
     ANY_REQUIRE( streamPtr->socketClient );
@@ -201,6 +292,748 @@ long IOChannelGenericSocket_write( IOChannel *self, const void *buffer, long siz
 }
 
 
+bool IOChannelGenericSocket_setBatch( IOChannel *self, int count, long datagramSize )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketBatch *batch = (struct IOChannelGenericSocketBatch *)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( datagramSize > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->batch )
+    {
+        if( IOChannelGenericSocket_batchFlush( self ) == -1 )
+        {
+            return false;
+        }
+
+        if( streamPtr->batch->rxNext < streamPtr->batch->rxCount )
+        {
+            ANY_LOG( 5, "Dropping %d received datagrams not read yet", ANY_LOG_WARNING,
+                     streamPtr->batch->rxCount - streamPtr->batch->rxNext );
+        }
+
+        IOChannelGenericSocket_freeBatch( self );
+    }
+
+    if( count <= 1 )
+    {
+        return true;
+    }
+
+    if( count > BERKELEYSOCKET_DATAGRAMS_MAX )
+    {
+        ANY_LOG( 5, "Batches are limited to %d datagrams", ANY_LOG_WARNING, BERKELEYSOCKET_DATAGRAMS_MAX );
+        count = BERKELEYSOCKET_DATAGRAMS_MAX;
+    }
+
+    batch = ANY_TALLOC( struct IOChannelGenericSocketBatch );
+    ANY_REQUIRE( batch );
+
+    /* the datagram buffers are allocated on the first read resp. write */
+    batch->count = count;
+    batch->datagramSize = datagramSize;
+
+    streamPtr->batch = batch;
+    self->usesBatching = true;
+
+    return true;
+}
+
+
+static BerkeleySocketDatagram *IOChannelGenericSocket_newDatagrams( struct IOChannelGenericSocketBatch *batch,
+                                                                    BaseUI8 **storage )
+{
+    BerkeleySocketDatagram *datagrams = (BerkeleySocketDatagram *)NULL;
+    int i = 0;
+
+    datagrams = ANY_NTALLOC( batch->count, BerkeleySocketDatagram );
+    ANY_REQUIRE( datagrams );
+
+    *storage = (BaseUI8 *)ANY_BALLOC( batch->count * batch->datagramSize );
+    ANY_REQUIRE( *storage );
+
+    for( i = 0; i < batch->count; i++ )
+    {
+        datagrams[i].buffer = *storage + i * batch->datagramSize;
+        datagrams[i].size = (int)batch->datagramSize;
+    }
+
+    return datagrams;
+}
+
+
+long IOChannelGenericSocket_batchRead( IOChannel *self, void *buffer, long size )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketBatch *batch = (struct IOChannelGenericSocketBatch *)NULL;
+    BerkeleySocketDatagram *datagram = (BerkeleySocketDatagram *)NULL;
+    long retVal = -1;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    batch = streamPtr->batch;
+    ANY_REQUIRE( batch );
+
+    if( batch->rxNext >= batch->rxCount )
+    {
+        if( !batch->rx )
+        {
+            batch->rx = IOChannelGenericSocket_newDatagrams( batch, &batch->rxStorage );
+        }
+
+        for( i = 0; i < batch->count; i++ )
+        {
+            batch->rx[i].size = (int)batch->datagramSize;
+            batch->rx[i].addr.sin_family = 0;
+        }
+
+        batch->rxNext = 0;
+        batch->rxCount = BerkeleySocket_readDatagrams( streamPtr->socket, batch->rx, batch->count );
+
+        if( batch->rxCount <= 0 )
+        {
+            batch->rxCount = 0;
+
+            if( IOChannelGenericSocket_isEof( self ))
+            {
+                ANY_LOG( 10, "Reading from Socket: Eof Was found!", ANY_LOG_INFO );
+
+                IOCHANNEL_SET_EOF( self );
+                retVal = 0;
+            }
+            else
+            {
+                IOChannel_setError( self, IOCHANNELERROR_BSOCKR );
+            }
+
+            return retVal;
+        }
+    }
+
+    /* one datagram per read, the part not fitting into buffer is lost as with recv() */
+    datagram = &batch->rx[batch->rxNext++];
+    retVal = datagram->length < size ? datagram->length : size;
+
+    Any_memcpy( buffer, datagram->buffer, retVal );
+
+    return retVal;
+}
+
+
+long IOChannelGenericSocket_batchWrite( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketBatch *batch = (struct IOChannelGenericSocketBatch *)NULL;
+    BerkeleySocketDatagram *datagram = (BerkeleySocketDatagram *)NULL;
+    long retVal = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    batch = streamPtr->batch;
+    ANY_REQUIRE( batch );
+
+    if( !batch->tx )
+    {
+        batch->tx = IOChannelGenericSocket_newDatagrams( batch, &batch->txStorage );
+    }
+
+    /* each write is a datagram on its own, sent with the next flush or when the batch is full */
+    retVal = size < batch->datagramSize ? size : batch->datagramSize;
+
+    datagram = &batch->tx[batch->txCount++];
+    Any_memcpy( datagram->buffer, buffer, retVal );
+    datagram->size = (int)retVal;
+
+    if( batch->txCount == batch->count )
+    {
+        if( IOChannelGenericSocket_batchFlush( self ) == -1 )
+        {
+            retVal = -1;
+        }
+    }
+
+    return retVal;
+}
+
+
+long IOChannelGenericSocket_batchFlush( IOChannel *self )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketBatch *batch = (struct IOChannelGenericSocketBatch *)NULL;
+    long retVal = 0;
+    int sent = 0;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    batch = streamPtr->batch;
+
+    if( !batch || batch->txCount == 0 )
+    {
+        return 0;
+    }
+
+    sent = BerkeleySocket_writeDatagrams( streamPtr->socket, batch->tx, batch->txCount );
+
+    for( i = 0; i < sent; i++ )
+    {
+        retVal += batch->tx[i].length;
+    }
+
+    if( sent < batch->txCount )
+    {
+        if( IOChannelGenericSocket_isEof( self ))
+        {
+            ANY_LOG( 10, "Writing on Socket: Eof Was found!", ANY_LOG_INFO );
+            IOCHANNEL_SET_EOF( self );
+        }
+        else
+        {
+            IOChannel_setError( self, IOCHANNELERROR_BSOCKW );
+        }
+
+        /* datagrams are not retried, the unsent ones are dropped */
+        retVal = sent > 0 ? retVal : -1;
+    }
+
+    batch->txCount = 0;
+
+    return retVal;
+}
+
+
+static void IOChannelGenericSocket_freeBatch( IOChannel *self )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketBatch *batch = (struct IOChannelGenericSocketBatch *)NULL;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    batch = streamPtr->batch;
+
+    if( batch )
+    {
+        ANY_FREE( batch->rx );
+        ANY_FREE( batch->rxStorage );
+        ANY_FREE( batch->tx );
+        ANY_FREE( batch->txStorage );
+        ANY_FREE( batch );
+
+        streamPtr->batch = (struct IOChannelGenericSocketBatch *)NULL;
+    }
+
+    self->usesBatching = streamPtr->fragment != NULL;
+}
+
+
+bool IOChannelGenericSocket_setFragment( IOChannel *self, long fragmentSize )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketFragment *fragment = (struct IOChannelGenericSocketFragment *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        if( IOChannelGenericSocket_fragmentFlush( self ) == -1 )
+        {
+            return false;
+        }
+
+        if( streamPtr->fragment->messageNext < streamPtr->fragment->messageLength )
+        {
+            ANY_LOG( 5, "Discarding %ld unread bytes of a reassembled message", ANY_LOG_WARNING,
+                     streamPtr->fragment->messageLength - streamPtr->fragment->messageNext );
+        }
+
+        IOChannelGenericSocket_freeFragment( self );
+    }
+
+    if( fragmentSize <= 0 )
+    {
+        return true;
+    }
+
+    if( fragmentSize > IOCHANNELGENERICSOCKET_DATAGRAM_MAXSIZE - IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE )
+    {
+        ANY_LOG( 5, "Fragments are limited to %ld bytes", ANY_LOG_WARNING,
+                 IOCHANNELGENERICSOCKET_DATAGRAM_MAXSIZE - IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE );
+        return false;
+    }
+
+    /* datagrams still queued by a batch leave before the first message */
+    if( IOChannelGenericSocket_batchFlush( self ) == -1 )
+    {
+        return false;
+    }
+
+    fragment = ANY_TALLOC( struct IOChannelGenericSocketFragment );
+    ANY_REQUIRE( fragment );
+
+    fragment->fragmentSize = fragmentSize;
+
+    /* tells apart the messages of different senders talking to the same receiver */
+    fragment->sender = (BaseUI32)( (unsigned long)Any_getCurrentTimeInMicroSeconds() ^ (unsigned long)self );
+
+    streamPtr->fragment = fragment;
+    self->usesBatching = true;
+
+    return true;
+}
+
+
+long IOChannelGenericSocket_fragmentRead( IOChannel *self, void *buffer, long size )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketFragment *fragment = (struct IOChannelGenericSocketFragment *)NULL;
+    long retVal = 0;
+    long length = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    fragment = streamPtr->fragment;
+    ANY_REQUIRE( fragment );
+
+    while( fragment->messageNext >= fragment->messageLength )
+    {
+        if( !fragment->rxDatagram )
+        {
+            fragment->rxDatagram = (BaseUI8 *)ANY_BALLOC( IOCHANNELGENERICSOCKET_DATAGRAM_MAXSIZE );
+            ANY_REQUIRE( fragment->rxDatagram );
+        }
+
+        if( streamPtr->batch )
+        {
+            length = IOChannelGenericSocket_batchRead( self, fragment->rxDatagram,
+                                                       IOCHANNELGENERICSOCKET_DATAGRAM_MAXSIZE );
+        }
+        else
+        {
+            length = IOChannelGenericSocket_read( self, fragment->rxDatagram,
+                                                  IOCHANNELGENERICSOCKET_DATAGRAM_MAXSIZE );
+        }
+
+        if( length <= 0 )
+        {
+            return length;
+        }
+
+        IOChannelGenericSocket_reassemble( fragment, fragment->rxDatagram, length );
+    }
+
+    /* reads never cross the end of a message, its remainder is returned by the next ones */
+    retVal = fragment->messageLength - fragment->messageNext;
+    retVal = size < retVal ? size : retVal;
+
+    Any_memcpy( buffer, fragment->message + fragment->messageNext, retVal );
+    fragment->messageNext += retVal;
+
+    return retVal;
+}
+
+
+long IOChannelGenericSocket_fragmentWrite( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketFragment *fragment = (struct IOChannelGenericSocketFragment *)NULL;
+    BaseUI8 *tx = (BaseUI8 *)NULL;
+    long capacity = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    fragment = streamPtr->fragment;
+    ANY_REQUIRE( fragment );
+
+    if( fragment->txLength + size > IOCHANNELGENERICSOCKET_FRAGMENT_MAXMESSAGE )
+    {
+        ANY_LOG( 5, "Messages are limited to %d bytes", ANY_LOG_ERROR,
+                 IOCHANNELGENERICSOCKET_FRAGMENT_MAXMESSAGE );
+        IOChannel_setError( self, IOCHANNELERROR_EFBIG );
+        return -1;
+    }
+
+    /* all the writes up to the next flush make up one message */
+    if( fragment->txLength + size > fragment->txCapacity )
+    {
+        capacity = fragment->txCapacity > 0 ? fragment->txCapacity : fragment->fragmentSize;
+
+        while( capacity < fragment->txLength + size )
+        {
+            capacity *= 2;
+        }
+
+        tx = (BaseUI8 *)ANY_BALLOC( capacity );
+        ANY_REQUIRE( tx );
+
+        if( fragment->txLength > 0 )
+        {
+            Any_memcpy( tx, fragment->tx, fragment->txLength );
+        }
+
+        ANY_FREE( fragment->tx );
+        fragment->tx = tx;
+        fragment->txCapacity = capacity;
+    }
+
+    Any_memcpy( fragment->tx + fragment->txLength, buffer, size );
+    fragment->txLength += size;
+
+    return size;
+}
+
+
+long IOChannelGenericSocket_fragmentFlush( IOChannel *self )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketFragment *fragment = (struct IOChannelGenericSocketFragment *)NULL;
+    IOChannelGenericSocketFragmentHeader header;
+    BerkeleySocketDatagram *datagram = (BerkeleySocketDatagram *)NULL;
+    long retVal = 0;
+    long offset = 0;
+    long length = 0;
+    BaseUI32 count = 0;
+    BaseUI32 index = 0;
+    int n = 0;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    fragment = streamPtr->fragment;
+
+    if( !fragment || fragment->txLength == 0 )
+    {
+        return 0;
+    }
+
+    if( !fragment->txDatagrams )
+    {
+        fragment->txDatagrams = ANY_NTALLOC( BERKELEYSOCKET_DATAGRAMS_MAX, BerkeleySocketDatagram );
+        ANY_REQUIRE( fragment->txDatagrams );
+
+        fragment->txStorage = (BaseUI8 *)ANY_BALLOC( BERKELEYSOCKET_DATAGRAMS_MAX *
+                                                     ( IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE +
+                                                       fragment->fragmentSize ));
+        ANY_REQUIRE( fragment->txStorage );
+    }
+
+    count = (BaseUI32)(( fragment->txLength + fragment->fragmentSize - 1 ) / fragment->fragmentSize );
+
+    header.magic = htonl( IOCHANNELGENERICSOCKET_FRAGMENT_MAGIC );
+    header.sender = htonl( fragment->sender );
+    header.messageId = htonl( fragment->nextMessageId++ );
+    header.messageSize = htonl( (BaseUI32)fragment->txLength );
+    header.count = htonl( count );
+
+    retVal = fragment->txLength;
+
+    for( index = 0; index < count; index += n )
+    {
+        n = count - index < BERKELEYSOCKET_DATAGRAMS_MAX ? (int)( count - index ) : BERKELEYSOCKET_DATAGRAMS_MAX;
+
+        for( i = 0; i < n; i++ )
+        {
+            offset = (long)( index + i ) * fragment->fragmentSize;
+            length = fragment->txLength - offset;
+            length = length < fragment->fragmentSize ? length : fragment->fragmentSize;
+
+            header.offset = htonl( (BaseUI32)offset );
+            header.index = htonl( index + i );
+
+            datagram = &fragment->txDatagrams[i];
+            datagram->buffer = fragment->txStorage +
+                               i * ( IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE + fragment->fragmentSize );
+            datagram->size = (int)( IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE + length );
+            datagram->addr.sin_family = 0;
+
+            Any_memcpy( datagram->buffer, &header, IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE );
+            Any_memcpy( datagram->buffer + IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE,
+                        fragment->tx + offset, length );
+        }
+
+        if( BerkeleySocket_writeDatagrams( streamPtr->socket, fragment->txDatagrams, n ) < n )
+        {
+            if( IOChannelGenericSocket_isEof( self ))
+            {
+                ANY_LOG( 10, "Writing on Socket: Eof Was found!", ANY_LOG_INFO );
+                IOCHANNEL_SET_EOF( self );
+            }
+            else
+            {
+                IOChannel_setError( self, IOCHANNELERROR_BSOCKW );
+            }
+
+            /* the receiver drops the incomplete message once it times out */
+            retVal = -1;
+            break;
+        }
+    }
+
+    fragment->txLength = 0;
+
+    return retVal;
+}
+
+
+long *IOChannelGenericSocket_getFragmentDropped( IOChannel *self )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    return streamPtr->fragment ? &streamPtr->fragment->dropped : (long *)NULL;
+}
+
+
+static void IOChannelGenericSocket_dropReassembly( struct IOChannelGenericSocketFragment *fragment,
+                                                   struct IOChannelGenericSocketReassembly *slot,
+                                                   bool completed )
+{
+    if( !completed )
+    {
+        ANY_LOG( 7, "Dropping incomplete message %u, %u of %u fragments received", ANY_LOG_WARNING,
+                 slot->messageId, slot->received, slot->count );
+        fragment->dropped++;
+    }
+
+    fragment->reassemblyBytes -= slot->messageSize;
+
+    ANY_FREE( slot->data );
+    ANY_FREE( slot->seen );
+
+    Any_memset( slot, 0, sizeof( struct IOChannelGenericSocketReassembly ));
+}
+
+
+static struct IOChannelGenericSocketReassembly *IOChannelGenericSocket_getReassembly( struct IOChannelGenericSocketFragment *fragment,
+                                                                                     IOChannelGenericSocketFragmentHeader *header,
+                                                                                     unsigned long long now )
+{
+    struct IOChannelGenericSocketReassembly *slot = (struct IOChannelGenericSocketReassembly *)NULL;
+    struct IOChannelGenericSocketReassembly *freeSlot = (struct IOChannelGenericSocketReassembly *)NULL;
+    struct IOChannelGenericSocketReassembly *oldest = (struct IOChannelGenericSocketReassembly *)NULL;
+    int i = 0;
+
+    for( i = 0; i < IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS; i++ )
+    {
+        slot = &fragment->slots[i];
+
+        if( !slot->used )
+        {
+            freeSlot = freeSlot ? freeSlot : slot;
+        }
+        else if( slot->sender == header->sender && slot->messageId == header->messageId )
+        {
+            return slot;
+        }
+    }
+
+    /* late duplicates of a delivered message must not start it again */
+    for( i = 0; i < IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS; i++ )
+    {
+        if( fragment->completedSender[i] == header->sender && fragment->completedId[i] == header->messageId )
+        {
+            return (struct IOChannelGenericSocketReassembly *)NULL;
+        }
+    }
+
+    /* the reassembly buffer is bounded, the oldest incomplete messages make room */
+    while( !freeSlot ||
+           fragment->reassemblyBytes + header->messageSize > IOCHANNELGENERICSOCKET_FRAGMENT_MAXMESSAGE )
+    {
+        oldest = (struct IOChannelGenericSocketReassembly *)NULL;
+
+        for( i = 0; i < IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS; i++ )
+        {
+            slot = &fragment->slots[i];
+
+            if( slot->used && ( !oldest || slot->started < oldest->started ))
+            {
+                oldest = slot;
+            }
+        }
+
+        ANY_REQUIRE( oldest );
+
+        IOChannelGenericSocket_dropReassembly( fragment, oldest, false );
+        freeSlot = freeSlot ? freeSlot : oldest;
+    }
+
+    slot = freeSlot;
+
+    slot->used = true;
+    slot->sender = header->sender;
+    slot->messageId = header->messageId;
+    slot->messageSize = header->messageSize;
+    slot->count = header->count;
+    slot->started = now;
+
+    slot->data = (BaseUI8 *)ANY_BALLOC( slot->messageSize );
+    ANY_REQUIRE( slot->data );
+
+    slot->seen = (BaseUI8 *)ANY_BALLOC( ( slot->count + 7 ) / 8 );
+    ANY_REQUIRE( slot->seen );
+
+    fragment->reassemblyBytes += slot->messageSize;
+
+    return slot;
+}
+
+
+static void IOChannelGenericSocket_reassemble( struct IOChannelGenericSocketFragment *fragment,
+                                               const BaseUI8 *datagram, long length )
+{
+    struct IOChannelGenericSocketReassembly *slot = (struct IOChannelGenericSocketReassembly *)NULL;
+    IOChannelGenericSocketFragmentHeader header;
+    unsigned long long now = 0;
+    long payload = 0;
+    int i = 0;
+
+    now = Any_getTime();
+
+    for( i = 0; i < IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS; i++ )
+    {
+        slot = &fragment->slots[i];
+
+        if( slot->used && now - slot->started > IOCHANNELGENERICSOCKET_REASSEMBLY_TIMEOUT * 1000ULL )
+        {
+            IOChannelGenericSocket_dropReassembly( fragment, slot, false );
+        }
+    }
+
+    if( length < IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE )
+    {
+        ANY_LOG( 7, "Ignoring a datagram too short for a fragment", ANY_LOG_WARNING );
+        return;
+    }
+
+    Any_memcpy( &header, datagram, IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE );
+
+    header.magic = ntohl( header.magic );
+    header.sender = ntohl( header.sender );
+    header.messageId = ntohl( header.messageId );
+    header.messageSize = ntohl( header.messageSize );
+    header.offset = ntohl( header.offset );
+    header.index = ntohl( header.index );
+    header.count = ntohl( header.count );
+
+    payload = length - IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE;
+
+    if( header.magic != IOCHANNELGENERICSOCKET_FRAGMENT_MAGIC ||
+        header.messageSize == 0 || header.messageSize > IOCHANNELGENERICSOCKET_FRAGMENT_MAXMESSAGE ||
+        header.count == 0 || header.count > header.messageSize || header.index >= header.count ||
+        payload == 0 || header.offset > header.messageSize || payload > header.messageSize - header.offset )
+    {
+        ANY_LOG( 7, "Ignoring a datagram which is not a valid fragment", ANY_LOG_WARNING );
+        return;
+    }
+
+    slot = IOChannelGenericSocket_getReassembly( fragment, &header, now );
+
+    if( !slot || slot->count != header.count || slot->messageSize != header.messageSize ||
+        ( slot->seen[header.index / 8] & ( 1 << ( header.index % 8 ))))
+    {
+        return;
+    }
+
+    slot->seen[header.index / 8] |= (BaseUI8)( 1 << ( header.index % 8 ));
+    slot->received++;
+    slot->receivedBytes += (BaseUI32)payload;
+
+    Any_memcpy( slot->data + header.offset, datagram + IOCHANNELGENERICSOCKET_FRAGMENT_HEADERSIZE, payload );
+
+    if( slot->received == slot->count )
+    {
+        if( slot->receivedBytes == slot->messageSize )
+        {
+            /* only called once the previous message has been read entirely */
+            ANY_FREE( fragment->message );
+
+            fragment->message = slot->data;
+            fragment->messageLength = slot->messageSize;
+            fragment->messageNext = 0;
+            slot->data = (BaseUI8 *)NULL;
+
+            fragment->completedSender[fragment->completedNext] = slot->sender;
+            fragment->completedId[fragment->completedNext] = slot->messageId;
+            fragment->completedNext = ( fragment->completedNext + 1 ) % IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS;
+
+            IOChannelGenericSocket_dropReassembly( fragment, slot, true );
+        }
+        else
+        {
+            IOChannelGenericSocket_dropReassembly( fragment, slot, false );
+        }
+    }
+}
+
+
+static void IOChannelGenericSocket_freeFragment( IOChannel *self )
+{
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+    struct IOChannelGenericSocketFragment *fragment = (struct IOChannelGenericSocketFragment *)NULL;
+    int i = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    fragment = streamPtr->fragment;
+
+    if( fragment )
+    {
+        for( i = 0; i < IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS; i++ )
+        {
+            ANY_FREE( fragment->slots[i].data );
+            ANY_FREE( fragment->slots[i].seen );
+        }
+
+        ANY_FREE( fragment->tx );
+        ANY_FREE( fragment->txDatagrams );
+        ANY_FREE( fragment->txStorage );
+        ANY_FREE( fragment->rxDatagram );
+        ANY_FREE( fragment->message );
+        ANY_FREE( fragment );
+
+        streamPtr->fragment = (struct IOChannelGenericSocketFragment *)NULL;
+    }
+
+    self->usesBatching = streamPtr->batch != NULL;
+}
+
+
 bool IOChannelGenericSocket_isEof( IOChannel *self )
 {
     bool retVal = true;
@@ -346,6 +1179,9 @@ void IOChannelGenericSocket_clear( IOChannel *self )
     streamPtr = IOChannel_getStreamPtr( self );
     ANY_REQUIRE( streamPtr );
 
+    IOChannelGenericSocket_freeFragment( self );
+    IOChannelGenericSocket_freeBatch( self );
+
     BerkeleySocketClient_clear( streamPtr->socketClient );
     BerkeleySocketClient_delete( streamPtr->socketClient );
 
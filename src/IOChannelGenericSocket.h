@@ -32,12 +32,42 @@
 extern "C" {
 #endif
 
+/*!
+ * \brief Default payload of a message fragment
+ *
+ * Together with the IP, UDP and fragment headers it fits into the 1500 bytes
+ * of an Ethernet MTU, so that fragments are never split again by IP.
+ */
+#define IOCHANNELGENERICSOCKET_FRAGMENT_SIZE          ( 1400 )
+
+/*!
+ * \brief Largest message which can be sent or reassembled, in bytes
+ *
+ * It also bounds the memory taken by all the messages being reassembled.
+ */
+#define IOCHANNELGENERICSOCKET_FRAGMENT_MAXMESSAGE    ( 64 * 1024 * 1024 )
+
+/*!
+ * \brief Number of messages which can be reassembled at the same time
+ */
+#define IOCHANNELGENERICSOCKET_REASSEMBLY_SLOTS       ( 8 )
+
+/*!
+ * \brief Microseconds after which an incomplete message is dropped
+ */
+#define IOCHANNELGENERICSOCKET_REASSEMBLY_TIMEOUT     ( 1000000 )
+
+struct IOChannelGenericSocketBatch;
+struct IOChannelGenericSocketFragment;
+
 typedef struct IOChannelGenericSocket
 {
     int socketFd;
     BerkeleySocket *socket;
     BerkeleySocketClient *socketClient;
     BerkeleySocketServer *socketServer;
+    struct IOChannelGenericSocketBatch *batch;
+    struct IOChannelGenericSocketFragment *fragment;
 }
         IOChannelGenericSocket;
 
@@ -56,6 +86,24 @@ long IOChannelGenericSocket_write( IOChannel *self, const void *buffer, long siz
 
 bool IOChannelGenericSocket_isEof( IOChannel *self );
 
+bool IOChannelGenericSocket_setBatch( IOChannel *self, int count, long datagramSize );
+
+long IOChannelGenericSocket_batchRead( IOChannel *self, void *buffer, long size );
+
+long IOChannelGenericSocket_batchWrite( IOChannel *self, const void *buffer, long size );
+
+long IOChannelGenericSocket_batchFlush( IOChannel *self );
+
+bool IOChannelGenericSocket_setFragment( IOChannel *self, long fragmentSize );
+
+long IOChannelGenericSocket_fragmentRead( IOChannel *self, void *buffer, long size );
+
+long IOChannelGenericSocket_fragmentWrite( IOChannel *self, const void *buffer, long size );
+
+long IOChannelGenericSocket_fragmentFlush( IOChannel *self );
+
+long *IOChannelGenericSocket_getFragmentDropped( IOChannel *self );
+
 long long IOChannelGenericSocket_seek( IOChannel *self,
                                        long long offset, IOChannelWhence whence );
 
@@ -0,0 +1,562 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <IOChannelGenericUnix.h>
+
+#if !defined(__windows__)
+
+#include <poll.h>
+#include <stddef.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#endif
+
+
+#if !defined(__windows__)
+
+static socklen_t IOChannelGenericUnix_setAddress( struct sockaddr_un *address, const char *path );
+
+static void IOChannelGenericUnix_storeFds( IOChannel *self, struct msghdr *message );
+
+#endif
+
+
+void *IOChannelGenericUnix_new( void )
+{
+    IOChannelGenericUnix *self = (IOChannelGenericUnix *)NULL;
+
+    self = ANY_TALLOC( IOChannelGenericUnix );
+
+    ANY_REQUIRE( self );
+
+    return self;
+}
+
+
+bool IOChannelGenericUnix_init( IOChannel *self )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    streamPtr->fd = -1;
+    streamPtr->isSeqPacket = false;
+    streamPtr->numSendFds = 0;
+    streamPtr->numReceivedFds = 0;
+    streamPtr->receivedFd = -1;
+
+    return true;
+}
+
+
+#if !defined(__windows__)
+
+
+bool IOChannelGenericUnix_connect( IOChannel *self, const char *path, bool isSeqPacket )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+    struct sockaddr_un address;
+    socklen_t addressLength = 0;
+    bool retVal = false;
+    int fd = -1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( path );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    addressLength = IOChannelGenericUnix_setAddress( &address, path );
+
+    if( addressLength == 0 )
+    {
+        ANY_LOG( 0, "Socket path too long: %s", ANY_LOG_ERROR, path );
+        IOChannel_setError( self, IOCHANNELERROR_ENAMETOOLONG );
+        goto outLabel;
+    }
+
+    fd = socket( AF_UNIX, ( isSeqPacket ? SOCK_SEQPACKET : SOCK_STREAM ) | SOCK_CLOEXEC, 0 );
+
+    if( fd == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+    if( connect( fd, (struct sockaddr *)&address, addressLength ) == -1 )
+    {
+        ANY_LOG( 5, "Unable to connect to %s: %s", ANY_LOG_WARNING, path, strerror( errno ));
+        IOChannel_setError( self, IOCHANNELERROR_UCONCL );
+        close( fd );
+        goto outLabel;
+    }
+
+    streamPtr->fd = fd;
+    streamPtr->isSeqPacket = isSeqPacket;
+    IOChannel_setType( self, IOCHANNELTYPE_FD );
+
+    retVal = true;
+
+    outLabel:
+    return retVal;
+}
+
+
+bool IOChannelGenericUnix_accept( IOChannel *self, const char *path, bool isSeqPacket, long timeout )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+    struct sockaddr_un address;
+    struct pollfd pollFd;
+    struct stat st;
+    socklen_t addressLength = 0;
+    bool retVal = false;
+    int listenFd = -1;
+    int fd = -1;
+    int status = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( path );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    addressLength = IOChannelGenericUnix_setAddress( &address, path );
+
+    if( addressLength == 0 )
+    {
+        ANY_LOG( 0, "Socket path too long: %s", ANY_LOG_ERROR, path );
+        IOChannel_setError( self, IOCHANNELERROR_ENAMETOOLONG );
+        goto outLabel;
+    }
+
+    /* a socket file left by a server which did not close is in the way */
+    if( path[0] != '@' && lstat( path, &st ) == 0 && S_ISSOCK( st.st_mode ))
+    {
+        unlink( path );
+    }
+
+    listenFd = socket( AF_UNIX, ( isSeqPacket ? SOCK_SEQPACKET : SOCK_STREAM ) | SOCK_CLOEXEC, 0 );
+
+    if( listenFd == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+    if( bind( listenFd, (struct sockaddr *)&address, addressLength ) == -1 ||
+        listen( listenFd, 1 ) == -1 )
+    {
+        ANY_LOG( 0, "Unable to listen on %s: %s", ANY_LOG_ERROR, path, strerror( errno ));
+        IOChannel_setError( self, IOCHANNELERROR_UCONCL );
+        goto outLabel;
+    }
+
+    pollFd.fd = listenFd;
+    pollFd.events = POLLIN;
+    pollFd.revents = 0;
+
+    do
+    {
+        status = poll( &pollFd, 1, timeout > 0 ? (int)( timeout / 1000 ) : -1 );
+    }
+    while( status == -1 && errno == EINTR );
+
+    if( status <= 0 )
+    {
+        ANY_LOG( 5, "No incoming client.", ANY_LOG_INFO );
+        IOChannel_setError( self, IOCHANNELERROR_SOCKETTIMEOUT );
+        goto outLabel;
+    }
+
+    fd = accept4( listenFd, (struct sockaddr *)NULL, (socklen_t *)NULL, SOCK_CLOEXEC );
+
+    if( fd == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+    streamPtr->fd = fd;
+    streamPtr->isSeqPacket = isSeqPacket;
+    IOChannel_setType( self, IOCHANNELTYPE_FD );
+
+    retVal = true;
+
+    outLabel:
+    if( listenFd != -1 )
+    {
+        close( listenFd );
+
+        if( path[0] != '@' )
+        {
+            unlink( path );
+        }
+    }
+
+    return retVal;
+}
+
+
+long IOChannelGenericUnix_read( IOChannel *self, void *buffer, long size )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+    union
+    {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE( sizeof( int ) * IOCHANNELGENERICUNIX_MAXFDS )];
+    } control;
+    struct msghdr message;
+    struct iovec iov;
+    long retVal = -1;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    iov.iov_base = buffer;
+    iov.iov_len = size;
+
+    do
+    {
+        Any_memset( &message, 0, sizeof( message ));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof( control.buffer );
+
+        retVal = recvmsg( streamPtr->fd, &message, MSG_CMSG_CLOEXEC );
+    }
+    while( retVal == -1 && errno == EINTR );
+
+    if( retVal == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+    }
+    else
+    {
+        IOChannelGenericUnix_storeFds( self, &message );
+
+        if( retVal == 0 )
+        {
+            IOCHANNEL_SET_EOF( self );
+        }
+        else if( message.msg_flags & MSG_TRUNC )
+        {
+            ANY_LOG( 5, "Packet larger than the %ld bytes read, the rest is lost", ANY_LOG_WARNING, size );
+        }
+    }
+
+    return retVal;
+}
+
+
+long IOChannelGenericUnix_write( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+    union
+    {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE( sizeof( int ) * IOCHANNELGENERICUNIX_MAXFDS )];
+    } control;
+    struct cmsghdr *controlHeader = (struct cmsghdr *)NULL;
+    struct msghdr message;
+    struct iovec iov;
+    long retVal = 0;
+    long nBytes = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size >= 0 );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    /* stream sockets may take less than requested, packets are sent whole */
+    do
+    {
+        iov.iov_base = (char *)buffer + retVal;
+        iov.iov_len = size - retVal;
+
+        Any_memset( &message, 0, sizeof( message ));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+
+        /* the queued descriptors travel with the first bytes */
+        if( streamPtr->numSendFds > 0 )
+        {
+            Any_memset( &control, 0, sizeof( control ));
+            message.msg_control = control.buffer;
+            message.msg_controllen = CMSG_SPACE( sizeof( int ) * streamPtr->numSendFds );
+
+            controlHeader = CMSG_FIRSTHDR( &message );
+            controlHeader->cmsg_level = SOL_SOCKET;
+            controlHeader->cmsg_type = SCM_RIGHTS;
+            controlHeader->cmsg_len = CMSG_LEN( sizeof( int ) * streamPtr->numSendFds );
+            Any_memcpy( CMSG_DATA( controlHeader ), streamPtr->sendFds, sizeof( int ) * streamPtr->numSendFds );
+        }
+
+        do
+        {
+            nBytes = sendmsg( streamPtr->fd, &message, MSG_NOSIGNAL );
+        }
+        while( nBytes == -1 && errno == EINTR );
+
+        if( nBytes == -1 )
+        {
+            IOCHANNEL_SETSYSERRORFROMERRNO( self );
+            retVal = retVal > 0 ? retVal : -1;
+            break;
+        }
+
+        streamPtr->numSendFds = 0;
+        retVal += nBytes;
+    }
+    while( retVal < size && !streamPtr->isSeqPacket );
+
+    return retVal;
+}
+
+
+static socklen_t IOChannelGenericUnix_setAddress( struct sockaddr_un *address, const char *path )
+{
+    size_t length = Any_strlen( path );
+
+    if( length == 0 || length >= sizeof( address->sun_path ))
+    {
+        return 0;
+    }
+
+    Any_memset( address, 0, sizeof( struct sockaddr_un ));
+    address->sun_family = AF_UNIX;
+    Any_memcpy( address->sun_path, path, length );
+
+    if( path[0] == '@' )
+    {
+        /* abstract names start with a zero byte and are not terminated */
+        address->sun_path[0] = '\0';
+        return (socklen_t)( offsetof( struct sockaddr_un, sun_path ) + length );
+    }
+
+    return (socklen_t)sizeof( struct sockaddr_un );
+}
+
+
+static void IOChannelGenericUnix_storeFds( IOChannel *self, struct msghdr *message )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+    struct cmsghdr *controlHeader = (struct cmsghdr *)NULL;
+    int *fds = (int *)NULL;
+    int count = 0;
+    int i = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+
+    if( message->msg_flags & MSG_CTRUNC )
+    {
+        ANY_LOG( 5, "More than %d descriptors were sent at once, some are lost",
+                 ANY_LOG_WARNING, IOCHANNELGENERICUNIX_MAXFDS );
+    }
+
+    for( controlHeader = CMSG_FIRSTHDR( message ); controlHeader;
+         controlHeader = CMSG_NXTHDR( message, controlHeader ))
+    {
+        if( controlHeader->cmsg_level != SOL_SOCKET || controlHeader->cmsg_type != SCM_RIGHTS )
+        {
+            continue;
+        }
+
+        fds = (int *)CMSG_DATA( controlHeader );
+        count = (int)(( controlHeader->cmsg_len - CMSG_LEN( 0 )) / sizeof( int ));
+
+        for( i = 0; i < count; i++ )
+        {
+            if( streamPtr->numReceivedFds < IOCHANNELGENERICUNIX_MAXFDS )
+            {
+                streamPtr->receivedFds[streamPtr->numReceivedFds++] = fds[i];
+            }
+            else
+            {
+                ANY_LOG( 5, "Too many descriptors waiting to be fetched, closing fd %d",
+                         ANY_LOG_WARNING, fds[i] );
+                close( fds[i] );
+            }
+        }
+    }
+}
+
+
+#else
+
+
+bool IOChannelGenericUnix_connect( IOChannel *self, const char *path, bool isSeqPacket )
+{
+    ANY_LOG( 0, "Unix domain sockets are not supported on this platform", ANY_LOG_ERROR );
+    IOChannel_setError( self, IOCHANNELERROR_UCONCL );
+
+    return false;
+}
+
+
+bool IOChannelGenericUnix_accept( IOChannel *self, const char *path, bool isSeqPacket, long timeout )
+{
+    ANY_LOG( 0, "Unix domain sockets are not supported on this platform", ANY_LOG_ERROR );
+    IOChannel_setError( self, IOCHANNELERROR_UCONCL );
+
+    return false;
+}
+
+
+long IOChannelGenericUnix_read( IOChannel *self, void *buffer, long size )
+{
+    return -1;
+}
+
+
+long IOChannelGenericUnix_write( IOChannel *self, const void *buffer, long size )
+{
+    return -1;
+}
+
+
+#endif
+
+
+bool IOChannelGenericUnix_sendFd( IOChannel *self, int fd )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( fd < 0 || streamPtr->numSendFds == IOCHANNELGENERICUNIX_MAXFDS )
+    {
+        ANY_LOG( 5, "Unable to queue fd %d, at most %d are sent with one write",
+                 ANY_LOG_WARNING, fd, IOCHANNELGENERICUNIX_MAXFDS );
+        return false;
+    }
+
+    streamPtr->sendFds[streamPtr->numSendFds++] = fd;
+
+    return true;
+}
+
+
+int *IOChannelGenericUnix_receiveFd( IOChannel *self )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->numReceivedFds == 0 )
+    {
+        return (int *)NULL;
+    }
+
+    /* the caller owns the descriptor from now on */
+    streamPtr->receivedFd = streamPtr->receivedFds[0];
+    streamPtr->numReceivedFds--;
+
+    Any_memmove( streamPtr->receivedFds, streamPtr->receivedFds + 1,
+                 sizeof( int ) * streamPtr->numReceivedFds );
+
+    return &streamPtr->receivedFd;
+}
+
+
+int *IOChannelGenericUnix_getFdPtr( IOChannel *self )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    return streamPtr->fd != -1 ? &streamPtr->fd : (int *)NULL;
+}
+
+
+bool IOChannelGenericUnix_close( IOChannel *self )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+    bool retVal = true;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+#if !defined(__windows__)
+    /* descriptors nobody fetched would leak */
+    for( i = 0; i < streamPtr->numReceivedFds; i++ )
+    {
+        close( streamPtr->receivedFds[i] );
+    }
+
+    if( streamPtr->fd != -1 && close( streamPtr->fd ) == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        retVal = false;
+    }
+#endif
+
+    streamPtr->fd = -1;
+    streamPtr->numSendFds = 0;
+    streamPtr->numReceivedFds = 0;
+
+    return retVal;
+}
+
+
+void IOChannelGenericUnix_clear( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+}
+
+
+void IOChannelGenericUnix_delete( IOChannel *self )
+{
+    IOChannelGenericUnix *streamPtr = (IOChannelGenericUnix *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+    ANY_FREE( streamPtr );
+}
+
+
+/* EOF */
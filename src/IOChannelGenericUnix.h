@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef IOCHANNELGENERICUNIX_H
+#define IOCHANNELGENERICUNIX_H
+
+
+#include <IOChannel.h>
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * descriptors which can wait to be sent with the next write, and received
+ * descriptors which can wait to be fetched
+ */
+#define IOCHANNELGENERICUNIX_MAXFDS  ( 16 )
+
+typedef struct IOChannelGenericUnix
+{
+    int fd;
+    bool isSeqPacket;
+    int sendFds[IOCHANNELGENERICUNIX_MAXFDS];
+    int numSendFds;
+    int receivedFds[IOCHANNELGENERICUNIX_MAXFDS];
+    int numReceivedFds;
+    int receivedFd;
+}
+        IOChannelGenericUnix;
+
+
+void *IOChannelGenericUnix_new( void );
+
+bool IOChannelGenericUnix_init( IOChannel *self );
+
+/*
+ * Paths starting with '@' name a socket in the Linux abstract namespace,
+ * which has no file and vanishes with its last descriptor.
+ */
+bool IOChannelGenericUnix_connect( IOChannel *self, const char *path, bool isSeqPacket );
+
+/*
+ * Binds path, replacing a stale socket file, and waits up to timeout
+ * microseconds for one peer (forever if timeout is 0). The name is released
+ * once the peer is accepted.
+ */
+bool IOChannelGenericUnix_accept( IOChannel *self, const char *path, bool isSeqPacket, long timeout );
+
+long IOChannelGenericUnix_read( IOChannel *self, void *buffer, long size );
+
+long IOChannelGenericUnix_write( IOChannel *self, const void *buffer, long size );
+
+/* Queues a descriptor to be duplicated into the peer along with the next write */
+bool IOChannelGenericUnix_sendFd( IOChannel *self, int fd );
+
+/* Returns the oldest descriptor received and not yet fetched, or NULL */
+int *IOChannelGenericUnix_receiveFd( IOChannel *self );
+
+int *IOChannelGenericUnix_getFdPtr( IOChannel *self );
+
+bool IOChannelGenericUnix_close( IOChannel *self );
+
+void IOChannelGenericUnix_clear( IOChannel *self );
+
+void IOChannelGenericUnix_delete( IOChannel *self );
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
+
+/* EOF */
@@ -228,10 +228,23 @@ static void *IOChannelMemMapFd_getProperty( IOChannel *self, const char *propert
 static bool IOChannelMemMapFd_setProperty( IOChannel *self, const char *propertyName,
                                            void *property )
 {
+    bool retVal = false;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( propertyName );
 
-    return false;
+    IOCHANNELPROPERTY_START
+    {
+        /* (void *)true lets writes past the end grow the file and the mapping */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Growable )
+        {
+            retVal = IOChannelGenericMem_setGrowable( self, property != NULL );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Growable )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
@@ -18,32 +18,90 @@
  */
 
 
+
 /* some API parameters unused but kept for polymorphism */
 #if defined(__GNUC__)
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #endif
 
 
-#include <stdio.h>
-#include <IOChannelGenericAnsiFILE.h>
+#include <IOChannel.h>
 #include <IOChannelReferenceValue.h>
 
+#if !defined(__windows__)
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+#endif
+
 
 IOCHANNELINTERFACE_CREATE_PLUGIN( PipeCmd );
 
 
+/*
+ * commands using any of these characters are run by the shell, all the
+ * others are split at blanks and spawned directly
+ */
+#define IOCHANNELPIPECMD_SHELLCHARS  "|&;<>()$`\\\"'*?[]#~={}!\n"
+
+#define IOCHANNELPIPECMD_SHELL       "/bin/sh"
+
+
+typedef struct IOChannelPipeCmd
+{
+    long pid;
+    int readFd;
+    int writeFd;
+    FILE *fp;
+}
+        IOChannelPipeCmd;
+
+
+#if !defined(__windows__)
+
+static bool IOChannelPipeCmd_spawn( IOChannel *self, const char *command,
+                                    bool isReadable, bool isWritable );
+
+static char **IOChannelPipeCmd_splitCommand( const char *command, char **buffer );
+
+#endif
+
+
 static void *IOChannelPipeCmd_new( void )
 {
-    return IOChannelGenericAnsiFILE_new();
+    IOChannelPipeCmd *self = (IOChannelPipeCmd *)NULL;
+
+    self = ANY_TALLOC( IOChannelPipeCmd );
+
+    ANY_REQUIRE( self );
+
+    return self;
 }
 
 
 static bool IOChannelPipeCmd_init( IOChannel *self )
 {
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+
     ANY_REQUIRE( self );
     IOChannel_valid( self );
 
-    return IOChannelGenericAnsiFILE_init( self );
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    streamPtr->pid = 0;
+    streamPtr->readFd = -1;
+    streamPtr->writeFd = -1;
+    streamPtr->fp = (FILE *)NULL;
+
+    return true;
 }
 
 
@@ -90,12 +148,11 @@ static bool IOChannelPipeCmd_openFromString( IOChannel *self,
 
 #if defined(__windows__)
 
-    ANY_LOG( 1, "The popen() is not available on windows at moment", ANY_LOG_WARNING );
+    ANY_LOG( 1, "Spawning commands is not available on windows at moment", ANY_LOG_WARNING );
     IOChannel_setError( self, IOCHANNELERROR_ENOTSUP );
 
 #else
 
-    FILE *fp = NULL;
     char *command = (char *)NULL;
 
     ANY_REQUIRE( self );
@@ -116,17 +173,22 @@ static bool IOChannelPipeCmd_openFromString( IOChannel *self,
     {
         if( IOCHANNEL_MODEIS_R_ONLY( self->mode ))
         {
-            fp = popen( command, "r" );
+            retVal = IOChannelPipeCmd_spawn( self, command, true, false );
         }
         else if( IOCHANNEL_MODEIS_W_ONLY( self->mode ))
         {
-            fp = popen( command, "w" );
+            retVal = IOChannelPipeCmd_spawn( self, command, false, true );
+        }
+        else if( IOCHANNEL_MODEIS_RW( self->mode ))
+        {
+            /* we write the standard input and read the standard output of the command */
+            retVal = IOChannelPipeCmd_spawn( self, command, true, true );
         }
         else
         {
             ANY_LOG( 0, "Bad Mode was passed to \"PipeCmd://\" stream: "
                              "You Can use Only "
-                             "IOCHANNEL_MODEIS_R_ONLY or IOCHANNEL_MODEIS_W_ONLY!",
+                             "IOCHANNEL_MODE_R_ONLY, IOCHANNEL_MODE_W_ONLY or IOCHANNEL_MODE_RW!",
                      ANY_LOG_ERROR );
 
             IOChannel_setError( self, IOCHANNELERROR_BFLGS );
@@ -140,20 +202,11 @@ static bool IOChannelPipeCmd_openFromString( IOChannel *self,
         goto exitLabel;
     }
 
-    if( fp == NULL )
+    if( retVal )
     {
-        IOChannel_setError( self, IOCHANNELERROR_BOARG );
-        ANY_LOG( 5, "IOChannelPipeCmd_open(). Not valid FILE pointer argument was passed to IOChannel_openFromString",
-                 ANY_LOG_ERROR );
-        goto exitLabel;
+        IOChannel_setType( self, IOCHANNELTYPE_FD );
     }
 
-    IOChannel_setType( self, IOCHANNELTYPE_ANSIFILE );
-
-    IOChannelGenericAnsiFILE_setFp( self, (void *)fp );
-
-    retVal = true;
-
     exitLabel:;
 
 #endif
@@ -163,11 +216,76 @@ static bool IOChannelPipeCmd_openFromString( IOChannel *self,
 
 static long IOChannelPipeCmd_read( IOChannel *self, void *buffer, long size )
 {
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+    long retVal = -1;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( buffer );
     ANY_REQUIRE( size > 0 );
 
-    return IOChannelGenericAnsiFILE_read( self, buffer, size );
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+#if !defined(__windows__)
+    do
+    {
+        retVal = read( streamPtr->readFd, buffer, size );
+    }
+    while( retVal == -1 && errno == EINTR );
+
+    if( retVal == -1 )
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+    }
+    else if( retVal == 0 )
+    {
+        IOCHANNEL_SET_EOF( self );
+    }
+#endif
+
+    return retVal;
+}
+
+
+static long IOChannelPipeCmd_writeFd( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+    long retVal = 0;
+    long nBytes = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->writeFd == -1 )
+    {
+        ANY_LOG( 5, "The standard input of the command is already closed", ANY_LOG_ERROR );
+        IOChannel_setError( self, IOCHANNELERROR_EPIPE );
+        return -1;
+    }
+
+#if !defined(__windows__)
+    /* pipes may take less than requested when the command is slow */
+    while( retVal < size )
+    {
+        nBytes = write( streamPtr->writeFd, (const char *)buffer + retVal, size - retVal );
+
+        if( nBytes == -1 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            IOCHANNEL_SETSYSERRORFROMERRNO( self );
+            retVal = retVal > 0 ? retVal : -1;
+            break;
+        }
+
+        retVal += nBytes;
+    }
+#endif
+
+    return retVal;
 }
 
 
@@ -177,15 +295,28 @@ static long IOChannelPipeCmd_write( IOChannel *self, const void *buffer, long si
     ANY_REQUIRE( buffer );
     ANY_REQUIRE( size > 0 );
 
-    return IOChannelGenericAnsiFILE_write( self, buffer, size );
+    if( IOChannel_usesWriteBuffering( self ))
+    {
+        return IOChannel_addToWriteBuffer( self, buffer, size );
+    }
+    else
+    {
+        return IOChannelPipeCmd_writeFd( self, buffer, size );
+    }
 }
 
 
 static long IOChannelPipeCmd_flush( IOChannel *self )
 {
+    void *ptr = (void *)NULL;
+    long nBytes = 0;
+
     ANY_REQUIRE( self );
 
-    return IOChannelGenericAnsiFILE_flush( self );
+    nBytes = IOChannel_getWriteBufferedBytes( self );
+    ptr = IOChannel_getInternalWriteBufferPtr( self );
+
+    return nBytes > 0 ? IOChannelPipeCmd_writeFd( self, ptr, nBytes ) : 0;
 }
 
 
@@ -199,80 +330,355 @@ static long long IOChannelPipeCmd_seek( IOChannel *self,
 
 static bool IOChannelPipeCmd_close( IOChannel *self )
 {
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
     bool retVal = false;
 
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
 #if defined(__windows__)
 
-    ANY_LOG( 1, "The pclose() is not available on windows at moment", ANY_LOG_WARNING );
+    ANY_LOG( 1, "Spawning commands is not available on windows at moment", ANY_LOG_WARNING );
     IOChannel_setError( self, IOCHANNELERROR_ENOTSUP );
 
 #else
 
-    ANY_REQUIRE( self );
+    int status = 0;
+    pid_t pid = -1;
 
-    /* Default and Close */
-    if( !IOCHANNEL_MODEIS_NOTCLOSE( self->mode ))
+    /*
+     * like pclose(), the command gets EOF and we wait for it to terminate,
+     * also with IOCHANNEL_MODE_NOTCLOSE as nobody else could reap it
+     */
+    if( streamPtr->fp )
     {
-        void *fp = IOChannelGenericAnsiFILE_getFp( self );
-        ANY_REQUIRE( fp );
-
-        if( pclose( fp ) == EOF )
+        /* the FILE owns the descriptor it was opened on */
+        if( fileno( streamPtr->fp ) == streamPtr->readFd )
         {
-            ANY_LOG( 5, "IOChannelPipeCmd_close: "
-                    "unable to close the FILE stream", ANY_LOG_WARNING );
-            retVal = false;
+            streamPtr->readFd = -1;
         }
         else
         {
-            /* Not Close */
-            retVal = true;
+            streamPtr->writeFd = -1;
         }
+
+        fclose( streamPtr->fp );
+    }
+
+    if( streamPtr->writeFd != -1 )
+    {
+        close( streamPtr->writeFd );
+    }
+
+    if( streamPtr->readFd != -1 )
+    {
+        close( streamPtr->readFd );
+    }
+
+    do
+    {
+        pid = waitpid( (pid_t)streamPtr->pid, &status, 0 );
+    }
+    while( pid == -1 && errno == EINTR );
+
+    if( pid == -1 )
+    {
+        ANY_LOG( 5, "IOChannelPipeCmd_close: "
+                "unable to wait for the command", ANY_LOG_WARNING );
+        retVal = false;
     }
     else
     {
-        IOChannelGenericAnsiFILE_setFp( self, (void *)NULL );
+        if( !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+        {
+            ANY_LOG( 7, "The command terminated with status 0x%x", ANY_LOG_INFO, status );
+        }
+
         retVal = true;
     }
 
 #endif
 
+    streamPtr->pid = 0;
+    streamPtr->readFd = -1;
+    streamPtr->writeFd = -1;
+    streamPtr->fp = (FILE *)NULL;
+
     return retVal;
 }
 
 
 static void *IOChannelPipeCmd_getProperty( IOChannel *self, const char *propertyName )
 {
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+    void *retVal = (void *)NULL;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( propertyName );
 
-    return IOChannelGenericAnsiFILE_getProperty( self, propertyName );
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* the standard output of the command, or its standard input if write-only */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Fd )
+        {
+            retVal = streamPtr->readFd != -1 ? (void *)&streamPtr->readFd :
+                     streamPtr->writeFd != -1 ? (void *)&streamPtr->writeFd : (void *)NULL;
+        }
+        IOCHANNELPROPERTY_PARSE_END( Fd )
+
+        IOCHANNELPROPERTY_PARSE_BEGIN( Pid )
+        {
+            retVal = streamPtr->pid > 0 ? (void *)&streamPtr->pid : (void *)NULL;
+        }
+        IOCHANNELPROPERTY_PARSE_END( Pid )
+
+        /*
+         * the FILE of the former popen() based stream, opened on the same
+         * descriptor as Fd and closed with the stream
+         */
+        IOCHANNELPROPERTY_PARSE_BEGIN( AnsiFile )
+        {
+#if !defined(__windows__)
+            if( !streamPtr->fp && streamPtr->readFd != -1 )
+            {
+                streamPtr->fp = fdopen( streamPtr->readFd, "r" );
+            }
+            else if( !streamPtr->fp && streamPtr->writeFd != -1 )
+            {
+                streamPtr->fp = fdopen( streamPtr->writeFd, "w" );
+            }
+#endif
+            retVal = streamPtr->fp;
+        }
+        IOCHANNELPROPERTY_PARSE_END( AnsiFile )
+    }
+    IOCHANNELPROPERTY_END;
+
+    if( !retVal )
+    {
+        ANY_LOG( 7, "Property '%s' not set or not defined for this stream",
+                 ANY_LOG_WARNING, propertyName );
+    }
+
+    return retVal;
 }
 
 
 static bool IOChannelPipeCmd_setProperty( IOChannel *self, const char *propertyName,
                                           void *property )
 {
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+    bool retVal = false;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( propertyName );
 
-    return IOChannelGenericAnsiFILE_setProperty( self, propertyName, property );
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    IOCHANNELPROPERTY_START
+    {
+        /*
+         * (void *)true sends EOF to the command while its output can still
+         * be read, as filters like sort need before they answer
+         */
+        IOCHANNELPROPERTY_PARSE_BEGIN( CloseWrite )
+        {
+            if( property && streamPtr->writeFd != -1 && IOChannel_flush( self ) != -1 )
+            {
+#if !defined(__windows__)
+                if( streamPtr->fp && fileno( streamPtr->fp ) == streamPtr->writeFd )
+                {
+                    fclose( streamPtr->fp );
+                    streamPtr->fp = (FILE *)NULL;
+                }
+                else
+                {
+                    close( streamPtr->writeFd );
+                }
+#endif
+                streamPtr->writeFd = -1;
+                retVal = true;
+            }
+        }
+        IOCHANNELPROPERTY_PARSE_END( CloseWrite )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
 static void IOChannelPipeCmd_clear( IOChannel *self )
 {
     ANY_REQUIRE( self );
-
-    IOChannelGenericAnsiFILE_clear( self );
 }
 
 
 static void IOChannelPipeCmd_delete( IOChannel *self )
 {
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+
     ANY_REQUIRE( self );
 
-    IOChannelGenericAnsiFILE_delete( self );
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+    ANY_FREE( streamPtr );
 }
 
 
+#if !defined(__windows__)
+
+static bool IOChannelPipeCmd_spawn( IOChannel *self, const char *command,
+                                    bool isReadable, bool isWritable )
+{
+    IOChannelPipeCmd *streamPtr = (IOChannelPipeCmd *)NULL;
+    posix_spawn_file_actions_t actions;
+    char *shellArgv[] = { (char *)"sh", (char *)"-c", (char *)NULL, (char *)NULL };
+    char **argv = (char **)NULL;
+    char *buffer = (char *)NULL;
+    int outPipe[2] = { -1, -1 };
+    int inPipe[2] = { -1, -1 };
+    bool retVal = false;
+    pid_t pid = -1;
+    int status = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    /* our ends must not leak into the command, nor into other children */
+    if(( isReadable && pipe2( outPipe, O_CLOEXEC ) == -1 ) ||
+       ( isWritable && pipe2( inPipe, O_CLOEXEC ) == -1 ))
+    {
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+    posix_spawn_file_actions_init( &actions );
+
+    if( isReadable )
+    {
+        posix_spawn_file_actions_adddup2( &actions, outPipe[1], STDOUT_FILENO );
+    }
+
+    if( isWritable )
+    {
+        posix_spawn_file_actions_adddup2( &actions, inPipe[0], STDIN_FILENO );
+    }
+
+    /*
+     * posix_spawn() does not copy the address space as fork() does, which
+     * matters for processes with a large memory footprint, and the shell is
+     * only started when the command needs it
+     */
+    if( strpbrk( command, IOCHANNELPIPECMD_SHELLCHARS ))
+    {
+        shellArgv[2] = (char *)command;
+        status = posix_spawn( &pid, IOCHANNELPIPECMD_SHELL, &actions, NULL, shellArgv, environ );
+    }
+    else
+    {
+        argv = IOChannelPipeCmd_splitCommand( command, &buffer );
+        status = argv[0] ? posix_spawnp( &pid, argv[0], &actions, NULL, argv, environ ) : EINVAL;
+    }
+
+    posix_spawn_file_actions_destroy( &actions );
+
+    if( status != 0 )
+    {
+        ANY_LOG( 5, "IOChannelPipeCmd_open(). Unable to run '%s': %s", ANY_LOG_ERROR,
+                 command, strerror( status ));
+        errno = status;
+        IOCHANNEL_SETSYSERRORFROMERRNO( self );
+        goto outLabel;
+    }
+
+    streamPtr->pid = (long)pid;
+    streamPtr->readFd = outPipe[0];
+    streamPtr->writeFd = inPipe[1];
+    outPipe[0] = -1;
+    inPipe[1] = -1;
+
+    retVal = true;
+
+    outLabel:
+    /* the ends of the command are closed in any case, ours only on failure */
+    if( outPipe[0] != -1 )
+    {
+        close( outPipe[0] );
+    }
+
+    if( outPipe[1] != -1 )
+    {
+        close( outPipe[1] );
+    }
+
+    if( inPipe[0] != -1 )
+    {
+        close( inPipe[0] );
+    }
+
+    if( inPipe[1] != -1 )
+    {
+        close( inPipe[1] );
+    }
+
+    ANY_FREE( argv );
+    ANY_FREE( buffer );
+
+    return retVal;
+}
+
+
+static char **IOChannelPipeCmd_splitCommand( const char *command, char **buffer )
+{
+    char **argv = (char **)NULL;
+    char *ptr = (char *)NULL;
+    size_t length = 0;
+    int argc = 0;
+
+    length = Any_strlen( command );
+
+    *buffer = (char *)ANY_BALLOC( length + 1 );
+    ANY_REQUIRE( *buffer );
+
+    Any_memcpy( *buffer, command, length );
+
+    /* at most one argument every two characters, plus the terminating NULL */
+    argv = ANY_NTALLOC( length / 2 + 2, char * );
+    ANY_REQUIRE( argv );
+
+    ptr = *buffer;
+
+    while( *ptr )
+    {
+        while( *ptr == ' ' || *ptr == '\t' )
+        {
+            *ptr++ = '\0';
+        }
+
+        if( *ptr )
+        {
+            argv[argc++] = ptr;
+
+            while( *ptr && *ptr != ' ' && *ptr != '\t' )
+            {
+                ptr++;
+            }
+        }
+    }
+
+    argv[argc] = (char *)NULL;
+
+    return argv;
+}
+
+#endif
+
+
 /* EOF */
@@ -108,6 +108,8 @@ static bool IOChannelServerUdp_openFromString( IOChannel *self,
     BerkeleySocketType protocol = BERKELEYSOCKET_UDP;
     BerkeleySocket *socket;
     int maxClient = 1;
+    int batch = 0;
+    int fragment = 0;
     char *broadcastPtr = NULL;
 
     ANY_REQUIRE( self );
@@ -215,6 +217,20 @@ static bool IOChannelServerUdp_openFromString( IOChannel *self,
     retVal = IOChannelGenericSocket_setSocket( self, socket );
     ANY_REQUIRE( streamPtr->socket );
 
+    batch = IOChannelReferenceValue_getInt( referenceVector, "batch" );
+
+    if( retVal && batch > 1 )
+    {
+        retVal = IOChannelGenericSocket_setBatch( self, batch, IOCHANNELSERVERUDP_SOCKET_BUFFSIZE );
+    }
+
+    fragment = IOChannelReferenceValue_getInt( referenceVector, "fragment" );
+
+    if( retVal && fragment > 0 )
+    {
+        retVal = IOChannelGenericSocket_setFragment( self, fragment );
+    }
+
     exitLabel:;
     return retVal;
 #undef HOSTNAME_MAXLEN
@@ -224,21 +240,48 @@ static bool IOChannelServerUdp_openFromString( IOChannel *self,
 
 static long IOChannelServerUdp_read( IOChannel *self, void *buffer, long size )
 {
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( buffer );
     ANY_REQUIRE( size > 0 );
 
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        return IOChannelGenericSocket_fragmentRead( self, buffer, size );
+    }
+    else if( streamPtr->batch )
+    {
+        return IOChannelGenericSocket_batchRead( self, buffer, size );
+    }
+
     return IOChannelGenericSocket_read( self, buffer, size );
 }
 
 
 static long IOChannelServerUdp_write( IOChannel *self, const void *buffer, long size )
 {
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( buffer );
     ANY_REQUIRE( size > 0 );
 
-    if( IOChannel_usesWriteBuffering( self ))
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        return IOChannelGenericSocket_fragmentWrite( self, buffer, size );
+    }
+    else if( streamPtr->batch )
+    {
+        return IOChannelGenericSocket_batchWrite( self, buffer, size );
+    }
+    else if( IOChannel_usesWriteBuffering( self ))
     {
         return IOChannel_addToWriteBuffer( self, buffer, size );
     }
@@ -253,11 +296,24 @@ static long IOChannelServerUdp_write( IOChannel *self, const void *buffer, long
 
 static long IOChannelServerUdp_flush( IOChannel *self )
 {
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
     void *ptr = (void *)NULL;
     long nBytes = 0;
 
     ANY_REQUIRE( self );
 
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        return IOChannelGenericSocket_fragmentFlush( self );
+    }
+    else if( streamPtr->batch )
+    {
+        return IOChannelGenericSocket_batchFlush( self );
+    }
+
     nBytes = IOChannel_getWriteBufferedBytes( self );
     ptr = IOChannel_getInternalWriteBufferPtr( self );
 
@@ -327,6 +383,13 @@ static void *IOChannelServerUdp_getProperty( IOChannel *self, const char *proper
         }
         IOCHANNELPROPERTY_PARSE_END( Socket )
 
+        /* pointer to the number of incomplete messages dropped by the reassembly */
+        IOCHANNELPROPERTY_PARSE_BEGIN( FragmentDropped )
+        {
+            retVal = IOChannelGenericSocket_getFragmentDropped( self );
+        }
+        IOCHANNELPROPERTY_PARSE_END( FragmentDropped )
+
         IOCHANNELPROPERTY_PARSE_BEGIN( SocketServer )
         {
             retVal = streamPtr->socketServer;
@@ -349,7 +412,31 @@ static void *IOChannelServerUdp_getProperty( IOChannel *self, const char *proper
 
 static bool IOChannelServerUdp_setProperty( IOChannel *self, const char *propertyName, void *property )
 {
-    return false;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* pointer to the number of datagrams moved per system call, NULL or 1 disables */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Batch )
+        {
+            retVal = IOChannelGenericSocket_setBatch( self, property ? *(int *)property : 0,
+                                                      IOCHANNELSERVERUDP_SOCKET_BUFFSIZE );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Batch )
+
+        /* pointer to the payload size of the fragments messages are split into, NULL disables */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Fragment )
+        {
+            retVal = IOChannelGenericSocket_setFragment( self, property ? *(int *)property : 0 );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Fragment )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
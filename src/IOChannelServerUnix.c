@@ -0,0 +1,281 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/* some API parameters unused but kept for polymorphism */
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+
+#include <IOChannelGenericUnix.h>
+#include <IOChannelReferenceValue.h>
+
+
+IOCHANNELINTERFACE_CREATE_PLUGIN( ServerUnix );
+
+#define IOCHANNELSERVERUNIX_SOCKET_TIMEOUT  60
+#define IOCHANNELSERVERUNIX_TYPESTRING  "type"
+#define IOCHANNELSERVERUNIX_WAITCLIENTTIMEOUTSTRING "waitClientTimeout"
+
+
+static void *IOChannelServerUnix_new( void )
+{
+    return IOChannelGenericUnix_new();
+}
+
+
+static bool IOChannelServerUnix_init( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+
+    IOChannel_valid( self );
+
+    return IOChannelGenericUnix_init( self );
+}
+
+
+static bool IOChannelServerUnix_open( IOChannel *self, char *infoString,
+                                IOChannelMode mode,
+                                IOChannelPermissions permissions, va_list varArg )
+{
+    bool retVal = false;
+    IOChannelReferenceValue **vect = (IOChannelReferenceValue **)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( infoString );
+
+    IOChannel_valid( self );
+
+    if( *infoString == IOCHANNELREFERENCEVALUE_EOF )
+    {
+        ANY_LOG( 0, "ServerUnix stream needs a socket path.", ANY_LOG_ERROR );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    IOCHANNELREFERENCEVALUE_BEGINSET( &vect )
+
+    IOCHANNELREFERENCEVALUE_ADDSET( name, "%s", infoString );
+
+    IOCHANNELREFERENCEVALUE_ENDSET( &vect );
+
+    retVal = IOChannelServerUnix_openFromString( self, vect );
+
+    IOCHANNELREFERENCEVALUE_FREESET( &vect );
+
+    outLabel:;
+    return retVal;
+}
+
+
+static bool IOChannelServerUnix_openFromString( IOChannel *self,
+                                          IOChannelReferenceValue **referenceVector )
+{
+    char *path = (char *)NULL;
+    char *type = (char *)NULL;
+    char *readTimeout = (char *)NULL;
+    long timeout = 0;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( referenceVector );
+
+    IOChannel_valid( self );
+
+    if( !IOCHANNEL_MODEIS_DEFINED( self->mode ))
+    {
+        self->mode = IOCHANNEL_MODE_RW;
+    }
+
+    path = IOChannelReferenceValue_getString( referenceVector, IOCHANNELREFERENCEVALUE_NAME );
+
+    if( !path )
+    {
+        ANY_LOG( 5, "Error. Socket path not found.", ANY_LOG_ERROR );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    /* "stream" (default) or "seqpacket", which keeps the boundaries of the writes */
+    type = IOChannelReferenceValue_getString( referenceVector, IOCHANNELSERVERUNIX_TYPESTRING );
+
+    if( type && Any_strcasecmp( type, "seqpacket" ) != 0 && Any_strcasecmp( type, "stream" ) != 0 )
+    {
+        ANY_LOG( 0, "Bad socket type was passed![%s]", ANY_LOG_ERROR, type );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    readTimeout = IOChannelReferenceValue_getString( referenceVector, IOCHANNELSERVERUNIX_WAITCLIENTTIMEOUTSTRING );
+    if( !readTimeout )
+    {
+        /* No user specified client timeout, defaulting to IOCHANNELSERVERUNIX_SOCKET_TIMEOUT */
+        timeout = IOCHANNELSERVERUNIX_SOCKET_TIMEOUT * 1000000L;
+    }
+    else
+    {
+        timeout = atol( readTimeout );
+    }
+
+    ANY_LOG( 7, "Incoming client timeout: %ld", ANY_LOG_INFO, timeout );
+
+    retVal = IOChannelGenericUnix_accept( self, path, type && Any_strcasecmp( type, "seqpacket" ) == 0, timeout );
+
+    outLabel:
+    return retVal;
+}
+
+
+static long IOChannelServerUnix_read( IOChannel *self, void *buffer, long size )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    return IOChannelGenericUnix_read( self, buffer, size );
+}
+
+
+static long IOChannelServerUnix_write( IOChannel *self, const void *buffer, long size )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    if( IOChannel_usesWriteBuffering( self ))
+    {
+        return IOChannel_addToWriteBuffer( self, buffer, size );
+    }
+    else
+    {
+        return IOChannelGenericUnix_write( self, buffer, size );
+    }
+}
+
+
+static long IOChannelServerUnix_flush( IOChannel *self )
+{
+    void *ptr = (void *)NULL;
+    long nBytes = 0;
+
+    ANY_REQUIRE( self );
+
+    nBytes = IOChannel_getWriteBufferedBytes( self );
+    ptr = IOChannel_getInternalWriteBufferPtr( self );
+
+    return IOChannelGenericUnix_write( self, ptr, nBytes );
+}
+
+
+static long long IOChannelServerUnix_seek( IOChannel *self, long long offset, IOChannelWhence whence )
+{
+    return 0;
+}
+
+
+static bool IOChannelServerUnix_close( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+
+    if( IOCHANNEL_MODEIS_NOTCLOSE( self->mode ))
+    {
+        return true;
+    }
+    else
+    {
+        return IOChannelGenericUnix_close( self );
+    }
+}
+
+
+static void *IOChannelServerUnix_getProperty( IOChannel *self, const char *propertyName )
+{
+    void *retVal = (void *)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        IOCHANNELPROPERTY_PARSE_BEGIN( Fd )
+        {
+            retVal = (void *)IOChannelGenericUnix_getFdPtr( self );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Fd )
+
+        /* pointer to the next descriptor sent by the peer, NULL if there is none */
+        IOCHANNELPROPERTY_PARSE_BEGIN( ReceivedFd )
+        {
+            retVal = (void *)IOChannelGenericUnix_receiveFd( self );
+        }
+        IOCHANNELPROPERTY_PARSE_END( ReceivedFd )
+    }
+    IOCHANNELPROPERTY_END;
+
+    if( !retVal )
+    {
+        ANY_LOG( 7, "Property '%s' not set or not defined for this stream",
+                 ANY_LOG_WARNING, propertyName );
+    }
+
+    return retVal;
+}
+
+
+static bool IOChannelServerUnix_setProperty( IOChannel *self, const char *propertyName, void *property )
+{
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* pointer to a descriptor the peer receives along with the next write */
+        IOCHANNELPROPERTY_PARSE_BEGIN( SendFd )
+        {
+            retVal = property && IOChannelGenericUnix_sendFd( self, *(int *)property );
+        }
+        IOCHANNELPROPERTY_PARSE_END( SendFd )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
+}
+
+
+static void IOChannelServerUnix_clear( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+
+    IOChannelGenericUnix_clear( self );
+}
+
+
+static void IOChannelServerUnix_delete( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+
+    IOChannelGenericUnix_delete( self );
+}
+
+
+/* EOF */
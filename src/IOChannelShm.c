@@ -283,6 +283,9 @@ static bool IOChannelShm_close( IOChannel *self )
         else
         {
             /* This is the converse operation of shmget-openByKey */
+            IOChannelGenericMem_setRing( self, false );
+            IOChannelGenericMem_setBroadcast( self, false );
+
             status = shmdt( streamPtr->ptr );
             if( status == -1 )
             {
@@ -323,6 +326,13 @@ static void *IOChannelShm_getProperty( IOChannel *self, const char *propertyName
             retVal = streamPtr->ptr;
         }
         IOCHANNELPROPERTY_PARSE_END( MemPointer )
+
+        /* (long *) messages lost by this broadcast reader */
+        IOCHANNELPROPERTY_PARSE_BEGIN( BroadcastLost )
+        {
+            retVal = IOChannelGenericMem_getBroadcastLostPtr( self );
+        }
+        IOCHANNELPROPERTY_PARSE_END( BroadcastLost )
     }
     IOCHANNELPROPERTY_END;
 
@@ -340,7 +350,30 @@ static void *IOChannelShm_getProperty( IOChannel *self, const char *propertyName
 static bool IOChannelShm_setProperty( IOChannel *self, const char *propertyName,
                                       void *property )
 {
-    return false;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* (void *)true streams through the memory as a ring buffer */
+        IOCHANNELPROPERTY_PARSE_BEGIN( RingBuffer )
+        {
+            retVal = IOChannelGenericMem_setRing( self, property != NULL );
+        }
+        IOCHANNELPROPERTY_PARSE_END( RingBuffer )
+
+        /* (void *)true streams from one writer to many readers */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Broadcast )
+        {
+            retVal = IOChannelGenericMem_setBroadcast( self, property != NULL );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Broadcast )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
@@ -0,0 +1,770 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/* some API parameters unused but kept for polymorphism */
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+
+#include <IOChannel.h>
+#include <IOChannelReferenceValue.h>
+#include <Cond.h>
+#include <Mutex.h>
+#include <Threads.h>
+
+
+IOCHANNELINTERFACE_CREATE_PLUGIN( Tee );
+
+
+#define IOCHANNELTEE_MAXSINKS          ( 16 )
+
+/* writes which can be queued for a sink, whatever their size */
+#define IOCHANNELTEE_QUEUELEN          ( 256 )
+
+/* bytes which can be queued for a sink unless "limit" says otherwise */
+#define IOCHANNELTEE_DEFAULTLIMIT      ( 4 * 1024 * 1024 )
+
+#define IOCHANNELTEE_POLICYSTRING      "policy"
+#define IOCHANNELTEE_LIMITSTRING       "limit"
+#define IOCHANNELTEE_THREADSSTRING     "threads"
+
+
+typedef enum IOChannelTeePolicy
+{
+    IOCHANNELTEE_POLICY_BLOCK,  /* wait for slow sinks */
+    IOCHANNELTEE_POLICY_DROP,   /* drop data for sinks still busy */
+    IOCHANNELTEE_POLICY_BUFFER  /* queue up to the limit, then drop */
+}
+        IOChannelTeePolicy;
+
+
+/* data of one write, shared by all the sinks it is queued for */
+typedef struct IOChannelTeeChunk
+{
+    int refCount;
+    long size;
+}
+        IOChannelTeeChunk;
+
+#define IOCHANNELTEECHUNK_DATA( __chunk ) ( (char *)( (__chunk) + 1 ) )
+
+
+struct IOChannelTee;
+
+typedef struct IOChannelTeeSink
+{
+    struct IOChannelTee *tee;
+    IOChannel *channel;
+    Threads *thread;
+    IOChannelTeeChunk *queue[IOCHANNELTEE_QUEUELEN];
+    int head;
+    int count;
+    long pendingBytes;
+    bool flushPending;
+    bool failed;
+}
+        IOChannelTeeSink;
+
+
+typedef struct IOChannelTee
+{
+    IOChannelTeeSink sinks[IOCHANNELTEE_MAXSINKS];
+    int numSinks;
+    IOChannelTeePolicy policy;
+    long limit;
+    bool useThreads;
+    bool quit;
+    long droppedBytes;
+    Mutex *mutex;
+    Cond *dataCond;
+    Cond *spaceCond;
+}
+        IOChannelTee;
+
+
+static bool IOChannelTee_addSink( IOChannel *self, IOChannel *channel );
+
+static long IOChannelTee_writeSinks( IOChannel *self, const void *buffer, long size );
+
+static long IOChannelTee_queueSinks( IOChannel *self, const void *buffer, long size );
+
+static bool IOChannelTee_flushSinks( IOChannel *self );
+
+static void IOChannelTee_releaseChunk( IOChannelTeeChunk *chunk );
+
+static void *IOChannelTee_sinkThread( void *arg );
+
+
+static void *IOChannelTee_new( void )
+{
+    IOChannelTee *self = (IOChannelTee *)NULL;
+
+    self = ANY_TALLOC( IOChannelTee );
+
+    ANY_REQUIRE( self );
+
+    return self;
+}
+
+
+static bool IOChannelTee_init( IOChannel *self )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+
+    ANY_REQUIRE( self );
+    IOChannel_valid( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    streamPtr->numSinks = 0;
+    streamPtr->policy = IOCHANNELTEE_POLICY_BLOCK;
+    streamPtr->limit = IOCHANNELTEE_DEFAULTLIMIT;
+    streamPtr->useThreads = false;
+    streamPtr->quit = false;
+    streamPtr->droppedBytes = 0;
+    streamPtr->mutex = (Mutex *)NULL;
+    streamPtr->dataCond = (Cond *)NULL;
+    streamPtr->spaceCond = (Cond *)NULL;
+
+    return true;
+}
+
+
+static bool IOChannelTee_open( IOChannel *self, char *infoString,
+                               IOChannelMode mode,
+                               IOChannelPermissions permissions, va_list varArg )
+{
+    bool retVal = false;
+    IOChannelReferenceValue **vect = (IOChannelReferenceValue **)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( infoString );
+
+    IOChannel_valid( self );
+
+    IOCHANNELREFERENCEVALUE_BEGINSET( &vect )
+
+    /* "Tee://drop" is the same as "stream=Tee policy=drop" */
+    if( *infoString != IOCHANNELREFERENCEVALUE_EOF )
+    {
+        IOCHANNELREFERENCEVALUE_ADDSET( policy, "%s", infoString );
+    }
+
+    IOCHANNELREFERENCEVALUE_ENDSET( &vect );
+
+    retVal = IOChannelTee_openFromString( self, vect );
+
+    IOCHANNELREFERENCEVALUE_FREESET( &vect );
+
+    return retVal;
+}
+
+
+static bool IOChannelTee_openFromString( IOChannel *self,
+                                         IOChannelReferenceValue **referenceVector )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    char *policy = (char *)NULL;
+    char *limit = (char *)NULL;
+    char *threads = (char *)NULL;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( referenceVector );
+
+    IOChannel_valid( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( !IOCHANNEL_MODEIS_DEFINED( self->mode ))
+    {
+        self->mode = IOCHANNEL_MODE_W_ONLY;
+    }
+
+    if( !IOCHANNEL_MODEIS_W_ONLY( self->mode ))
+    {
+        ANY_LOG( 0, "Bad Mode was passed to \"Tee://\" stream: "
+                         "only IOCHANNEL_MODE_W_ONLY can be used", ANY_LOG_ERROR );
+        IOChannel_setError( self, IOCHANNELERROR_BFLGS );
+        goto outLabel;
+    }
+
+    policy = IOChannelReferenceValue_getString( referenceVector, IOCHANNELTEE_POLICYSTRING );
+
+    if( !policy || Any_strcasecmp( policy, "block" ) == 0 )
+    {
+        streamPtr->policy = IOCHANNELTEE_POLICY_BLOCK;
+    }
+    else if( Any_strcasecmp( policy, "drop" ) == 0 )
+    {
+        streamPtr->policy = IOCHANNELTEE_POLICY_DROP;
+    }
+    else if( Any_strcasecmp( policy, "buffer" ) == 0 )
+    {
+        streamPtr->policy = IOCHANNELTEE_POLICY_BUFFER;
+    }
+    else
+    {
+        ANY_LOG( 0, "Bad policy was passed![%s]", ANY_LOG_ERROR, policy );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    limit = IOChannelReferenceValue_getString( referenceVector, IOCHANNELTEE_LIMITSTRING );
+    streamPtr->limit = limit ? atol( limit ) : IOCHANNELTEE_DEFAULTLIMIT;
+
+    if( streamPtr->limit <= 0 )
+    {
+        ANY_LOG( 0, "Bad limit was passed![%s]", ANY_LOG_ERROR, limit );
+        IOChannel_setError( self, IOCHANNELERROR_BIST );
+        goto outLabel;
+    }
+
+    threads = IOChannelReferenceValue_getString( referenceVector, IOCHANNELTEE_THREADSSTRING );
+    streamPtr->useThreads = threads && atoi( threads ) != 0;
+
+    streamPtr->numSinks = 0;
+    streamPtr->quit = false;
+    streamPtr->droppedBytes = 0;
+
+    if( streamPtr->useThreads )
+    {
+        streamPtr->mutex = Mutex_new();
+        ANY_REQUIRE( streamPtr->mutex );
+        Mutex_init( streamPtr->mutex, MUTEX_PRIVATE );
+
+        streamPtr->dataCond = Cond_new();
+        ANY_REQUIRE( streamPtr->dataCond );
+        Cond_init( streamPtr->dataCond, COND_PRIVATE );
+        Cond_setMutex( streamPtr->dataCond, streamPtr->mutex );
+
+        streamPtr->spaceCond = Cond_new();
+        ANY_REQUIRE( streamPtr->spaceCond );
+        Cond_init( streamPtr->spaceCond, COND_PRIVATE );
+        Cond_setMutex( streamPtr->spaceCond, streamPtr->mutex );
+    }
+
+    /* flushes must reach the sinks even when nothing is buffered here */
+    self->usesBatching = true;
+
+    retVal = true;
+
+    outLabel:
+    return retVal;
+}
+
+
+static long IOChannelTee_read( IOChannel *self, void *buffer, long size )
+{
+    ANY_LOG( 5, "\"Tee://\" streams are write-only", ANY_LOG_ERROR );
+    IOChannel_setError( self, IOCHANNELERROR_ENOTSUP );
+
+    return -1;
+}
+
+
+static long IOChannelTee_write( IOChannel *self, const void *buffer, long size )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( buffer );
+    ANY_REQUIRE( size > 0 );
+
+    if( IOChannel_usesWriteBuffering( self ))
+    {
+        return IOChannel_addToWriteBuffer( self, buffer, size );
+    }
+    else
+    {
+        return IOChannelTee_writeSinks( self, buffer, size );
+    }
+}
+
+
+static long IOChannelTee_flush( IOChannel *self )
+{
+    void *ptr = (void *)NULL;
+    long nBytes = 0;
+    long retVal = 0;
+
+    ANY_REQUIRE( self );
+
+    nBytes = IOChannel_getWriteBufferedBytes( self );
+    ptr = IOChannel_getInternalWriteBufferPtr( self );
+
+    if( nBytes > 0 )
+    {
+        retVal = IOChannelTee_writeSinks( self, ptr, nBytes );
+    }
+
+    if( retVal != -1 && !IOChannelTee_flushSinks( self ))
+    {
+        retVal = -1;
+    }
+
+    return retVal;
+}
+
+
+static long long IOChannelTee_seek( IOChannel *self, long long offset, IOChannelWhence whence )
+{
+    return 0;
+}
+
+
+static bool IOChannelTee_close( IOChannel *self )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    IOChannelTeeSink *sink = (IOChannelTeeSink *)NULL;
+    int i = 0;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    /* the sinks were flushed already, they belong to the caller which closes them */
+    if( streamPtr->useThreads )
+    {
+        Mutex_lock( streamPtr->mutex );
+        streamPtr->quit = true;
+        Cond_broadcast( streamPtr->dataCond );
+        Mutex_unlock( streamPtr->mutex );
+
+        for( i = 0; i < streamPtr->numSinks; i++ )
+        {
+            sink = &streamPtr->sinks[i];
+
+            /* the threads empty their queue before leaving */
+            Threads_join( sink->thread, NULL );
+            Threads_clear( sink->thread );
+            Threads_delete( sink->thread );
+        }
+
+        Cond_clear( streamPtr->spaceCond );
+        Cond_delete( streamPtr->spaceCond );
+
+        Cond_clear( streamPtr->dataCond );
+        Cond_delete( streamPtr->dataCond );
+
+        Mutex_clear( streamPtr->mutex );
+        Mutex_delete( streamPtr->mutex );
+    }
+
+    streamPtr->numSinks = 0;
+    streamPtr->mutex = (Mutex *)NULL;
+    streamPtr->dataCond = (Cond *)NULL;
+    streamPtr->spaceCond = (Cond *)NULL;
+
+    return true;
+}
+
+
+static void *IOChannelTee_getProperty( IOChannel *self, const char *propertyName )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    void *retVal = (void *)NULL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* bytes not delivered to some sink, once for each of them */
+        IOCHANNELPROPERTY_PARSE_BEGIN( DroppedBytes )
+        {
+            retVal = &streamPtr->droppedBytes;
+        }
+        IOCHANNELPROPERTY_PARSE_END( DroppedBytes )
+    }
+    IOCHANNELPROPERTY_END;
+
+    if( !retVal )
+    {
+        ANY_LOG( 7, "Property '%s' not set or not defined for this stream",
+                 ANY_LOG_WARNING, propertyName );
+    }
+
+    return retVal;
+}
+
+
+static bool IOChannelTee_setProperty( IOChannel *self, const char *propertyName,
+                                      void *property )
+{
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        IOCHANNELPROPERTY_PARSE_BEGIN( AddSink )
+        {
+            retVal = property && IOChannelTee_addSink( self, (IOChannel *)property );
+        }
+        IOCHANNELPROPERTY_PARSE_END( AddSink )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
+}
+
+
+static void IOChannelTee_clear( IOChannel *self )
+{
+    ANY_REQUIRE( self );
+}
+
+
+static void IOChannelTee_delete( IOChannel *self )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+
+    ANY_REQUIRE( self );
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+    ANY_FREE( streamPtr );
+}
+
+
+static bool IOChannelTee_addSink( IOChannel *self, IOChannel *channel )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    IOChannelTeeSink *sink = (IOChannelTeeSink *)NULL;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->numSinks >= IOCHANNELTEE_MAXSINKS )
+    {
+        ANY_LOG( 5, "A \"Tee://\" stream can have at most %d sinks", ANY_LOG_ERROR,
+                 IOCHANNELTEE_MAXSINKS );
+        return false;
+    }
+
+    /* the sink threads only look at the sinks they were started for */
+    sink = &streamPtr->sinks[streamPtr->numSinks];
+    Any_memset( sink, 0, sizeof( IOChannelTeeSink ));
+
+    sink->tee = streamPtr;
+    sink->channel = channel;
+
+    if( streamPtr->useThreads )
+    {
+        sink->thread = Threads_new();
+        ANY_REQUIRE( sink->thread );
+        Threads_init( sink->thread, true );
+
+        if( Threads_start( sink->thread, IOChannelTee_sinkThread, sink ) != 0 )
+        {
+            ANY_LOG( 5, "Unable to start the thread of a sink", ANY_LOG_ERROR );
+            Threads_clear( sink->thread );
+            Threads_delete( sink->thread );
+            return false;
+        }
+
+        Mutex_lock( streamPtr->mutex );
+        streamPtr->numSinks++;
+        Mutex_unlock( streamPtr->mutex );
+    }
+    else
+    {
+        streamPtr->numSinks++;
+    }
+
+    return true;
+}
+
+
+static long IOChannelTee_writeSinks( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    IOChannelTeeSink *sink = (IOChannelTeeSink *)NULL;
+    long retVal = size;
+    int i = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+
+    if( streamPtr->useThreads )
+    {
+        return IOChannelTee_queueSinks( self, buffer, size );
+    }
+
+    for( i = 0; i < streamPtr->numSinks; i++ )
+    {
+        sink = &streamPtr->sinks[i];
+
+        if( sink->failed )
+        {
+            streamPtr->droppedBytes += size;
+            continue;
+        }
+
+        if( IOChannel_writeBlock( sink->channel, buffer, size ) != size ||
+            IOChannel_isErrorOccurred( sink->channel ))
+        {
+            if( streamPtr->policy == IOCHANNELTEE_POLICY_BLOCK )
+            {
+                /* all the sinks get all the data, or the write fails */
+                self->errnoValue = IOChannel_getErrnoValue( sink->channel );
+                IOChannel_setError( self, IOChannel_getErrorNumber( sink->channel ));
+                retVal = -1;
+            }
+            else
+            {
+                ANY_LOG( 5, "Sink %d of a \"Tee://\" stream failed, skipping it from now on",
+                         ANY_LOG_WARNING, i );
+                sink->failed = true;
+                streamPtr->droppedBytes += size;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+
+static long IOChannelTee_queueSinks( IOChannel *self, const void *buffer, long size )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    IOChannelTeeSink *sink = (IOChannelTeeSink *)NULL;
+    IOChannelTeeChunk *chunk = (IOChannelTeeChunk *)NULL;
+    bool fits = false;
+    int i = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+
+    /* a single copy, whatever the number of sinks */
+    chunk = (IOChannelTeeChunk *)ANY_BALLOC( sizeof( IOChannelTeeChunk ) + size );
+    ANY_REQUIRE( chunk );
+
+    chunk->refCount = 1;
+    chunk->size = size;
+    Any_memcpy( IOCHANNELTEECHUNK_DATA( chunk ), buffer, size );
+
+    Mutex_lock( streamPtr->mutex );
+
+    for( i = 0; i < streamPtr->numSinks; i++ )
+    {
+        sink = &streamPtr->sinks[i];
+
+        while( true )
+        {
+            /* a write larger than the limit still goes to an idle sink */
+            fits = sink->count < IOCHANNELTEE_QUEUELEN &&
+                   ( sink->pendingBytes == 0 ||
+                     ( streamPtr->policy != IOCHANNELTEE_POLICY_DROP &&
+                       sink->pendingBytes + size <= streamPtr->limit ));
+
+            if( fits || sink->failed || streamPtr->policy != IOCHANNELTEE_POLICY_BLOCK )
+            {
+                break;
+            }
+
+            Cond_wait( streamPtr->spaceCond, 0 );
+        }
+
+        if( fits && !sink->failed )
+        {
+            sink->queue[( sink->head + sink->count ) % IOCHANNELTEE_QUEUELEN] = chunk;
+            sink->count++;
+            sink->pendingBytes += size;
+            chunk->refCount++;
+        }
+        else
+        {
+            streamPtr->droppedBytes += size;
+        }
+    }
+
+    Cond_broadcast( streamPtr->dataCond );
+
+    IOChannelTee_releaseChunk( chunk );
+
+    Mutex_unlock( streamPtr->mutex );
+
+    return size;
+}
+
+
+static bool IOChannelTee_flushSinks( IOChannel *self )
+{
+    IOChannelTee *streamPtr = (IOChannelTee *)NULL;
+    IOChannelTeeSink *sink = (IOChannelTeeSink *)NULL;
+    bool retVal = true;
+    bool done = false;
+    int i = 0;
+
+    streamPtr = IOChannel_getStreamPtr( self );
+
+    if( !streamPtr->useThreads )
+    {
+        for( i = 0; i < streamPtr->numSinks; i++ )
+        {
+            sink = &streamPtr->sinks[i];
+
+            if( !sink->failed && IOChannel_flush( sink->channel ) == -1 )
+            {
+                if( streamPtr->policy == IOCHANNELTEE_POLICY_BLOCK )
+                {
+                    self->errnoValue = IOChannel_getErrnoValue( sink->channel );
+                    IOChannel_setError( self, IOChannel_getErrorNumber( sink->channel ));
+                    retVal = false;
+                }
+                else
+                {
+                    sink->failed = true;
+                }
+            }
+        }
+
+        return retVal;
+    }
+
+    /* each thread flushes its sink once all the data queued so far is written */
+    Mutex_lock( streamPtr->mutex );
+
+    for( i = 0; i < streamPtr->numSinks; i++ )
+    {
+        streamPtr->sinks[i].flushPending = !streamPtr->sinks[i].failed;
+    }
+
+    Cond_broadcast( streamPtr->dataCond );
+
+    while( !done )
+    {
+        done = true;
+
+        for( i = 0; i < streamPtr->numSinks; i++ )
+        {
+            done = done && !streamPtr->sinks[i].flushPending;
+        }
+
+        if( !done )
+        {
+            Cond_wait( streamPtr->spaceCond, 0 );
+        }
+    }
+
+    Mutex_unlock( streamPtr->mutex );
+
+    return retVal;
+}
+
+
+/* to be called with the mutex held, if any */
+static void IOChannelTee_releaseChunk( IOChannelTeeChunk *chunk )
+{
+    chunk->refCount--;
+
+    if( chunk->refCount == 0 )
+    {
+        ANY_FREE( chunk );
+    }
+}
+
+
+static void *IOChannelTee_sinkThread( void *arg )
+{
+    IOChannelTeeSink *sink = (IOChannelTeeSink *)arg;
+    IOChannelTee *tee = sink->tee;
+    IOChannelTeeChunk *chunk = (IOChannelTeeChunk *)NULL;
+    bool isOk = false;
+
+    Mutex_lock( tee->mutex );
+
+    while( true )
+    {
+        while( !tee->quit && sink->count == 0 && !sink->flushPending )
+        {
+            Cond_wait( tee->dataCond, 0 );
+        }
+
+        if( sink->count > 0 )
+        {
+            chunk = sink->queue[sink->head];
+            sink->head = ( sink->head + 1 ) % IOCHANNELTEE_QUEUELEN;
+            sink->count--;
+
+            if( !sink->failed )
+            {
+                Mutex_unlock( tee->mutex );
+
+                isOk = IOChannel_writeBlock( sink->channel, IOCHANNELTEECHUNK_DATA( chunk ), chunk->size ) ==
+                       chunk->size && !IOChannel_isErrorOccurred( sink->channel );
+
+                Mutex_lock( tee->mutex );
+
+                if( !isOk )
+                {
+                    ANY_LOG( 5, "A sink of a \"Tee://\" stream failed, skipping it from now on",
+                             ANY_LOG_WARNING );
+                    sink->failed = true;
+                }
+            }
+
+            if( sink->failed )
+            {
+                tee->droppedBytes += chunk->size;
+            }
+
+            sink->pendingBytes -= chunk->size;
+            IOChannelTee_releaseChunk( chunk );
+
+            Cond_broadcast( tee->spaceCond );
+        }
+        else if( sink->flushPending )
+        {
+            if( !sink->failed )
+            {
+                Mutex_unlock( tee->mutex );
+
+                isOk = IOChannel_flush( sink->channel ) != -1;
+
+                Mutex_lock( tee->mutex );
+
+                sink->failed = sink->failed || !isOk;
+            }
+
+            sink->flushPending = false;
+
+            Cond_broadcast( tee->spaceCond );
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    Mutex_unlock( tee->mutex );
+
+    return NULL;
+}
+
+
+/* EOF */
@@ -124,6 +124,8 @@ static bool IOChannelUdp_openFromString( IOChannel *self,
     int ipPort;
     int srcPortNo = 0;
     char *broadcastPtr = NULL;
+    int batch = 0;
+    int fragment = 0;
     BerkeleySocketType protocol = BERKELEYSOCKET_UDP;
     BerkeleySocket *socket;
 
@@ -203,6 +205,20 @@ static bool IOChannelUdp_openFromString( IOChannel *self,
         BerkeleySocket_setLinger( streamPtr->socket, true, IOCHANNELUDP_SOCKET_LINGERTIMEOUT);
 
         retVal = IOChannelGenericSocket_setSocket( self, socket );
+
+        batch = IOChannelReferenceValue_getInt( referenceVector, "batch" );
+
+        if( retVal && batch > 1 )
+        {
+            retVal = IOChannelGenericSocket_setBatch( self, batch, IOCHANNELUDP_SOCKET_BUFFSIZE );
+        }
+
+        fragment = IOChannelReferenceValue_getInt( referenceVector, "fragment" );
+
+        if( retVal && fragment > 0 )
+        {
+            retVal = IOChannelGenericSocket_setFragment( self, fragment );
+        }
     }
     else
     {
@@ -217,10 +233,24 @@ static bool IOChannelUdp_openFromString( IOChannel *self,
 
 static long IOChannelUdp_read( IOChannel *self, void *buffer, long size )
 {
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( buffer );
     ANY_REQUIRE( size > 0 );
 
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        return IOChannelGenericSocket_fragmentRead( self, buffer, size );
+    }
+    else if( streamPtr->batch )
+    {
+        return IOChannelGenericSocket_batchRead( self, buffer, size );
+    }
+
     /* Read up to IOCHANNELUDP_SOCKET_BUFFSIZE bytes */
     return IOChannelGenericSocket_read( self, buffer,
                                         size > IOCHANNELUDP_SOCKET_BUFFSIZE ?
@@ -230,11 +260,24 @@ static long IOChannelUdp_read( IOChannel *self, void *buffer, long size )
 
 static long IOChannelUdp_write( IOChannel *self, const void *buffer, long size )
 {
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
+
     ANY_REQUIRE( self );
     ANY_REQUIRE( buffer );
     ANY_REQUIRE( size > 0 );
 
-    if( IOChannel_usesWriteBuffering( self ))
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        return IOChannelGenericSocket_fragmentWrite( self, buffer, size );
+    }
+    else if( streamPtr->batch )
+    {
+        return IOChannelGenericSocket_batchWrite( self, buffer, size );
+    }
+    else if( IOChannel_usesWriteBuffering( self ))
     {
         return IOChannel_addToWriteBuffer( self, buffer, size );
     }
@@ -250,6 +293,7 @@ static long IOChannelUdp_write( IOChannel *self, const void *buffer, long size )
 
 static long IOChannelUdp_flush( IOChannel *self )
 {
+    IOChannelGenericSocket *streamPtr = (IOChannelGenericSocket *)NULL;
     void *ptr = (void *)NULL;
     long nBytes = 0;
     long leftBytes = 0;
@@ -258,6 +302,18 @@ static long IOChannelUdp_flush( IOChannel *self )
 
     ANY_REQUIRE( self );
 
+    streamPtr = IOChannel_getStreamPtr( self );
+    ANY_REQUIRE( streamPtr );
+
+    if( streamPtr->fragment )
+    {
+        return IOChannelGenericSocket_fragmentFlush( self );
+    }
+    else if( streamPtr->batch )
+    {
+        return IOChannelGenericSocket_batchFlush( self );
+    }
+
     leftBytes = IOChannel_getWriteBufferedBytes( self );
     ptr = IOChannel_getInternalWriteBufferPtr( self );
 
@@ -342,6 +398,13 @@ static void *IOChannelUdp_getProperty( IOChannel *self, const char *propertyName
         }
         IOCHANNELPROPERTY_PARSE_END( SocketClient )
 
+        /* pointer to the number of incomplete messages dropped by the reassembly */
+        IOCHANNELPROPERTY_PARSE_BEGIN( FragmentDropped )
+        {
+            retVal = IOChannelGenericSocket_getFragmentDropped( self );
+        }
+        IOCHANNELPROPERTY_PARSE_END( FragmentDropped )
+
     }
     IOCHANNELPROPERTY_END;
 
@@ -357,7 +420,31 @@ static void *IOChannelUdp_getProperty( IOChannel *self, const char *propertyName
 
 static bool IOChannelUdp_setProperty( IOChannel *self, const char *propertyName, void *property )
 {
-    return false;
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( propertyName );
+
+    IOCHANNELPROPERTY_START
+    {
+        /* pointer to the number of datagrams moved per system call, NULL or 1 disables */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Batch )
+        {
+            retVal = IOChannelGenericSocket_setBatch( self, property ? *(int *)property : 0,
+                                                      IOCHANNELUDP_SOCKET_BUFFSIZE );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Batch )
+
+        /* pointer to the payload size of the fragments messages are split into, NULL disables */
+        IOCHANNELPROPERTY_PARSE_BEGIN( Fragment )
+        {
+            retVal = IOChannelGenericSocket_setFragment( self, property ? *(int *)property : 0 );
+        }
+        IOCHANNELPROPERTY_PARSE_END( Fragment )
+    }
+    IOCHANNELPROPERTY_END;
+
+    return retVal;
 }
 
 
@@ -0,0 +1,338 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <Atomic.h>
+#include <LockProfile.h>
+
+
+#define LOCKPROFILE_VALID    0x3c9a51e7
+
+#define LOCKPROFILE_INVALID  0x9e02b4d1
+
+
+struct LockProfile
+{
+    unsigned long valid;
+    const char *kind;
+    char name[LOCKPROFILE_NAME_MAXLEN];
+    AnyAtomic64 acquired;
+    AnyAtomic64 contended;
+    AnyAtomic64 failedTries;
+    AnyAtomic64 totalWaitTime;
+    AnyAtomic64 maxWaitTime;
+    AnyAtomic64 waitTimes[LOCKPROFILE_NUM_BUCKETS];
+    struct LockProfile *next;
+};
+
+
+typedef struct LockProfileSnapshot
+{
+    const char *kind;
+    char name[LOCKPROFILE_NAME_MAXLEN];
+    LockProfileStats stats;
+} LockProfileSnapshot;
+
+
+static void LockProfile_reset( LockProfile *self );
+
+static int LockProfile_compareSnapshots( const void *a, const void *b );
+
+
+/* the registered profiles, the dump may run while locks come and go */
+static pthread_mutex_t LockProfile_registryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static LockProfile *LockProfile_registry = NULL;
+
+
+LockProfile *LockProfile_new( const char *kind, const char *name )
+{
+    LockProfile *self = NULL;
+    int status = 0;
+
+    ANY_REQUIRE( kind );
+    ANY_REQUIRE( name );
+
+    self = ANY_TALLOC( LockProfile );
+    ANY_REQUIRE( self );
+
+    self->kind = kind;
+    Any_strncpy( self->name, name, LOCKPROFILE_NAME_MAXLEN - 1 );
+
+    self->valid = LOCKPROFILE_VALID;
+
+    status = pthread_mutex_lock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    self->next = LockProfile_registry;
+    LockProfile_registry = self;
+
+    status = pthread_mutex_unlock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    return self;
+}
+
+
+void LockProfile_delete( LockProfile *self )
+{
+    LockProfile **ptrNext = NULL;
+    int status = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == LOCKPROFILE_VALID );
+
+    status = pthread_mutex_lock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    for( ptrNext = &LockProfile_registry; *ptrNext != self; ptrNext = &( *ptrNext )->next )
+    {
+        ANY_REQUIRE_MSG( *ptrNext, "LockProfile not registered" );
+    }
+
+    *ptrNext = self->next;
+
+    status = pthread_mutex_unlock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    self->valid = LOCKPROFILE_INVALID;
+
+    ANY_FREE( self );
+}
+
+
+void LockProfile_record( LockProfile *self, bool contended, unsigned long long waitTime )
+{
+    unsigned long long microsecs = 0;
+    AnyAtomic64 maxWaitTime = 0;
+    int bucket = 0;
+
+    ANY_REQUIRE( self );
+
+    Atomic64_inc( &self->acquired );
+
+    if( !contended )
+    {
+        return;
+    }
+
+    Atomic64_inc( &self->contended );
+    Atomic64_add( &self->totalWaitTime, (AnyAtomic64)waitTime );
+
+    maxWaitTime = Atomic64_get( &self->maxWaitTime );
+
+    while( (AnyAtomic64)waitTime > maxWaitTime )
+    {
+        if( Atomic64_testAndSetBool( &self->maxWaitTime, maxWaitTime, (AnyAtomic64)waitTime ))
+        {
+            break;
+        }
+
+        maxWaitTime = Atomic64_get( &self->maxWaitTime );
+    }
+
+    for( microsecs = waitTime / 1000; microsecs > 0 && bucket < LOCKPROFILE_NUM_BUCKETS - 1; microsecs >>= 1 )
+    {
+        bucket++;
+    }
+
+    Atomic64_inc( &self->waitTimes[ bucket ] );
+}
+
+
+void LockProfile_recordFailedTry( LockProfile *self )
+{
+    ANY_REQUIRE( self );
+
+    Atomic64_inc( &self->failedTries );
+}
+
+
+void LockProfile_getStats( LockProfile *self, LockProfileStats *stats )
+{
+    int i;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == LOCKPROFILE_VALID );
+    ANY_REQUIRE( stats );
+
+    stats->acquired      = Atomic64_get( &self->acquired );
+    stats->contended     = Atomic64_get( &self->contended );
+    stats->failedTries   = Atomic64_get( &self->failedTries );
+    stats->totalWaitTime = Atomic64_get( &self->totalWaitTime );
+    stats->maxWaitTime   = Atomic64_get( &self->maxWaitTime );
+
+    for( i = 0; i < LOCKPROFILE_NUM_BUCKETS; i++ )
+    {
+        stats->waitTimes[ i ] = Atomic64_get( &self->waitTimes[ i ] );
+    }
+}
+
+
+void LockProfile_dump( FILE *stream )
+{
+    LockProfileSnapshot *snapshots = NULL;
+    LockProfileStats *stats = NULL;
+    LockProfile *profile = NULL;
+    long numProfiles = 0;
+    long i = 0;
+    int bucket = 0;
+    int status = 0;
+
+    ANY_REQUIRE( stream );
+
+    /* copy the counters first, the writing may take a while */
+    status = pthread_mutex_lock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    for( profile = LockProfile_registry; profile; profile = profile->next )
+    {
+        numProfiles++;
+    }
+
+    if( numProfiles > 0 )
+    {
+        snapshots = ANY_NTALLOC( numProfiles, LockProfileSnapshot );
+        ANY_REQUIRE( snapshots );
+    }
+
+    for( profile = LockProfile_registry, i = 0; profile; profile = profile->next, i++ )
+    {
+        snapshots[ i ].kind = profile->kind;
+        Any_strncpy( snapshots[ i ].name, profile->name, LOCKPROFILE_NAME_MAXLEN );
+        LockProfile_getStats( profile, &snapshots[ i ].stats );
+    }
+
+    status = pthread_mutex_unlock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    if( numProfiles > 1 )
+    {
+        qsort( snapshots, numProfiles, sizeof( LockProfileSnapshot ), LockProfile_compareSnapshots );
+    }
+
+    fprintf( stream, "Lock profile: %ld locks\n", numProfiles );
+
+    for( i = 0; i < numProfiles; i++ )
+    {
+        stats = &snapshots[ i ].stats;
+
+        fprintf( stream, "%s '%s': %llu acquired, %llu contended (%.1f%%), %llu failed tries\n",
+                 snapshots[ i ].kind, snapshots[ i ].name,
+                 stats->acquired, stats->contended,
+                 stats->acquired > 0 ? stats->contended * 100.0 / stats->acquired : 0.0,
+                 stats->failedTries );
+
+        if( stats->contended == 0 )
+        {
+            continue;
+        }
+
+        fprintf( stream, "    wait time %llu ns total, %llu ns average, %llu ns max\n",
+                 stats->totalWaitTime, stats->totalWaitTime / stats->contended,
+                 stats->maxWaitTime );
+
+        fprintf( stream, "    waits:" );
+
+        for( bucket = 0; bucket < LOCKPROFILE_NUM_BUCKETS; bucket++ )
+        {
+            if( stats->waitTimes[ bucket ] == 0 )
+            {
+                continue;
+            }
+
+            if( bucket == 0 )
+            {
+                fprintf( stream, " <1us %llu", stats->waitTimes[ bucket ] );
+            }
+            else if( bucket == LOCKPROFILE_NUM_BUCKETS - 1 )
+            {
+                fprintf( stream, " >=%luus %llu", 1UL << ( bucket - 1 ), stats->waitTimes[ bucket ] );
+            }
+            else
+            {
+                fprintf( stream, " <%luus %llu", 1UL << bucket, stats->waitTimes[ bucket ] );
+            }
+        }
+
+        fprintf( stream, "\n" );
+    }
+
+    fflush( stream );
+
+    ANY_FREE( snapshots );
+}
+
+
+void LockProfile_resetAll( void )
+{
+    LockProfile *profile = NULL;
+    int status = 0;
+
+    status = pthread_mutex_lock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+
+    for( profile = LockProfile_registry; profile; profile = profile->next )
+    {
+        LockProfile_reset( profile );
+    }
+
+    status = pthread_mutex_unlock( &LockProfile_registryMutex );
+    ANY_REQUIRE( status == 0 );
+}
+
+
+/* the counters are reset one by one, concurrent updates may survive */
+static void LockProfile_reset( LockProfile *self )
+{
+    int i;
+
+    Atomic64_set( &self->acquired, 0 );
+    Atomic64_set( &self->contended, 0 );
+    Atomic64_set( &self->failedTries, 0 );
+    Atomic64_set( &self->totalWaitTime, 0 );
+    Atomic64_set( &self->maxWaitTime, 0 );
+
+    for( i = 0; i < LOCKPROFILE_NUM_BUCKETS; i++ )
+    {
+        Atomic64_set( &self->waitTimes[ i ], 0 );
+    }
+}
+
+
+/* longest total wait time first */
+static int LockProfile_compareSnapshots( const void *a, const void *b )
+{
+    const LockProfileSnapshot *first = (const LockProfileSnapshot *)a;
+    const LockProfileSnapshot *second = (const LockProfileSnapshot *)b;
+
+    if( first->stats.totalWaitTime != second->stats.totalWaitTime )
+    {
+        return first->stats.totalWaitTime > second->stats.totalWaitTime ? -1 : 1;
+    }
+
+    return first->stats.acquired > second->stats.acquired ? -1 :
+           first->stats.acquired < second->stats.acquired ? 1 : 0;
+}
+
+
+/* EOF */
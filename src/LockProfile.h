@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOCKPROFILE_H
+#define LOCKPROFILE_H
+
+#include <stdio.h>
+
+#include <Any.h>
+
+
+/*
+ * Contention profiling of Mutex and RWLock objects, to find the lock
+ * hotspots of a running program:
+ *
+ * \code
+ * Mutex_enableProfiling( queueMutex, "frame queue" );
+ * RWLock_enableProfiling( registryLock, "subscribers" );
+ * ...
+ * LockProfile_dump( stderr );
+ * \endcode
+ *
+ * An uncontended acquisition costs one more atomic increment, a
+ * contended one reads the clock twice. The waits of Cond_wait() for the
+ * mutex are not counted.
+ */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+/*
+ * waitTimes[0] counts the waits below 1 microsecond, waitTimes[i] the
+ * ones from 2^(i-1) to 2^i microseconds and the last one all the longer
+ * ones
+ */
+#define LOCKPROFILE_NUM_BUCKETS  ( 20 )
+
+#define LOCKPROFILE_NAME_MAXLEN  ( 64 )
+
+/*
+ * contended acquisitions had to wait for another thread, failed tries
+ * are the trylock calls returning EBUSY. Times are in nanoseconds.
+ */
+typedef struct LockProfileStats
+{
+    unsigned long long acquired;
+    unsigned long long contended;
+    unsigned long long failedTries;
+    unsigned long long totalWaitTime;
+    unsigned long long maxWaitTime;
+    unsigned long long waitTimes[LOCKPROFILE_NUM_BUCKETS];
+} LockProfileStats;
+
+typedef struct LockProfile LockProfile;
+
+
+/* registers a new profile, kind is e.g. "Mutex" and must be a literal */
+LockProfile *LockProfile_new( const char *kind, const char *name );
+
+/* unregisters and frees it */
+void LockProfile_delete( LockProfile *self );
+
+/* one acquisition, waitTime is ignored if not contended */
+void LockProfile_record( LockProfile *self, bool contended, unsigned long long waitTime );
+
+void LockProfile_recordFailedTry( LockProfile *self );
+
+void LockProfile_getStats( LockProfile *self, LockProfileStats *stats );
+
+/* writes all the registered profiles, the longest total wait time first */
+void LockProfile_dump( FILE *stream );
+
+/* restarts the counting of all the registered profiles */
+void LockProfile_resetAll( void );
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
+
+/* EOF */
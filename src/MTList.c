@@ -22,11 +22,53 @@
 #include <string.h>
 #include <errno.h>
 
+#include <AnyTime.h>
+#include <MThreadKey.h>
 #include <MTList.h>
 
 
+#define MTLIST_CACHELINE  ( 64 )
+
+
+/*
+ * Read-mostly lists: readers announce the epoch in which they entered a
+ * read section in their own slot, writers unlink elements and stamp them
+ * with the epoch they have been removed in, then bump it. An element is
+ * freed once no reader is still inside a read section entered in that
+ * epoch or before, since later readers cannot reach it anymore.
+ */
+typedef struct MTListReader
+{
+    AnyAtomic epoch;             /* 0 outside of a read section */
+    AnyAtomic inUse;
+    int depth;                   /* nesting, only touched by the owner */
+    struct MTListReader *next;
+    char pad[MTLIST_CACHELINE - 2 * sizeof( AnyAtomic ) - sizeof( int ) - sizeof( void * )];
+}
+MTListReader;
+
+
+typedef struct MTListEpoch
+{
+    AnyAtomic epoch;
+    char pad[MTLIST_CACHELINE - sizeof( AnyAtomic )];
+    MThreadKey *readerKey;
+    MTListReader *readers;
+    MTListElement *retired;
+}
+MTListEpoch;
+
+
 MTListElement *MTList_searchListElement( MTList *self, int (*cmpFunc)( void *, void * ), void *searched );
 
+static MTListReader *MTList_getReader( MTList *self );
+
+static void MTList_releaseReader( void *reader );
+
+static void MTList_retire( MTList *self, MTListElement *element );
+
+static void MTList_reclaim( MTList *self );
+
 static MTListElement *MTListElement_new( void );
 
 static bool MTListElement_init( MTListElement *self, void *data );
@@ -73,6 +115,7 @@ bool MTList_init( MTList *self )
     self->last = NULL;
     self->numElement = 0L;
     self->deleteMode = MTLIST_DELETEMODE_AUTOMATIC;
+    self->epoch = NULL;
 
     self->valid = MTLIST_VALID;
 
@@ -82,6 +125,144 @@ bool MTList_init( MTList *self )
 }
 
 
+bool MTList_initReadMostly( MTList *self )
+{
+    bool retVal = false;
+
+    ANY_REQUIRE( self );
+
+    retVal = MTList_init( self );
+
+    if( retVal )
+    {
+        self->epoch = ANY_TALLOC( MTListEpoch );
+        ANY_REQUIRE_MSG( self->epoch, "unable to allocate self->epoch" );
+
+        /* 0 tells an idle reader, so the epochs start from 1 */
+        self->epoch->epoch = 1;
+
+        self->epoch->readerKey = MThreadKey_new();
+        ANY_REQUIRE_MSG( self->epoch->readerKey, "unable to allocate self->epoch->readerKey" );
+
+        retVal = MThreadKey_init( self->epoch->readerKey, MTList_releaseReader );
+
+        if( !retVal )
+        {
+            ANY_LOG( 0, "Unable to initialize the readers key", ANY_LOG_ERROR );
+
+            MThreadKey_delete( self->epoch->readerKey );
+            ANY_FREE( self->epoch );
+            self->epoch = NULL;
+
+            RWLock_clear( self->rwlock );
+            RWLock_delete( self->rwlock );
+
+            self->valid = MTLIST_INVALID;
+        }
+    }
+
+    return retVal;
+}
+
+
+void MTList_beginRead( MTList *self )
+{
+    MTListReader *reader = NULL;
+    int status = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == MTLIST_VALID );
+
+    if( !self->epoch )
+    {
+        status = RWLock_readLock( self->rwlock );
+        ANY_REQUIRE( status == 0 );
+        return;
+    }
+
+    reader = MTList_getReader( self );
+
+    if( reader->depth++ == 0 )
+    {
+        /*
+         * the full barrier of Atomic_set() makes the writers see the
+         * reader before it loads any element of the list
+         */
+        Atomic_set( &reader->epoch, Atomic_get( &self->epoch->epoch ));
+    }
+}
+
+
+void MTList_endRead( MTList *self )
+{
+    MTListReader *reader = NULL;
+    int status = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == MTLIST_VALID );
+
+    if( !self->epoch )
+    {
+        status = RWLock_unlock( self->rwlock );
+        ANY_REQUIRE( status == 0 );
+        return;
+    }
+
+    reader = (MTListReader *)MThreadKey_get( self->epoch->readerKey );
+    ANY_REQUIRE_MSG( reader && reader->depth > 0, "MTList_endRead() without MTList_beginRead()" );
+
+    if( --reader->depth == 0 )
+    {
+        Atomic_setRelease( &reader->epoch, 0 );
+    }
+}
+
+
+void MTList_synchronize( MTList *self )
+{
+    MTListReader *reader = NULL;
+    AnyAtomic epoch = 0;
+    AnyAtomic readerEpoch = 0;
+    int status = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == MTLIST_VALID );
+
+    if( !self->epoch )
+    {
+        /* the readers hold the list lock */
+        status = RWLock_writeLock( self->rwlock );
+        ANY_REQUIRE( status == 0 );
+
+        status = RWLock_unlock( self->rwlock );
+        ANY_REQUIRE( status == 0 );
+        return;
+    }
+
+    /* the readers entering from now on get the new epoch */
+    epoch = Atomic_inc( &self->epoch->epoch );
+
+    for( reader = (MTListReader *)Atomic_getAcquire( &self->epoch->readers ); reader; reader = reader->next )
+    {
+        readerEpoch = Atomic_get( &reader->epoch );
+
+        while( readerEpoch != 0 && readerEpoch < epoch )
+        {
+            Any_sleepMicroSeconds( 10 );
+            readerEpoch = Atomic_get( &reader->epoch );
+        }
+    }
+
+    status = RWLock_writeLock( self->rwlock );
+    ANY_REQUIRE( status == 0 );
+
+    MTList_reclaim( self );
+
+    status = RWLock_unlock( self->rwlock );
+    ANY_REQUIRE( status == 0 );
+}
+
+
 void MTList_setDeleteMode( MTList *self, int deleteMode )
 {
     int status = 0;
@@ -120,15 +301,19 @@ bool MTList_add( MTList *self, void *data )
             status = RWLock_writeLock( self->rwlock );
             ANY_REQUIRE( status == 0 );
 
-            /* we have some element ? */
+            /*
+             * we have some element ? The element is published with a
+             * release store, lock-free readers of read-mostly lists see
+             * it only fully initialized
+             */
             if( self->numElement )
             {
                 /* add a new element in tail */
-                self->last->next = ptr;
+                Atomic_setRelease( &self->last->next, ptr );
             }
             else
             {
-                self->first = ptr;
+                Atomic_setRelease( &self->first, ptr );
             }
 
             self->last = ptr;
@@ -214,7 +399,7 @@ bool MTList_insert( MTList *self, void *data )
         ptr->next = self->first;
 
         /* now the new first is the brand new element */
-        self->first = ptr;
+        Atomic_setRelease( &self->first, ptr );
 
         if( self->last == (MTListElement *)NULL)
         {
@@ -289,7 +474,7 @@ bool MTList_remove( MTList *self, int (*cmpFunc)( void *, void * ), void *search
         /* we have found the element ? */
         if( retCmpFunc == 0 )
         {
-            *ptrNext = ptr->next;
+            Atomic_setRelease( ptrNext, ptr->next );
 
             if( ptr == self->last )
             {
@@ -297,17 +482,26 @@ bool MTList_remove( MTList *self, int (*cmpFunc)( void *, void * ), void *search
 
                 if( oldPtr )
                 {
-                    oldPtr->next = NULL;
+                    Atomic_setRelease( &oldPtr->next, (MTListElement *)NULL );
                 }
             }
 
-            if( ptr->data && self->deleteMode == MTLIST_DELETEMODE_AUTOMATIC )
+            if( self->epoch )
             {
-                ANY_FREE( ptr->data );
+                /* lock-free readers may still walk on it */
+                MTList_retire( self, ptr );
+                MTList_reclaim( self );
             }
+            else
+            {
+                if( ptr->data && self->deleteMode == MTLIST_DELETEMODE_AUTOMATIC )
+                {
+                    ANY_FREE( ptr->data );
+                }
 
-            MTListElement_clear( ptr );
-            MTListElement_delete( ptr );
+                MTListElement_clear( ptr );
+                MTListElement_delete( ptr );
+            }
 
             self->numElement--;
             result = true;
@@ -360,7 +554,7 @@ bool MTList_set( MTList *self, void *searched, void *newData )
          */
         if( ptr->data == searched )
         {
-            ptr->data = newData;
+            Atomic_setRelease( &ptr->data, newData );
 
             /* unlock the element */
             status = RWLock_unlock( ptr->rwlock );
@@ -392,6 +586,7 @@ void *MTList_iterate( MTList *self, int (*func)( void * ), int flags )
     int status = 0;
     int retFunc = 0;
     MTListElement *ptr = NULL;
+    void *data = NULL;
     int (*lockFunc)( RWLock * ) = NULL;
 
     ANY_REQUIRE( self );
@@ -415,96 +610,118 @@ void *MTList_iterate( MTList *self, int (*func)( void * ), int flags )
     /* the lockFunc definition is required otherwise we fail */
     ANY_REQUIRE( lockFunc );
 
+    /* the elements of read-mostly lists are read without any lock */
+    if( self->epoch && lockFunc == RWLock_readLock )
+    {
+        lockFunc = NULL;
+    }
+
     /* lock the list for read */
-    status = RWLock_readLock( self->rwlock );
-    ANY_REQUIRE( status == 0 );
+    MTList_beginRead( self );
 
     /* start from the first element */
-    ptr = self->first;
+    ptr = Atomic_getAcquire( &self->first );
 
     while( ptr )
     {
         /* lock as flags request the element before to call the func() */
-        status = ( *lockFunc )( ptr->rwlock );
-        ANY_REQUIRE( status == 0 );
+        if( lockFunc )
+        {
+            status = ( *lockFunc )( ptr->rwlock );
+            ANY_REQUIRE( status == 0 );
+        }
 
         /*
           * Call the generic function. The func should return 0 to stop the
           * iteration or not zero to continue
           */
-        retFunc = ( *func )( ptr->data );
+        retFunc = ( *func )( Atomic_getAcquire( &ptr->data ));
 
         /* unlock the element */
-        status = RWLock_unlock( ptr->rwlock );
-        ANY_REQUIRE( status == 0 );
+        if( lockFunc )
+        {
+            status = RWLock_unlock( ptr->rwlock );
+            ANY_REQUIRE( status == 0 );
+        }
 
         /* we had to stop ? */
         if( retFunc == 0 )
         {
+            data = Atomic_getAcquire( &ptr->data );
             break;
         }
 
         /* next element */
-        ptr = ptr->next;
+        ptr = Atomic_getAcquire( &ptr->next );
     }
 
-    status = RWLock_unlock( self->rwlock );
-    ANY_REQUIRE( status == 0 );
+    MTList_endRead( self );
 
-    return ( ptr ? ptr->data : NULL);
+    return ( data );
 }
 
 
 void *MTList_search( MTList *self, int (*cmpFunc)( void *, void * ), void *searched )
 {
     MTListElement *ptr = NULL;
+    void *data = NULL;
 
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTLIST_VALID );
     ANY_REQUIRE( cmpFunc );
 
+    /* keeps the found element of a read-mostly list from being reclaimed */
+    if( self->epoch )
+    {
+        MTList_beginRead( self );
+    }
+
     ptr = MTList_searchListElement( self, cmpFunc, searched );
 
     /*
      * if we arrive at the and of the list we always have ptr == NULL
      * than we'll return NULL as expected for a not found element
      */
-    return ( ptr ? ptr->data : NULL);
+    data = ptr ? Atomic_getAcquire( &ptr->data ) : NULL;
+
+    if( self->epoch )
+    {
+        MTList_endRead( self );
+    }
+
+    return ( data );
 }
 
 
 bool MTList_isPresent( MTList *self, void *searched )
 {
     bool result = false;
-    int status = 0;
     MTListElement *ptr = NULL;
 
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTLIST_VALID );
 
     /* lock the list for read */
-    status = RWLock_readLock( self->rwlock );
-    ANY_REQUIRE( status == 0 );
+    MTList_beginRead( self );
 
     /* we start from then first element */
-    ptr = self->first;
+    ptr = Atomic_getAcquire( &self->first );
 
     /* and we loop until we have element in list */
     while( ptr )
     {
         ANY_REQUIRE( ptr->valid == MTLISTELEMENT_VALID );
 
-        if( ptr->data == searched )
+        if( Atomic_getAcquire( &ptr->data ) == searched )
         {
             result = true;
             break;
         }
 
-        ptr = ptr->next;
+        ptr = Atomic_getAcquire( &ptr->next );
     }
 
-    status = RWLock_unlock( self->rwlock );
-    ANY_REQUIRE( status == 0 );
+    MTList_endRead( self );
 
     return ( result );
 }
@@ -518,6 +735,11 @@ long MTList_numElements( MTList *self )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTLIST_VALID );
 
+    if( self->epoch )
+    {
+        return ( Atomic_getAcquire( &self->numElement ));
+    }
+
     /* lock the list for read */
     status = RWLock_readLock( self->rwlock );
     ANY_REQUIRE( status == 0 );
@@ -542,28 +764,36 @@ MTListElement *MTList_searchListElement( MTList *self, int (*cmpFunc)( void *, v
     ANY_REQUIRE( cmpFunc );
 
     /* lock the list for read */
-    status = RWLock_readLock( self->rwlock );
-    ANY_REQUIRE( status == 0 );
+    MTList_beginRead( self );
 
     /* start from the first element */
-    ptr = self->first;
+    ptr = Atomic_getAcquire( &self->first );
 
     while( ptr )
     {
-        /* lock the element for read before to call the cmpFunc() */
-        status = RWLock_readLock( ptr->rwlock );
-        ANY_REQUIRE( status == 0 );
+        /*
+         * lock the element for read before to call the cmpFunc(),
+         * the elements of read-mostly lists are read without any lock
+         */
+        if( !self->epoch )
+        {
+            status = RWLock_readLock( ptr->rwlock );
+            ANY_REQUIRE( status == 0 );
+        }
 
         /*
          * Call the comparison function. The cmpFunc should
          * return -1, 0 or greater than 0 if the comparison it's less, equal or greater
          * of the searched element
          */
-        retCmpFunc = ( *cmpFunc )( ptr->data, searched );
+        retCmpFunc = ( *cmpFunc )( Atomic_getAcquire( &ptr->data ), searched );
 
         /* unlock the element */
-        status = RWLock_unlock( ptr->rwlock );
-        ANY_REQUIRE( status == 0 );
+        if( !self->epoch )
+        {
+            status = RWLock_unlock( ptr->rwlock );
+            ANY_REQUIRE( status == 0 );
+        }
 
         /* we have found the element ? */
         if( retCmpFunc == 0 )
@@ -572,11 +802,10 @@ MTListElement *MTList_searchListElement( MTList *self, int (*cmpFunc)( void *, v
         }
 
         /* next element */
-        ptr = ptr->next;
+        ptr = Atomic_getAcquire( &ptr->next );
     }
 
-    status = RWLock_unlock( self->rwlock );
-    ANY_REQUIRE( status == 0 );
+    MTList_endRead( self );
 
     /*
      * if we arrive at the and of the list we always have ptr == NULL
@@ -594,6 +823,22 @@ MTListElement *MTList_getNextElement( MTList *self, MTListElement *current )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTLIST_VALID );
 
+    if( self->epoch )
+    {
+        /* the caller protects current with MTList_beginRead() */
+        if( current )
+        {
+            ANY_REQUIRE( current->valid == MTLISTELEMENT_VALID );
+            next = Atomic_getAcquire( &current->next );
+        }
+        else
+        {
+            next = Atomic_getAcquire( &self->first );
+        }
+
+        return ( next );
+    }
+
     /* lock the list for read */
     status = RWLock_readLock( self->rwlock );
     ANY_REQUIRE( status == 0 );
@@ -679,6 +924,7 @@ void MTList_clear( MTList *self )
 {
     int status = 0;
     MTListElement *ptr = NULL;
+    MTListReader *reader = NULL;
 
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTLIST_VALID );
@@ -686,6 +932,14 @@ void MTList_clear( MTList *self )
     status = RWLock_writeLock( self->rwlock );
     ANY_REQUIRE( status == 0 );
 
+    /* no reader can be left, the removed elements go right away */
+    if( self->epoch )
+    {
+        Atomic_inc( &self->epoch->epoch );
+        MTList_reclaim( self );
+        ANY_REQUIRE( self->epoch->retired == (MTListElement *)NULL );
+    }
+
     /* check if we must clear some list element */
     if( self->numElement )
     {
@@ -731,6 +985,22 @@ void MTList_clear( MTList *self )
     RWLock_clear( self->rwlock );
     RWLock_delete( self->rwlock );
 
+    if( self->epoch )
+    {
+        MThreadKey_clear( self->epoch->readerKey );
+        MThreadKey_delete( self->epoch->readerKey );
+
+        while( self->epoch->readers )
+        {
+            reader = self->epoch->readers;
+            self->epoch->readers = reader->next;
+            ANY_FREE( reader );
+        }
+
+        ANY_FREE( self->epoch );
+        self->epoch = NULL;
+    }
+
     /* now the object is invalid */
     self->valid = MTLIST_INVALID;
 }
@@ -743,6 +1013,114 @@ void MTList_delete( MTList *self )
 }
 
 
+static MTListReader *MTList_getReader( MTList *self )
+{
+    MTListReader *reader = NULL;
+    MTListReader *first = NULL;
+
+    reader = (MTListReader *)MThreadKey_get( self->epoch->readerKey );
+
+    if( reader )
+    {
+        return reader;
+    }
+
+    /* first read of this thread, take over the slot of a terminated one */
+    for( reader = Atomic_getAcquire( &self->epoch->readers ); reader; reader = reader->next )
+    {
+        if( Atomic_testAndSetBool( &reader->inUse, 0, 1 ))
+        {
+            break;
+        }
+    }
+
+    if( !reader )
+    {
+        reader = ANY_TALLOC( MTListReader );
+        ANY_REQUIRE( reader );
+
+        reader->inUse = 1;
+
+        do
+        {
+            first = Atomic_getAcquire( &self->epoch->readers );
+            reader->next = first;
+        }
+        while( !AtomicPointer_testAndSetBool( &self->epoch->readers, first, reader ));
+    }
+
+    MThreadKey_set( self->epoch->readerKey, reader );
+
+    return reader;
+}
+
+
+static void MTList_releaseReader( void *reader )
+{
+    MTListReader *self = (MTListReader *)reader;
+
+    self->depth = 0;
+    Atomic_setRelease( &self->epoch, 0 );
+    Atomic_set( &self->inUse, 0 );
+}
+
+
+static void MTList_retire( MTList *self, MTListElement *element )
+{
+    /* only readers entered up to now may still see the element */
+    element->retireEpoch = Atomic_inc( &self->epoch->epoch ) - 1;
+
+    element->nextRetired = self->epoch->retired;
+    self->epoch->retired = element;
+}
+
+
+static void MTList_reclaim( MTList *self )
+{
+    MTListReader *reader = NULL;
+    MTListElement *ptr = NULL;
+    MTListElement **ptrNext = NULL;
+    AnyAtomic oldest = 0;
+    AnyAtomic readerEpoch = 0;
+
+    /* the epoch of the oldest read section still in progress */
+    oldest = Atomic_get( &self->epoch->epoch );
+
+    for( reader = Atomic_getAcquire( &self->epoch->readers ); reader; reader = reader->next )
+    {
+        readerEpoch = Atomic_get( &reader->epoch );
+
+        if( readerEpoch != 0 && readerEpoch < oldest )
+        {
+            oldest = readerEpoch;
+        }
+    }
+
+    ptrNext = &self->epoch->retired;
+
+    while( *ptrNext )
+    {
+        ptr = *ptrNext;
+
+        if( ptr->retireEpoch >= oldest )
+        {
+            ptrNext = &ptr->nextRetired;
+            continue;
+        }
+
+        *ptrNext = ptr->nextRetired;
+
+        if( ptr->data && self->deleteMode == MTLIST_DELETEMODE_AUTOMATIC )
+        {
+            ANY_FREE( ptr->data );
+        }
+
+        MTListElement_clear( ptr );
+        MTListElement_delete( ptr );
+    }
+}
+
+
 /* MTListElement implementation */
 
 static MTListElement *MTListElement_new( void )
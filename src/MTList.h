@@ -60,6 +60,26 @@
  *    MTList_delete( aList );
  *    ...
  * \endcode
+ *
+ * <h3>Read-mostly lists</h3>
+ *
+ * Lists which are searched far more often than modified, e.g. registries
+ * of subscribers, can be initialized with MTList_initReadMostly(). Their
+ * readers take no lock at all: MTList_iterate() for read, MTList_search(),
+ * MTList_isPresent() and MTLIST_FOREACH_BEGIN for read just announce the
+ * read section in a slot of the calling thread, so lookups scale with the
+ * number of reader threads. Writers still serialize among themselves,
+ * publish new elements atomically and free removed ones only once all the
+ * read sections which might see them are over.
+ *
+ * The data of an element may be replaced with MTList_set() but should not
+ * be modified in place, since readers do not lock the elements. After
+ * replacing or removing an element in MTLIST_DELETEMODE_MANUAL, call
+ * MTList_synchronize() before freeing the old data.
+ *
+ * Walking the list with MTList_getNextElement() must happen between
+ * MTList_beginRead() and MTList_endRead() to keep the current element
+ * from being freed.
  */
 
 
@@ -68,6 +88,7 @@
 
 
 #include <Any.h>
+#include <Atomic.h>
 #include <RWLock.h>
 
 #if defined(__cplusplus)
@@ -86,6 +107,10 @@ typedef struct MTListElement
     struct MTListElement *next;
     /**< Next element in list */
     void *data;   /**< Element's data */
+    struct MTListElement *nextRetired;
+    /**< Next removed element waiting for the readers (read-mostly lists) */
+    long retireEpoch;
+    /**< Epoch in which the element has been removed (read-mostly lists) */
 }
         MTListElement;
 
@@ -106,6 +131,8 @@ typedef struct MTList
     long numElement;
     /**< Number of elements in list */
     int deleteMode;    /**< Element's delete mode */
+    struct MTListEpoch *epoch;
+    /**< Readers and removed elements, NULL unless read-mostly */
 }
         MTList;
 
@@ -199,6 +226,56 @@ MTList *MTList_new( void );
  */
 bool MTList_init( MTList *self );
 
+/*!
+ *  \brief Initialize a read-mostly MTList object
+ *  \param self Pointer to a MTList object
+ *
+ * Like MTList_init(), but the readers of the list walk it without any
+ * lock and the removed elements are freed once no reader can still see
+ * them (see \ref MTList_About).
+ *
+ *  \return Return true if the object is initialized correctly, false if not.
+ *  \see MTList_init()
+ *  \see MTList_synchronize()
+ */
+bool MTList_initReadMostly( MTList *self );
+
+/*!
+ *  \brief Begin a read section on the MTList
+ *  \param self Pointer to a MTList object
+ *
+ * Read-locks the list, or on read-mostly lists keeps the elements seen
+ * until the matching MTList_endRead() from being freed. Read sections of
+ * read-mostly lists may be nested.
+ *
+ *  \return Nothing
+ *  \see MTList_endRead()
+ */
+void MTList_beginRead( MTList *self );
+
+/*!
+ *  \brief End a read section on the MTList
+ *  \param self Pointer to a MTList object
+ *
+ *  \return Nothing
+ *  \see MTList_beginRead()
+ */
+void MTList_endRead( MTList *self );
+
+/*!
+ *  \brief Wait for the read sections in progress
+ *  \param self Pointer to a MTList object
+ *
+ * Returns once all the read sections begun before the call are over, and
+ * frees the elements removed up to then. Afterwards no reader can see the
+ * data of removed or replaced elements anymore. Must not be called inside
+ * a read section.
+ *
+ *  \return Nothing
+ *  \see MTList_initReadMostly()
+ */
+void MTList_synchronize( MTList *self );
+
 /*!
  *  \brief Add a new element on the MTList
  *  \param self Pointer to a MTList object
@@ -341,15 +418,22 @@ void *MTList_iterate( MTList *self, int (*func)( void * ), int flags );
           break;\
   }\
 \
-  RWLock_readLock (__list->rwlock);\
+  /* the elements of read-mostly lists are read without any lock */\
+  if (__list->epoch && __lockFunc == RWLock_readLock)\
+  {\
+    __lockFunc = (int (*)(RWLock*))NULL;\
+  }\
 \
-  __ptr = __list->first;\
+  MTList_beginRead (__list);\
 \
-  for (__ptr = __list->first; __ptr; __ptr = __ptr->next)\
+  for (__ptr = Atomic_getAcquire (&__list->first); __ptr; __ptr = Atomic_getAcquire (&__ptr->next))\
   {\
     /* lock as flags request the element before to call the func() */\
-    __status = (*__lockFunc) (__ptr->rwlock);\
-    ANY_REQUIRE (__status == 0);\
+    if (__lockFunc)\
+    {\
+      __status = (*__lockFunc) (__ptr->rwlock);\
+      ANY_REQUIRE (__status == 0);\
+    }\
 \
     {
 
@@ -361,9 +445,12 @@ void *MTList_iterate( MTList *self, int (*func)( void * ), int flags );
 #define MTLIST_FOREACH_END \
     }\
 \
-    RWLock_unlock (__ptr->rwlock);\
+    if (__lockFunc)\
+    {\
+      RWLock_unlock (__ptr->rwlock);\
+    }\
   }\
-  RWLock_unlock (__list->rwlock);\
+  MTList_endRead (__list);\
 }
 
 /*!
@@ -385,7 +472,10 @@ void *MTList_iterate( MTList *self, int (*func)( void * ), int flags );
  */
 #define MTLIST_FOREACH_BREAK \
     { \
-        RWLock_unlock (__ptr->rwlock); \
+        if (__lockFunc) \
+        { \
+            RWLock_unlock (__ptr->rwlock); \
+        } \
         break; \
     }
 
@@ -464,7 +554,9 @@ void MTList_setDeleteMode( MTList *self, int deleteMode );
  *
  * This function iterate in the specified MTList instance, the user can specify
  * the \a current from where to continue the iteration, if NULL than the first
- * element is returned. The operation will be done in readlock mode
+ * element is returned. The operation will be done in readlock mode, on
+ * read-mostly lists the whole walk must be done inside MTList_beginRead()
+ * and MTList_endRead()
  *
  * \return Return the next MTListElement instance or NULL if the MTList is terminated or empty
  *
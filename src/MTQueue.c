@@ -18,12 +18,39 @@
  */
 
 
+#include <limits.h>
+
+#if defined(__linux__)
+
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#endif
+
 #include <Any.h>
+#include <Atomic.h>
 #include <MTQueue.h>
 
 #define MTQUEUE_VALID      0x016e134c
 #define MTQUEUE_INVALID    0x49d1602c
 
+/* popped elements kept for the next pushes instead of being freed */
+#define MTQUEUE_MAX_FREE_ELEMENTS  64
+
+#define MTQUEUE_CACHELINE  ( 64 )
+
+/* polls of a bounded queue before going to sleep on the futex */
+#define MTQUEUE_RINGSPIN   ( 1000 )
+
+
+/* a futex is a 32 bit int, elsewhere a plain AnyAtomic is polled */
+#if defined(__linux__)
+typedef int MTQueueWord;
+#else
+typedef AnyAtomic MTQueueWord;
+#endif
+
 
 typedef struct MTQueueElement
 {
@@ -33,6 +60,18 @@ typedef struct MTQueueElement
 }
 MTQueueElement;
 
+/*
+ * Slot of a bounded queue. Its sequence is the position of the next push
+ * it can take, or that position + 1 once the push is published.
+ */
+typedef struct MTQueueSlot
+{
+    AnyAtomic sequence;
+    void *data;
+    MTQueueUserClass userClass;
+}
+MTQueueSlot;
+
 struct MTQueue
 {
     unsigned long valid;
@@ -43,6 +82,21 @@ struct MTQueue
     void *head;
     void *tail;
     bool quit;
+    void *freeElements;
+    unsigned long numFreeElements;
+
+    /* bounded mode only, the positions on their own cache lines */
+    MTQueueSlot *ring;
+    long ringMask;
+    char pad0[MTQUEUE_CACHELINE];
+    AnyAtomic pushPos;
+    char pad1[MTQUEUE_CACHELINE - sizeof( AnyAtomic )];
+    AnyAtomic popPos;
+    char pad2[MTQUEUE_CACHELINE - sizeof( AnyAtomic )];
+    MTQueueWord dataSeq;        /* futex, bumped when a waiting pop has to look again */
+    MTQueueWord spaceSeq;       /* futex, bumped when a waiting push has to look again */
+    AnyAtomic popWaiting;
+    AnyAtomic pushWaiting;
 };
 
 static void MTQueue_lock( MTQueue *self );
@@ -57,6 +111,24 @@ static void MTQueue_addTail( MTQueue *self, void *data, MTQueueUserClass userCla
 
 static void MTQueue_addHead( MTQueue *self, void *data, MTQueueUserClass userClass );
 
+static MTQueueElement *MTQueue_newElement( MTQueue *self );
+
+static void MTQueue_freeElement( MTQueue *self, MTQueueElement *e );
+
+static bool MTQueue_ringTryPush( MTQueue *self, void *data, MTQueueUserClass userClass );
+
+static void *MTQueue_ringTryPop( MTQueue *self, MTQueueUserClass *userClass );
+
+static bool MTQueue_ringPush( MTQueue *self, void *data, MTQueueUserClass userClass );
+
+static void *MTQueue_ringPopWait( MTQueue *self, MTQueueUserClass *userClass, long microsecs );
+
+static void MTQueue_ringWakeAll( MTQueue *self );
+
+static void MTQueue_futexWait( MTQueueWord *address, MTQueueWord value, long microsecs );
+
+static void MTQueue_futexWake( MTQueueWord *address, int count );
+
 
 MTQueue *MTQueue_new( void )
 {
@@ -84,12 +156,29 @@ int MTQueue_init( MTQueue *self, MTQueueType type, bool multiThread )
 
         Cond_setMutex( self->pushCond, self->lock );
     }
+    else
+    {
+        self->lock = NULL;
+        self->pushCond = NULL;
+    }
 
     self->type = type;
     self->numElements = 0UL;
     self->head = NULL;
     self->tail = NULL;
     self->quit = false;
+    self->freeElements = NULL;
+    self->numFreeElements = 0UL;
+
+    /* list mode, MTQueue_initBounded() sets the ring up afterwards */
+    self->ring = NULL;
+    self->ringMask = 0;
+    self->pushPos = 0;
+    self->popPos = 0;
+    self->dataSeq = 0;
+    self->spaceSeq = 0;
+    self->popWaiting = 0;
+    self->pushWaiting = 0;
 
     self->valid = MTQUEUE_VALID;
 
@@ -97,12 +186,54 @@ int MTQueue_init( MTQueue *self, MTQueueType type, bool multiThread )
 }
 
 
+int MTQueue_initBounded( MTQueue *self, unsigned long capacity )
+{
+    unsigned long size = 2UL;
+    long i = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( capacity > 0 );
+
+    MTQueue_init( self, MTQUEUE_FIFO, false );
+
+    while( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    self->ring = ANY_NTALLOC( size, MTQueueSlot );
+    ANY_REQUIRE_MSG( self->ring, "Unable to allocate memory for the slots of a MTQueue" );
+
+    for( i = 0; i < (long)size; i++ )
+    {
+        self->ring[ i ].sequence = i;
+    }
+
+    self->ringMask = (long)size - 1;
+
+    /* the slots are ready before anybody may see the queue */
+    Atomic_memoryBarrier();
+
+    return 0;
+}
+
+
 void MTQueue_push( MTQueue *self, void *data, MTQueueUserClass userClass )
 {
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
     ANY_REQUIRE( data );
 
+    if( self->ring )
+    {
+        if( !MTQueue_ringPush( self, data, userClass ) )
+        {
+            ANY_LOG( 5, "The queue is full and quitting, element dropped", ANY_LOG_WARNING );
+        }
+
+        return;
+    }
+
     MTQueue_lock( self );
 
     switch( self->type )
@@ -128,6 +259,77 @@ void MTQueue_push( MTQueue *self, void *data, MTQueueUserClass userClass )
 }
 
 
+void MTQueue_pushMany( MTQueue *self, void **data, unsigned long numElements,
+                       MTQueueUserClass userClass )
+{
+    unsigned long i = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == MTQUEUE_VALID );
+    ANY_REQUIRE( data || numElements == 0 );
+
+    if( numElements == 0 )
+    {
+        return;
+    }
+
+    if( self->ring )
+    {
+        for( i = 0; i < numElements; i++ )
+        {
+            ANY_REQUIRE( data[ i ] );
+
+            if( !MTQueue_ringPush( self, data[ i ], userClass ) )
+            {
+                ANY_LOG( 5, "The queue is full and quitting, %lu elements dropped",
+                         ANY_LOG_WARNING, numElements - i );
+                break;
+            }
+        }
+
+        return;
+    }
+
+    MTQueue_lock( self );
+
+    /* the elements come from the free ones first, as for MTQueue_push() */
+    for( i = 0; i < numElements; i++ )
+    {
+        ANY_REQUIRE( data[ i ] );
+
+        switch( self->type )
+        {
+            case MTQUEUE_FIFO:
+                MTQueue_addTail( self, data[ i ], userClass );
+                break;
+
+            case MTQUEUE_LIFO:
+                MTQueue_addHead( self, data[ i ], userClass );
+                break;
+
+            default:
+                ANY_LOG( 0, "Invalid queue type '0x%08x'", ANY_LOG_ERROR, self->type );
+                break;
+        }
+    }
+
+    /* one wake up for the whole batch */
+    if( self->pushCond )
+    {
+        if( numElements > 1 )
+        {
+            Cond_broadcast( self->pushCond );
+        }
+        else
+        {
+            Cond_signal( self->pushCond );
+        }
+    }
+
+    MTQueue_unlock( self );
+}
+
+
 void *MTQueue_pop( MTQueue *self, MTQueueUserClass *userClass )
 {
     void *retVal = NULL;
@@ -135,6 +337,11 @@ void *MTQueue_pop( MTQueue *self, MTQueueUserClass *userClass )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
 
+    if( self->ring )
+    {
+        return MTQueue_ringTryPop( self, userClass );
+    }
+
     MTQueue_lock( self );
 
     retVal = MTQueue_unlockedPop( self, userClass );
@@ -152,6 +359,11 @@ void *MTQueue_popWait( MTQueue *self, MTQueueUserClass *userClass, const long mi
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
 
+    if( self->ring )
+    {
+        return MTQueue_ringPopWait( self, userClass, microsecs );
+    }
+
     MTQueue_lock( self );
 
     if ( self->quit )
@@ -186,6 +398,15 @@ unsigned long MTQueue_numElements( MTQueue *self )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
 
+    if( self->ring )
+    {
+        /* a snapshot only, the pops may be read after pushes they follow */
+        long popPos = Atomic_get( &self->popPos );
+        long pushPos = Atomic_get( &self->pushPos );
+
+        return pushPos > popPos ? (unsigned long)( pushPos - popPos ) : 0UL;
+    }
+
     MTQueue_lock( self );
 
     retVal = self->numElements;
@@ -206,6 +427,11 @@ void MTQueue_setQuit( MTQueue * self, bool status )
     self->quit = status;
 
     MTQueue_unlock( self );
+
+    if( self->ring )
+    {
+        MTQueue_ringWakeAll( self );
+    }
 }
 
 
@@ -214,6 +440,12 @@ void MTQueue_wakeUpAll( MTQueue * self )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
 
+    if( self->ring )
+    {
+        MTQueue_ringWakeAll( self );
+        return;
+    }
+
     MTQueue_lock( self );
 
     Cond_broadcast( self->pushCond );
@@ -234,6 +466,22 @@ void MTQueue_clear( MTQueue *self )
 
     ANY_REQUIRE( self->numElements == 0 );
 
+    if( self->ring )
+    {
+        ANY_FREE( self->ring );
+        self->ring = NULL;
+    }
+
+    while( self->freeElements )
+    {
+        MTQueueElement *e = (MTQueueElement *)self->freeElements;
+
+        self->freeElements = (void *)e->next;
+        ANY_FREE( e );
+    }
+
+    self->numFreeElements = 0UL;
+
     if( self->lock )
     {
         Mutex_clear( self->lock );
@@ -279,7 +527,7 @@ static void *MTQueue_unlockedPop( MTQueue *self, MTQueueUserClass *userClass )
             *userClass = e->userClass;
         }
 
-        ANY_FREE( e );
+        MTQueue_freeElement( self, e );
 
         self->numElements--;
 
@@ -340,8 +588,7 @@ static void MTQueue_addHead( MTQueue *self, void *data, MTQueueUserClass userCla
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
     ANY_REQUIRE( data );
 
-    e = ANY_TALLOC( MTQueueElement );
-    ANY_REQUIRE_MSG( e, "Unable to allocate memory for a new MTQueueElement" );
+    e = MTQueue_newElement( self );
 
     e->data = data;
     e->userClass = userClass;
@@ -370,11 +617,11 @@ static void MTQueue_addTail( MTQueue *self, void *data, MTQueueUserClass userCla
     ANY_REQUIRE( self->valid == MTQUEUE_VALID );
     ANY_REQUIRE( data );
 
-    e = ANY_TALLOC( MTQueueElement );
-    ANY_REQUIRE_MSG( e, "Unable to allocate memory for a new MTQueueElement" );
+    e = MTQueue_newElement( self );
 
     e->data = data;
     e->userClass = userClass;
+    e->next = NULL;
 
     if( self->tail )
     {
@@ -391,4 +638,280 @@ static void MTQueue_addTail( MTQueue *self, void *data, MTQueueUserClass userCla
     self->numElements++;
 }
 
+
+/* to be called with the queue locked */
+static MTQueueElement *MTQueue_newElement( MTQueue *self )
+{
+    MTQueueElement *e = NULL;
+
+    if( self->freeElements )
+    {
+        e = (MTQueueElement *)self->freeElements;
+        self->freeElements = (void *)e->next;
+        self->numFreeElements--;
+    }
+    else
+    {
+        e = ANY_TALLOC( MTQueueElement );
+        ANY_REQUIRE_MSG( e, "Unable to allocate memory for a new MTQueueElement" );
+    }
+
+    return e;
+}
+
+
+/* to be called with the queue locked */
+static void MTQueue_freeElement( MTQueue *self, MTQueueElement *e )
+{
+    if( self->numFreeElements < MTQUEUE_MAX_FREE_ELEMENTS )
+    {
+        e->next = (MTQueueElement *)self->freeElements;
+        self->freeElements = (void *)e;
+        self->numFreeElements++;
+    }
+    else
+    {
+        ANY_FREE( e );
+    }
+}
+
+
+static bool MTQueue_ringTryPush( MTQueue *self, void *data, MTQueueUserClass userClass )
+{
+    MTQueueSlot *slot = NULL;
+    long pos = Atomic_get( &self->pushPos );
+    long diff = 0;
+
+    for( ;; )
+    {
+        slot = &self->ring[ pos & self->ringMask ];
+        diff = Atomic_get( &slot->sequence ) - pos;
+
+        if( diff == 0 )
+        {
+            if( Atomic_testAndSetBool( &self->pushPos, pos, pos + 1 ) )
+            {
+                break;
+            }
+        }
+        else if( diff < 0 )
+        {
+            /* still holds the element pushed one round before */
+            return false;
+        }
+
+        pos = Atomic_get( &self->pushPos );
+    }
+
+    slot->data = data;
+    slot->userClass = userClass;
+
+    /* publishes the element to the pops */
+    Atomic_memoryBarrier();
+    Atomic_set( &slot->sequence, pos + 1 );
+
+    if( Atomic_get( &self->popWaiting ) > 0 )
+    {
+        Atomic_inc( &self->dataSeq );
+        MTQueue_futexWake( &self->dataSeq, 1 );
+    }
+
+    return true;
+}
+
+
+static void *MTQueue_ringTryPop( MTQueue *self, MTQueueUserClass *userClass )
+{
+    MTQueueSlot *slot = NULL;
+    void *retVal = NULL;
+    long pos = Atomic_get( &self->popPos );
+    long diff = 0;
+
+    for( ;; )
+    {
+        slot = &self->ring[ pos & self->ringMask ];
+        diff = Atomic_get( &slot->sequence ) - ( pos + 1 );
+
+        if( diff == 0 )
+        {
+            if( Atomic_testAndSetBool( &self->popPos, pos, pos + 1 ) )
+            {
+                break;
+            }
+        }
+        else if( diff < 0 )
+        {
+            /* not pushed yet */
+            return NULL;
+        }
+
+        pos = Atomic_get( &self->popPos );
+    }
+
+    retVal = slot->data;
+
+    if( userClass )
+    {
+        *userClass = slot->userClass;
+    }
+
+    /* hands the slot over to the push of the next round */
+    Atomic_memoryBarrier();
+    Atomic_set( &slot->sequence, pos + self->ringMask + 1 );
+
+    if( Atomic_get( &self->pushWaiting ) > 0 )
+    {
+        Atomic_inc( &self->spaceSeq );
+        MTQueue_futexWake( &self->spaceSeq, 1 );
+    }
+
+    return retVal;
+}
+
+
+/* blocks while the queue is full, false if it was told to quit meanwhile */
+static bool MTQueue_ringPush( MTQueue *self, void *data, MTQueueUserClass userClass )
+{
+    MTQueueWord seq = 0;
+    int spin = 0;
+
+    while( !MTQueue_ringTryPush( self, data, userClass ) )
+    {
+        Atomic_memoryBarrier();
+
+        if( self->quit )
+        {
+            return false;
+        }
+
+        if( spin < MTQUEUE_RINGSPIN )
+        {
+            spin++;
+            continue;
+        }
+
+        seq = Atomic_get( &self->spaceSeq );
+        Atomic_inc( &self->pushWaiting );
+
+        /* a pop may have made room meanwhile, without waking us */
+        if( MTQueue_ringTryPush( self, data, userClass ) )
+        {
+            Atomic_dec( &self->pushWaiting );
+            break;
+        }
+
+        if( !self->quit )
+        {
+            MTQueue_futexWait( &self->spaceSeq, seq, 0 );
+        }
+
+        Atomic_dec( &self->pushWaiting );
+    }
+
+    return true;
+}
+
+
+static void *MTQueue_ringPopWait( MTQueue *self, MTQueueUserClass *userClass, long microsecs )
+{
+    unsigned long long deadline = 0;
+    unsigned long long now = 0;
+    MTQueueWord seq = 0;
+    void *retVal = NULL;
+    long timeout = 0;
+    int spin = 0;
+
+    if( microsecs > 0 )
+    {
+        deadline = Any_getTime() + (unsigned long long)microsecs * 1000;
+    }
+
+    while( !( retVal = MTQueue_ringTryPop( self, userClass ) ) )
+    {
+        Atomic_memoryBarrier();
+
+        if( self->quit )
+        {
+            break;
+        }
+
+        if( spin < MTQUEUE_RINGSPIN )
+        {
+            spin++;
+            continue;
+        }
+
+        if( deadline )
+        {
+            now = Any_getTime();
+
+            if( now >= deadline )
+            {
+                break;
+            }
+
+            timeout = (long)( ( deadline - now + 999 ) / 1000 );
+        }
+
+        seq = Atomic_get( &self->dataSeq );
+        Atomic_inc( &self->popWaiting );
+
+        /* a push may have come meanwhile, without waking us */
+        retVal = MTQueue_ringTryPop( self, userClass );
+
+        if( !retVal && !self->quit )
+        {
+            MTQueue_futexWait( &self->dataSeq, seq, timeout );
+        }
+
+        Atomic_dec( &self->popWaiting );
+
+        if( retVal )
+        {
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+
+static void MTQueue_ringWakeAll( MTQueue *self )
+{
+    Atomic_inc( &self->dataSeq );
+    MTQueue_futexWake( &self->dataSeq, INT_MAX );
+
+    Atomic_inc( &self->spaceSeq );
+    MTQueue_futexWake( &self->spaceSeq, INT_MAX );
+}
+
+
+/* returns when the word changes or the time is over, and may return earlier */
+static void MTQueue_futexWait( MTQueueWord *address, MTQueueWord value, long microsecs )
+{
+#if defined(__linux__)
+    struct timespec timeout;
+
+    timeout.tv_sec = microsecs / 1000000;
+    timeout.tv_nsec = ( microsecs % 1000000 ) * 1000;
+
+    syscall( SYS_futex, address, FUTEX_WAIT_PRIVATE, value,
+             microsecs > 0 ? &timeout : NULL, NULL, 0 );
+#else
+    if( Atomic_get( address ) == value )
+    {
+        Any_sleepMicroSeconds( microsecs > 0 && microsecs < 50 ? microsecs : 50 );
+    }
+#endif
+}
+
+
+static void MTQueue_futexWake( MTQueueWord *address, int count )
+{
+#if defined(__linux__)
+    syscall( SYS_futex, address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0 );
+#endif
+}
+
+
 /* EOF */
@@ -61,8 +61,20 @@ MTQueue *MTQueue_new( void );
 
 int MTQueue_init( MTQueue *self, MTQueueType type, bool multiThread );
 
+/*
+ * lock-free FIFO for many producers and consumers, in a ring of at least
+ * capacity slots (rounded up to a power of two). Nothing is locked or
+ * allocated per element. MTQueue_push() blocks while the queue is full,
+ * waiting pushes and pops sleep on a futex. After MTQueue_setQuit() a
+ * push finding the queue full drops its element.
+ */
+int MTQueue_initBounded( MTQueue *self, unsigned long capacity );
+
 void MTQueue_push( MTQueue *self, void *data, MTQueueUserClass userClass );
 
+void MTQueue_pushMany( MTQueue *self, void **data, unsigned long numElements,
+                       MTQueueUserClass userClass );
+
 void *MTQueue_pop( MTQueue *self, MTQueueUserClass *userClass );
 
 void *MTQueue_popWait( MTQueue *self, MTQueueUserClass *userClass, const long microsecs );
@@ -40,6 +40,7 @@
  * \li Cond.h: conditional variable to allow a thread to be suspended until
  *             a certain condition is met
  * \li RWLock.h: Read/Write lock
+ * \li LockProfile.h: contention profiling of Mutex and RWLock objects
  * \li Traps.h: print stacktrace in case of error
  *
  * <h3>Example:</h3>
@@ -62,6 +63,7 @@
 
 #include "Barrier.h"
 #include "Cond.h"
+#include "LockProfile.h"
 #include "Mutex.h"
 #include "RWLock.h"
 #include "Threads.h"
@@ -22,12 +22,40 @@
 #include <pthread.h>
 
 #include <Mutex.h>
+#include <Threads.h>
 
 
 #define MUTEX_VALID   0xb87d8223
 
 #define MUTEX_INVALID   0xac1cca9d
 
+/* upper bound of the tries of an adaptive mutex before parking */
+#define MUTEX_MAXSPIN   ( 100 )
+
+/* upper bound of the pauses between two tries */
+#define MUTEX_MAXBACKOFF  ( 64 )
+
+#if defined(__i386__) || defined(__x86_64__)
+#define MUTEX_CPURELAX()  __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define MUTEX_CPURELAX()  __asm__ __volatile__( "yield" ::: "memory" )
+#else
+#define MUTEX_CPURELAX()  do { } while( 0 )
+#endif
+
+
+static void Mutex_initNumCpus( void );
+
+static bool Mutex_canSpin( void );
+
+static int Mutex_spinLock( Mutex *self );
+
+
+/* CPUs the process may run on, queried by the first adaptive mutex */
+static pthread_once_t Mutex_numCpusOnce = PTHREAD_ONCE_INIT;
+
+static int Mutex_numCpus = 0;
+
 
 Mutex *Mutex_new( void )
 {
@@ -66,6 +94,16 @@ BaseBool Mutex_init( Mutex *self, const long flags )
     status = pthread_mutex_init( &self->mutex, &self->attr );
     ANY_REQUIRE( status == 0 );
 
+    self->flags = flags;
+    self->spin = 0;
+    self->profile = NULL;
+
+    /* nobody can release the lock while we spin on the only CPU */
+    if( ( flags & MUTEX_ADAPTIVE ) && !Mutex_canSpin() )
+    {
+        self->flags &= ~MUTEX_ADAPTIVE;
+    }
+
     self->valid = MUTEX_VALID;
 
     return true;
@@ -81,18 +119,56 @@ int Mutex_tryLock( Mutex *self )
 
     retVal = pthread_mutex_trylock( &self->mutex );
 
+    if( self->profile )
+    {
+        if( retVal == 0 )
+        {
+            LockProfile_record( self->profile, false, 0 );
+        }
+        else if( retVal == EBUSY )
+        {
+            LockProfile_recordFailedTry( self->profile );
+        }
+    }
+
     return retVal;
 }
 
 
 int Mutex_lock( Mutex *self )
 {
+    unsigned long long startTime = 0;
+    bool contended = false;
     int retVal = 0;
 
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == MUTEX_VALID );
 
-    retVal = pthread_mutex_lock( &self->mutex );
+    if( !self->profile && !( self->flags & MUTEX_ADAPTIVE ) )
+    {
+        retVal = pthread_mutex_lock( &self->mutex );
+    }
+    else
+    {
+        retVal = pthread_mutex_trylock( &self->mutex );
+
+        if( retVal == EBUSY )
+        {
+            startTime = self->profile ? Any_getTime() : 0;
+
+            if( self->flags & MUTEX_ADAPTIVE )
+            {
+                retVal = Mutex_spinLock( self );
+            }
+
+            if( retVal == EBUSY )
+            {
+                retVal = pthread_mutex_lock( &self->mutex );
+            }
+
+            contended = true;
+        }
+    }
 
 #if !defined( __mingw__ )
     // Missing on mingw: https://www.gnu.org/software/gnulib/manual/html_node/pthread_005fmutex_005fconsistent.html
@@ -102,6 +178,12 @@ int Mutex_lock( Mutex *self )
     }
 #endif
 
+    /* counted while holding the lock */
+    if( self->profile && retVal == 0 )
+    {
+        LockProfile_record( self->profile, contended, contended ? Any_getTime() - startTime : 0 );
+    }
+
     return retVal;
 }
 
@@ -119,6 +201,37 @@ int Mutex_unlock( Mutex *self )
 }
 
 
+void Mutex_enableProfiling( Mutex *self, const char *name )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == MUTEX_VALID );
+    ANY_REQUIRE( name );
+    ANY_REQUIRE_MSG( !( self->flags & MUTEX_SHARED ), "the profile of a shared mutex is process local" );
+
+    if( !self->profile )
+    {
+        self->profile = LockProfile_new( "Mutex", name );
+    }
+}
+
+
+void Mutex_getStats( Mutex *self, LockProfileStats *stats )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == MUTEX_VALID );
+    ANY_REQUIRE( stats );
+
+    if( self->profile )
+    {
+        LockProfile_getStats( self->profile, stats );
+    }
+    else
+    {
+        Any_memset( stats, 0, sizeof( LockProfileStats ));
+    }
+}
+
+
 void Mutex_clear( Mutex *self )
 {
     int status = 0;
@@ -132,6 +245,12 @@ void Mutex_clear( Mutex *self )
     status = pthread_mutex_destroy( &self->mutex );
     ANY_REQUIRE( status == 0 );
 
+    if( self->profile )
+    {
+        LockProfile_delete( self->profile );
+        self->profile = NULL;
+    }
+
     self->valid = MUTEX_INVALID;
 }
 
@@ -143,4 +262,69 @@ void Mutex_delete( Mutex *self )
 }
 
 
+static void Mutex_initNumCpus( void )
+{
+    ThreadsCpuSet cpus;
+
+    Mutex_numCpus = Threads_getAvailableCpus( &cpus ) ? ThreadsCpuSet_count( &cpus ) : 2;
+}
+
+
+static bool Mutex_canSpin( void )
+{
+    int status = 0;
+
+    status = pthread_once( &Mutex_numCpusOnce, Mutex_initNumCpus );
+    ANY_REQUIRE( status == 0 );
+
+    return ( Mutex_numCpus > 1 );
+}
+
+
+/*
+ * tries again with twice the pauses in between each time, for up to
+ * about twice the tries the former contended locks needed
+ */
+static int Mutex_spinLock( Mutex *self )
+{
+    int retVal = EBUSY;
+    int maxTries = 0;
+    int tries = 0;
+    int backoff = 1;
+    int i = 0;
+
+    maxTries = self->spin * 2 + 10;
+
+    if( maxTries > MUTEX_MAXSPIN )
+    {
+        maxTries = MUTEX_MAXSPIN;
+    }
+
+    for( tries = 1; tries <= maxTries; tries++ )
+    {
+        for( i = 0; i < backoff; i++ )
+        {
+            MUTEX_CPURELAX();
+        }
+
+        if( backoff < MUTEX_MAXBACKOFF )
+        {
+            backoff *= 2;
+        }
+
+        retVal = pthread_mutex_trylock( &self->mutex );
+
+        if( retVal != EBUSY )
+        {
+            break;
+        }
+    }
+
+    /* a racy moving average is good enough for a hint */
+    self->spin += ( ( tries > maxTries ? maxTries : tries ) - self->spin ) / 8;
+
+    return retVal;
+}
+
+
 /* EOF */
@@ -30,6 +30,7 @@
 
 #include <Any.h>
 #include <Base.h>
+#include <LockProfile.h>
 
 #define MUTEX_EINVAL    EINVAL
 #define MUTEX_EAGAIN    EAGAIN
@@ -52,12 +53,22 @@ extern "C" {
 #define MUTEX_PRIVATE  0x00000001
 #define MUTEX_SHARED   0x00000002
 
+/*
+ * spin with an exponential backoff before parking the thread, for short
+ * critical sections. The spin adapts to the time the lock is usually
+ * held, and is skipped on single CPU machines.
+ */
+#define MUTEX_ADAPTIVE 0x00000004
+
 
 typedef struct Mutex
 {
     unsigned long valid;
     pthread_mutex_t mutex;
     pthread_mutexattr_t attr;
+    long flags;
+    int spin;
+    LockProfile *profile;
 } Mutex;
 
 
@@ -66,7 +77,8 @@ Mutex *Mutex_new( void );
 /*!
  * \brief Initialize a mutex
  * \param self Pointer to a mutex
- * \param flags should always be MUTEX_PRIVATE
+ * \param flags should always be MUTEX_PRIVATE, optionally or'ed with
+ *              MUTEX_ADAPTIVE
  */
 BaseBool Mutex_init( Mutex *self, const long flags );
 
@@ -89,6 +101,16 @@ int Mutex_lock( Mutex *self );
 
 int Mutex_unlock( Mutex *self );
 
+/*
+ * counts the acquisitions and waits of a process private mutex until it
+ * is cleared, see LockProfile.h. Must be called before the mutex is used
+ * by other threads.
+ */
+void Mutex_enableProfiling( Mutex *self, const char *name );
+
+/* all zero if the profiling is not enabled */
+void Mutex_getStats( Mutex *self, LockProfileStats *stats );
+
 void Mutex_clear( Mutex *self );
 
 void Mutex_delete( Mutex *self );
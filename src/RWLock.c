@@ -29,6 +29,12 @@
 #define RWLOCK_INVALID   0x4e374f6f
 
 
+static int RWLock_profiledLock( RWLock *self, int (*tryLockFunc)( pthread_rwlock_t * ),
+                                int (*lockFunc)( pthread_rwlock_t * ) );
+
+static void RWLock_profileTry( RWLock *self, int status );
+
+
 RWLock *RWLock_new( void )
 {
     RWLock *self = (RWLock *)NULL;
@@ -71,6 +77,8 @@ bool RWLock_init( RWLock *self, const long flags )
 #endif
     ANY_REQUIRE_MSG( status == 0, "failed to initialize self->rwlock" );
 
+    self->profile = NULL;
+
     self->valid = RWLOCK_VALID;
 
     return true;
@@ -84,6 +92,11 @@ int RWLock_readLock( RWLock *self )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == RWLOCK_VALID );
 
+    if( self->profile )
+    {
+        return RWLock_profiledLock( self, pthread_rwlock_tryrdlock, pthread_rwlock_rdlock );
+    }
+
     retVal = pthread_rwlock_rdlock( self->rwlock );
 
     return retVal;
@@ -99,6 +112,11 @@ int RWLock_tryReadLock( RWLock *self )
 
     retVal = pthread_rwlock_tryrdlock( self->rwlock );
 
+    if( self->profile )
+    {
+        RWLock_profileTry( self, retVal );
+    }
+
     return retVal;
 }
 
@@ -110,6 +128,11 @@ int RWLock_writeLock( RWLock *self )
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == RWLOCK_VALID );
 
+    if( self->profile )
+    {
+        return RWLock_profiledLock( self, pthread_rwlock_trywrlock, pthread_rwlock_wrlock );
+    }
+
     retVal = pthread_rwlock_wrlock( self->rwlock );
 
     return retVal;
@@ -125,6 +148,11 @@ int RWLock_tryWriteLock( RWLock *self )
 
     retVal = pthread_rwlock_trywrlock( self->rwlock );
 
+    if( self->profile )
+    {
+        RWLock_profileTry( self, retVal );
+    }
+
     return retVal;
 }
 
@@ -142,6 +170,36 @@ int RWLock_unlock( RWLock *self )
 }
 
 
+void RWLock_enableProfiling( RWLock *self, const char *name )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == RWLOCK_VALID );
+    ANY_REQUIRE( name );
+
+    if( !self->profile )
+    {
+        self->profile = LockProfile_new( "RWLock", name );
+    }
+}
+
+
+void RWLock_getStats( RWLock *self, LockProfileStats *stats )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == RWLOCK_VALID );
+    ANY_REQUIRE( stats );
+
+    if( self->profile )
+    {
+        LockProfile_getStats( self->profile, stats );
+    }
+    else
+    {
+        Any_memset( stats, 0, sizeof( LockProfileStats ));
+    }
+}
+
+
 void RWLock_clear( RWLock *self )
 {
     int status = 0;
@@ -159,6 +217,12 @@ void RWLock_clear( RWLock *self )
 
     ANY_FREE( self->attr );
     ANY_FREE( self->rwlock );
+
+    if( self->profile )
+    {
+        LockProfile_delete( self->profile );
+        self->profile = NULL;
+    }
 }
 
 
@@ -169,4 +233,43 @@ void RWLock_delete( RWLock *self )
 }
 
 
+/* the read and write locks of a profiled rwlock, waiting is contention */
+static int RWLock_profiledLock( RWLock *self, int (*tryLockFunc)( pthread_rwlock_t * ),
+                                int (*lockFunc)( pthread_rwlock_t * ) )
+{
+    unsigned long long startTime = 0;
+    bool contended = false;
+    int retVal = 0;
+
+    retVal = ( *tryLockFunc )( self->rwlock );
+
+    if( retVal == EBUSY )
+    {
+        startTime = Any_getTime();
+        retVal = ( *lockFunc )( self->rwlock );
+        contended = true;
+    }
+
+    if( retVal == 0 )
+    {
+        LockProfile_record( self->profile, contended, contended ? Any_getTime() - startTime : 0 );
+    }
+
+    return retVal;
+}
+
+
+static void RWLock_profileTry( RWLock *self, int status )
+{
+    if( status == 0 )
+    {
+        LockProfile_record( self->profile, false, 0 );
+    }
+    else if( status == EBUSY )
+    {
+        LockProfile_recordFailedTry( self->profile );
+    }
+}
+
+
 /* EOF */
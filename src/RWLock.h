@@ -28,6 +28,7 @@
 #include <pthread.h>
 
 #include <Any.h>
+#include <LockProfile.h>
 
 
 #define RWLOCK_EINVAL    EINVAL
@@ -77,6 +78,8 @@ typedef struct RWLock
     pthread_rwlock_t *rwlock;
     /**< rwlock */
     pthread_rwlockattr_t *attr;    /**< rwlock attribute */
+    LockProfile *profile;
+    /**< contention profile, NULL unless enabled */
 } RWLock;
 
 /*!
@@ -163,6 +166,25 @@ int RWLock_tryWriteLock( RWLock *self );
  */
 int RWLock_unlock( RWLock *self );
 
+/*!
+ * \brief Profile the contention of a RWLock
+ * \param self Pointer to a rwlock
+ * \param name Name of the rwlock in LockProfile_dump()
+ * Counts the read and write acquisitions and their waits until the rwlock
+ * is cleared. Must be called before the rwlock is used by other threads,
+ * and only on process private rwlocks.
+ * \see LockProfile_dump
+ */
+void RWLock_enableProfiling( RWLock *self, const char *name );
+
+/*!
+ * \brief Return the contention profile of a RWLock
+ * \param self Pointer to a rwlock
+ * \param stats Filled with the counters, all zero if not profiled
+ * \see RWLock_enableProfiling
+ */
+void RWLock_getStats( RWLock *self, LockProfileStats *stats );
+
 /*!
  * \brief Clean up a RWLock
  * \param self Pointer to a rwlock
@@ -0,0 +1,632 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <limits.h>
+
+#if defined(__linux__)
+
+#include <unistd.h>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+
+#endif
+
+#include <Any.h>
+#include <Atomic.h>
+#include <SPSCQueue.h>
+#include <Threads.h>
+
+
+#define SPSCQUEUE_VALID      0x5b5c0e21
+#define SPSCQUEUE_INVALID    0x2a71d9f4
+
+#define SPSCQUEUE_CACHELINE  ( 64 )
+
+/* polls before going to sleep on the futex, to keep the latency low */
+#define SPSCQUEUE_SPIN       ( 2000 )
+
+
+/* a futex is a 32 bit int, elsewhere a plain AnyAtomic is polled */
+#if defined(__linux__)
+typedef int SPSCQueueWord;
+#else
+typedef AnyAtomic SPSCQueueWord;
+#endif
+
+
+/*
+ * head and tail only grow, the slot is their value masked. Each side
+ * writes to its own cache line only, the waiter flags have their own
+ * lines too: they are read at every publication but written only by a
+ * side going to sleep.
+ */
+struct SPSCQueue
+{
+    unsigned long valid;
+    void **ring;
+    long mask;
+    int spin;
+    bool quit;
+    bool asymmetric;            /* the waiters pay for the publishers' barrier */
+    char pad0[SPSCQUEUE_CACHELINE];
+
+    /* producer side */
+    long head;                  /* next slot to push, published to the consumer */
+    long cachedTail;            /* the tail as last seen by the producer */
+    SPSCQueueWord dataSeq;      /* futex, bumped for a waiting consumer */
+    char pad1[SPSCQUEUE_CACHELINE - 2 * sizeof( long ) - sizeof( SPSCQueueWord )];
+
+    /* consumer side */
+    long tail;                  /* next slot to pop, published to the producer */
+    long cachedHead;            /* the head as last seen by the consumer */
+    SPSCQueueWord spaceSeq;     /* futex, bumped for a waiting producer */
+    char pad2[SPSCQUEUE_CACHELINE - 2 * sizeof( long ) - sizeof( SPSCQueueWord )];
+
+    SPSCQueueWord popWaiting;   /* the consumer sleeps on dataSeq */
+    char pad3[SPSCQUEUE_CACHELINE - sizeof( SPSCQueueWord )];
+
+    SPSCQueueWord pushWaiting;  /* the producer sleeps on spaceSeq */
+    char pad4[SPSCQUEUE_CACHELINE - sizeof( SPSCQueueWord )];
+};
+
+
+static void SPSCQueue_publishHead( SPSCQueue *self, long head );
+
+static void SPSCQueue_publishTail( SPSCQueue *self, long tail );
+
+static void SPSCQueue_setWaiting( SPSCQueue *self, SPSCQueueWord *flag );
+
+static int SPSCQueue_getSpin( void );
+
+static bool SPSCQueue_initAsymmetric( void );
+
+static long SPSCQueue_getParkTime( unsigned long long deadline, bool *expired );
+
+static void SPSCQueue_futexWait( SPSCQueueWord *address, SPSCQueueWord value, long microsecs );
+
+static void SPSCQueue_futexWake( SPSCQueueWord *address, int count );
+
+
+SPSCQueue *SPSCQueue_new( void )
+{
+    return ANY_TALLOC( SPSCQueue );
+}
+
+
+bool SPSCQueue_init( SPSCQueue *self, unsigned long capacity )
+{
+    unsigned long size = 2UL;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( capacity > 0 );
+
+    self->valid = SPSCQUEUE_INVALID;
+
+    while( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    self->ring = ANY_NTALLOC( size, void * );
+
+    if( !self->ring )
+    {
+        ANY_LOG( 0, "Unable to allocate %lu slots", ANY_LOG_ERROR, size );
+        return false;
+    }
+
+    self->mask = (long)size - 1;
+    self->quit = false;
+    self->spin = SPSCQueue_getSpin();
+    self->asymmetric = SPSCQueue_initAsymmetric();
+    self->head = 0;
+    self->cachedTail = 0;
+    self->dataSeq = 0;
+    self->pushWaiting = 0;
+    self->tail = 0;
+    self->cachedHead = 0;
+    self->spaceSeq = 0;
+    self->popWaiting = 0;
+
+    self->valid = SPSCQUEUE_VALID;
+
+    /* ready before any of the two threads may see it */
+    Atomic_memoryBarrier();
+
+    return true;
+}
+
+
+bool SPSCQueue_push( SPSCQueue *self, void *data )
+{
+    long head;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+    ANY_REQUIRE( data );
+
+    head = self->head;
+
+    if( head - self->cachedTail > self->mask )
+    {
+        self->cachedTail = Atomic_getAcquire( &self->tail );
+
+        if( head - self->cachedTail > self->mask )
+        {
+            return false;
+        }
+    }
+
+    self->ring[ head & self->mask ] = data;
+
+    SPSCQueue_publishHead( self, head + 1 );
+
+    return true;
+}
+
+
+unsigned long SPSCQueue_pushMany( SPSCQueue *self, void **data, unsigned long numElements )
+{
+    unsigned long room;
+    unsigned long i;
+    long head;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+    ANY_REQUIRE( data || numElements == 0 );
+
+    head = self->head;
+    room = (unsigned long)( self->mask + 1 - ( head - self->cachedTail ) );
+
+    if( room < numElements )
+    {
+        self->cachedTail = Atomic_getAcquire( &self->tail );
+        room = (unsigned long)( self->mask + 1 - ( head - self->cachedTail ) );
+    }
+
+    if( numElements > room )
+    {
+        numElements = room;
+    }
+
+    if( numElements == 0 )
+    {
+        return 0;
+    }
+
+    for( i = 0; i < numElements; i++ )
+    {
+        ANY_REQUIRE( data[ i ] );
+        self->ring[ ( head + i ) & self->mask ] = data[ i ];
+    }
+
+    /* a single publication for the whole batch */
+    SPSCQueue_publishHead( self, head + (long)numElements );
+
+    return numElements;
+}
+
+
+bool SPSCQueue_pushWait( SPSCQueue *self, void *data, long microsecs )
+{
+    unsigned long long deadline = 0;
+    SPSCQueueWord seq;
+    bool expired = false;
+    long timeout;
+    int spin = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    if( microsecs > 0 )
+    {
+        deadline = Any_getTime() + (unsigned long long)microsecs * 1000;
+    }
+
+    while( !SPSCQueue_push( self, data ) )
+    {
+        Atomic_memoryBarrier();
+
+        if( self->quit )
+        {
+            return false;
+        }
+
+        if( spin < self->spin )
+        {
+            spin++;
+            continue;
+        }
+
+        timeout = SPSCQueue_getParkTime( deadline, &expired );
+
+        if( expired )
+        {
+            return false;
+        }
+
+        seq = Atomic_get( &self->spaceSeq );
+        SPSCQueue_setWaiting( self, &self->pushWaiting );
+
+        /* the consumer may have made room meanwhile, without waking us */
+        if( SPSCQueue_push( self, data ) )
+        {
+            Atomic_dec( &self->pushWaiting );
+            break;
+        }
+
+        if( !self->quit )
+        {
+            SPSCQueue_futexWait( &self->spaceSeq, seq, timeout );
+        }
+
+        Atomic_dec( &self->pushWaiting );
+    }
+
+    return true;
+}
+
+
+void *SPSCQueue_pop( SPSCQueue *self )
+{
+    void *retVal;
+    long tail;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    tail = self->tail;
+
+    if( tail == self->cachedHead )
+    {
+        self->cachedHead = Atomic_getAcquire( &self->head );
+
+        if( tail == self->cachedHead )
+        {
+            return NULL;
+        }
+    }
+
+    retVal = self->ring[ tail & self->mask ];
+
+    SPSCQueue_publishTail( self, tail + 1 );
+
+    return retVal;
+}
+
+
+unsigned long SPSCQueue_popMany( SPSCQueue *self, void **data, unsigned long maxElements )
+{
+    unsigned long available;
+    unsigned long i;
+    long tail;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+    ANY_REQUIRE( data || maxElements == 0 );
+
+    tail = self->tail;
+    available = (unsigned long)( self->cachedHead - tail );
+
+    if( available < maxElements )
+    {
+        self->cachedHead = Atomic_getAcquire( &self->head );
+        available = (unsigned long)( self->cachedHead - tail );
+    }
+
+    if( maxElements > available )
+    {
+        maxElements = available;
+    }
+
+    if( maxElements == 0 )
+    {
+        return 0;
+    }
+
+    for( i = 0; i < maxElements; i++ )
+    {
+        data[ i ] = self->ring[ ( tail + i ) & self->mask ];
+    }
+
+    /* the slots are handed back all at once */
+    SPSCQueue_publishTail( self, tail + (long)maxElements );
+
+    return maxElements;
+}
+
+
+void *SPSCQueue_popWait( SPSCQueue *self, long microsecs )
+{
+    unsigned long long deadline = 0;
+    SPSCQueueWord seq;
+    void *retVal;
+    bool expired = false;
+    long timeout;
+    int spin = 0;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    if( microsecs > 0 )
+    {
+        deadline = Any_getTime() + (unsigned long long)microsecs * 1000;
+    }
+
+    while( !( retVal = SPSCQueue_pop( self ) ) )
+    {
+        Atomic_memoryBarrier();
+
+        if( self->quit )
+        {
+            break;
+        }
+
+        if( spin < self->spin )
+        {
+            spin++;
+            continue;
+        }
+
+        timeout = SPSCQueue_getParkTime( deadline, &expired );
+
+        if( expired )
+        {
+            break;
+        }
+
+        seq = Atomic_get( &self->dataSeq );
+        SPSCQueue_setWaiting( self, &self->popWaiting );
+
+        /* the producer may have pushed meanwhile, without waking us */
+        retVal = SPSCQueue_pop( self );
+
+        if( !retVal && !self->quit )
+        {
+            SPSCQueue_futexWait( &self->dataSeq, seq, timeout );
+        }
+
+        Atomic_dec( &self->popWaiting );
+
+        if( retVal )
+        {
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+
+void SPSCQueue_setQuit( SPSCQueue *self, bool status )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    self->quit = status;
+
+    Atomic_inc( &self->dataSeq );
+    Atomic_inc( &self->spaceSeq );
+
+    SPSCQueue_futexWake( &self->dataSeq, INT_MAX );
+    SPSCQueue_futexWake( &self->spaceSeq, INT_MAX );
+}
+
+
+unsigned long SPSCQueue_numElements( SPSCQueue *self )
+{
+    long tail;
+    long head;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    /* the tail first, so it cannot pass the head read afterwards */
+    tail = Atomic_getAcquire( &self->tail );
+    head = Atomic_getAcquire( &self->head );
+
+    return (unsigned long)( head - tail );
+}
+
+
+unsigned long SPSCQueue_capacity( SPSCQueue *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    return (unsigned long)( self->mask + 1 );
+}
+
+
+void SPSCQueue_clear( SPSCQueue *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == SPSCQUEUE_VALID );
+
+    self->valid = SPSCQUEUE_INVALID;
+
+    ANY_FREE( self->ring );
+
+    self->ring = NULL;
+    self->mask = 0;
+}
+
+
+void SPSCQueue_delete( SPSCQueue *self )
+{
+    ANY_REQUIRE( self );
+
+    ANY_FREE( self );
+}
+
+
+/*
+ * The new head must be visible before we look at the flag, else a
+ * consumer going to sleep right now may miss the head while we miss its
+ * flag. With membarrier() the consumer forces that barrier on us when
+ * setting its flag, so only the compiler must keep the order here.
+ */
+static void SPSCQueue_publishHead( SPSCQueue *self, long head )
+{
+    Atomic_setRelease( &self->head, head );
+
+#if defined(__linux__)
+    if( self->asymmetric )
+    {
+        __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    }
+    else
+#endif
+    {
+        Atomic_memoryBarrier();
+    }
+
+    if( Atomic_getAcquire( &self->popWaiting ) )
+    {
+        Atomic_inc( &self->dataSeq );
+        SPSCQueue_futexWake( &self->dataSeq, 1 );
+    }
+}
+
+
+static void SPSCQueue_publishTail( SPSCQueue *self, long tail )
+{
+    Atomic_setRelease( &self->tail, tail );
+
+#if defined(__linux__)
+    if( self->asymmetric )
+    {
+        __atomic_signal_fence( __ATOMIC_SEQ_CST );
+    }
+    else
+#endif
+    {
+        Atomic_memoryBarrier();
+    }
+
+    if( Atomic_getAcquire( &self->pushWaiting ) )
+    {
+        Atomic_inc( &self->spaceSeq );
+        SPSCQueue_futexWake( &self->spaceSeq, 1 );
+    }
+}
+
+
+/* the other half of the barrier in SPSCQueue_publishHead() */
+static void SPSCQueue_setWaiting( SPSCQueue *self, SPSCQueueWord *flag )
+{
+    Atomic_inc( flag );
+
+#if defined(__linux__)
+    if( self->asymmetric )
+    {
+        syscall( SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0 );
+    }
+#else
+    (void)self;
+#endif
+}
+
+
+/* on a single CPU the other side cannot make progress while we poll */
+static int SPSCQueue_getSpin( void )
+{
+    ThreadsCpuSet cpus;
+
+    if( Threads_getAvailableCpus( &cpus ) && ThreadsCpuSet_count( &cpus ) < 2 )
+    {
+        return 0;
+    }
+
+    return SPSCQUEUE_SPIN;
+}
+
+
+/* true if the publishers can leave their barrier to membarrier() */
+static bool SPSCQueue_initAsymmetric( void )
+{
+#if defined(__linux__)
+    long commands;
+
+    commands = syscall( SYS_membarrier, MEMBARRIER_CMD_QUERY, 0 );
+
+    /* registering again is harmless */
+    return commands > 0 && ( commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED ) &&
+           syscall( SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0 ) == 0;
+#else
+    return false;
+#endif
+}
+
+
+/* microseconds to sleep up to the deadline, 0 without one */
+static long SPSCQueue_getParkTime( unsigned long long deadline, bool *expired )
+{
+    unsigned long long now;
+
+    *expired = false;
+
+    if( deadline == 0 )
+    {
+        return 0;
+    }
+
+    now = Any_getTime();
+
+    if( now >= deadline )
+    {
+        *expired = true;
+        return 0;
+    }
+
+    return (long)( ( deadline - now + 999 ) / 1000 );
+}
+
+
+/* returns when the word changes or the time is over, 0 waits forever, and may return earlier */
+static void SPSCQueue_futexWait( SPSCQueueWord *address, SPSCQueueWord value, long microsecs )
+{
+#if defined(__linux__)
+    struct timespec timeout;
+
+    timeout.tv_sec = microsecs / 1000000;
+    timeout.tv_nsec = ( microsecs % 1000000 ) * 1000;
+
+    syscall( SYS_futex, address, FUTEX_WAIT_PRIVATE, value,
+             microsecs > 0 ? &timeout : NULL, NULL, 0 );
+#else
+    if( Atomic_get( address ) == value )
+    {
+        Any_sleepMicroSeconds( microsecs > 0 && microsecs < 50 ? microsecs : 50 );
+    }
+#endif
+}
+
+
+static void SPSCQueue_futexWake( SPSCQueueWord *address, int count )
+{
+#if defined(__linux__)
+    syscall( SYS_futex, address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0 );
+#endif
+}
+
+
+/* EOF */
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) Honda Research Institute Europe GmbH
+ *
+ *  This file is part of ToolBOSLib.
+ *
+ *  ToolBOSLib is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ToolBOSLib is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ToolBOSLib. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <Any.h>
+
+
+/*!
+ * \page SPSCQueue_About Single producer, single consumer queues
+ *
+ * The SPSCQueue library implements a bounded FIFO of pointers between
+ * exactly one producer thread and one consumer thread, e.g. a sensor
+ * thread feeding a processing thread.
+ *
+ * The elements live in a preallocated ring and both sides only publish
+ * their own index, so neither side ever locks, allocates or waits for
+ * the other one. Each side remembers the last index it has seen of the
+ * other one and reads the shared one only when that is not enough, which
+ * keeps the cache lines of the two sides apart. SPSCQueue_pushMany() and
+ * SPSCQueue_popMany() publish a whole batch at once.
+ *
+ * SPSCQueue_push() and SPSCQueue_pop() fail at once on a full or empty
+ * queue, SPSCQueue_pushWait() and SPSCQueue_popWait() spin for a while and
+ * then sleep until the other side makes progress.
+ *
+ * \code
+ * SPSCQueue *queue = SPSCQueue_new();
+ *
+ * SPSCQueue_init( queue, 1024 );
+ *
+ * // producer thread
+ * SPSCQueue_pushWait( queue, frame, 0 );
+ *
+ * // consumer thread
+ * frame = SPSCQueue_popWait( queue, 0 );
+ * \endcode
+ */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+typedef struct SPSCQueue SPSCQueue;
+
+
+SPSCQueue *SPSCQueue_new( void );
+
+/* the capacity is rounded up to a power of two */
+bool SPSCQueue_init( SPSCQueue *self, unsigned long capacity );
+
+/* producer side, false if the queue is full */
+bool SPSCQueue_push( SPSCQueue *self, void *data );
+
+/* producer side, pushes as many as fit and returns their number */
+unsigned long SPSCQueue_pushMany( SPSCQueue *self, void **data, unsigned long numElements );
+
+/* producer side, waits for room, false on timeout or quit; 0 waits forever */
+bool SPSCQueue_pushWait( SPSCQueue *self, void *data, long microsecs );
+
+/* consumer side, NULL if the queue is empty */
+void *SPSCQueue_pop( SPSCQueue *self );
+
+/* consumer side, pops up to maxElements and returns their number */
+unsigned long SPSCQueue_popMany( SPSCQueue *self, void **data, unsigned long maxElements );
+
+/* consumer side, waits for an element, NULL on timeout or quit; 0 waits forever */
+void *SPSCQueue_popWait( SPSCQueue *self, long microsecs );
+
+/* makes the waiting calls return */
+void SPSCQueue_setQuit( SPSCQueue *self, bool status );
+
+unsigned long SPSCQueue_numElements( SPSCQueue *self );
+
+unsigned long SPSCQueue_capacity( SPSCQueue *self );
+
+void SPSCQueue_clear( SPSCQueue *self );
+
+void SPSCQueue_delete( SPSCQueue *self );
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
+
+
+/* EOF */
@@ -963,19 +963,23 @@ bool Serialize_deployDataType( Serialize *self,
             {
                 case SERIALIZE_DEPLOYDATAMODE_BINARY:
                 {
-                    /* Call IOChannel_write until all data are written */
-                    while( rdwrBytes < len )
+                    IOChannelIOVec payload;
+
+                    /*
+                     * IOChannel_writev() writes until all data are written,
+                     * and sends large payloads together with the still
+                     * buffered header in one call, without copying them
+                     * into the write buffer first
+                     */
+                    payload.buffer = data;
+                    payload.size = len;
+
+                    nBytes = IOChannel_writev( self->stream, &payload, 1 );
+                    if( nBytes != len )
                     {
-                        nBytes = IOChannel_write( self->stream, (unsigned char *)data + rdwrBytes, ( len - rdwrBytes ));
-                        if( nBytes == -1 || IOChannel_eof( self->stream ) == true ||
-                            IOChannel_isErrorOccurred( self->stream ) == true )
-                        {
-                            ANY_LOG( 0, "Unable To DEPLOY(Write) BINARY VALUE on stream: %s", ANY_LOG_ERROR,
-                                     ( nBytes == -1 ) ? "-1 returned" : "EOF found or error occurred" );
-                            self->errorOccurred = true;
-                            break;
-                        }
-                        rdwrBytes += nBytes;
+                        ANY_LOG( 0, "Unable To DEPLOY(Write) BINARY VALUE on stream: %s", ANY_LOG_ERROR,
+                                 ( nBytes == -1 ) ? "-1 returned" : "EOF found or error occurred" );
+                        self->errorOccurred = true;
                     }
 
                     /*
@@ -21,12 +21,30 @@
 #include <stdio.h>
 #include <signal.h>
 
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 #include <Threads.h>
 
 
 #define THREADS_VALID    0x8685e2ae
 #define THREADS_INVALID    0x87411d50
 
+#define THREADS_CPUSET_WORDBITS  ( 8 * sizeof( unsigned long ) )
+
+#define THREADS_NUMANODE_PATH    "/sys/devices/system/node/node%d"
+
+
+#if defined(__linux__)
+
+static void ThreadsCpuSet_toCpuSet( const ThreadsCpuSet *self, cpu_set_t *cpuSet );
+
+static int Threads_readCpuList( const char *path, ThreadsCpuSet *cpus );
+
+#endif
+
 
 Threads *Threads_new( void )
 {
@@ -60,6 +78,8 @@ bool Threads_init( Threads *self, bool joinable )
     status = pthread_attr_getschedparam( &self->attr, &self->schedulerParams );
     ANY_REQUIRE( status == 0 );
 
+    self->name[ 0 ] = '\0';
+
     self->valid = THREADS_VALID;
 
     return true;
@@ -88,6 +108,14 @@ int Threads_start( Threads *self,
     /* start the thread */
     status = pthread_create( &self->thread, &self->attr, start_routine, arg );
 
+#if defined(__linux__)
+    /* only for tools like top and perf, a failure is not worth reporting */
+    if( status == 0 && self->name[ 0 ] != '\0' )
+    {
+        pthread_setname_np( self->thread, self->name );
+    }
+#endif
+
     return ( status );
 }
 
@@ -324,4 +352,346 @@ void Threads_setSchedPolicy( Threads *self, int policy, int priority )
 }
 
 
+int Threads_setAffinity( Threads *self, const ThreadsCpuSet *cpus )
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+#endif
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == THREADS_VALID );
+    ANY_REQUIRE( cpus );
+
+#if defined(__linux__)
+    ThreadsCpuSet_toCpuSet( cpus, &cpuSet );
+
+    return ( pthread_attr_setaffinity_np( &self->attr, sizeof( cpu_set_t ), &cpuSet ));
+#else
+    return ( THREADS_ENOTSUP );
+#endif
+}
+
+
+int Threads_setCurrentAffinity( const ThreadsCpuSet *cpus )
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+#endif
+
+    ANY_REQUIRE( cpus );
+
+#if defined(__linux__)
+    ThreadsCpuSet_toCpuSet( cpus, &cpuSet );
+
+    return ( pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &cpuSet ));
+#else
+    return ( THREADS_ENOTSUP );
+#endif
+}
+
+
+int Threads_setStackSize( Threads *self, size_t size )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == THREADS_VALID );
+
+    return ( pthread_attr_setstacksize( &self->attr, size ));
+}
+
+
+int Threads_setName( Threads *self, const char *name )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == THREADS_VALID );
+    ANY_REQUIRE( name );
+
+    Any_strncpy( self->name, name, THREADS_NAME_MAXLEN - 1 );
+    self->name[ THREADS_NAME_MAXLEN - 1 ] = '\0';
+
+#if defined(__linux__)
+    return ( 0 );
+#else
+    return ( THREADS_ENOTSUP );
+#endif
+}
+
+
+int Threads_setCurrentName( const char *name )
+{
+#if defined(__linux__)
+    char buffer[THREADS_NAME_MAXLEN];
+#endif
+
+    ANY_REQUIRE( name );
+
+#if defined(__linux__)
+    Any_strncpy( buffer, name, THREADS_NAME_MAXLEN - 1 );
+    buffer[ THREADS_NAME_MAXLEN - 1 ] = '\0';
+
+    return ( pthread_setname_np( pthread_self(), buffer ));
+#else
+    return ( THREADS_ENOTSUP );
+#endif
+}
+
+
+int Threads_getCurrentCpu( void )
+{
+#if defined(__linux__)
+    return ( sched_getcpu());
+#else
+    return ( -1 );
+#endif
+}
+
+
+bool Threads_getAvailableCpus( ThreadsCpuSet *cpus )
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    int       i;
+#endif
+
+    ANY_REQUIRE( cpus );
+
+    ThreadsCpuSet_zero( cpus );
+
+#if defined(__linux__)
+    if( sched_getaffinity( 0, sizeof( cpu_set_t ), &cpuSet ) == 0 )
+    {
+        for( i = 0; i < CPU_SETSIZE && i < THREADS_CPUSET_MAXCPUS; i++ )
+        {
+            if( CPU_ISSET( i, &cpuSet ))
+            {
+                ThreadsCpuSet_add( cpus, i );
+            }
+        }
+
+        return ( true );
+    }
+#endif
+
+    /* unknown: assume CPU 0 */
+    ThreadsCpuSet_add( cpus, 0 );
+
+    return ( false );
+}
+
+
+int Threads_getNumNumaNodes( void )
+{
+    int numNodes = 0;
+
+#if defined(__linux__)
+    char path[64];
+
+    /* the node directories are numbered without gaps */
+    for( ;; )
+    {
+        Any_snprintf( path, sizeof( path ), THREADS_NUMANODE_PATH, numNodes );
+
+        if( access( path, F_OK ) != 0 )
+        {
+            break;
+        }
+
+        numNodes++;
+    }
+#endif
+
+    return ( numNodes > 0 ? numNodes : 1 );
+}
+
+
+bool Threads_getNumaNodeCpus( int node, ThreadsCpuSet *cpus )
+{
+    ThreadsCpuSet available;
+
+#if defined(__linux__)
+    char path[64];
+#endif
+
+    ANY_REQUIRE( cpus );
+
+    if( node < 0 || node >= Threads_getNumNumaNodes() )
+    {
+        return ( false );
+    }
+
+#if defined(__linux__)
+    Any_snprintf( path, sizeof( path ), THREADS_NUMANODE_PATH "/cpulist", node );
+
+    if( Threads_readCpuList( path, cpus ) == 0 )
+    {
+        return ( true );
+    }
+#endif
+
+    Threads_getAvailableCpus( &available );
+    *cpus = available;
+
+    return ( true );
+}
+
+
+void ThreadsCpuSet_zero( ThreadsCpuSet *self )
+{
+    ANY_REQUIRE( self );
+
+    Any_memset( self, 0, sizeof( ThreadsCpuSet ));
+}
+
+
+void ThreadsCpuSet_add( ThreadsCpuSet *self, int cpu )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( cpu >= 0 && cpu < THREADS_CPUSET_MAXCPUS );
+
+    self->bits[ cpu / THREADS_CPUSET_WORDBITS ] |= 1UL << ( cpu % THREADS_CPUSET_WORDBITS );
+}
+
+
+void ThreadsCpuSet_remove( ThreadsCpuSet *self, int cpu )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( cpu >= 0 && cpu < THREADS_CPUSET_MAXCPUS );
+
+    self->bits[ cpu / THREADS_CPUSET_WORDBITS ] &= ~( 1UL << ( cpu % THREADS_CPUSET_WORDBITS ));
+}
+
+
+bool ThreadsCpuSet_contains( const ThreadsCpuSet *self, int cpu )
+{
+    ANY_REQUIRE( self );
+
+    if( cpu < 0 || cpu >= THREADS_CPUSET_MAXCPUS )
+    {
+        return ( false );
+    }
+
+    return ( ( self->bits[ cpu / THREADS_CPUSET_WORDBITS ] >> ( cpu % THREADS_CPUSET_WORDBITS )) & 1UL );
+}
+
+
+int ThreadsCpuSet_count( const ThreadsCpuSet *self )
+{
+    int count = 0;
+    int i;
+
+    ANY_REQUIRE( self );
+
+    for( i = 0; i < THREADS_CPUSET_MAXCPUS; i++ )
+    {
+        if( ThreadsCpuSet_contains( self, i ))
+        {
+            count++;
+        }
+    }
+
+    return ( count );
+}
+
+
+void ThreadsCpuSet_intersect( ThreadsCpuSet *self, const ThreadsCpuSet *other )
+{
+    unsigned int i;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( other );
+
+    for( i = 0; i < sizeof( self->bits ) / sizeof( self->bits[ 0 ] ); i++ )
+    {
+        self->bits[ i ] &= other->bits[ i ];
+    }
+}
+
+
+int ThreadsCpuSet_getNth( const ThreadsCpuSet *self, int n )
+{
+    int i;
+
+    ANY_REQUIRE( self );
+
+    for( i = 0; i < THREADS_CPUSET_MAXCPUS; i++ )
+    {
+        if( ThreadsCpuSet_contains( self, i ) && n-- == 0 )
+        {
+            return ( i );
+        }
+    }
+
+    return ( -1 );
+}
+
+
+#if defined(__linux__)
+
+static void ThreadsCpuSet_toCpuSet( const ThreadsCpuSet *self, cpu_set_t *cpuSet )
+{
+    int i;
+
+    CPU_ZERO( cpuSet );
+
+    for( i = 0; i < CPU_SETSIZE && i < THREADS_CPUSET_MAXCPUS; i++ )
+    {
+        if( ThreadsCpuSet_contains( self, i ))
+        {
+            CPU_SET( i, cpuSet );
+        }
+    }
+}
+
+
+/* parses a kernel CPU list like "0-7,16-23" */
+static int Threads_readCpuList( const char *path, ThreadsCpuSet *cpus )
+{
+    FILE *fp = (FILE *)NULL;
+    int  first = 0;
+    int  last = 0;
+    int  cpu = 0;
+    int  c = 0;
+
+    fp = fopen( path, "r" );
+
+    if( !fp )
+    {
+        return ( -1 );
+    }
+
+    ThreadsCpuSet_zero( cpus );
+
+    while( fscanf( fp, "%d", &first ) == 1 )
+    {
+        last = first;
+        c    = fgetc( fp );
+
+        if( c == '-' )
+        {
+            if( fscanf( fp, "%d", &last ) != 1 )
+            {
+                break;
+            }
+
+            c = fgetc( fp );
+        }
+
+        for( cpu = first; cpu <= last && cpu < THREADS_CPUSET_MAXCPUS; cpu++ )
+        {
+            ThreadsCpuSet_add( cpus, cpu );
+        }
+
+        if( c != ',' )
+        {
+            break;
+        }
+    }
+
+    fclose( fp );
+
+    return ( 0 );
+}
+
+#endif
+
+
 /* EOF */
@@ -49,6 +49,11 @@
 #define THREADS_SCHED_FIFO  SCHED_FIFO
 #define THREADS_SCHED_OTHER SCHED_OTHER
 
+/* the longest name the kernel keeps, including the terminating zero */
+#define THREADS_NAME_MAXLEN     ( 16 )
+
+#define THREADS_CPUSET_MAXCPUS  ( 1024 )
+
 
 #if defined(__cplusplus)
 extern "C" {
@@ -61,8 +66,20 @@ typedef struct Threads
     pthread_t thread;
     pthread_attr_t attr;
     struct sched_param schedulerParams;
+    char name[THREADS_NAME_MAXLEN];
 } Threads;
 
+/*!
+ * \brief Set of CPUs, see Threads_setAffinity()
+ *
+ * CPUs are numbered as in /proc/cpuinfo, from 0 to
+ * THREADS_CPUSET_MAXCPUS - 1.
+ */
+typedef struct ThreadsCpuSet
+{
+    unsigned long bits[THREADS_CPUSET_MAXCPUS / ( 8 * sizeof( unsigned long ))];
+} ThreadsCpuSet;
+
 
 Threads *Threads_new( void );
 
@@ -332,6 +349,88 @@ void Threads_delete( Threads *self );
  */
 void Threads_setSchedPolicy( Threads *self, int policy, int priority );
 
+/*!
+ * \brief Restricts the thread to a set of CPUs
+ * \param self Pointer to a Thread
+ * \param cpus CPUs the thread may run on
+ *
+ * Like Threads_setSchedPolicy() it must be called before Threads_start().
+ * Threads_setCurrentAffinity() pins an already running thread, from
+ * the thread itself.
+ *
+ * \return Return \a 0 on success, \a THREADS_ENOTSUP if not supported
+ * on this platform, an error code otherwise
+ */
+int Threads_setAffinity( Threads *self, const ThreadsCpuSet *cpus );
+
+int Threads_setCurrentAffinity( const ThreadsCpuSet *cpus );
+
+/*!
+ * \brief Sets the size of the thread's stack, to be called before Threads_start()
+ *
+ * \return Return \a 0 on success, \a THREADS_EINVAL if \a size is too small
+ */
+int Threads_setStackSize( Threads *self, size_t size );
+
+/*!
+ * \brief Names the thread, as shown by top, ps and perf
+ * \param self Pointer to a Thread
+ * \param name Name of the thread, truncated to THREADS_NAME_MAXLEN - 1 characters
+ *
+ * Like Threads_setSchedPolicy() it must be called before Threads_start().
+ * Threads_setCurrentName() names the calling thread.
+ *
+ * \return Return \a 0 on success, \a THREADS_ENOTSUP if not supported
+ * on this platform, an error code otherwise
+ */
+int Threads_setName( Threads *self, const char *name );
+
+int Threads_setCurrentName( const char *name );
+
+/*!
+ * \brief CPU the calling thread is running on, -1 if unknown
+ */
+int Threads_getCurrentCpu( void );
+
+/*!
+ * \brief CPUs the process may run on, e.g. restricted by taskset or cgroups
+ */
+bool Threads_getAvailableCpus( ThreadsCpuSet *cpus );
+
+/*!
+ * \brief Number of NUMA nodes of the machine, 1 if unknown
+ */
+int Threads_getNumNumaNodes( void );
+
+/*!
+ * \brief CPUs of a NUMA node, as listed by the kernel
+ *
+ * If the topology is unknown node 0 holds all the available CPUs.
+ *
+ * \return Return \a false if there is no such node
+ */
+bool Threads_getNumaNodeCpus( int node, ThreadsCpuSet *cpus );
+
+void ThreadsCpuSet_zero( ThreadsCpuSet *self );
+
+void ThreadsCpuSet_add( ThreadsCpuSet *self, int cpu );
+
+void ThreadsCpuSet_remove( ThreadsCpuSet *self, int cpu );
+
+bool ThreadsCpuSet_contains( const ThreadsCpuSet *self, int cpu );
+
+int ThreadsCpuSet_count( const ThreadsCpuSet *self );
+
+/*!
+ * \brief Keeps in \a self only the CPUs also in \a other
+ */
+void ThreadsCpuSet_intersect( ThreadsCpuSet *self, const ThreadsCpuSet *other );
+
+/*!
+ * \brief The n-th CPU of the set, counting from 0, or -1 if there are fewer
+ */
+int ThreadsCpuSet_getNth( const ThreadsCpuSet *self, int n );
+
 
 #if defined(__cplusplus)
 }
@@ -47,6 +47,7 @@
  * \li \subpage ArrayList_About
  * \li \subpage HashTable_About
  * \li \subpage MTQueue_About
+ * \li \subpage SPSCQueue_About
  * \li \subpage PQueue_About
  * \li \subpage PQueueArray_About
  * \li \subpage AnyTracing_About
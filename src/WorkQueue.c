@@ -18,13 +18,54 @@
  */
 
 
+#if defined(__linux__)
+
+#include <limits.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#endif
+
 #include <Any.h>
+#include <MThreadKey.h>
 #include <MTList.h>
 #include <WorkQueue.h>
 
 
+/* a futex is a 32 bit int, elsewhere a plain AnyAtomic is polled */
+#if defined(__linux__)
+typedef int WorkQueueWord;
+#else
+typedef AnyAtomic WorkQueueWord;
+#endif
+
+
 typedef struct WorkQueueTaskPool WorkQueueTaskPool;
 
+typedef struct WorkQueueParallelFor WorkQueueParallelFor;
+
+typedef struct WorkQueueDequeArray WorkQueueDequeArray;
+
+/* ring of tasks, replaced by a larger one when full */
+struct WorkQueueDequeArray
+{
+    long                size;
+    WorkQueueDequeArray *retired;
+    WorkQueueTask       *tasks[1];
+};
+
+/*
+ * Chase-Lev deque: the owner pushes and takes at the bottom, the thieves
+ * steal at the top. Only a take of the last task races with the thieves.
+ */
+typedef struct WorkQueueDeque
+{
+    AnyAtomic           top;
+    AnyAtomic           bottom;
+    WorkQueueDequeArray *array;
+} WorkQueueDeque;
+
 struct WorkQueueTask
 {
     unsigned long         valid;
@@ -32,11 +73,38 @@ struct WorkQueueTask
     WorkQueueTaskCallback callback;
     void                  *instance;
     void                  *userData;
-    Mutex                 *mutex;
-    Cond                  *taskTerminatedCond;
-    bool terminated;
+    WorkQueueWord         state;
+    WorkQueueTaskPool     *pool;
+    WorkQueueTask         *next;
+    WorkQueue             *queue;
+    AnyAtomic             pendingDeps;
+    bool                  enqueued;
+    WorkQueueTask         **successors;
+    unsigned int          numSuccessors;
+    unsigned int          maxSuccessors;
+    WorkQueuePriority     priority;
+    unsigned long long    enqueueTime;
 };
 
+/*
+ * the tasks waiting for a worker, one FIFO per priority linked through
+ * WorkQueueTask.next. The counters are updated under the mutex but read
+ * without it to skip empty queues.
+ */
+typedef struct WorkQueueRunQueue
+{
+    Mutex          mutex;
+    Cond           cond;
+    WorkQueueTask  *heads[WORKQUEUE_NUM_PRIORITIES];
+    WorkQueueTask  *tails[WORKQUEUE_NUM_PRIORITIES];
+    unsigned int   passedOver[WORKQUEUE_NUM_PRIORITIES];
+    WorkQueueStats stats[WORKQUEUE_NUM_PRIORITIES];
+    AnyAtomic      numTasks;
+    AnyAtomic      numUrgent;
+    long           numWaiting;
+    bool           quit;
+} WorkQueueRunQueue;
+
 struct WorkQueueWorker
 {
     unsigned long valid;
@@ -44,12 +112,16 @@ struct WorkQueueWorker
     WorkQueue     *parent;
     AnyAtomic     exit;
     AnyAtomic     busy;
+    WorkQueueDeque deque;
+    unsigned int  seed;
+    int           index;
+    int           node;
 };
 
 struct WorkQueue
 {
     unsigned long     valid;
-    MTQueue           *tasks;
+    WorkQueueRunQueue runQueue;
     WorkQueueTaskPool *taskPool;
     MTList            *workers;
     int               minWorkers;
@@ -59,15 +131,65 @@ struct WorkQueue
     bool clearing;
     AnyAtomic         maxWorkersReached;
     AnyAtomic         freeWorkers;
+    WorkQueueScheduler scheduler;
+    WorkQueueWorker   **stealWorkers;
+    AnyAtomic         numStealWorkers;
+    AnyAtomic         sleepingWorkers;
+    Mutex             *parkMutex;
+    Cond              *parkCond;
+    MThreadKey        *workerKey;
+    WorkQueuePinning  pinning;
+    char              name[THREADS_NAME_MAXLEN];
+    AnyAtomic         numStartedWorkers;
+    ThreadsCpuSet     availableCpus;
+    ThreadsCpuSet     *nodeCpus;
+    int               numNodes;
+};
+
+/*
+ * shared by the caller of WorkQueue_parallelFor() and its helper tasks,
+ * handed back to the pool by the last one done with it. It keeps its
+ * helpers, taken from the pool too, for the next WorkQueue_parallelFor().
+ */
+struct WorkQueueParallelFor
+{
+    WorkQueueRangeFn     fn;
+    void                 *context;
+    long                 begin;
+    long                 end;
+    long                 grain;
+    long                 numChunks;
+    AnyAtomic            nextChunk;
+    AnyAtomic            pendingChunks;
+    AnyAtomic            refCount;
+    WorkQueueWord        state;
+    WorkQueueTaskPool    *pool;
+    WorkQueueParallelFor *next;
+    WorkQueueTask        **helpers;
+    unsigned int         numHelpers;
 };
 
+#define WORKQUEUE_TASKPOOL_BLOCK_SIZE   64
+
+/* never freed before the pool, a late wake up may still touch a task */
+typedef struct WorkQueueTaskBlock
+{
+    struct WorkQueueTaskBlock *next;
+    WorkQueueTask             tasks[WORKQUEUE_TASKPOOL_BLOCK_SIZE];
+} WorkQueueTaskBlock;
+
+/*
+ * the free tasks are linked through WorkQueueTask.next, the free states of
+ * WorkQueue_parallelFor() through WorkQueueParallelFor.next
+ */
 struct WorkQueueTaskPool
 {
-    unsigned long valid;
-    AnyAtomic     taskBalance;
-    MTQueue       *tasks;
-    MTList        *nonTerminatedTasks;
-    MTQueue       *tempQueue;
+    unsigned long        valid;
+    AnyAtomic            taskBalance;
+    Mutex                mutex;
+    WorkQueueTask        *freeTasks;
+    WorkQueueTaskBlock   *blocks;
+    WorkQueueParallelFor *freeParallelFors;
 };
 
 #define WORKQUEUE_VALID            0x3da80c98
@@ -81,8 +203,22 @@ struct WorkQueueTaskPool
 
 #define WORKQUEUETASK_POP_TIMEOUT  200000
 
-#define WORKQUEUE_MTQUEUE_CLASS     1
 #define WORKQUEUE_TASKPOOL_INITIAL_SIZE 10
+#define WORKQUEUE_DEQUE_INITIAL_SIZE    256
+#define WORKQUEUE_SUCCESSORS_INITIAL_SIZE 4
+
+/* times a non empty priority can be passed over before being served */
+#define WORKQUEUE_PRIORITY_AGING        8
+
+/*
+ * bits of WorkQueueTask.state: LOCKED guards the successors, WAITERS asks
+ * WorkQueueTask_signal() for a wake up and DISPOSED hands the task back to
+ * the pool as soon as it terminates
+ */
+#define WORKQUEUETASK_TERMINATED   0x1
+#define WORKQUEUETASK_WAITERS      0x2
+#define WORKQUEUETASK_DISPOSED     0x4
+#define WORKQUEUETASK_LOCKED       0x8
 
 static WorkQueueWorker *WorkQueueWorker_new();
 
@@ -94,11 +230,15 @@ static void WorkQueueWorker_delete( WorkQueueWorker *self );
 
 static void WorkQueueTask_signal( WorkQueueTask *self );
 
-static WorkQueueTask *WorkQueueTask_new();
-
 static void WorkQueueTask_clear( WorkQueueTask *self );
 
-static void WorkQueueTask_delete( WorkQueueTask *self );
+static WorkQueueWord WorkQueueTask_lock( WorkQueueTask *self );
+
+static WorkQueueWord WorkQueueTask_setState( WorkQueueTask *self, WorkQueueWord set, WorkQueueWord unset );
+
+static void WorkQueueWord_wait( WorkQueueWord *self, WorkQueueWord value );
+
+static void WorkQueueWord_wakeAll( WorkQueueWord *self );
 
 static WorkQueueTaskPool *WorkQueueTaskPool_new();
 
@@ -112,7 +252,65 @@ static WorkQueueTask *WorkQueueTaskPool_getTask( WorkQueueTaskPool *self );
 
 static void WorkQueueTaskPool_disposeTask( WorkQueueTaskPool *self, WorkQueueTask *task );
 
-static void WorkQueueTaskPool_refreshTasks( WorkQueueTaskPool *self );
+static void WorkQueueTaskPool_addBlock( WorkQueueTaskPool *self );
+
+static void WorkQueueTaskPool_recycle( WorkQueueTaskPool *self, WorkQueueTask *task );
+
+static WorkQueueParallelFor *WorkQueueTaskPool_getParallelFor( WorkQueueTaskPool *self, unsigned int numHelpers );
+
+static void WorkQueueTaskPool_putParallelFor( WorkQueueTaskPool *self, WorkQueueParallelFor *pfor );
+
+static void WorkQueue_addWorkerIfNeeded( WorkQueue *self );
+
+static void WorkQueue_submit( WorkQueue *self, WorkQueueTask **tasks, unsigned int numTasks );
+
+static bool WorkQueueTask_setEnqueued( WorkQueueTask *self, WorkQueue *queue );
+
+static void WorkQueueTask_releaseSuccessors( WorkQueueTask **successors, unsigned int numSuccessors );
+
+static void WorkQueue_enqueueStealing( WorkQueue *self, WorkQueueTask **tasks, unsigned int numTasks );
+
+static unsigned int WorkQueue_numWorkers( WorkQueue *self );
+
+static WorkQueueTaskStatus WorkQueueParallelFor_helperFn( void *instance, void *userData );
+
+static void WorkQueueParallelFor_run( WorkQueueParallelFor *self );
+
+static void WorkQueueParallelFor_release( WorkQueueParallelFor *self );
+
+static void WorkQueueParallelFor_dropHelper( WorkQueueTask *task );
+
+static bool WorkQueue_hasWork( WorkQueue *self );
+
+static void WorkQueueWorker_setupThread( WorkQueueWorker *self );
+
+static void WorkQueueRunQueue_init( WorkQueueRunQueue *self );
+
+static void WorkQueueRunQueue_clear( WorkQueueRunQueue *self );
+
+static void WorkQueueRunQueue_push( WorkQueueRunQueue *self, WorkQueueTask **tasks, unsigned int numTasks );
+
+static WorkQueueTask *WorkQueueRunQueue_pop( WorkQueueRunQueue *self, bool wait );
+
+static void WorkQueueRunQueue_quit( WorkQueueRunQueue *self );
+
+static void WorkQueueWorker_runTask( WorkQueueWorker *self, WorkQueueTask *task );
+
+static WorkQueueTask *WorkQueueWorker_findTask( WorkQueueWorker *self );
+
+static void WorkQueueWorker_park( WorkQueueWorker *self );
+
+static void WorkQueueDeque_init( WorkQueueDeque *self, long size );
+
+static void WorkQueueDeque_clear( WorkQueueDeque *self );
+
+static void WorkQueueDeque_push( WorkQueueDeque *self, WorkQueueTask *task );
+
+static WorkQueueTask *WorkQueueDeque_take( WorkQueueDeque *self );
+
+static WorkQueueTask *WorkQueueDeque_steal( WorkQueueDeque *self );
+
+static bool WorkQueueDeque_isEmpty( WorkQueueDeque *self );
 
 
 WorkQueue *WorkQueue_new()
@@ -122,9 +320,25 @@ WorkQueue *WorkQueue_new()
 
 
 bool WorkQueue_init( WorkQueue *self, unsigned int minWorkers, unsigned int maxWorkers )
+{
+    return WorkQueue_initScheduler( self, minWorkers, maxWorkers, WORKQUEUE_SCHEDULER_SHARED );
+}
+
+
+bool WorkQueue_initScheduler( WorkQueue *self, unsigned int minWorkers, unsigned int maxWorkers,
+                              WorkQueueScheduler scheduler )
+{
+    return WorkQueue_initPinned( self, minWorkers, maxWorkers, scheduler,
+                                 WORKQUEUE_PINNING_NONE, NULL );
+}
+
+
+bool WorkQueue_initPinned( WorkQueue *self, unsigned int minWorkers, unsigned int maxWorkers,
+                           WorkQueueScheduler scheduler, WorkQueuePinning pinning,
+                           const char *name )
 {
     unsigned int i;
-    int          iRetVal;
+    int          node;
     bool         bRetVal;
 
     ANY_REQUIRE( self );
@@ -134,14 +348,72 @@ bool WorkQueue_init( WorkQueue *self, unsigned int minWorkers, unsigned int maxW
     self->clearing          = false;
     self->maxWorkersReached = ( minWorkers == maxWorkers );
     self->freeWorkers       = 0;
+    self->scheduler         = scheduler;
+    self->stealWorkers      = NULL;
+    self->numStealWorkers   = 0;
+    self->sleepingWorkers   = 0;
+    self->parkMutex         = NULL;
+    self->parkCond          = NULL;
+    self->workerKey         = NULL;
+    self->pinning           = pinning;
+    self->numStartedWorkers = 0;
+    self->nodeCpus          = NULL;
+    self->numNodes          = 1;
+    self->name[ 0 ]         = '\0';
+
+    if( name )
+    {
+        Any_strncpy( self->name, name, THREADS_NAME_MAXLEN - 1 );
+        self->name[ THREADS_NAME_MAXLEN - 1 ] = '\0';
+    }
 
-    /* Create and init task queue */
+    if( pinning != WORKQUEUE_PINNING_NONE )
+    {
+        /* the topology is read once, the workers added later use it too */
+        Threads_getAvailableCpus( &self->availableCpus );
+
+        self->numNodes = Threads_getNumNumaNodes();
+        self->nodeCpus = ANY_NTALLOC( self->numNodes, ThreadsCpuSet );
+        ANY_REQUIRE( self->nodeCpus );
+
+        for( node = 0; node < self->numNodes; node++ )
+        {
+            Threads_getNumaNodeCpus( node, &self->nodeCpus[ node ] );
+            ThreadsCpuSet_intersect( &self->nodeCpus[ node ], &self->availableCpus );
+        }
+    }
+
+    if( scheduler == WORKQUEUE_SCHEDULER_WORKSTEALING )
+    {
+        /* the pool does not grow, the deques are set up once */
+        minWorkers = maxWorkers ? maxWorkers : minWorkers;
+        ANY_REQUIRE_MSG( minWorkers > 0, "A work stealing WorkQueue needs at least one worker" );
+
+        self->maxWorkersReached = true;
+
+        self->stealWorkers = ANY_NTALLOC( minWorkers, WorkQueueWorker * );
+        ANY_REQUIRE( self->stealWorkers );
+
+        self->parkMutex = Mutex_new();
+        ANY_REQUIRE( self->parkMutex );
+        bRetVal = Mutex_init( self->parkMutex, MUTEX_PRIVATE );
+        ANY_REQUIRE( bRetVal );
+
+        self->parkCond = Cond_new();
+        ANY_REQUIRE( self->parkCond );
+        bRetVal = Cond_init( self->parkCond, COND_PRIVATE );
+        ANY_REQUIRE( bRetVal );
+        Cond_setMutex( self->parkCond, self->parkMutex );
 
-    self->tasks = MTQueue_new();
-    ANY_REQUIRE( self->tasks != NULL );
+        /* tells WorkQueue_enqueue() which worker, if any, is calling it */
+        self->workerKey = MThreadKey_new();
+        ANY_REQUIRE( self->workerKey );
+        bRetVal = MThreadKey_init( self->workerKey, NULL );
+        ANY_REQUIRE( bRetVal );
+    }
 
-    iRetVal = MTQueue_init( self->tasks, MTQUEUE_FIFO, true );
-    ANY_REQUIRE( iRetVal == 0 );
+    /* Create and init task queue */
+    WorkQueueRunQueue_init( &self->runQueue );
 
     /* Create and init task pool */
     self->taskPool = WorkQueueTaskPool_new();
@@ -176,6 +448,13 @@ bool WorkQueue_init( WorkQueue *self, unsigned int minWorkers, unsigned int maxW
         bRetVal = WorkQueueWorker_init( worker, self );
         ANY_REQUIRE( bRetVal );
         MTList_add( self->workers, worker );
+
+        if( self->stealWorkers )
+        {
+            /* published before the count, the thieves only look below it */
+            self->stealWorkers[ i ] = worker;
+            Atomic_inc( &self->numStealWorkers );
+        }
     }
 
     self->valid = WORKQUEUE_VALID;
@@ -185,8 +464,11 @@ bool WorkQueue_init( WorkQueue *self, unsigned int minWorkers, unsigned int maxW
 
 void WorkQueue_clear( WorkQueue *self )
 {
-    bool bRetVal;
-    int  status;
+    WorkQueueTask *task;
+    WorkQueueTask *next;
+    bool          bRetVal;
+    int           status;
+    int           i;
 
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == WORKQUEUE_VALID );
@@ -215,8 +497,18 @@ void WorkQueue_clear( WorkQueue *self )
     MTLIST_FOREACH_END;
 
     /* Wake up all the workers */
-    MTQueue_setQuit( self->tasks, true );
-    MTQueue_wakeUpAll( self->tasks );
+    WorkQueueRunQueue_quit( &self->runQueue );
+
+    if( self->parkCond )
+    {
+        status = Mutex_lock( self->parkMutex );
+        ANY_REQUIRE( status == 0 );
+
+        Cond_broadcast( self->parkCond );
+
+        status = Mutex_unlock( self->parkMutex );
+        ANY_REQUIRE( status == 0 );
+    }
 
     /* Wait for all workers to terminate */
     Barrier_wait( self->workerTerminationBarrier );
@@ -227,6 +519,19 @@ void WorkQueue_clear( WorkQueue *self )
         Any_sleepMilliSeconds( 500 );
     }
 
+    /*
+     * the helpers of WorkQueue_parallelFor() left in the queues hold a
+     * reference on its state, the callers have done their chunks already
+     */
+    for( i = 0; i < WORKQUEUE_NUM_PRIORITIES; i++ )
+    {
+        for( task = self->runQueue.heads[ i ]; task; task = next )
+        {
+            next = task->next;
+            WorkQueueParallelFor_dropHelper( task );
+        }
+    }
+
     status = Mutex_lock( self->mutex );
     ANY_REQUIRE( status == 0 );
 
@@ -234,6 +539,15 @@ void WorkQueue_clear( WorkQueue *self )
                 {
                     WorkQueueWorker *worker;
                     worker = (WorkQueueWorker *)MTLIST_FOREACH_ELEMENTPTR;
+
+                    if( worker->deque.array )
+                    {
+                        while( ( task = WorkQueueDeque_take( &worker->deque ) ) != NULL )
+                        {
+                            WorkQueueParallelFor_dropHelper( task );
+                        }
+                    }
+
                     WorkQueueWorker_clear( worker );
                     WorkQueueWorker_delete( worker );
                 }
@@ -249,15 +563,38 @@ void WorkQueue_clear( WorkQueue *self )
     MTList_clear( self->workers );
     MTList_delete( self->workers );
 
-    MTQueue_clear( self->tasks );
-    MTQueue_delete( self->tasks );
+    WorkQueueRunQueue_clear( &self->runQueue );
 
     Mutex_clear( self->mutex );
     Mutex_delete( self->mutex );
 
     WorkQueueTaskPool_clear( self->taskPool );
     WorkQueueTaskPool_delete( self->taskPool );
-    self->tasks                    = NULL;
+
+    if( self->scheduler == WORKQUEUE_SCHEDULER_WORKSTEALING )
+    {
+        MThreadKey_clear( self->workerKey );
+        MThreadKey_delete( self->workerKey );
+
+        Cond_clear( self->parkCond );
+        Cond_delete( self->parkCond );
+
+        Mutex_clear( self->parkMutex );
+        Mutex_delete( self->parkMutex );
+
+        ANY_FREE( self->stealWorkers );
+    }
+
+    if( self->nodeCpus )
+    {
+        ANY_FREE( self->nodeCpus );
+    }
+
+    self->stealWorkers             = NULL;
+    self->nodeCpus                 = NULL;
+    self->parkMutex                = NULL;
+    self->parkCond                 = NULL;
+    self->workerKey                = NULL;
     self->workers                  = NULL;
     self->workerTerminationBarrier = NULL;
     self->taskPool                 = NULL;
@@ -301,15 +638,106 @@ void WorkQueue_disposeTask( WorkQueue *self, WorkQueueTask *task )
 
 void WorkQueue_enqueue( WorkQueue *self, WorkQueueTask *task )
 {
-    int status;
-
     ANY_REQUIRE( self );
     ANY_REQUIRE( self->valid == WORKQUEUE_VALID );
     ANY_REQUIRE( task );
     ANY_REQUIRE( task->valid == WORKQUEUETASK_VALID );
 
-    ANY_LOG( 10, "Enqueued task %p, queue len %ld", ANY_LOG_INFO,
-             (void *)task, MTQueue_numElements( self->tasks ) );
+    /* started later by its last predecessor */
+    if( !WorkQueueTask_setEnqueued( task, self ) )
+    {
+        ANY_LOG( 10, "Task %p waits for its predecessors", ANY_LOG_INFO, (void *)task );
+        return;
+    }
+
+    WorkQueue_submit( self, &task, 1 );
+}
+
+
+void WorkQueue_enqueueMany( WorkQueue *self, WorkQueueTask **tasks, unsigned int numTasks )
+{
+    WorkQueueTask **ready = NULL;
+    unsigned int  numReady = 0;
+    unsigned int  i;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUE_VALID );
+    ANY_REQUIRE( tasks || numTasks == 0 );
+
+    for( i = 0; i < numTasks; i++ )
+    {
+        ANY_REQUIRE( tasks[ i ] );
+        ANY_REQUIRE( tasks[ i ]->valid == WORKQUEUETASK_VALID );
+
+        if( WorkQueueTask_setEnqueued( tasks[ i ], self ) )
+        {
+            if( ready )
+            {
+                ready[ numReady ] = tasks[ i ];
+            }
+
+            numReady++;
+        }
+        else if( !ready )
+        {
+            /*
+             * some wait for their predecessors, collect the others: once
+             * enqueued a waiting task may be started at any time
+             */
+            ready = ANY_NTALLOC( numTasks, WorkQueueTask * );
+            ANY_REQUIRE( ready );
+
+            Any_memcpy( ready, tasks, numReady * sizeof( WorkQueueTask * ) );
+        }
+    }
+
+    if( ready )
+    {
+        WorkQueue_submit( self, ready, numReady );
+        ANY_FREE( ready );
+    }
+    else
+    {
+        WorkQueue_submit( self, tasks, numTasks );
+    }
+}
+
+
+static void WorkQueue_submit( WorkQueue *self, WorkQueueTask **tasks, unsigned int numTasks )
+{
+    unsigned int i;
+
+    if( numTasks == 0 )
+    {
+        return;
+    }
+
+    if( numTasks == 1 )
+    {
+        ANY_LOG( 10, "Enqueued task %p, queue len %ld", ANY_LOG_INFO,
+                 (void *)tasks[ 0 ], Atomic_get( &self->runQueue.numTasks ) );
+    }
+
+    if( self->scheduler == WORKQUEUE_SCHEDULER_WORKSTEALING )
+    {
+        WorkQueue_enqueueStealing( self, tasks, numTasks );
+        return;
+    }
+
+    /* the same growth as one WorkQueue_enqueue() per task */
+    for( i = 0; i < numTasks; i++ )
+    {
+        WorkQueue_addWorkerIfNeeded( self );
+    }
+
+    WorkQueueRunQueue_push( &self->runQueue, tasks, numTasks );
+}
+
+
+static void WorkQueue_addWorkerIfNeeded( WorkQueue *self )
+{
+    int status;
+
     /* Checking workercount to avoid locking when the maximum
        worker count has been reached */
     if( ( !Atomic_get( &self->maxWorkersReached ) ) &&
@@ -336,94 +764,537 @@ void WorkQueue_enqueue( WorkQueue *self, WorkQueueTask *task )
             ANY_REQUIRE( status == 0 );
         }
     }
-    MTQueue_push( self->tasks, task, WORKQUEUE_MTQUEUE_CLASS );
 }
 
 
-/* this is the main worker thread */
-static void *WorkQueueWorker_main( void *worker )
+static void WorkQueue_enqueueStealing( WorkQueue *self, WorkQueueTask **tasks, unsigned int numTasks )
 {
-    WorkQueueWorker     *self = (WorkQueueWorker *)worker;
-    WorkQueueTaskStatus status;
-    WorkQueueTask       *task = NULL;
+    WorkQueueWorker *worker;
+    unsigned int    i;
+    int             status;
 
-    Atomic_set( &self->busy, false );
-    Atomic_inc( &self->parent->freeWorkers );
+    worker = (WorkQueueWorker *)MThreadKey_get( self->workerKey );
 
-    while( !Atomic_get( &self->exit ) )
+    if( worker )
     {
-        ANY_LOG( 10, "Popping( %p ) task, queue len %ld", ANY_LOG_INFO,
-                 (void *)self->parent, MTQueue_numElements( self->parent->tasks ) );
-        task = (WorkQueueTask *)MTQueue_popWait( self->parent->tasks, NULL, 0 );
-        ANY_LOG( 10, "Popped task %p, queue len %ld", ANY_LOG_INFO,
-                 (void *)task, MTQueue_numElements( self->parent->tasks ) );
+        /*
+         * enqueued by one of our tasks, they stay with this worker unless
+         * stolen. The deque ignores priorities, the others go to the run queue.
+         */
+        for( i = 0; i < numTasks; i++ )
+        {
+            if( tasks[ i ]->priority == WORKQUEUE_PRIORITY_NORMAL )
+            {
+                WorkQueueDeque_push( &worker->deque, tasks[ i ] );
+            }
+            else
+            {
+                WorkQueueRunQueue_push( &self->runQueue, &tasks[ i ], 1 );
+            }
+        }
+    }
+    else
+    {
+        WorkQueueRunQueue_push( &self->runQueue, tasks, numTasks );
+    }
 
-        if( task )
+    /* pairs with the check done by WorkQueueWorker_park() before sleeping */
+    Atomic_memoryBarrier();
+
+    if( Atomic_get( &self->sleepingWorkers ) > 0 )
+    {
+        status = Mutex_lock( self->parkMutex );
+        ANY_REQUIRE( status == 0 );
+
+        if( numTasks > 1 )
         {
-            Atomic_dec( &self->parent->freeWorkers );
-            Atomic_set( &self->busy, true );
+            Cond_broadcast( self->parkCond );
+        }
+        else
+        {
+            Cond_signal( self->parkCond );
+        }
 
-            status = task->taskFn( task->instance, task->userData );
+        status = Mutex_unlock( self->parkMutex );
+        ANY_REQUIRE( status == 0 );
+    }
+}
 
-            if( task->callback )
-            { task->callback( status, task ); }
 
-            /* Signal task termination to callers of Task_wait() */
-            WorkQueueTask_signal( task );
+static bool WorkQueue_hasWork( WorkQueue *self )
+{
+    long i;
+    long numWorkers;
 
-            Atomic_set( &self->busy, false );
-            Atomic_inc( &self->parent->freeWorkers );
-        }
+    if( Atomic_get( &self->runQueue.numTasks ) > 0 )
+    {
+        return true;
     }
 
-    Barrier_wait( self->parent->workerTerminationBarrier );
+    numWorkers = Atomic_get( &self->numStealWorkers );
 
-    return NULL;
+    for( i = 0; i < numWorkers; i++ )
+    {
+        if( !WorkQueueDeque_isEmpty( &self->stealWorkers[ i ]->deque ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 
-WorkQueueWorker *WorkQueueWorker_new()
+static unsigned int WorkQueue_numWorkers( WorkQueue *self )
 {
-    return ANY_TALLOC( WorkQueueWorker );
+    long numWorkers;
+
+    if( self->scheduler == WORKQUEUE_SCHEDULER_WORKSTEALING )
+    {
+        numWorkers = Atomic_get( &self->numStealWorkers );
+    }
+    else
+    {
+        numWorkers = self->maxWorkers ? self->maxWorkers : MTList_numElements( self->workers );
+    }
+
+    return numWorkers > 0 ? (unsigned int)numWorkers : 1;
 }
 
 
-bool WorkQueueWorker_init( WorkQueueWorker *self, WorkQueue *parent )
+void WorkQueue_parallelFor( WorkQueue *self, long begin, long end, long grain,
+                            WorkQueueRangeFn fn, void *context )
 {
-    bool retVal = true;
+    WorkQueueParallelFor *pfor;
+    WorkQueueWord        state;
+    unsigned int         numWorkers;
+    unsigned int         numHelpers;
+    unsigned int         i;
+    long                 numChunks;
 
     ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUE_VALID );
+    ANY_REQUIRE( fn );
 
-    self->valid = WORKQUEUEWORKER_INVALID;
-
-    Atomic_set( &self->exit, false );
+    if( end <= begin )
+    {
+        return;
+    }
 
-    self->parent = parent;
+    numWorkers = WorkQueue_numWorkers( self );
 
-    self->workerThread = Threads_new();
-    if( !self->workerThread )
-    { goto exit_error; }
+    /* by default a few chunks per worker, to even out uneven ones */
+    if( grain <= 0 )
+    {
+        grain = ( end - begin + numWorkers * 4 - 1 ) / ( numWorkers * 4 );
+    }
 
-    retVal = Threads_init( self->workerThread, false );
+    numChunks  = ( end - begin + grain - 1 ) / grain;
+    numHelpers = numChunks - 1 < numWorkers ? (unsigned int)( numChunks - 1 ) : numWorkers;
 
-    if( !retVal )
-    { goto dealloc_thread; }
+    if( numHelpers == 0 )
+    {
+        fn( begin, end, context );
+        return;
+    }
 
-    /* Start the worker thread */
-    if( Threads_start( self->workerThread, WorkQueueWorker_main, self ) != 0 )
+    /* the shared state and its helpers come from the pool, nothing to allocate */
+    pfor = WorkQueueTaskPool_getParallelFor( self->taskPool, numHelpers );
+
+    pfor->fn            = fn;
+    pfor->context       = context;
+    pfor->begin         = begin;
+    pfor->end           = end;
+    pfor->grain         = grain;
+    pfor->numChunks     = numChunks;
+    pfor->nextChunk     = 0;
+    pfor->pendingChunks = numChunks;
+    pfor->refCount      = numHelpers + 1;
+    pfor->state         = 0;
+
+    for( i = 0; i < numHelpers; i++ )
     {
-        goto clear_thread;
+        /* not signalled, the helpers report through the shared counter */
+        WorkQueueTask_init( pfor->helpers[ i ], WorkQueueParallelFor_helperFn, pfor, NULL, NULL );
     }
 
-    self->valid = WORKQUEUEWORKER_VALID;
-    return true;
+    WorkQueue_submit( self, pfor->helpers, numHelpers );
 
-    clear_thread:
-    Threads_clear( self->workerThread );
-    dealloc_thread:
-    Threads_delete( self->workerThread );
-    exit_error:
-    return false;
+    /* the caller works too, so nesting in a task cannot deadlock */
+    WorkQueueParallelFor_run( pfor );
+
+    /* the same protocol as WorkQueueTask_wait() */
+    state = Atomic_get( &pfor->state );
+
+    while( !( state & WORKQUEUETASK_TERMINATED ) )
+    {
+        if( !( state & WORKQUEUETASK_WAITERS ) )
+        {
+            state = Atomic_or( &pfor->state, WORKQUEUETASK_WAITERS );
+            continue;
+        }
+
+        WorkQueueWord_wait( &pfor->state, state );
+        state = Atomic_get( &pfor->state );
+    }
+
+    WorkQueueParallelFor_release( pfor );
+}
+
+
+static WorkQueueTaskStatus WorkQueueParallelFor_helperFn( void *instance, void *userData )
+{
+    WorkQueueParallelFor *self = (WorkQueueParallelFor *)instance;
+
+    (void)userData;
+
+    WorkQueueParallelFor_run( self );
+    WorkQueueParallelFor_release( self );
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+
+static void WorkQueueParallelFor_run( WorkQueueParallelFor *self )
+{
+    long chunk;
+    long first;
+    long last;
+
+    while( ( chunk = Atomic_inc( &self->nextChunk ) - 1 ) < self->numChunks )
+    {
+        first = self->begin + chunk * self->grain;
+        last  = first + self->grain < self->end ? first + self->grain : self->end;
+
+        self->fn( first, last, self->context );
+
+        /* the caller is woken only if it went to sleep */
+        if( Atomic_dec( &self->pendingChunks ) == 0 &&
+            ( Atomic_or( &self->state, WORKQUEUETASK_TERMINATED ) & WORKQUEUETASK_WAITERS ) )
+        {
+            WorkQueueWord_wakeAll( &self->state );
+        }
+    }
+}
+
+
+static void WorkQueueParallelFor_release( WorkQueueParallelFor *self )
+{
+    if( Atomic_dec( &self->refCount ) == 0 )
+    {
+        WorkQueueTaskPool_putParallelFor( self->pool, self );
+    }
+}
+
+
+/* a helper which will never run, the other tasks are left to the pool */
+static void WorkQueueParallelFor_dropHelper( WorkQueueTask *task )
+{
+    if( task->taskFn == WorkQueueParallelFor_helperFn )
+    {
+        WorkQueueParallelFor_release( (WorkQueueParallelFor *)task->instance );
+    }
+}
+
+
+void WorkQueue_getStats( WorkQueue *self, WorkQueuePriority priority, WorkQueueStats *stats )
+{
+    int status;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUE_VALID );
+    ANY_REQUIRE( priority >= WORKQUEUE_PRIORITY_REALTIME && priority < WORKQUEUE_NUM_PRIORITIES );
+    ANY_REQUIRE( stats );
+
+    status = Mutex_lock( &self->runQueue.mutex );
+    ANY_REQUIRE( status == 0 );
+
+    *stats = self->runQueue.stats[ priority ];
+
+    status = Mutex_unlock( &self->runQueue.mutex );
+    ANY_REQUIRE( status == 0 );
+}
+
+
+/* this is the main worker thread */
+static void *WorkQueueWorker_main( void *worker )
+{
+    WorkQueueWorker     *self = (WorkQueueWorker *)worker;
+    WorkQueueTask       *task = NULL;
+    bool                stealing;
+
+    Atomic_set( &self->busy, false );
+    Atomic_inc( &self->parent->freeWorkers );
+
+    stealing = ( self->parent->scheduler == WORKQUEUE_SCHEDULER_WORKSTEALING );
+
+    if( stealing )
+    {
+        MThreadKey_set( self->parent->workerKey, self );
+    }
+
+    while( !Atomic_get( &self->exit ) )
+    {
+        if( stealing )
+        {
+            task = WorkQueueWorker_findTask( self );
+
+            if( task )
+            {
+                WorkQueueWorker_runTask( self, task );
+            }
+            else
+            {
+                WorkQueueWorker_park( self );
+            }
+
+            continue;
+        }
+
+        ANY_LOG( 10, "Popping( %p ) task, queue len %ld", ANY_LOG_INFO,
+                 (void *)self->parent, Atomic_get( &self->parent->runQueue.numTasks ) );
+        task = WorkQueueRunQueue_pop( &self->parent->runQueue, true );
+        ANY_LOG( 10, "Popped task %p, queue len %ld", ANY_LOG_INFO,
+                 (void *)task, Atomic_get( &self->parent->runQueue.numTasks ) );
+
+        if( task )
+        {
+            WorkQueueWorker_runTask( self, task );
+        }
+    }
+
+    Barrier_wait( self->parent->workerTerminationBarrier );
+
+    return NULL;
+}
+
+
+static void WorkQueueWorker_runTask( WorkQueueWorker *self, WorkQueueTask *task )
+{
+    WorkQueueTaskStatus status;
+
+    Atomic_dec( &self->parent->freeWorkers );
+    Atomic_set( &self->busy, true );
+
+    /* the helpers of WorkQueue_parallelFor() may be reused as soon as they have run */
+    if( task->taskFn == WorkQueueParallelFor_helperFn )
+    {
+        task->taskFn( task->instance, task->userData );
+
+        Atomic_set( &self->busy, false );
+        Atomic_inc( &self->parent->freeWorkers );
+        return;
+    }
+
+    status = task->taskFn( task->instance, task->userData );
+
+    if( task->callback )
+    { task->callback( status, task ); }
+
+    /* Signal task termination to callers of Task_wait() */
+    WorkQueueTask_signal( task );
+
+    Atomic_set( &self->busy, false );
+    Atomic_inc( &self->parent->freeWorkers );
+}
+
+
+static WorkQueueTask *WorkQueueWorker_findTask( WorkQueueWorker *self )
+{
+    WorkQueue       *queue = self->parent;
+    WorkQueueWorker *victim;
+    WorkQueueTask   *task;
+    long            numWorkers;
+    long            start;
+    long            i;
+    int             pass;
+
+    /* tasks above the normal priority do not wait for our deque */
+    if( Atomic_get( &queue->runQueue.numUrgent ) > 0 )
+    {
+        task = WorkQueueRunQueue_pop( &queue->runQueue, false );
+    }
+    else
+    {
+        task = NULL;
+    }
+
+    /* newest first from our own deque, its data is likely still in cache */
+    if( !task )
+    {
+        task = WorkQueueDeque_take( &self->deque );
+    }
+
+    if( !task && Atomic_get( &queue->runQueue.numTasks ) > 0 )
+    {
+        task = WorkQueueRunQueue_pop( &queue->runQueue, false );
+    }
+
+    /* the pool may still be starting up, with no worker published yet */
+    numWorkers = Atomic_get( &queue->numStealWorkers );
+
+    if( !task && numWorkers > 0 )
+    {
+        /* oldest first from the others, starting at a random one */
+
+        self->seed = self->seed * 1103515245 + 12345;
+        start      = ( self->seed >> 16 ) % numWorkers;
+
+        /* on several NUMA nodes, from the workers of our own node first */
+        for( pass = queue->numNodes > 1 ? 0 : 1; pass < 2 && !task; pass++ )
+        {
+            for( i = 0; i < numWorkers && !task; i++ )
+            {
+                victim = queue->stealWorkers[ ( start + i ) % numWorkers ];
+
+                if( victim != self && ( pass == 1 || victim->node == self->node ) )
+                {
+                    task = WorkQueueDeque_steal( &victim->deque );
+                }
+            }
+        }
+    }
+
+    return task;
+}
+
+
+static void WorkQueueWorker_park( WorkQueueWorker *self )
+{
+    WorkQueue *queue = self->parent;
+    int       status;
+
+    status = Mutex_lock( queue->parkMutex );
+    ANY_REQUIRE( status == 0 );
+
+    /*
+     * announce ourselves before the last look for work: an enqueue either
+     * sees us sleeping and signals, or we see its task
+     */
+    Atomic_inc( &queue->sleepingWorkers );
+
+    if( !Atomic_get( &self->exit ) && !WorkQueue_hasWork( queue ) )
+    {
+        Cond_wait( queue->parkCond, WORKQUEUETASK_POP_TIMEOUT );
+    }
+
+    Atomic_dec( &queue->sleepingWorkers );
+
+    status = Mutex_unlock( queue->parkMutex );
+    ANY_REQUIRE( status == 0 );
+}
+
+
+WorkQueueWorker *WorkQueueWorker_new()
+{
+    return ANY_TALLOC( WorkQueueWorker );
+}
+
+
+bool WorkQueueWorker_init( WorkQueueWorker *self, WorkQueue *parent )
+{
+    bool retVal = true;
+
+    ANY_REQUIRE( self );
+
+    self->valid = WORKQUEUEWORKER_INVALID;
+
+    Atomic_set( &self->exit, false );
+
+    self->parent = parent;
+    self->seed   = (unsigned int)(uintptr_t)self;
+    self->index  = Atomic_inc( &parent->numStartedWorkers ) - 1;
+    self->node   = -1;
+
+    /* must exist before the thread starts, other workers may steal from it */
+    if( parent->scheduler == WORKQUEUE_SCHEDULER_WORKSTEALING )
+    {
+        WorkQueueDeque_init( &self->deque, WORKQUEUE_DEQUE_INITIAL_SIZE );
+    }
+
+    self->workerThread = Threads_new();
+    if( !self->workerThread )
+    { goto exit_error; }
+
+    retVal = Threads_init( self->workerThread, false );
+
+    if( !retVal )
+    { goto dealloc_thread; }
+
+    WorkQueueWorker_setupThread( self );
+
+    /* Start the worker thread */
+    if( Threads_start( self->workerThread, WorkQueueWorker_main, self ) != 0 )
+    {
+        goto clear_thread;
+    }
+
+    self->valid = WORKQUEUEWORKER_VALID;
+    return true;
+
+    clear_thread:
+    Threads_clear( self->workerThread );
+    dealloc_thread:
+    Threads_delete( self->workerThread );
+    exit_error:
+    return false;
+}
+
+
+/* name and pin the thread of a worker, before it starts */
+static void WorkQueueWorker_setupThread( WorkQueueWorker *self )
+{
+    WorkQueue     *queue = self->parent;
+    ThreadsCpuSet cpus;
+    char          name[64];
+    int           cpu;
+    int           node;
+
+    if( queue->name[ 0 ] != '\0' )
+    {
+        Any_snprintf( name, sizeof( name ), "%s/%d", queue->name, self->index );
+        Threads_setName( self->workerThread, name );
+    }
+
+    switch( queue->pinning )
+    {
+        case WORKQUEUE_PINNING_CPU:
+            cpu = ThreadsCpuSet_getNth( &queue->availableCpus,
+                                        self->index % ThreadsCpuSet_count( &queue->availableCpus ) );
+
+            ThreadsCpuSet_zero( &cpus );
+            ThreadsCpuSet_add( &cpus, cpu );
+
+            for( node = 0; node < queue->numNodes; node++ )
+            {
+                if( ThreadsCpuSet_contains( &queue->nodeCpus[ node ], cpu ) )
+                {
+                    self->node = node;
+                    break;
+                }
+            }
+            break;
+
+        case WORKQUEUE_PINNING_NUMANODE:
+            self->node = self->index % queue->numNodes;
+            cpus       = queue->nodeCpus[ self->node ];
+            break;
+
+        default:
+            return;
+    }
+
+    /* e.g. a node without CPUs available to us: leave it to the OS */
+    if( ThreadsCpuSet_count( &cpus ) == 0 )
+    {
+        ANY_LOG( 5, "No CPU to pin worker %d to", ANY_LOG_WARNING, self->index );
+        return;
+    }
+
+    if( Threads_setAffinity( self->workerThread, &cpus ) != 0 )
+    {
+        ANY_LOG( 3, "Unable to pin worker %d", ANY_LOG_WARNING, self->index );
+    }
 }
 
 
@@ -437,328 +1308,935 @@ void WorkQueueWorker_clear( WorkQueueWorker *self )
     Threads_clear( self->workerThread );
     Threads_delete( self->workerThread );
 
+    WorkQueueDeque_clear( &self->deque );
+
     self->workerThread = NULL;
     self->parent       = NULL;
 }
 
 
-void WorkQueueWorker_delete( WorkQueueWorker *self )
-{
-    ANY_REQUIRE( self );
+void WorkQueueWorker_delete( WorkQueueWorker *self )
+{
+    ANY_REQUIRE( self );
+
+    ANY_FREE( self );
+}
+
+
+bool WorkQueueTask_init( WorkQueueTask *self, WorkQueueTaskFn taskFn, void *instance,
+                         void *userData, WorkQueueTaskCallback callback )
+{
+    ANY_REQUIRE( self );
+    ANY_LOG( 10, "WorkQueueTask_init(%p, %p)", ANY_LOG_INFO, (void *)self, (void *)taskFn );
+
+    /* nothing to allocate, the task comes from the pool of its queue */
+    self->state    = 0;
+    self->next     = NULL;
+    self->instance = instance;
+    self->userData = userData;
+
+    self->taskFn   = taskFn;
+    self->callback = callback;
+
+    /* one hold dropped by WorkQueue_enqueue(), plus one per predecessor */
+    self->queue         = NULL;
+    self->pendingDeps   = 1;
+    self->enqueued      = false;
+    self->successors    = NULL;
+    self->numSuccessors = 0;
+    self->maxSuccessors = 0;
+
+    self->priority    = WORKQUEUE_PRIORITY_NORMAL;
+    self->enqueueTime = 0;
+
+    self->valid = WORKQUEUETASK_VALID;
+    return true;
+}
+
+
+bool WorkQueueTask_addDependency( WorkQueueTask *self, WorkQueueTask *predecessor )
+{
+    WorkQueueTask **successors;
+    unsigned int  maxSuccessors;
+    bool          retVal = true;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+    ANY_REQUIRE( predecessor );
+    ANY_REQUIRE( predecessor->valid == WORKQUEUETASK_VALID );
+    ANY_REQUIRE( predecessor != self );
+    ANY_REQUIRE_MSG( !self->enqueued, "Dependencies must be added before enqueuing the task" );
+
+    /* nothing to wait for once it is done */
+    if( WorkQueueTask_lock( predecessor ) & WORKQUEUETASK_TERMINATED )
+    {
+        goto exit;
+    }
+
+    if( predecessor->numSuccessors == predecessor->maxSuccessors )
+    {
+        maxSuccessors = predecessor->maxSuccessors ? predecessor->maxSuccessors * 2 :
+                        WORKQUEUE_SUCCESSORS_INITIAL_SIZE;
+
+        successors = ANY_NTALLOC( maxSuccessors, WorkQueueTask * );
+
+        if( !successors )
+        {
+            ANY_LOG( 0, "Unable to allocate the successors of task %p", ANY_LOG_ERROR,
+                     (void *)predecessor );
+            retVal = false;
+            goto exit;
+        }
+
+        if( predecessor->successors )
+        {
+            Any_memcpy( successors, predecessor->successors,
+                        predecessor->numSuccessors * sizeof( WorkQueueTask * ) );
+            ANY_FREE( predecessor->successors );
+        }
+
+        predecessor->successors    = successors;
+        predecessor->maxSuccessors = maxSuccessors;
+    }
+
+    predecessor->successors[ predecessor->numSuccessors++ ] = self;
+    Atomic_inc( &self->pendingDeps );
+
+    exit:
+    WorkQueueTask_setState( predecessor, 0, WORKQUEUETASK_LOCKED );
+
+    return retVal;
+}
+
+
+static bool WorkQueueTask_setEnqueued( WorkQueueTask *self, WorkQueue *queue )
+{
+    ANY_REQUIRE_MSG( !self->enqueued, "A task can be enqueued only once" );
+
+    self->queue    = queue;
+    self->enqueued = true;
+
+    /* true if all the predecessors are already done */
+    return Atomic_dec( &self->pendingDeps ) == 0;
+}
+
+
+static void WorkQueueTask_releaseSuccessors( WorkQueueTask **successors, unsigned int numSuccessors )
+{
+    WorkQueueTask *ready[WORKQUEUE_SUCCESSORS_INITIAL_SIZE];
+    WorkQueue     *queue = NULL;
+    unsigned int  numReady = 0;
+    unsigned int  i;
+
+    /* batch the ones becoming ready, as long as they go to the same queue */
+    for( i = 0; i < numSuccessors; i++ )
+    {
+        if( Atomic_dec( &successors[ i ]->pendingDeps ) != 0 )
+        {
+            continue;
+        }
+
+        if( numReady == WORKQUEUE_SUCCESSORS_INITIAL_SIZE ||
+            ( numReady > 0 && successors[ i ]->queue != queue ) )
+        {
+            WorkQueue_submit( queue, ready, numReady );
+            numReady = 0;
+        }
+
+        queue = successors[ i ]->queue;
+        ready[ numReady++ ] = successors[ i ];
+    }
+
+    if( numReady > 0 )
+    {
+        WorkQueue_submit( queue, ready, numReady );
+    }
+}
+
+
+void WorkQueueTask_setPriority( WorkQueueTask *self, WorkQueuePriority priority )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+    ANY_REQUIRE( priority >= WORKQUEUE_PRIORITY_REALTIME && priority < WORKQUEUE_NUM_PRIORITIES );
+    ANY_REQUIRE_MSG( !self->enqueued, "The priority must be set before enqueuing the task" );
+
+    self->priority = priority;
+}
+
+
+void *WorkQueueTask_getInstance( WorkQueueTask *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+
+    return self->instance;
+}
+
+
+void *WorkQueueTask_getUserData( WorkQueueTask *self )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+
+    return self->userData;
+}
+
+
+void WorkQueueTask_signal( WorkQueueTask *self )
+{
+    WorkQueueTask **successors;
+    unsigned int  numSuccessors;
+    WorkQueueWord state;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+
+    WorkQueueTask_lock( self );
+
+    /* no successor can be added from now on */
+    successors          = self->successors;
+    numSuccessors       = self->numSuccessors;
+    self->successors    = NULL;
+    self->numSuccessors = 0;
+    self->maxSuccessors = 0;
+
+    /* self may be disposed as soon as it is terminated */
+    state = WorkQueueTask_setState( self, WORKQUEUETASK_TERMINATED, WORKQUEUETASK_LOCKED );
+
+    if( state & WORKQUEUETASK_WAITERS )
+    {
+        WorkQueueWord_wakeAll( &self->state );
+    }
+
+    if( successors )
+    {
+        WorkQueueTask_releaseSuccessors( successors, numSuccessors );
+        ANY_FREE( successors );
+    }
+
+    /* disposed while running, nobody else refers to it */
+    if( state & WORKQUEUETASK_DISPOSED )
+    {
+        WorkQueueTaskPool_recycle( self->pool, self );
+    }
+}
+
+
+void WorkQueueTask_wait( WorkQueueTask *self )
+{
+    WorkQueueWord state;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+
+    state = Atomic_get( &self->state );
+
+    while( !( state & WORKQUEUETASK_TERMINATED ) )
+    {
+        if( !( state & WORKQUEUETASK_WAITERS ) )
+        {
+            state = WorkQueueTask_setState( self, WORKQUEUETASK_WAITERS, 0 );
+            continue;
+        }
+
+        WorkQueueWord_wait( &self->state, state );
+        state = Atomic_get( &self->state );
+    }
+}
+
+
+/* spins until the successors are free, returns the state it got them in */
+static WorkQueueWord WorkQueueTask_lock( WorkQueueTask *self )
+{
+    WorkQueueWord state;
+
+    for( ;; )
+    {
+        state = Atomic_get( &self->state );
+
+        if( !( state & WORKQUEUETASK_LOCKED ) &&
+            Atomic_testAndSetBool( &self->state, state, state | WORKQUEUETASK_LOCKED ) )
+        {
+            return state;
+        }
+
+        Threads_yield();
+    }
+}
+
+
+/* returns the state before the change */
+static WorkQueueWord WorkQueueTask_setState( WorkQueueTask *self, WorkQueueWord set, WorkQueueWord unset )
+{
+    WorkQueueWord state;
+
+    do
+    {
+        state = Atomic_get( &self->state );
+    }
+    while( !Atomic_testAndSetBool( &self->state, state, ( state & ~unset ) | set ) );
+
+    return state;
+}
+
+
+/* blocks while the word still has the given value, may return early */
+static void WorkQueueWord_wait( WorkQueueWord *self, WorkQueueWord value )
+{
+#if defined(__linux__)
+    syscall( SYS_futex, self, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0 );
+#else
+    Threads_yield();
+
+    if( Atomic_get( self ) == value )
+    {
+        Any_sleepMicroSeconds( 50 );
+    }
+#endif
+}
+
+
+static void WorkQueueWord_wakeAll( WorkQueueWord *self )
+{
+#if defined(__linux__)
+    syscall( SYS_futex, self, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0 );
+#else
+    (void)self;
+#endif
+}
+
+
+static void WorkQueueTask_clear( WorkQueueTask *self )
+{
+    ANY_REQUIRE( self );
+    ANY_LOG( 10, "WorkQueueTask_clear(%p), %lx", ANY_LOG_INFO, (void *)self, Threads_id() );
+    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+
+    self->valid = WORKQUEUETASK_INVALID;
+
+    if( self->successors )
+    {
+        ANY_FREE( self->successors );
+    }
+
+    self->instance      = NULL;
+    self->userData      = NULL;
+    self->taskFn        = NULL;
+    self->callback      = NULL;
+    self->queue         = NULL;
+    self->successors    = NULL;
+    self->numSuccessors = 0;
+    self->maxSuccessors = 0;
+}
+
+
+/* Task Pool */
+
+static WorkQueueTaskPool *WorkQueueTaskPool_new()
+{
+    return ANY_TALLOC( WorkQueueTaskPool );
+}
+
+
+static bool WorkQueueTaskPool_init( WorkQueueTaskPool *self, unsigned int initialSize )
+{
+    unsigned int i;
+    bool         bRetVal;
+
+    ANY_REQUIRE( self );
+
+    self->taskBalance      = 0;
+    self->freeTasks        = NULL;
+    self->blocks           = NULL;
+    self->freeParallelFors = NULL;
+
+    bRetVal = Mutex_init( &self->mutex, MUTEX_PRIVATE );
+    ANY_REQUIRE( bRetVal );
+
+    for( i = 0; i < initialSize; i += WORKQUEUE_TASKPOOL_BLOCK_SIZE )
+    {
+        WorkQueueTaskPool_addBlock( self );
+    }
+
+    self->valid = WORKQUEUETASKPOOL_VALID;
+
+    return true;
+}
+
+
+static void WorkQueueTaskPool_clear( WorkQueueTaskPool *self )
+{
+    WorkQueueTaskBlock   *block;
+    WorkQueueParallelFor *pfor;
+    int                  balance;
+    int                  i;
+
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
+
+    self->valid = WORKQUEUETASKPOOL_INVALID;
+
+    balance = Atomic_get( &self->taskBalance );
+    if( balance != 0 )
+    {
+        ANY_LOG( 0, "%d tasks have not been disposed correctly! ", ANY_LOG_WARNING,
+                 balance );
+    }
+
+    /* their helpers are in the blocks */
+    while( self->freeParallelFors )
+    {
+        pfor                   = self->freeParallelFors;
+        self->freeParallelFors = pfor->next;
+
+        ANY_FREE( pfor->helpers );
+        ANY_FREE( pfor );
+    }
+
+    while( self->blocks )
+    {
+        block        = self->blocks;
+        self->blocks = block->next;
+
+        /* the ones never terminated still own their successors */
+        for( i = 0; i < WORKQUEUE_TASKPOOL_BLOCK_SIZE; i++ )
+        {
+            if( block->tasks[ i ].valid == WORKQUEUETASK_VALID )
+            {
+                WorkQueueTask_clear( &block->tasks[ i ] );
+            }
+        }
+
+        ANY_FREE( block );
+    }
+
+    self->freeTasks = NULL;
 
-    ANY_FREE( self );
+    Mutex_clear( &self->mutex );
 }
 
 
-static WorkQueueTask *WorkQueueTask_new()
+static void WorkQueueTaskPool_delete( WorkQueueTaskPool *self )
 {
-    return ANY_TALLOC( WorkQueueTask );
+    ANY_FREE( self );
 }
 
 
-bool WorkQueueTask_init( WorkQueueTask *self, WorkQueueTaskFn taskFn, void *instance,
-                         void *userData, WorkQueueTaskCallback callback )
+static WorkQueueTask *WorkQueueTaskPool_getTask( WorkQueueTaskPool *self )
 {
-    bool retVal = true;
+    WorkQueueTask *task;
+    int           status;
 
     ANY_REQUIRE( self );
-    ANY_LOG( 10, "WorkQueueTask_init(%p, %p)", ANY_LOG_INFO, (void *)self, (void *)taskFn );
-
-    self->valid = WORKQUEUETASK_INVALID;
-
-    self->terminated = false;
-    self->instance   = instance;
-    self->userData   = userData;
-
-    self->taskFn   = taskFn;
-    self->callback = callback;
-
-    self->taskTerminatedCond = Cond_new();
-    if( !self->taskTerminatedCond )
-    { goto exit_error; }
-
-    retVal = Cond_init( self->taskTerminatedCond, COND_PRIVATE );
-    if( !retVal )
-    { goto dealloc_cond; }
+    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
 
-    self->mutex = Mutex_new();
-    if( !self->mutex )
-    { goto clear_cond; }
+    status = Mutex_lock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 
-    retVal = Mutex_init( self->mutex, MUTEX_PRIVATE );
-    if( !retVal )
-    { goto dealloc_mutex; }
+    if( !self->freeTasks )
+    {
+        WorkQueueTaskPool_addBlock( self );
+    }
 
-    Cond_setMutex( self->taskTerminatedCond, self->mutex );
+    task            = self->freeTasks;
+    self->freeTasks = task->next;
+    task->next      = NULL;
 
-    self->valid = WORKQUEUETASK_VALID;
-    return true;
+    status = Mutex_unlock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 
-    dealloc_mutex:
-    Mutex_delete( self->mutex );
-    clear_cond:
-    Cond_clear( self->taskTerminatedCond );
-    dealloc_cond:
-    Cond_delete( self->taskTerminatedCond );
-    exit_error:
-    return false;
+    Atomic_inc( &self->taskBalance );
+    return task;
 }
 
 
-void *WorkQueueTask_getInstance( WorkQueueTask *self )
+static void WorkQueueTaskPool_disposeTask( WorkQueueTaskPool *self, WorkQueueTask *task )
 {
     ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
+    ANY_REQUIRE( task );
+    ANY_REQUIRE( task->pool == self );
 
-    return self->instance;
+    ANY_LOG( 10, "Disposing task %p", ANY_LOG_INFO, (void *)task );
+    Atomic_dec( &self->taskBalance );
+
+    /* otherwise WorkQueueTask_signal() recycles it */
+    if( WorkQueueTask_setState( task, WORKQUEUETASK_DISPOSED, 0 ) & WORKQUEUETASK_TERMINATED )
+    {
+        WorkQueueTaskPool_recycle( self, task );
+    }
 }
 
 
-void *WorkQueueTask_getUserData( WorkQueueTask *self )
+/* called with the mutex held */
+static void WorkQueueTaskPool_addBlock( WorkQueueTaskPool *self )
 {
-    ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+    WorkQueueTaskBlock *block;
+    int                i;
 
-    return self->userData;
+    block = ANY_TALLOC( WorkQueueTaskBlock );
+    ANY_REQUIRE( block );
+
+    block->next  = self->blocks;
+    self->blocks = block;
+
+    for( i = WORKQUEUE_TASKPOOL_BLOCK_SIZE - 1; i >= 0; i-- )
+    {
+        block->tasks[ i ].valid = WORKQUEUETASK_INVALID;
+        block->tasks[ i ].pool  = self;
+        block->tasks[ i ].next  = self->freeTasks;
+        self->freeTasks         = &block->tasks[ i ];
+    }
 }
 
 
-void WorkQueueTask_signal( WorkQueueTask *self )
+static void WorkQueueTaskPool_recycle( WorkQueueTaskPool *self, WorkQueueTask *task )
 {
     int status;
-    ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
 
-    status = Mutex_lock( self->mutex );
-    ANY_REQUIRE( status == 0 );
+    /* never initialized ones can be disposed too */
+    if( task->valid == WORKQUEUETASK_VALID )
+    {
+        WorkQueueTask_clear( task );
+    }
 
-    self->terminated = true;
-    status = Cond_signal( self->taskTerminatedCond );
+    status = Mutex_lock( &self->mutex );
     ANY_REQUIRE( status == 0 );
 
-    status = Mutex_unlock( self->mutex );
+    task->next      = self->freeTasks;
+    self->freeTasks = task;
+
+    status = Mutex_unlock( &self->mutex );
     ANY_REQUIRE( status == 0 );
 }
 
 
-void WorkQueueTask_wait( WorkQueueTask *self )
+/* the helpers are not counted in the task balance, they are never disposed */
+static WorkQueueParallelFor *WorkQueueTaskPool_getParallelFor( WorkQueueTaskPool *self, unsigned int numHelpers )
 {
-    int status;
+    WorkQueueParallelFor *pfor;
+    WorkQueueTask        **helpers;
+    int                  status;
+
     ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
 
-    status = Mutex_lock( self->mutex );
+    status = Mutex_lock( &self->mutex );
     ANY_REQUIRE( status == 0 );
 
-    if( !self->terminated )
+    pfor = self->freeParallelFors;
+
+    if( pfor )
     {
-        status = Cond_wait( self->taskTerminatedCond, 0 );
-        ANY_REQUIRE( status == 0 );
+        self->freeParallelFors = pfor->next;
     }
+    else
+    {
+        pfor = ANY_TALLOC( WorkQueueParallelFor );
+        ANY_REQUIRE( pfor );
 
-    status = Mutex_unlock( self->mutex );
+        pfor->pool = self;
+    }
+
+    /* only when more workers are there than the last time it was used */
+    if( pfor->numHelpers < numHelpers )
+    {
+        helpers = ANY_NTALLOC( numHelpers, WorkQueueTask * );
+        ANY_REQUIRE( helpers );
+
+        if( pfor->helpers )
+        {
+            Any_memcpy( helpers, pfor->helpers, pfor->numHelpers * sizeof( WorkQueueTask * ) );
+            ANY_FREE( pfor->helpers );
+        }
+
+        for( ; pfor->numHelpers < numHelpers; pfor->numHelpers++ )
+        {
+            if( !self->freeTasks )
+            {
+                WorkQueueTaskPool_addBlock( self );
+            }
+
+            helpers[ pfor->numHelpers ] = self->freeTasks;
+            self->freeTasks             = self->freeTasks->next;
+        }
+
+        pfor->helpers = helpers;
+    }
+
+    pfor->next = NULL;
+
+    status = Mutex_unlock( &self->mutex );
     ANY_REQUIRE( status == 0 );
+
+    return pfor;
 }
 
 
-static void WorkQueueTask_clear( WorkQueueTask *self )
+static void WorkQueueTaskPool_putParallelFor( WorkQueueTaskPool *self, WorkQueueParallelFor *pfor )
 {
-    ANY_REQUIRE( self );
-    ANY_LOG( 10, "WorkQueueTask_clear(%p), %lx", ANY_LOG_INFO, (void *)self, Threads_id() );
-    ANY_REQUIRE( self->valid == WORKQUEUETASK_VALID );
+    int status;
 
-    self->valid = WORKQUEUETASK_INVALID;
+    status = Mutex_lock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 
-    Cond_clear( self->taskTerminatedCond );
-    Mutex_clear( self->mutex );
-    Cond_delete( self->taskTerminatedCond );
-    Mutex_delete( self->mutex );
+    pfor->next             = self->freeParallelFors;
+    self->freeParallelFors = pfor;
 
-    self->instance           = NULL;
-    self->userData           = NULL;
-    self->taskFn             = NULL;
-    self->callback           = NULL;
-    self->taskTerminatedCond = NULL;
-    self->mutex              = NULL;
+    status = Mutex_unlock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 }
 
 
-static void WorkQueueTask_delete( WorkQueueTask *self )
+/* Run queue */
+
+static void WorkQueueRunQueue_init( WorkQueueRunQueue *self )
 {
-    ANY_REQUIRE( self );
-    ANY_FREE( self );
-}
+    bool bRetVal;
 
+    Any_memset( self, 0, sizeof( WorkQueueRunQueue ) );
 
-/* Task Pool */
+    bRetVal = Mutex_init( &self->mutex, MUTEX_PRIVATE );
+    ANY_REQUIRE( bRetVal );
 
-static WorkQueueTaskPool *WorkQueueTaskPool_new()
+    bRetVal = Cond_init( &self->cond, COND_PRIVATE );
+    ANY_REQUIRE( bRetVal );
+    Cond_setMutex( &self->cond, &self->mutex );
+}
+
+
+static void WorkQueueRunQueue_clear( WorkQueueRunQueue *self )
 {
-    return ANY_TALLOC( WorkQueueTaskPool );
+    Cond_clear( &self->cond );
+    Mutex_clear( &self->mutex );
 }
 
 
-static bool WorkQueueTaskPool_init( WorkQueueTaskPool *self, unsigned int initialSize )
+static void WorkQueueRunQueue_push( WorkQueueRunQueue *self, WorkQueueTask **tasks, unsigned int numTasks )
 {
-    unsigned int  i;
-    int           iRetVal;
-    bool          bRetVal;
-    WorkQueueTask *task;
+    WorkQueueTask      *task;
+    WorkQueueStats     *stats;
+    unsigned long long now;
+    unsigned int       i;
+    int                status;
 
-    ANY_REQUIRE( self );
+    now = Any_getTime();
 
-    self->valid = WORKQUEUETASKPOOL_VALID;
+    status = Mutex_lock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    for( i = 0; i < numTasks; i++ )
+    {
+        task              = tasks[ i ];
+        task->enqueueTime = now;
+        task->next        = NULL;
 
-    self->taskBalance = 0;
+        if( self->tails[ task->priority ] )
+        {
+            self->tails[ task->priority ]->next = task;
+        }
+        else
+        {
+            self->heads[ task->priority ] = task;
+        }
 
-    self->tasks = MTQueue_new();
-    ANY_REQUIRE( self->tasks );
-    iRetVal = MTQueue_init( self->tasks, MTQUEUE_FIFO, true );
-    ANY_REQUIRE( iRetVal == 0 );
+        self->tails[ task->priority ] = task;
 
-    self->nonTerminatedTasks = MTList_new();
-    ANY_REQUIRE( self->nonTerminatedTasks );
-    bRetVal = MTList_init( self->nonTerminatedTasks );
-    ANY_REQUIRE( bRetVal );
-    MTList_setDeleteMode( self->nonTerminatedTasks, MTLIST_DELETEMODE_MANUAL );
+        stats = &self->stats[ task->priority ];
+        stats->queued++;
+        stats->enqueued++;
 
-    self->tempQueue = MTQueue_new();
-    ANY_REQUIRE( self->tempQueue );
-    iRetVal = MTQueue_init( self->tempQueue, MTQUEUE_FIFO, true );
-    ANY_REQUIRE( iRetVal == 0 );
+        if( stats->queued > stats->maxQueued )
+        {
+            stats->maxQueued = stats->queued;
+        }
+
+        if( task->priority < WORKQUEUE_PRIORITY_NORMAL )
+        {
+            Atomic_inc( &self->numUrgent );
+        }
+    }
 
-    for( i = 0; i < initialSize; i++ )
+    Atomic_add( &self->numTasks, numTasks );
+
+    if( self->numWaiting > 0 )
     {
-        task = WorkQueueTask_new();
-        ANY_REQUIRE( task );
-        MTQueue_push( self->tasks, task, WORKQUEUE_MTQUEUE_CLASS );
+        if( numTasks > 1 )
+        {
+            Cond_broadcast( &self->cond );
+        }
+        else
+        {
+            Cond_signal( &self->cond );
+        }
     }
-    return true;
+
+    status = Mutex_unlock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 }
 
 
-static void WorkQueueTaskPool_clear( WorkQueueTaskPool *self )
+static WorkQueueTask *WorkQueueRunQueue_pop( WorkQueueRunQueue *self, bool wait )
 {
-    WorkQueueTask *task;
-    int           balance;
+    WorkQueueTask      *task = NULL;
+    WorkQueueStats     *stats;
+    unsigned long long waitTime;
+    int                level = -1;
+    int                i;
+    int                status;
+
+    status = Mutex_lock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 
-    ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
+    while( Atomic_get( &self->numTasks ) == 0 )
+    {
+        if( !wait || self->quit )
+        {
+            goto exit;
+        }
 
-    self->valid = WORKQUEUETASKPOOL_INVALID;
+        self->numWaiting++;
+        Cond_wait( &self->cond, 0 );
+        self->numWaiting--;
+    }
 
-    task = (WorkQueueTask *)MTQueue_pop( self->tasks, NULL );
-    while( task != NULL )
+    /* the highest priority waiting, unless a lower one waited too long */
+    for( i = 0; i < WORKQUEUE_NUM_PRIORITIES; i++ )
     {
-        WorkQueueTask_delete( task );
-        task = (WorkQueueTask *)MTQueue_pop( self->tasks, NULL );
+        if( self->stats[ i ].queued == 0 )
+        {
+            continue;
+        }
+
+        if( level < 0 )
+        {
+            level = i;
+        }
+        else if( ++self->passedOver[ i ] > WORKQUEUE_PRIORITY_AGING &&
+                 self->passedOver[ level ] <= WORKQUEUE_PRIORITY_AGING )
+        {
+            level = i;
+        }
     }
-    MTQueue_clear( self->tasks );
-    MTQueue_delete( self->tasks );
 
-    MTQueue_clear( self->tempQueue );
-    MTQueue_delete( self->tempQueue );
+    ANY_REQUIRE( level >= 0 );
 
-    MTLIST_FOREACH_BEGIN ( self->nonTerminatedTasks, MTLIST_ITERATE_FOR_READ )
-                {
-                    task = (WorkQueueTask *)MTLIST_FOREACH_ELEMENTPTR;
-                    WorkQueueTask_wait( task );
-                    WorkQueueTask_clear( task );
-                    WorkQueueTask_delete( task );
-                }
-    MTLIST_FOREACH_END;
+    self->passedOver[ level ] = 0;
 
-    MTList_clear( self->nonTerminatedTasks );
-    MTList_delete( self->nonTerminatedTasks );
+    task = self->heads[ level ];
+    ANY_REQUIRE( task );
 
-    balance = Atomic_get( &self->taskBalance );
-    if( balance != 0 )
+    self->heads[ level ] = task->next;
+    task->next           = NULL;
+
+    if( !self->heads[ level ] )
     {
-        ANY_LOG( 0, "%d tasks have not been disposed correctly! ", ANY_LOG_WARNING,
-                 balance );
+        self->tails[ level ] = NULL;
+    }
+
+    Atomic_dec( &self->numTasks );
+
+    if( level < WORKQUEUE_PRIORITY_NORMAL )
+    {
+        Atomic_dec( &self->numUrgent );
+    }
+
+    waitTime = Any_getTime() - task->enqueueTime;
+
+    stats = &self->stats[ level ];
+    stats->queued--;
+    stats->started++;
+    stats->totalWaitTime += waitTime;
+
+    if( waitTime > stats->maxWaitTime )
+    {
+        stats->maxWaitTime = waitTime;
     }
+
+    exit:
+    status = Mutex_unlock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    return task;
 }
 
 
-static void WorkQueueTaskPool_delete( WorkQueueTaskPool *self )
+static void WorkQueueRunQueue_quit( WorkQueueRunQueue *self )
 {
-    ANY_FREE( self );
+    int status;
+
+    status = Mutex_lock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
+
+    self->quit = true;
+    Cond_broadcast( &self->cond );
+
+    status = Mutex_unlock( &self->mutex );
+    ANY_REQUIRE( status == 0 );
 }
 
 
-static WorkQueueTask *WorkQueueTaskPool_getTask( WorkQueueTaskPool *self )
+/* Work stealing deque */
+
+static WorkQueueDequeArray *WorkQueueDequeArray_new( long size )
 {
-    WorkQueueTask *task;
+    WorkQueueDequeArray *self;
 
+    self = (WorkQueueDequeArray *)ANY_BALLOC( sizeof( WorkQueueDequeArray ) +
+                                              ( size - 1 ) * sizeof( WorkQueueTask * ) );
     ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
 
-    WorkQueueTaskPool_refreshTasks( self );
+    self->size    = size;
+    self->retired = NULL;
+
+    return self;
+}
+
+
+static void WorkQueueDeque_init( WorkQueueDeque *self, long size )
+{
+    ANY_REQUIRE( self );
+    ANY_REQUIRE( size > 0 && ( size & ( size - 1 ) ) == 0 );
+
+    self->top    = 0;
+    self->bottom = 0;
+    self->array  = WorkQueueDequeArray_new( size );
+}
+
+
+static void WorkQueueDeque_clear( WorkQueueDeque *self )
+{
+    WorkQueueDequeArray *array;
+    WorkQueueDequeArray *retired;
 
-    task = (WorkQueueTask *)MTQueue_pop( self->tasks, NULL );
-    if( task == NULL )
+    ANY_REQUIRE( self );
+
+    array = self->array;
+
+    while( array )
     {
-        task = WorkQueueTask_new();
+        retired = array->retired;
+        ANY_FREE( array );
+        array = retired;
     }
 
-    Atomic_inc( &self->taskBalance );
-    return task;
+    self->array = NULL;
 }
 
 
-static int WorkQueueTaskPool_taskCompare( void *a, void *b )
+/* owner only */
+static void WorkQueueDeque_push( WorkQueueDeque *self, WorkQueueTask *task )
 {
-    return a == b ? 0 : 1;
+    WorkQueueDequeArray *array;
+    WorkQueueDequeArray *larger;
+    long                bottom;
+    long                top;
+    long                i;
+
+    bottom = self->bottom;
+    top    = Atomic_get( &self->top );
+    array  = self->array;
+
+    if( bottom - top >= array->size )
+    {
+        /*
+         * thieves may still be reading the old ring, it is kept until the
+         * deque is cleared
+         */
+        larger = WorkQueueDequeArray_new( array->size * 2 );
+
+        for( i = top; i < bottom; i++ )
+        {
+            larger->tasks[ i & ( larger->size - 1 ) ] = array->tasks[ i & ( array->size - 1 ) ];
+        }
+
+        larger->retired = array;
+
+        Atomic_memoryBarrier();
+        AtomicPointer_set( &self->array, larger );
+
+        array = larger;
+    }
+
+    array->tasks[ bottom & ( array->size - 1 ) ] = task;
+
+    /* the task must be visible before the thieves can see the new bottom */
+    Atomic_memoryBarrier();
+    Atomic_set( &self->bottom, bottom + 1 );
 }
 
 
-static void WorkQueueTaskPool_refreshTasks( WorkQueueTaskPool *self )
+/* owner only */
+static WorkQueueTask *WorkQueueDeque_take( WorkQueueDeque *self )
 {
-    WorkQueueTask *task;
+    WorkQueueDequeArray *array;
+    WorkQueueTask       *task = NULL;
+    long                bottom;
+    long                top;
 
-    ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
-    ANY_LOG( 10, "Refresh task begin %lx", ANY_LOG_INFO, Threads_id() );
+    bottom = self->bottom - 1;
+    array  = self->array;
 
-    MTLIST_FOREACH_BEGIN ( self->nonTerminatedTasks, MTLIST_ITERATE_FOR_READ )
-                {
-                    task = (WorkQueueTask *)MTLIST_FOREACH_ELEMENTPTR;
-                    if( task->terminated )
-                    {
-                        MTQueue_push( self->tempQueue, task, WORKQUEUE_MTQUEUE_CLASS );
-                    }
-                }
-    MTLIST_FOREACH_END;
+    /* reserve the bottom task before looking at what the thieves did */
+    Atomic_set( &self->bottom, bottom );
+    top = Atomic_get( &self->top );
 
-    task = MTQueue_pop( self->tempQueue, NULL );
-    while( task != NULL )
+    if( top <= bottom )
     {
-        MTList_remove( self->nonTerminatedTasks, WorkQueueTaskPool_taskCompare, task );
-        MTQueue_push( self->tasks, task, WORKQUEUE_MTQUEUE_CLASS );
-        ANY_LOG( 10, "Clearing task %p", ANY_LOG_INFO, (void *)task );
-        WorkQueueTask_clear( task );
-        task = MTQueue_pop( self->tempQueue, NULL );
+        task = array->tasks[ bottom & ( array->size - 1 ) ];
+
+        if( top == bottom )
+        {
+            /* last one, a thief may be taking it too */
+            if( !Atomic_testAndSetBool( &self->top, top, top + 1 ) )
+            {
+                task = NULL;
+            }
+
+            Atomic_set( &self->bottom, bottom + 1 );
+        }
+    }
+    else
+    {
+        Atomic_set( &self->bottom, bottom + 1 );
     }
-    ANY_LOG( 10, "Refresh task end %lx", ANY_LOG_INFO, Threads_id() );
+
+    return task;
 }
 
 
-static void WorkQueueTaskPool_disposeTask( WorkQueueTaskPool *self, WorkQueueTask *task )
+/* any thread, returns NULL when empty or when losing a race with another thread */
+static WorkQueueTask *WorkQueueDeque_steal( WorkQueueDeque *self )
 {
-    ANY_REQUIRE( self );
-    ANY_REQUIRE( self->valid == WORKQUEUETASKPOOL_VALID );
+    WorkQueueDequeArray *array;
+    WorkQueueTask       *task;
+    long                bottom;
+    long                top;
 
-    ANY_LOG( 10, "Disposing task %p", ANY_LOG_INFO, (void *)task );
-    Atomic_dec( &self->taskBalance );
-    if( task->terminated )
+    top    = Atomic_get( &self->top );
+    bottom = Atomic_get( &self->bottom );
+
+    if( top >= bottom )
     {
-        MTQueue_push( self->tasks, task, WORKQUEUE_MTQUEUE_CLASS );
-        WorkQueueTask_clear( task );
+        return NULL;
     }
-    else
+
+    array = (WorkQueueDequeArray *)AtomicPointer_get( &self->array );
+    task  = array->tasks[ top & ( array->size - 1 ) ];
+
+    if( !Atomic_testAndSetBool( &self->top, top, top + 1 ) )
     {
-        MTList_add( self->nonTerminatedTasks, task );
+        return NULL;
     }
+
+    return task;
+}
+
+
+static bool WorkQueueDeque_isEmpty( WorkQueueDeque *self )
+{
+    return Atomic_get( &self->top ) >= Atomic_get( &self->bottom );
 }
 
 
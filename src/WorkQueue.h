@@ -40,12 +40,76 @@ typedef enum WorkQueueTaskStatus
     WORKQUEUE_TASK_FAILURE
 } WorkQueueTaskStatus;
 
+/*
+ * SHARED: all the workers pop from a single queue, workers are added on
+ * demand up to maxWorkers.
+ *
+ * WORKSTEALING: each worker has its own deque, tasks enqueued by a task
+ * go to the deque of the worker running it and idle workers steal from
+ * the others. The pool has a fixed size of maxWorkers (minWorkers if
+ * maxWorkers is 0).
+ */
+typedef enum WorkQueueScheduler
+{
+    WORKQUEUE_SCHEDULER_SHARED,
+    WORKQUEUE_SCHEDULER_WORKSTEALING
+} WorkQueueScheduler;
+
+/*
+ * CPU: each worker is pinned to one of the CPUs available to the process,
+ * in turn.
+ *
+ * NUMANODE: each worker is pinned to the CPUs of a NUMA node, the nodes
+ * taken in turn. In work stealing mode a worker steals from the workers of
+ * its own node first.
+ */
+typedef enum WorkQueuePinning
+{
+    WORKQUEUE_PINNING_NONE,
+    WORKQUEUE_PINNING_CPU,
+    WORKQUEUE_PINNING_NUMANODE
+} WorkQueuePinning;
+
+/*
+ * the workers start the waiting tasks of the highest priority first, in
+ * FIFO order within a priority. A priority passed over a few times in a
+ * row gets the next worker, so the lower ones are delayed but not starved.
+ */
+typedef enum WorkQueuePriority
+{
+    WORKQUEUE_PRIORITY_REALTIME,
+    WORKQUEUE_PRIORITY_HIGH,
+    WORKQUEUE_PRIORITY_NORMAL,
+    WORKQUEUE_PRIORITY_LOW,
+    WORKQUEUE_PRIORITY_BACKGROUND
+} WorkQueuePriority;
+
+#define WORKQUEUE_NUM_PRIORITIES  ( 5 )
+
+/*
+ * queue depth and waiting times (in nanoseconds, from the enqueue to the
+ * start) of the tasks of one priority. Normal priority tasks enqueued by
+ * a task of a work stealing WorkQueue stay with its worker and are not
+ * counted.
+ */
+typedef struct WorkQueueStats
+{
+    unsigned long      queued;
+    unsigned long      maxQueued;
+    unsigned long long enqueued;
+    unsigned long long started;
+    unsigned long long totalWaitTime;
+    unsigned long long maxWaitTime;
+} WorkQueueStats;
+
 typedef struct WorkQueueTask WorkQueueTask;
 
 typedef WorkQueueTaskStatus ( *WorkQueueTaskFn )( void *instance, void *userdata );
 
 typedef void                ( *WorkQueueTaskCallback )( WorkQueueTaskStatus status, WorkQueueTask *task );
 
+typedef void                ( *WorkQueueRangeFn )( long begin, long end, void *context );
+
 typedef struct WorkQueue       WorkQueue;
 typedef struct WorkQueueWorker WorkQueueWorker;
 
@@ -53,19 +117,57 @@ WorkQueue *WorkQueue_new();
 
 bool WorkQueue_init( WorkQueue *self, unsigned int minWorkers, unsigned int maxWorkers );
 
+bool WorkQueue_initScheduler( WorkQueue *self, unsigned int minWorkers, unsigned int maxWorkers,
+                              WorkQueueScheduler scheduler );
+
+/*
+ * the workers are pinned as requested and, if name is not NULL, named
+ * "name/N" for top and perf. The kernel keeps THREADS_NAME_MAXLEN - 1
+ * characters of it, a short name keeps the worker number visible.
+ */
+bool WorkQueue_initPinned( WorkQueue *self, unsigned int minWorkers, unsigned int maxWorkers,
+                           WorkQueueScheduler scheduler, WorkQueuePinning pinning,
+                           const char *name );
+
 void WorkQueue_clear( WorkQueue *self );
 
 void WorkQueue_delete( WorkQueue *self );
 
+/*
+ * tasks come from a pool owned by the queue. A task can be disposed before
+ * it is done, it goes back to the pool once terminated.
+ */
 WorkQueueTask *WorkQueue_getTask( WorkQueue *self );
 
 void WorkQueue_disposeTask( WorkQueue *self, WorkQueueTask *task );
 
 void WorkQueue_enqueue( WorkQueue *self, WorkQueueTask *task );
 
+void WorkQueue_enqueueMany( WorkQueue *self, WorkQueueTask **tasks, unsigned int numTasks );
+
+/*
+ * calls fn() on [begin, end) split in chunks of grain elements (chosen
+ * from the number of workers if grain <= 0), and returns when all of them
+ * are done. The caller processes chunks too.
+ */
+void WorkQueue_parallelFor( WorkQueue *self, long begin, long end, long grain,
+                            WorkQueueRangeFn fn, void *context );
+
+void WorkQueue_getStats( WorkQueue *self, WorkQueuePriority priority, WorkQueueStats *stats );
+
 bool WorkQueueTask_init( WorkQueueTask *self, WorkQueueTaskFn taskFn, void *instance,
                          void *userData, WorkQueueTaskCallback callback );
 
+/*
+ * once enqueued, self is started only after predecessor is done, without
+ * blocking any worker: the last predecessor to finish enqueues it. To be
+ * called before enqueuing self, a predecessor already done is ignored.
+ * Returns false if out of memory.
+ */
+bool WorkQueueTask_addDependency( WorkQueueTask *self, WorkQueueTask *predecessor );
+
+/* WORKQUEUE_PRIORITY_NORMAL by default, to be set before enqueuing */
+void WorkQueueTask_setPriority( WorkQueueTask *self, WorkQueuePriority priority );
 
 void WorkQueueTask_wait( WorkQueueTask *self );
 
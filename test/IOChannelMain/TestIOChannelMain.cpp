@@ -33,7 +33,11 @@
 
 #if !defined(__windows__)
 
+#include <errno.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
 
 #endif
 
@@ -119,6 +123,21 @@ void *BerkeleyData_serverThread( void *arg );
 
 void *BerkeleyData_clientThread( void *arg );
 
+// For the shared memory ring buffer test
+void *ringBuffer_writerThread( void *arg );
+
+// For the BerkeleySocketServer event loop test
+struct EventLoopStats {
+    BerkeleySocketServer *server;
+    WorkQueue *workQueue;
+    AnyAtomic connected;
+    AnyAtomic closed;
+};
+
+void *eventLoop_serverThread( void *arg );
+
+static bool eventLoop_eventCallBack( BerkeleySocket *client, BerkeleySocketServerEvent event, void *data );
+
 bool BerkeleyData_readString( BerkeleySocket *newBerkeleySocket );
 
 bool BerkeleyData_readInteger( BerkeleySocket *newBerkeleySocket );
@@ -180,6 +199,7 @@ void Test_IOChannel_ClientServer_01( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, routine1_clientThread, NULL );
 
@@ -242,6 +262,7 @@ void Test_IOChannel_ClientServer_02( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, routine2_clientThread, NULL );
 
@@ -303,6 +324,7 @@ void Test_IOChannel_ClientServer_03( CuTest *tc )
     Threads_start( threadServer, routine3_serverThread, &mutexAndCond );
 
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, routine3_clientThread, NULL );
 
@@ -364,6 +386,7 @@ void Test_IOChannel_ClientServer_04( CuTest *tc )
     Threads_start( threadServer, routine4_serverThread, &mutexAndCond );
 
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, routine4_clientThread, NULL );
 
@@ -431,6 +454,7 @@ void Test_IOChannel_MultiClientServer( CuTest *tc )
     Threads_start( threadServer, multiClient_serverThread, &mutexAndCond );
 
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient1, multiClient_clientThread_1, NULL );
     Threads_start( threadClient2, multiClient_clientThread_2, NULL );
@@ -504,6 +528,7 @@ void Test_TCP_ClientServer( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, tcp_client, NULL );
 
@@ -571,6 +596,7 @@ void Test_UDP_ClientServer( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, udp_client, NULL );
 
@@ -637,6 +663,7 @@ void Test_UDP_Broadcast( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, udp_broadcast_client, NULL );
 
@@ -703,6 +730,7 @@ void Test_TCP_Block( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, blockNetworkTest_TCP_clientThread, NULL );
 
@@ -837,6 +865,7 @@ void Test_Berkeley_Data( CuTest *tc )
 
     // Wait for server thread to start
     Cond_wait( serverStartedCond, 0 );
+    Mutex_unlock( mutex );
 
     Threads_start( threadClient, BerkeleyData_clientThread, NULL );
 
@@ -955,6 +984,1525 @@ void Test_IOChannel_printf( CuTest *tc )
 }
 
 
+/*---------------------------------------------------------------------------*/
+/* IOChannel read buffering test                                             */
+/*---------------------------------------------------------------------------*/
+void Test_IOChannel_readBuffering( CuTest *tc )
+{
+    IOChannel *channel   = (IOChannel *)NULL;
+    char      line[BUFLEN];
+    char      block[BUFLEN];
+    int       value      = 0;
+    long      nBytes     = 0;
+    long      i          = 0;
+
+    channel = IOChannel_new();
+    CuAssertPtrNotNull( tc, channel );
+    CuAssertTrue( tc, IOChannel_init( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testReadBuffering~",
+                                      IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U ) );
+
+    for( i = 0; i < 100; i++ )
+    {
+        IOChannel_printf( channel, "line %ld\n", &i );
+    }
+
+    IOChannel_close( channel );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testReadBuffering~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+
+    /* a tiny buffer forces many refills */
+    IOChannel_setReadBuffer( channel, NULL, 16 );
+    CuAssertTrue( tc, IOChannel_setUseReadBuffering( channel, true ) );
+    CuAssertTrue( tc, IOChannel_usesReadBuffering( channel ) );
+
+    CuAssertIntEquals( tc, 6, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertStrEquals( tc, "line 0", line );
+    CuAssertTrue( tc, IOChannel_getReadBufferedBytes( channel ) > 0 );
+
+    CuAssertIntEquals( tc, 'l', IOChannel_getc( channel ) );
+    CuAssertIntEquals( tc, 1, IOChannel_unget( channel, (void *)"l", 1 ) );
+    CuAssertIntEquals( tc, 1, IOChannel_scanf( channel, &nBytes, "line %d", &value ) );
+    CuAssertIntEquals( tc, 1, value );
+
+    /* seeking moves read-ahead data back into the stream */
+    CuAssertIntEquals( tc, 0, IOChannel_seek( channel, 0, IOCHANNELWHENCE_SET ) );
+    CuAssertIntEquals( tc, 6, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertStrEquals( tc, "line 0", line );
+
+    CuAssertIntEquals( tc, 9, IOChannel_seek( channel, 2, IOCHANNELWHENCE_CUR ) );
+    CuAssertIntEquals( tc, 4, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertStrEquals( tc, "ne 1", line );
+
+    /* requests larger than the buffer bypass it */
+    CuAssertIntEquals( tc, 32, IOChannel_readBlock( channel, block, 32 ) );
+    CuAssertTrue( tc, Any_strncmp( block, "line 2\nline 3\n", 14 ) == 0 );
+
+    while( IOChannel_eof( channel ) == false )
+    {
+        CuAssertTrue( tc, IOChannel_gets( channel, line, BUFLEN ) >= 0 );
+    }
+
+    CuAssertTrue( tc, !IOChannel_isErrorOccurred( channel ) );
+    CuAssertIntEquals( tc, 0, IOChannel_getReadBufferedBytes( channel ) );
+
+    IOChannel_close( channel );
+
+    /* a write drops the read-ahead data but keeps the ungetted bytes */
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testReadBuffering~",
+                                      IOCHANNEL_MODE_RW, IOCHANNEL_PERMISSIONS_ALL ) );
+
+    IOChannel_setReadBuffer( channel, NULL, 16 );
+    CuAssertTrue( tc, IOChannel_setUseReadBuffering( channel, true ) );
+
+    CuAssertIntEquals( tc, 6, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertIntEquals( tc, 1, IOChannel_unget( channel, (void *)"x", 1 ) );
+    CuAssertIntEquals( tc, 1, IOChannel_write( channel, (void *)"L", 1 ) );
+    CuAssertIntEquals( tc, 'x', IOChannel_getc( channel ) );
+    CuAssertIntEquals( tc, 5, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertStrEquals( tc, "ine 1", line );
+
+    CuAssertIntEquals( tc, 0, IOChannel_seek( channel, 0, IOCHANNELWHENCE_SET ) );
+    CuAssertIntEquals( tc, 6, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertIntEquals( tc, 6, IOChannel_gets( channel, line, BUFLEN ) );
+    CuAssertStrEquals( tc, "Line 1", line );
+
+    IOChannel_close( channel );
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+}
+
+
+void Test_IOChannel_writevReadv( CuTest *tc )
+{
+    IOChannel      *channel        = (IOChannel *)NULL;
+    char           header[]        = "HEAD";
+    char           payload[BUFLEN];
+    char           memory[BUFLEN];
+    char           inHeader[4];
+    char           inPayload[BUFLEN];
+    IOChannelIOVec vector[3];
+    long           i               = 0;
+
+    for( i = 0; i < BUFLEN; i++ )
+    {
+        payload[ i ] = (char)( 'a' + i % 26 );
+    }
+
+    vector[ 0 ].buffer = header;
+    vector[ 0 ].size   = 4;
+    vector[ 1 ].buffer = NULL;
+    vector[ 1 ].size   = 0;
+    vector[ 2 ].buffer = payload;
+    vector[ 2 ].size   = BUFLEN;
+
+    channel = IOChannel_new();
+    CuAssertPtrNotNull( tc, channel );
+    CuAssertTrue( tc, IOChannel_init( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testWritev~",
+                                      IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U ) );
+
+    /* unbuffered, and then together with pending write buffer data */
+    CuAssertIntEquals( tc, 4 + BUFLEN, IOChannel_writev( channel, vector, 3 ) );
+
+    IOChannel_setWriteBuffer( channel, NULL, 64 );
+    CuAssertTrue( tc, IOChannel_setUseWriteBuffering( channel, true, false ) );
+    CuAssertIntEquals( tc, 3, IOChannel_write( channel, "XYZ", 3 ) );
+    CuAssertIntEquals( tc, 4 + BUFLEN, IOChannel_writev( channel, vector, 3 ) );
+    CuAssertIntEquals( tc, 0, IOChannel_getWriteBufferedBytes( channel ) );
+
+    /* small vectors just go into the write buffer */
+    CuAssertIntEquals( tc, 4, IOChannel_writev( channel, vector, 2 ) );
+    CuAssertIntEquals( tc, 4, IOChannel_getWriteBufferedBytes( channel ) );
+
+    CuAssertTrue( tc, !IOChannel_isErrorOccurred( channel ) );
+    IOChannel_close( channel );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testWritev~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+
+    vector[ 0 ].buffer = inHeader;
+    vector[ 2 ].buffer = inPayload;
+
+    CuAssertIntEquals( tc, 4 + BUFLEN, IOChannel_readv( channel, vector, 3 ) );
+    CuAssertTrue( tc, Any_strncmp( inHeader, "HEAD", 4 ) == 0 );
+    CuAssertTrue( tc, Any_memcmp( inPayload, payload, BUFLEN ) == 0 );
+
+    /* ungetted data is read first */
+    CuAssertIntEquals( tc, 3, IOChannel_read( channel, inHeader, 3 ) );
+    CuAssertIntEquals( tc, 1, IOChannel_unget( channel, (void *)"Z", 1 ) );
+    CuAssertIntEquals( tc, 4 + BUFLEN, IOChannel_readv( channel, vector, 3 ) );
+    CuAssertTrue( tc, Any_strncmp( inHeader, "ZHEA", 4 ) == 0 );
+    CuAssertTrue( tc, Any_strncmp( inPayload, "Dabc", 4 ) == 0 );
+
+    IOChannel_close( channel );
+
+    /* memory streams use the emulation */
+    CuAssertTrue( tc, IOChannel_open( channel, "Mem://", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, memory, (long)BUFLEN ) );
+
+    vector[ 0 ].buffer = header;
+    vector[ 2 ].buffer = payload;
+    vector[ 2 ].size   = 16;
+
+    CuAssertIntEquals( tc, 20, IOChannel_writev( channel, vector, 3 ) );
+    CuAssertTrue( tc, Any_strncmp( memory, "HEADabcdefghijklmnop", 20 ) == 0 );
+
+    IOChannel_close( channel );
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+}
+
+
+void Test_IOChannel_asyncIO( CuTest *tc )
+{
+    IOChannel *channel = (IOChannel *)NULL;
+    char      *block   = (char *)NULL;
+    char      *check   = (char *)NULL;
+    char      line[BUFLEN];
+    long      size     = 300 * 1024;
+    long      i        = 0;
+    bool      isAsync  = false;
+
+    block = (char *)ANY_BALLOC( size );
+    check = (char *)ANY_BALLOC( size );
+    CuAssertPtrNotNull( tc, block );
+    CuAssertPtrNotNull( tc, check );
+
+    for( i = 0; i < size; i++ )
+    {
+        block[ i ] = (char)( i % 251 );
+    }
+
+    channel = IOChannel_new();
+    CuAssertPtrNotNull( tc, channel );
+    CuAssertTrue( tc, IOChannel_init( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testAsyncIO~",
+                                      IOCHANNEL_MODE_RW | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U ) );
+
+    /* without io_uring the stream must keep working synchronously */
+    isAsync = IOChannel_setProperty( channel, "AsyncIO", (void *)true );
+    ANY_LOG( 5, "Asynchronous I/O is %s", ANY_LOG_INFO, isAsync ? "enabled" : "not available" );
+
+    for( i = 0; i < 100; i++ )
+    {
+        IOChannel_printf( channel, "line %ld\n", &i );
+    }
+
+    CuAssertIntEquals( tc, size, IOChannel_write( channel, block, size ) );
+    CuAssertTrue( tc, IOChannel_flush( channel ) != -1 );
+    CuAssertTrue( tc, !IOChannel_isErrorOccurred( channel ) );
+
+    /* read back through the same channel */
+    CuAssertIntEquals( tc, 0, IOChannel_seek( channel, 0, IOCHANNELWHENCE_SET ) );
+
+    for( i = 0; i < 100; i++ )
+    {
+        Any_snprintf( check, BUFLEN, "line %ld", i );
+        CuAssertTrue( tc, IOChannel_gets( channel, line, BUFLEN ) > 0 );
+        CuAssertStrEquals( tc, check, line );
+    }
+
+    CuAssertIntEquals( tc, size, IOChannel_readBlock( channel, check, size ) );
+    CuAssertTrue( tc, Any_memcmp( block, check, size ) == 0 );
+
+    CuAssertIntEquals( tc, 0, IOChannel_read( channel, line, 1 ) );
+    CuAssertTrue( tc, IOChannel_eof( channel ) );
+
+    /* append at the end, then overwrite the first line */
+    CuAssertIntEquals( tc, 4, IOChannel_write( channel, "tail", 4 ) );
+    CuAssertIntEquals( tc, 0, IOChannel_seek( channel, 0, IOCHANNELWHENCE_SET ) );
+    CuAssertIntEquals( tc, 4, IOChannel_write( channel, "LINE", 4 ) );
+
+    CuAssertTrue( tc, IOChannel_close( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testAsyncIO~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+
+    CuAssertTrue( tc, IOChannel_gets( channel, line, BUFLEN ) > 0 );
+    CuAssertStrEquals( tc, "LINE 0", line );
+
+    CuAssertTrue( tc, IOChannel_seek( channel, -4, IOCHANNELWHENCE_END ) != -1 );
+    CuAssertIntEquals( tc, 4, IOChannel_read( channel, line, 4 ) );
+    CuAssertTrue( tc, Any_strncmp( line, "tail", 4 ) == 0 );
+
+    IOChannel_close( channel );
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+
+    ANY_FREE( check );
+    ANY_FREE( block );
+}
+
+
+void Test_IOChannel_growableMemMapFd( CuTest *tc )
+{
+    IOChannel   *channel = (IOChannel *)NULL;
+    char        *block   = (char *)NULL;
+    char        *mapped  = (char *)NULL;
+    struct stat fileInfo;
+    long        size     = 3 * 1024 * 1024 + 17;
+    long        i        = 0;
+    int         fd       = -1;
+
+    block = (char *)ANY_BALLOC( size );
+    CuAssertPtrNotNull( tc, block );
+
+    for( i = 0; i < size; i++ )
+    {
+        block[ i ] = (char)( i % 251 );
+    }
+
+    fd = open( "testGrowable~", O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
+    CuAssertTrue( tc, fd != -1 );
+
+    channel = IOChannel_new();
+    CuAssertPtrNotNull( tc, channel );
+    CuAssertTrue( tc, IOChannel_init( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "MemMapFd://",
+                                      IOCHANNEL_MODE_RW | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_ALL, fd, (long)4096 ) );
+
+    /* without the property writes would stop at the 4 KiB mapped at opening */
+    CuAssertTrue( tc, IOChannel_setProperty( channel, "Growable", (void *)true ) );
+
+    CuAssertIntEquals( tc, 10, IOChannel_write( channel, "0123456789", 10 ) );
+
+    for( i = 0; i < size; i += 65536 )
+    {
+        long chunk = ( size - i ) < 65536 ? ( size - i ) : 65536;
+
+        CuAssertIntEquals( tc, chunk, IOChannel_write( channel, block + i, chunk ) );
+    }
+
+    CuAssertTrue( tc, !IOChannel_isErrorOccurred( channel ) );
+
+    /* the mapping may have moved while growing */
+    mapped = (char *)IOChannel_getProperty( channel, "MemPointer" );
+    CuAssertPtrNotNull( tc, mapped );
+    CuAssertTrue( tc, Any_memcmp( mapped, "0123456789", 10 ) == 0 );
+    CuAssertTrue( tc, Any_memcmp( mapped + 10, block, size ) == 0 );
+
+    /* overwrite the head, closing must keep everything written */
+    CuAssertIntEquals( tc, 0, IOChannel_seek( channel, 0, IOCHANNELWHENCE_SET ) );
+    CuAssertIntEquals( tc, 4, IOChannel_write( channel, "HEAD", 4 ) );
+
+    CuAssertTrue( tc, IOChannel_close( channel ) );
+
+    CuAssertIntEquals( tc, 0, fstat( fd, &fileInfo ) );
+    CuAssertIntEquals( tc, size + 10, (long)fileInfo.st_size );
+
+    CuAssertIntEquals( tc, 0, (long)lseek( fd, 0, SEEK_SET ) );
+    CuAssertIntEquals( tc, 10, (long)read( fd, block, 10 ) );
+    CuAssertTrue( tc, Any_strncmp( block, "HEAD456789", 10 ) == 0 );
+
+    close( fd );
+
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+
+    ANY_FREE( block );
+}
+
+
+#define RINGBUFFER_SHMNAME    "/TestIOChannelRingBuffer"
+#define RINGBUFFER_SHMSIZE    ( 4096 )
+#define RINGBUFFER_MESSAGES   ( 1000 )
+#define RINGBUFFER_BIGSIZE    ( 10000 )
+
+
+void Test_IOChannel_shmRingBuffer( CuTest *tc )
+{
+    IOChannel *channel = (IOChannel *)NULL;
+    Threads   *writer  = (Threads *)NULL;
+    char      buffer[256];
+    char      *big     = (char *)NULL;
+    long      nBytes   = 0;
+    long      total    = 0;
+    long      i        = 0;
+    long      j        = 0;
+
+    errorOccured = false;
+
+    big = (char *)ANY_BALLOC( RINGBUFFER_BIGSIZE );
+    CuAssertPtrNotNull( tc, big );
+
+    channel = IOChannel_new();
+    CuAssertPtrNotNull( tc, channel );
+    CuAssertTrue( tc, IOChannel_init( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "Shm://" RINGBUFFER_SHMNAME,
+                                      IOCHANNEL_MODE_RW | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U,
+                                      (long)RINGBUFFER_SHMSIZE ) );
+
+    CuAssertTrue( tc, IOChannel_setProperty( channel, "RingBuffer", (void *)true ) );
+
+    writer = Threads_new();
+    CuAssertPtrNotNull( tc, writer );
+    Threads_init( writer, true );
+    Threads_start( writer, ringBuffer_writerThread, NULL );
+
+    /* every read returns exactly one of the messages */
+    for( i = 0; i < RINGBUFFER_MESSAGES; i++ )
+    {
+        nBytes = IOChannel_read( channel, buffer, sizeof( buffer ) );
+        CuAssertIntEquals( tc, 1 + i % 200, nBytes );
+
+        for( j = 0; j < nBytes; j++ )
+        {
+            CuAssertIntEquals( tc, (char)( i + j ), buffer[ j ] );
+        }
+    }
+
+    /* a message bigger than the ring arrives in pieces */
+    while( total < RINGBUFFER_BIGSIZE )
+    {
+        nBytes = IOChannel_read( channel, big + total, RINGBUFFER_BIGSIZE - total );
+        CuAssertTrue( tc, nBytes > 0 );
+        total += nBytes;
+    }
+
+    for( j = 0; j < RINGBUFFER_BIGSIZE; j++ )
+    {
+        CuAssertIntEquals( tc, (char)( j % 251 ), big[ j ] );
+    }
+
+    /* the writer closed its side */
+    CuAssertIntEquals( tc, 0, IOChannel_read( channel, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, IOChannel_eof( channel ) );
+
+    Threads_join( writer, NULL );
+    Threads_clear( writer );
+    Threads_delete( writer );
+
+    IOChannel_close( channel );
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+
+    shm_unlink( RINGBUFFER_SHMNAME );
+    ANY_FREE( big );
+
+    CuAssertTrue( tc, !errorOccured );
+}
+
+
+void *ringBuffer_writerThread( void *arg )
+{
+    IOChannel *channel = (IOChannel *)NULL;
+    char      buffer[256];
+    char      *big     = (char *)NULL;
+    long      i        = 0;
+    long      j        = 0;
+
+    big = (char *)ANY_BALLOC( RINGBUFFER_BIGSIZE );
+    ANY_REQUIRE( big );
+
+    for( j = 0; j < RINGBUFFER_BIGSIZE; j++ )
+    {
+        big[ j ] = (char)( j % 251 );
+    }
+
+    channel = IOChannel_new();
+    ANY_REQUIRE( channel );
+    IOChannel_init( channel );
+
+    /* the ring already exists, do not truncate it */
+    if( !IOChannel_open( channel, "Shm://" RINGBUFFER_SHMNAME, IOCHANNEL_MODE_RW,
+                         IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U,
+                         (long)RINGBUFFER_SHMSIZE ) ||
+        !IOChannel_setProperty( channel, "RingBuffer", (void *)true ))
+    {
+        ANY_LOG( 0, "Unable to open the ring buffer", ANY_LOG_ERROR );
+        errorOccured = true;
+        goto outLabel;
+    }
+
+    for( i = 0; i < RINGBUFFER_MESSAGES; i++ )
+    {
+        for( j = 0; j < 1 + i % 200; j++ )
+        {
+            buffer[ j ] = (char)( i + j );
+        }
+
+        if( IOChannel_write( channel, buffer, 1 + i % 200 ) != 1 + i % 200 )
+        {
+            errorOccured = true;
+        }
+    }
+
+    if( IOChannel_write( channel, big, RINGBUFFER_BIGSIZE ) != RINGBUFFER_BIGSIZE )
+    {
+        errorOccured = true;
+    }
+
+    IOChannel_close( channel );
+
+    outLabel:
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+
+    ANY_FREE( big );
+
+    return NULL;
+}
+
+
+#define BROADCAST_SHMNAME     "/TestIOChannelBroadcast"
+#define BROADCAST_SHMSIZE     ( 64 * 1024 )
+#define BROADCAST_READERS     ( 3 )
+
+
+void Test_IOChannel_shmBroadcast( CuTest *tc )
+{
+    IOChannel *writer = (IOChannel *)NULL;
+    IOChannel *readers[BROADCAST_READERS];
+    char      message[2000];
+    char      buffer[2000];
+    long      *lost   = (long *)NULL;
+    long      nBytes  = 0;
+    long      total   = 0;
+    long      i       = 0;
+    long      j       = 0;
+
+    writer = IOChannel_new();
+    CuAssertPtrNotNull( tc, writer );
+    CuAssertTrue( tc, IOChannel_init( writer ) );
+
+    CuAssertTrue( tc, IOChannel_open( writer, "Shm://" BROADCAST_SHMNAME,
+                                      IOCHANNEL_MODE_RW | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U,
+                                      (long)BROADCAST_SHMSIZE ) );
+
+    CuAssertTrue( tc, IOChannel_setProperty( writer, "Broadcast", (void *)true ) );
+
+    /* the readers do not need write access */
+    for( i = 0; i < BROADCAST_READERS; i++ )
+    {
+        readers[ i ] = IOChannel_new();
+        CuAssertPtrNotNull( tc, readers[ i ] );
+        CuAssertTrue( tc, IOChannel_init( readers[ i ] ) );
+
+        CuAssertTrue( tc, IOChannel_open( readers[ i ], "Shm://" BROADCAST_SHMNAME,
+                                          IOCHANNEL_MODE_R_ONLY,
+                                          IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U,
+                                          (long)BROADCAST_SHMSIZE ) );
+
+        CuAssertTrue( tc, IOChannel_setProperty( readers[ i ], "Broadcast", (void *)true ) );
+    }
+
+    /* written once, read by everybody */
+    for( i = 0; i < 10; i++ )
+    {
+        Any_snprintf( message, sizeof( message ), "message %ld", i );
+        CuAssertIntEquals( tc, (long)Any_strlen( message ),
+                           IOChannel_write( writer, message, Any_strlen( message ) ));
+    }
+
+    for( j = 0; j < (long)sizeof( message ); j++ )
+    {
+        message[ j ] = (char)( j % 251 );
+    }
+
+    /* bigger than a slot */
+    CuAssertIntEquals( tc, sizeof( message ), IOChannel_write( writer, message, sizeof( message ) ) );
+
+    for( j = 0; j < BROADCAST_READERS; j++ )
+    {
+        for( i = 0; i < 10; i++ )
+        {
+            Any_snprintf( message, sizeof( message ), "message %ld", i );
+
+            nBytes = IOChannel_read( readers[ j ], buffer, sizeof( buffer ) );
+            CuAssertIntEquals( tc, (long)Any_strlen( message ), nBytes );
+            CuAssertTrue( tc, Any_strncmp( message, buffer, nBytes ) == 0 );
+        }
+
+        for( total = 0; total < (long)sizeof( buffer ); total += nBytes )
+        {
+            nBytes = IOChannel_read( readers[ j ], buffer + total, sizeof( buffer ) - total );
+            CuAssertTrue( tc, nBytes > 0 );
+        }
+
+        for( i = 0; i < (long)sizeof( buffer ); i++ )
+        {
+            CuAssertIntEquals( tc, (char)( i % 251 ), buffer[ i ] );
+        }
+    }
+
+    /* the writer never waits: a slow reader detects the overrun and resumes */
+    for( i = 0; i < 100; i++ )
+    {
+        CuAssertIntEquals( tc, sizeof( long ), IOChannel_write( writer, &i, sizeof( long ) ) );
+    }
+
+    CuAssertIntEquals( tc, -1, IOChannel_read( readers[ 0 ], buffer, sizeof( buffer ) ) );
+    CuAssertIntEquals( tc, IOCHANNELERROR_EOVERFLOW, IOChannel_getErrorNumber( readers[ 0 ] ) );
+    IOChannel_cleanError( readers[ 0 ] );
+
+    lost = (long *)IOChannel_getProperty( readers[ 0 ], "BroadcastLost" );
+    CuAssertPtrNotNull( tc, lost );
+    CuAssertTrue( tc, *lost > 0 );
+
+    for( i = *lost; i < 100; i++ )
+    {
+        CuAssertIntEquals( tc, sizeof( long ), IOChannel_read( readers[ 0 ], buffer, sizeof( buffer ) ) );
+        CuAssertIntEquals( tc, i, *(long *)buffer );
+    }
+
+    /* two slots per message: the overrun leaves the reader on the tail of one, which it skips */
+    for( i = 0; i < 50; i++ )
+    {
+        Any_memset( message, (int)i, sizeof( message ) / 2 );
+        CuAssertIntEquals( tc, sizeof( message ) / 2, IOChannel_write( writer, message, sizeof( message ) / 2 ) );
+    }
+
+    total = *lost;
+    CuAssertIntEquals( tc, -1, IOChannel_read( readers[ 0 ], buffer, sizeof( buffer ) ) );
+    CuAssertIntEquals( tc, IOCHANNELERROR_EOVERFLOW, IOChannel_getErrorNumber( readers[ 0 ] ) );
+    IOChannel_cleanError( readers[ 0 ] );
+    CuAssertTrue( tc, *lost > total );
+
+    nBytes = IOChannel_read( readers[ 0 ], buffer, sizeof( buffer ) / 2 );
+    CuAssertTrue( tc, nBytes > 0 && nBytes < (long)sizeof( buffer ) / 2 );
+    i = buffer[ 0 ];
+
+    for( total = nBytes; total < (long)sizeof( buffer ) / 2; total += nBytes )
+    {
+        nBytes = IOChannel_read( readers[ 0 ], buffer + total, sizeof( buffer ) / 2 - total );
+        CuAssertTrue( tc, nBytes > 0 );
+    }
+
+    for( j = 0; j < (long)sizeof( buffer ) / 2; j++ )
+    {
+        CuAssertIntEquals( tc, (char)i, buffer[ j ] );
+    }
+
+    for( i++; i < 50; i++ )
+    {
+        for( total = 0; total < (long)sizeof( buffer ) / 2; total += nBytes )
+        {
+            nBytes = IOChannel_read( readers[ 0 ], buffer + total, sizeof( buffer ) / 2 - total );
+            CuAssertTrue( tc, nBytes > 0 );
+            CuAssertIntEquals( tc, (char)i, buffer[ total ] );
+        }
+    }
+
+    /* readers get EOF once the writer is gone */
+    IOChannel_close( writer );
+
+    CuAssertIntEquals( tc, 0, IOChannel_read( readers[ 0 ], buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, IOChannel_eof( readers[ 0 ] ) );
+
+    for( i = 0; i < BROADCAST_READERS; i++ )
+    {
+        IOChannel_close( readers[ i ] );
+        IOChannel_clear( readers[ i ] );
+        IOChannel_delete( readers[ i ] );
+    }
+
+    IOChannel_clear( writer );
+    IOChannel_delete( writer );
+
+    shm_unlink( BROADCAST_SHMNAME );
+}
+
+
+void Test_IOChannel_transfer( CuTest *tc )
+{
+    IOChannel *source  = (IOChannel *)NULL;
+    IOChannel *channel = (IOChannel *)NULL;
+    char      *block   = (char *)NULL;
+    char      *check   = (char *)NULL;
+    char      memory[BUFLEN];
+    long      size     = 1024 * 1024;
+    long      i        = 0;
+    int       fds[2]   = { -1, -1 };
+
+    block = (char *)ANY_BALLOC( size );
+    check = (char *)ANY_BALLOC( size );
+    CuAssertPtrNotNull( tc, block );
+    CuAssertPtrNotNull( tc, check );
+
+    for( i = 0; i < size; i++ )
+    {
+        block[ i ] = (char)( i % 251 );
+    }
+
+    source = IOChannel_new();
+    channel = IOChannel_new();
+    CuAssertPtrNotNull( tc, source );
+    CuAssertPtrNotNull( tc, channel );
+    CuAssertTrue( tc, IOChannel_init( source ) );
+    CuAssertTrue( tc, IOChannel_init( channel ) );
+
+    CuAssertTrue( tc, IOChannel_open( source, "File://testTransferSource~",
+                                      IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U ) );
+    CuAssertIntEquals( tc, size, IOChannel_writeBlock( source, block, size ) );
+    IOChannel_close( source );
+
+    /* file to file, with read-ahead and write buffered data pending */
+    CuAssertTrue( tc, IOChannel_open( source, "File://testTransferSource~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+    CuAssertTrue( tc, IOChannel_setUseReadBuffering( source, true ) );
+    CuAssertIntEquals( tc, 10, IOChannel_read( source, memory, 10 ) );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testTransferTarget~",
+                                      IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U ) );
+    CuAssertTrue( tc, IOChannel_setUseWriteBuffering( channel, true, false ) );
+    CuAssertIntEquals( tc, 10, IOChannel_write( channel, memory, 10 ) );
+
+    /* asking for more than available stops at EOF */
+    CuAssertIntEquals( tc, size - 10, (long)IOChannel_transfer( channel, source, 2 * size ) );
+    CuAssertTrue( tc, IOChannel_eof( source ) );
+    CuAssertTrue( tc, !IOChannel_isErrorOccurred( channel ) );
+    CuAssertIntEquals( tc, size, (long)IOChannel_tell( channel ) );
+
+    IOChannel_close( channel );
+    IOChannel_close( source );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testTransferTarget~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+    CuAssertIntEquals( tc, size, IOChannel_readBlock( channel, check, size ) );
+    CuAssertTrue( tc, Any_memcmp( block, check, size ) == 0 );
+    IOChannel_close( channel );
+
+    /* file to socket */
+    CuAssertIntEquals( tc, 0, socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+
+    CuAssertTrue( tc, IOChannel_open( source, "File://testTransferSource~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+    CuAssertTrue( tc, IOChannel_open( channel, "Fd://", IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_NOTCLOSE,
+                                      IOCHANNEL_PERMISSIONS_ALL, fds[ 0 ] ) );
+
+    CuAssertIntEquals( tc, BUFLEN, (long)IOChannel_transfer( channel, source, BUFLEN ) );
+    CuAssertIntEquals( tc, BUFLEN, (long)recv( fds[ 1 ], memory, BUFLEN, MSG_WAITALL ) );
+    CuAssertTrue( tc, Any_memcmp( block, memory, BUFLEN ) == 0 );
+
+    IOChannel_close( channel );
+    IOChannel_close( source );
+
+    /* socket to file */
+    CuAssertIntEquals( tc, BUFLEN, (long)send( fds[ 1 ], block + 1, BUFLEN, 0 ) );
+
+    CuAssertTrue( tc, IOChannel_open( source, "Fd://", IOCHANNEL_MODE_R_ONLY | IOCHANNEL_MODE_NOTCLOSE,
+                                      IOCHANNEL_PERMISSIONS_ALL, fds[ 0 ] ) );
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testTransferTarget~",
+                                      IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_R_U | IOCHANNEL_PERMISSIONS_W_U ) );
+
+    CuAssertIntEquals( tc, BUFLEN, (long)IOChannel_transfer( channel, source, BUFLEN ) );
+
+    IOChannel_close( channel );
+    IOChannel_close( source );
+
+    CuAssertTrue( tc, IOChannel_open( channel, "File://testTransferTarget~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+    CuAssertIntEquals( tc, BUFLEN, IOChannel_readBlock( channel, check, BUFLEN ) );
+    CuAssertTrue( tc, Any_memcmp( block + 1, check, BUFLEN ) == 0 );
+    IOChannel_close( channel );
+
+    close( fds[ 0 ] );
+    close( fds[ 1 ] );
+
+    /* memory streams use the buffered loop */
+    CuAssertTrue( tc, IOChannel_open( source, "File://testTransferSource~",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+    CuAssertTrue( tc, IOChannel_open( channel, "Mem://", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, memory, (long)BUFLEN ) );
+
+    CuAssertIntEquals( tc, BUFLEN, (long)IOChannel_transfer( channel, source, BUFLEN ) );
+    CuAssertTrue( tc, Any_memcmp( block, memory, BUFLEN ) == 0 );
+
+    IOChannel_close( channel );
+    IOChannel_close( source );
+
+    IOChannel_clear( channel );
+    IOChannel_delete( channel );
+    IOChannel_clear( source );
+    IOChannel_delete( source );
+
+    ANY_FREE( check );
+    ANY_FREE( block );
+}
+
+
+#define EVENTLOOP_PORT     60003
+#define EVENTLOOP_CLIENTS  64
+
+void Test_BerkeleySocketServer_eventLoop( CuTest *tc )
+{
+    BerkeleySocketServer *server  = (BerkeleySocketServer *)NULL;
+    WorkQueue            *queue   = (WorkQueue *)NULL;
+    Threads              *thread  = (Threads *)NULL;
+    EventLoopStats       stats;
+    struct sockaddr_in   addr;
+    int                  fds[EVENTLOOP_CLIENTS];
+    int                  value    = 0;
+    int                  i        = 0;
+
+    errorOccured = false;
+
+    server = BerkeleySocketServer_new();
+    CuAssertPtrNotNull( tc, server );
+    CuAssertTrue( tc, BerkeleySocketServer_init( server, NULL ) );
+
+    BerkeleySocket_setReuseAddr( BerkeleySocketServer_getSocket( server ), true );
+    CuAssertPtrNotNull( tc, BerkeleySocketServer_connect( server, BERKELEYSOCKET_TCP, EVENTLOOP_PORT,
+                                                          EVENTLOOP_CLIENTS ) );
+
+    queue = WorkQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+    CuAssertTrue( tc, WorkQueue_init( queue, 2, 4 ) );
+
+    stats.server    = server;
+    stats.workQueue = queue;
+    stats.connected = 0;
+    stats.closed    = 0;
+
+    thread = Threads_new();
+    CuAssertPtrNotNull( tc, thread );
+    Threads_init( thread, true );
+    Threads_start( thread, eventLoop_serverThread, &stats );
+
+    Any_memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons( EVENTLOOP_PORT );
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    /* all the clients stay connected at the same time */
+    for( i = 0; i < EVENTLOOP_CLIENTS; i++ )
+    {
+        fds[ i ] = socket( AF_INET, SOCK_STREAM, 0 );
+        CuAssertTrue( tc, fds[ i ] != -1 );
+        CuAssertIntEquals( tc, 0, connect( fds[ i ], (struct sockaddr *)&addr, sizeof( addr ) ) );
+    }
+
+    for( i = 0; i < EVENTLOOP_CLIENTS; i++ )
+    {
+        value = i;
+        CuAssertIntEquals( tc, sizeof( value ), write( fds[ i ], &value, sizeof( value ) ) );
+    }
+
+    /* each client gets its own data echoed */
+    for( i = EVENTLOOP_CLIENTS - 1; i >= 0; i-- )
+    {
+        value = -1;
+        CuAssertIntEquals( tc, sizeof( value ), recv( fds[ i ], &value, sizeof( value ), MSG_WAITALL ) );
+        CuAssertIntEquals( tc, i, value );
+    }
+
+    CuAssertIntEquals( tc, EVENTLOOP_CLIENTS, Atomic_get( &stats.connected ) );
+
+    /* half of the clients leave, the others are closed by the loop on exit */
+    for( i = 0; i < EVENTLOOP_CLIENTS / 2; i++ )
+    {
+        close( fds[ i ] );
+    }
+
+    while( Atomic_get( &stats.closed ) < EVENTLOOP_CLIENTS / 2 )
+    {
+        Any_sleepMilliSeconds( 10 );
+    }
+
+    CuAssertTrue( tc, BerkeleySocketServer_stopEventLoop( server ) );
+
+    Threads_join( thread, NULL );
+    Threads_clear( thread );
+    Threads_delete( thread );
+
+    CuAssertIntEquals( tc, EVENTLOOP_CLIENTS, Atomic_get( &stats.closed ) );
+
+    for( i = EVENTLOOP_CLIENTS / 2; i < EVENTLOOP_CLIENTS; i++ )
+    {
+        CuAssertIntEquals( tc, 0, read( fds[ i ], &value, sizeof( value ) ) );
+        close( fds[ i ] );
+    }
+
+    WorkQueue_clear( queue );
+    WorkQueue_delete( queue );
+
+    BerkeleySocketServer_disconnect( server );
+    BerkeleySocketServer_clear( server );
+    BerkeleySocketServer_delete( server );
+
+    CuAssertTrue( tc, !errorOccured );
+}
+
+
+// For Test_BerkeleySocketServer_eventLoop
+void *eventLoop_serverThread( void *arg )
+{
+    EventLoopStats *stats = (EventLoopStats *)arg;
+
+    if( !BerkeleySocketServer_eventLoop( stats->server, eventLoop_eventCallBack, stats, NULL, NULL,
+                                         BERKELEYSOCKET_TIMEOUT_SECONDS( 1 ), stats->workQueue ) )
+    {
+        errorOccured = true;
+    }
+
+    return (void *)NULL;
+}
+
+
+// For Test_BerkeleySocketServer_eventLoop
+static bool eventLoop_eventCallBack( BerkeleySocket *client, BerkeleySocketServerEvent event, void *data )
+{
+    EventLoopStats *stats = (EventLoopStats *)data;
+    BaseUI8        buffer[64];
+    int            nBytes = 0;
+
+    switch( event )
+    {
+        case BERKELEYSOCKETSERVER_EVENT_CONNECT:
+            Atomic_inc( &stats->connected );
+            break;
+
+        case BERKELEYSOCKETSERVER_EVENT_READ:
+            /* edge-triggered, read until the socket is empty */
+            while( ( nBytes = BerkeleySocket_read( client, buffer, sizeof( buffer ) ) ) > 0 )
+            {
+                if( BerkeleySocket_write( client, buffer, nBytes ) != nBytes )
+                {
+                    errorOccured = true;
+                }
+            }
+
+            if( nBytes == 0 || errno != EAGAIN )
+            {
+                return false;
+            }
+            break;
+
+        case BERKELEYSOCKETSERVER_EVENT_CLOSE:
+            Atomic_inc( &stats->closed );
+            break;
+
+        default:
+            errorOccured = true;
+            break;
+    }
+
+    return true;
+}
+
+
+#define UDPBATCH_DATAGRAMS  100
+
+void Test_IOChannel_udpBatch( CuTest *tc )
+{
+    IOChannel *sender   = (IOChannel *)NULL;
+    IOChannel *receiver = (IOChannel *)NULL;
+    char      buffer[64];
+    int       batch     = 16;
+    long      i         = 0;
+    long      j         = 0;
+
+    sender = IOChannel_new();
+    receiver = IOChannel_new();
+    CuAssertPtrNotNull( tc, sender );
+    CuAssertPtrNotNull( tc, receiver );
+    IOChannel_init( sender );
+    IOChannel_init( receiver );
+
+    CuAssertTrue( tc, IOChannel_openFromString( receiver, "stream=Udp host=127.0.0.1 port=60005 srcport=60004 "
+                                                          "mode='IOCHANNEL_MODE_RW'" ) );
+    CuAssertTrue( tc, IOChannel_openFromString( sender, "stream=Udp host=127.0.0.1 port=60004 srcport=60005 "
+                                                        "mode='IOCHANNEL_MODE_RW' batch=8" ) );
+
+    /* the writes are queued and leave the sender eight datagrams at a time */
+    for( i = 0; i < UDPBATCH_DATAGRAMS; i++ )
+    {
+        for( j = 0; j < 1 + i % 50; j++ )
+        {
+            buffer[ j ] = (char)( i + j );
+        }
+
+        CuAssertIntEquals( tc, 1 + i % 50, IOChannel_write( sender, buffer, 1 + i % 50 ) );
+    }
+
+    CuAssertTrue( tc, IOChannel_flush( sender ) >= 0 );
+
+    /* the boundaries of the datagrams are kept on both sides of a batch */
+    CuAssertTrue( tc, IOChannel_setProperty( receiver, "Batch", &batch ) );
+
+    for( i = 0; i < UDPBATCH_DATAGRAMS; i++ )
+    {
+        CuAssertIntEquals( tc, 1 + i % 50, IOChannel_read( receiver, buffer, sizeof( buffer ) ) );
+
+        for( j = 0; j < 1 + i % 50; j++ )
+        {
+            CuAssertIntEquals( tc, (char)( i + j ), buffer[ j ] );
+        }
+    }
+
+    /* back to one datagram per system call */
+    CuAssertTrue( tc, IOChannel_setProperty( receiver, "Batch", NULL ) );
+
+    CuAssertIntEquals( tc, 5, IOChannel_write( sender, "Hello", 5 ) );
+    CuAssertTrue( tc, IOChannel_flush( sender ) >= 0 );
+    CuAssertIntEquals( tc, 5, IOChannel_read( receiver, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "Hello", 5 ) == 0 );
+
+    /* closing sends what is still queued */
+    CuAssertIntEquals( tc, 3, IOChannel_write( sender, "Bye", 3 ) );
+    IOChannel_close( sender );
+    CuAssertIntEquals( tc, 3, IOChannel_read( receiver, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "Bye", 3 ) == 0 );
+
+    IOChannel_close( receiver );
+
+    IOChannel_clear( sender );
+    IOChannel_delete( sender );
+    IOChannel_clear( receiver );
+    IOChannel_delete( receiver );
+}
+
+
+#define UDPFRAGMENT_MESSAGESIZE  ( 64 * 1024 )
+
+
+void Test_IOChannel_udpFragment( CuTest *tc )
+{
+    IOChannel *sender       = (IOChannel *)NULL;
+    IOChannel *receiver     = (IOChannel *)NULL;
+    char      *message      = (char *)NULL;
+    char      buffer[4096];
+    BaseUI32  partial[8];
+    long      *dropped      = (long *)NULL;
+    int       fragmentSize  = 1400;
+    long      nBytes        = 0;
+    long      i             = 0;
+
+    message = (char *)ANY_BALLOC( UDPFRAGMENT_MESSAGESIZE );
+    CuAssertPtrNotNull( tc, message );
+
+    for( i = 0; i < UDPFRAGMENT_MESSAGESIZE; i++ )
+    {
+        message[ i ] = (char)( i * 7 );
+    }
+
+    sender = IOChannel_new();
+    receiver = IOChannel_new();
+    CuAssertPtrNotNull( tc, sender );
+    CuAssertPtrNotNull( tc, receiver );
+    IOChannel_init( sender );
+    IOChannel_init( receiver );
+
+    CuAssertTrue( tc, IOChannel_openFromString( receiver, "stream=Udp host=127.0.0.1 port=60007 srcport=60006 "
+                                                          "mode='IOCHANNEL_MODE_RW' fragment=1400" ) );
+    CuAssertTrue( tc, IOChannel_openFromString( sender, "stream=Udp host=127.0.0.1 port=60006 srcport=60007 "
+                                                        "mode='IOCHANNEL_MODE_RW'" ) );
+    CuAssertTrue( tc, IOChannel_setProperty( sender, "Fragment", &fragmentSize ) );
+
+    /* a message four times larger than a datagram, written piecewise as a serializer does */
+    for( i = 0; i < UDPFRAGMENT_MESSAGESIZE; i += sizeof( buffer ) )
+    {
+        CuAssertIntEquals( tc, sizeof( buffer ), IOChannel_write( sender, message + i, sizeof( buffer ) ) );
+    }
+
+    CuAssertIntEquals( tc, UDPFRAGMENT_MESSAGESIZE, IOChannel_flush( sender ) );
+    CuAssertIntEquals( tc, 3, IOChannel_write( sender, "End", 3 ) );
+    CuAssertIntEquals( tc, 3, IOChannel_flush( sender ) );
+
+    for( i = 0; i < UDPFRAGMENT_MESSAGESIZE; i += nBytes )
+    {
+        nBytes = IOChannel_read( receiver, buffer, sizeof( buffer ) );
+        CuAssertTrue( tc, nBytes > 0 );
+        CuAssertTrue( tc, Any_memcmp( buffer, message + i, nBytes ) == 0 );
+    }
+
+    /* reads stop at the end of a message */
+    CuAssertIntEquals( tc, UDPFRAGMENT_MESSAGESIZE, i );
+    CuAssertIntEquals( tc, 3, IOChannel_read( receiver, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "End", 3 ) == 0 );
+
+    /* the first of two fragments, whose message is never completed */
+    partial[ 0 ] = htonl( 0x4652474dU );
+    partial[ 1 ] = htonl( 1 );
+    partial[ 2 ] = htonl( 1 );
+    partial[ 3 ] = htonl( 8 );
+    partial[ 4 ] = htonl( 0 );
+    partial[ 5 ] = htonl( 0 );
+    partial[ 6 ] = htonl( 2 );
+    partial[ 7 ] = htonl( 42 );
+
+    CuAssertTrue( tc, IOChannel_setProperty( sender, "Fragment", NULL ) );
+    CuAssertIntEquals( tc, sizeof( partial ), IOChannel_write( sender, partial, sizeof( partial ) ) );
+    IOChannel_flush( sender );
+    CuAssertTrue( tc, IOChannel_setProperty( sender, "Fragment", &fragmentSize ) );
+
+    /* the receiver starts the reassembly while reading the message behind it */
+    CuAssertIntEquals( tc, 3, IOChannel_write( sender, "One", 3 ) );
+    CuAssertIntEquals( tc, 3, IOChannel_flush( sender ) );
+    CuAssertIntEquals( tc, 3, IOChannel_read( receiver, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "One", 3 ) == 0 );
+
+    Any_sleepMilliSeconds( 1100 );
+
+    /* the stale message is dropped as the next one arrives */
+    CuAssertIntEquals( tc, 5, IOChannel_write( sender, "Hello", 5 ) );
+    IOChannel_close( sender );
+    CuAssertIntEquals( tc, 5, IOChannel_read( receiver, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "Hello", 5 ) == 0 );
+
+    dropped = (long *)IOChannel_getProperty( receiver, "FragmentDropped" );
+    CuAssertPtrNotNull( tc, dropped );
+    CuAssertIntEquals( tc, 1, *dropped );
+
+    IOChannel_close( receiver );
+
+    IOChannel_clear( sender );
+    IOChannel_delete( sender );
+    IOChannel_clear( receiver );
+    IOChannel_delete( receiver );
+
+    ANY_FREE( message );
+}
+
+
+#define UNIXSOCKET_PATH  "/tmp/TestIOChannelUnix.sock"
+
+
+static void *Test_IOChannel_unixSocketClient( void *arg )
+{
+    IOChannel *client     = (IOChannel *)NULL;
+    int       pipeFds[2]  = { -1, -1 };
+    bool      isOpen      = false;
+    int       i           = 0;
+
+    client = IOChannel_new();
+    ANY_REQUIRE( client );
+    IOChannel_init( client );
+
+    /* the server may not be listening yet */
+    for( i = 0; i < 500 && !isOpen; i++ )
+    {
+        isOpen = IOChannel_openFromString( client, "stream=Unix name=" UNIXSOCKET_PATH " type=seqpacket" );
+
+        if( !isOpen )
+        {
+            IOChannel_cleanError( client );
+            Any_sleepMilliSeconds( 10 );
+        }
+    }
+
+    if( !isOpen || pipe( pipeFds ) != 0 || write( pipeFds[ 1 ], "pipe", 4 ) != 4 )
+    {
+        errorOccured = true;
+    }
+    else
+    {
+        /* the read end of the pipe goes along with the first packet */
+        if( !IOChannel_setProperty( client, "SendFd", &pipeFds[ 0 ] ) ||
+            IOChannel_write( client, "Hi", 2 ) != 2 || IOChannel_flush( client ) < 0 ||
+            IOChannel_write( client, "Second", 6 ) != 6 || IOChannel_flush( client ) < 0 )
+        {
+            errorOccured = true;
+        }
+
+        IOChannel_close( client );
+
+        close( pipeFds[ 0 ] );
+        close( pipeFds[ 1 ] );
+    }
+
+    IOChannel_clear( client );
+    IOChannel_delete( client );
+
+    return NULL;
+}
+
+
+void Test_IOChannel_unixSocket( CuTest *tc )
+{
+    IOChannel *server       = (IOChannel *)NULL;
+    Threads   *clientThread = (Threads *)NULL;
+    char      buffer[64];
+    int       *fdPtr        = (int *)NULL;
+
+    errorOccured = false;
+
+    clientThread = Threads_new();
+    CuAssertPtrNotNull( tc, clientThread );
+    Threads_init( clientThread, true );
+
+    server = IOChannel_new();
+    CuAssertPtrNotNull( tc, server );
+    IOChannel_init( server );
+
+    Threads_start( clientThread, Test_IOChannel_unixSocketClient, NULL );
+
+    CuAssertTrue( tc, IOChannel_openFromString( server, "stream=ServerUnix name=" UNIXSOCKET_PATH " "
+                                                        "type=seqpacket waitClientTimeout=10000000" ) );
+
+    /* the name is released as soon as the client is accepted */
+    CuAssertTrue( tc, access( UNIXSOCKET_PATH, F_OK ) != 0 );
+
+    /* each write is a packet on its own */
+    CuAssertIntEquals( tc, 2, IOChannel_read( server, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "Hi", 2 ) == 0 );
+    CuAssertIntEquals( tc, 6, IOChannel_read( server, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "Second", 6 ) == 0 );
+
+    fdPtr = (int *)IOChannel_getProperty( server, "ReceivedFd" );
+    CuAssertPtrNotNull( tc, fdPtr );
+    CuAssertIntEquals( tc, 4, read( *fdPtr, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, Any_memcmp( buffer, "pipe", 4 ) == 0 );
+    close( *fdPtr );
+
+    CuAssertTrue( tc, IOChannel_getProperty( server, "ReceivedFd" ) == NULL );
+
+    Threads_join( clientThread, NULL );
+    CuAssertTrue( tc, !errorOccured );
+
+    CuAssertIntEquals( tc, 0, IOChannel_read( server, buffer, sizeof( buffer ) ) );
+    CuAssertTrue( tc, IOChannel_eof( server ) );
+
+    IOChannel_close( server );
+    IOChannel_clear( server );
+    IOChannel_delete( server );
+
+    Threads_clear( clientThread );
+    Threads_delete( clientThread );
+}
+
+
+void Test_IOChannel_pipeCmd( CuTest *tc )
+{
+    IOChannel *stream = (IOChannel *)NULL;
+    FILE      *fp     = (FILE *)NULL;
+    char      buffer[64];
+    long      size    = 0;
+    long      nBytes  = 0;
+    long      pid     = 0;
+
+    stream = IOChannel_new();
+    CuAssertPtrNotNull( tc, stream );
+    IOChannel_init( stream );
+
+    /* no shell syntax, sort is spawned directly and used in both directions */
+    CuAssertTrue( tc, IOChannel_openFromString( stream, "stream=PipeCmd name='sort -u' "
+                                                        "mode='IOCHANNEL_MODE_RW'" ) );
+    CuAssertPtrNotNull( tc, IOChannel_getProperty( stream, "Pid" ) );
+
+    CuAssertIntEquals( tc, 6, IOChannel_write( stream, "b\na\nb\n", 6 ) );
+    CuAssertTrue( tc, IOChannel_setProperty( stream, "CloseWrite", (void *)true ) );
+    CuAssertTrue( tc, IOChannel_write( stream, "c\n", 2 ) < 0 );
+    IOChannel_cleanError( stream );
+
+    do
+    {
+        nBytes = IOChannel_read( stream, buffer + size, sizeof( buffer ) - size );
+        size += nBytes > 0 ? nBytes : 0;
+    }
+    while( nBytes > 0 );
+
+    CuAssertIntEquals( tc, 4, size );
+    CuAssertTrue( tc, Any_memcmp( buffer, "a\nb\n", 4 ) == 0 );
+    CuAssertTrue( tc, IOChannel_eof( stream ) );
+
+    CuAssertTrue( tc, IOChannel_close( stream ) );
+
+    /* the pipe needs the shell, its output is also available as FILE */
+    CuAssertTrue( tc, IOChannel_openFromString( stream, "stream=PipeCmd name='echo abc | tr b x' "
+                                                        "mode='IOCHANNEL_MODE_R_ONLY'" ) );
+
+    fp = (FILE *)IOChannel_getProperty( stream, "AnsiFile" );
+    CuAssertPtrNotNull( tc, fp );
+    CuAssertPtrEquals( tc, fp, IOChannel_getProperty( stream, "AnsiFile" ) );
+    CuAssertPtrNotNull( tc, fgets( buffer, sizeof( buffer ), fp ) );
+    CuAssertStrEquals( tc, "axc\n", buffer );
+
+    CuAssertTrue( tc, IOChannel_close( stream ) );
+
+    /* the command is reaped also when the stream is not closed */
+    CuAssertTrue( tc, IOChannel_open( stream, "PipeCmd://true",
+                                      IOCHANNEL_MODE_R_ONLY | IOCHANNEL_MODE_NOTCLOSE,
+                                      IOCHANNEL_PERMISSIONS_ALL ) );
+
+    pid = *(long *)IOChannel_getProperty( stream, "Pid" );
+
+    CuAssertTrue( tc, IOChannel_close( stream ) );
+    CuAssertIntEquals( tc, -1, waitpid( (pid_t)pid, NULL, WNOHANG ) );
+    CuAssertIntEquals( tc, ECHILD, errno );
+
+    /* unknown commands fail at open time */
+    CuAssertTrue( tc, !IOChannel_openFromString( stream, "stream=PipeCmd name=/nonexistent/command "
+                                                         "mode='IOCHANNEL_MODE_R_ONLY'" ) );
+
+    IOChannel_clear( stream );
+    IOChannel_delete( stream );
+}
+
+
+void Test_IOChannel_stats( CuTest *tc )
+{
+    IOChannel      *stream = (IOChannel *)NULL;
+    IOChannelStats *stats  = (IOChannelStats *)NULL;
+    char           buffer[64];
+    unsigned long long total = 0;
+    int            i       = 0;
+
+    stream = IOChannel_new();
+    CuAssertPtrNotNull( tc, stream );
+    IOChannel_init( stream );
+
+    CuAssertPtrEquals( tc, NULL, IOChannel_getProperty( stream, "Stats" ) );
+    CuAssertTrue( tc, IOChannel_setProperty( stream, "Stats", (void *)true ) );
+
+    CuAssertTrue( tc, IOChannel_open( stream, "File:///tmp/TestIOChannelStats.tmp",
+                                      IOCHANNEL_MODE_W_ONLY | IOCHANNEL_MODE_CREAT | IOCHANNEL_MODE_TRUNC,
+                                      IOCHANNEL_PERMISSIONS_ALL ) );
+
+    for( i = 0; i < 3; i++ )
+    {
+        CuAssertIntEquals( tc, 10, IOChannel_write( stream, "0123456789", 10 ) );
+    }
+
+    CuAssertTrue( tc, IOChannel_close( stream ) );
+
+    /* still there after closing */
+    stats = (IOChannelStats *)IOChannel_getProperty( stream, "Stats" );
+    CuAssertPtrNotNull( tc, stats );
+    CuAssertTrue( tc, stats->writeCalls == 3 );
+    CuAssertTrue( tc, stats->writeBytes == 30 );
+    CuAssertTrue( tc, stats->streamWrites == 3 );
+    CuAssertTrue( tc, stats->shortWrites == 0 );
+
+    for( i = 0; i < IOCHANNELSTATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        total += stats->writeLatency[i];
+    }
+
+    CuAssertTrue( tc, total == 3 );
+
+    /* enabling again resets them */
+    CuAssertTrue( tc, IOChannel_setProperty( stream, "Stats", (void *)true ) );
+    CuAssertTrue( tc, stats->writeCalls == 0 );
+
+    CuAssertTrue( tc, IOChannel_open( stream, "File:///tmp/TestIOChannelStats.tmp",
+                                      IOCHANNEL_MODE_R_ONLY, IOCHANNEL_PERMISSIONS_ALL ) );
+
+    CuAssertIntEquals( tc, 30, IOChannel_read( stream, buffer, sizeof( buffer ) ) );
+
+    CuAssertTrue( tc, stats->readCalls == 1 );
+    CuAssertTrue( tc, stats->readBytes == 30 );
+    CuAssertTrue( tc, stats->streamReads == 1 );
+    CuAssertTrue( tc, stats->shortReads == 1 );
+
+    CuAssertTrue( tc, IOChannel_close( stream ) );
+
+    CuAssertTrue( tc, IOChannel_setProperty( stream, "Stats", NULL ) );
+    CuAssertPtrEquals( tc, NULL, IOChannel_getProperty( stream, "Stats" ) );
+
+    IOChannel_clear( stream );
+    IOChannel_delete( stream );
+
+    unlink( "/tmp/TestIOChannelStats.tmp" );
+}
+
+
+void Test_IOChannel_filter( CuTest *tc )
+{
+    IOChannel *memory = (IOChannel *)NULL;
+    IOChannel *filter = (IOChannel *)NULL;
+    char      buffer[128];
+    char      data[64];
+    BaseUI32  *crc32  = (BaseUI32 *)NULL;
+    long      length  = 0;
+
+    memory = IOChannel_new();
+    CuAssertPtrNotNull( tc, memory );
+    IOChannel_init( memory );
+
+    filter = IOChannel_new();
+    CuAssertPtrNotNull( tc, filter );
+    IOChannel_init( filter );
+
+    /* two messages, framed and then hex-encoded */
+    CuAssertTrue( tc, IOChannel_open( memory, "Mem://", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, buffer, (long)sizeof( buffer ) ) );
+    CuAssertTrue( tc, IOChannel_open( filter, "Filter://frame,hex", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, memory ) );
+
+    CuAssertIntEquals( tc, 5, IOChannel_write( filter, "Hello", 5 ) );
+    CuAssertIntEquals( tc, 6, IOChannel_write( filter, " World", 6 ) );
+    CuAssertTrue( tc, IOChannel_flush( filter ) != -1 );
+    CuAssertIntEquals( tc, 3, IOChannel_write( filter, "Bye", 3 ) );
+    CuAssertTrue( tc, IOChannel_close( filter ) );
+
+    /* the small writes were gathered into a single chunk */
+    CuAssertTrue( tc, Any_strncmp( buffer, "0000000b48656c6c6f20576f726c6400000000", 38 ) == 0 );
+    CuAssertTrue( tc, Any_strncmp( buffer + 38, "00000003427965" "00000000", 22 ) == 0 );
+    length = 60;
+
+    CuAssertTrue( tc, IOChannel_close( memory ) );
+
+    /* reads stop at the end of each message */
+    CuAssertTrue( tc, IOChannel_open( memory, "Mem://", IOCHANNEL_MODE_R_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, buffer, length ) );
+    CuAssertTrue( tc, IOChannel_open( filter, "Filter://frame,hex", IOCHANNEL_MODE_R_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, memory ) );
+
+    CuAssertIntEquals( tc, 11, IOChannel_read( filter, data, sizeof( data ) ) );
+    CuAssertTrue( tc, Any_memcmp( data, "Hello World", 11 ) == 0 );
+    CuAssertIntEquals( tc, 3, IOChannel_read( filter, data, sizeof( data ) ) );
+    CuAssertTrue( tc, Any_memcmp( data, "Bye", 3 ) == 0 );
+    CuAssertIntEquals( tc, 0, IOChannel_read( filter, data, sizeof( data ) ) );
+    CuAssertTrue( tc, IOChannel_eof( filter ) );
+
+    /* properties of the filtered stream are reachable as well */
+    CuAssertPtrEquals( tc, buffer, IOChannel_getProperty( filter, "MemPointer" ) );
+
+    CuAssertTrue( tc, IOChannel_close( filter ) );
+    CuAssertTrue( tc, IOChannel_close( memory ) );
+
+    /* checksum of the standard check sequence */
+    CuAssertTrue( tc, IOChannel_open( memory, "Mem://", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, buffer, (long)sizeof( buffer ) ) );
+    CuAssertTrue( tc, IOChannel_open( filter, "Filter://crc32", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, memory ) );
+
+    CuAssertIntEquals( tc, 9, IOChannel_write( filter, "123456789", 9 ) );
+    CuAssertTrue( tc, IOChannel_flush( filter ) != -1 );
+
+    crc32 = (BaseUI32 *)IOChannel_getProperty( filter, "WriteCrc32" );
+    CuAssertPtrNotNull( tc, crc32 );
+    CuAssertTrue( tc, *crc32 == 0xcbf43926 );
+    CuAssertTrue( tc, Any_memcmp( buffer, "123456789", 9 ) == 0 );
+
+    CuAssertTrue( tc, IOChannel_close( filter ) );
+
+    CuAssertTrue( tc, !IOChannel_open( filter, "Filter://frame,unknown", IOCHANNEL_MODE_W_ONLY,
+                                       IOCHANNEL_PERMISSIONS_ALL, memory ) );
+
+    CuAssertTrue( tc, IOChannel_close( memory ) );
+
+    IOChannel_clear( filter );
+    IOChannel_delete( filter );
+
+    IOChannel_clear( memory );
+    IOChannel_delete( memory );
+}
+
+
+void Test_IOChannel_tee( CuTest *tc )
+{
+    IOChannel *tee      = (IOChannel *)NULL;
+    IOChannel *sinks[2] = { NULL, NULL };
+    IOChannel *pipeSink = (IOChannel *)NULL;
+    char      memory[2][1024];
+    char      *block    = (char *)NULL;
+    long      *dropped  = (long *)NULL;
+    long      received  = 0;
+    long      nBytes    = 0;
+    int       pipeFds[2];
+    int       i         = 0;
+
+    tee = IOChannel_new();
+    CuAssertPtrNotNull( tc, tee );
+    IOChannel_init( tee );
+
+    for( i = 0; i < 2; i++ )
+    {
+        sinks[i] = IOChannel_new();
+        CuAssertPtrNotNull( tc, sinks[i] );
+        IOChannel_init( sinks[i] );
+    }
+
+    /* synchronous, then with a thread per sink */
+    for( i = 0; i < 2; i++ )
+    {
+        Any_memset( memory, 0, sizeof( memory ) );
+
+        CuAssertTrue( tc, IOChannel_open( sinks[0], "Mem://", IOCHANNEL_MODE_W_ONLY,
+                                          IOCHANNEL_PERMISSIONS_ALL, memory[0], (long)sizeof( memory[0] ) ) );
+        CuAssertTrue( tc, IOChannel_open( sinks[1], "Mem://", IOCHANNEL_MODE_W_ONLY,
+                                          IOCHANNEL_PERMISSIONS_ALL, memory[1], (long)sizeof( memory[1] ) ) );
+
+        CuAssertTrue( tc, IOChannel_openFromString( tee, i == 0 ? "stream=Tee" :
+                                                    "stream=Tee policy=block threads=1" ) );
+        CuAssertTrue( tc, IOChannel_setProperty( tee, "AddSink", sinks[0] ) );
+        CuAssertTrue( tc, IOChannel_setProperty( tee, "AddSink", sinks[1] ) );
+
+        CuAssertIntEquals( tc, 5, IOChannel_write( tee, "Hello", 5 ) );
+        CuAssertIntEquals( tc, 4, IOChannel_write( tee, " Tee", 4 ) );
+        CuAssertTrue( tc, IOChannel_flush( tee ) != -1 );
+
+        CuAssertTrue( tc, Any_memcmp( memory[0], "Hello Tee", 9 ) == 0 );
+        CuAssertTrue( tc, Any_memcmp( memory[1], "Hello Tee", 9 ) == 0 );
+
+        dropped = (long *)IOChannel_getProperty( tee, "DroppedBytes" );
+        CuAssertPtrNotNull( tc, dropped );
+        CuAssertIntEquals( tc, 0, *dropped );
+
+        CuAssertTrue( tc, IOChannel_close( tee ) );
+        CuAssertTrue( tc, IOChannel_close( sinks[0] ) );
+        CuAssertTrue( tc, IOChannel_close( sinks[1] ) );
+    }
+
+    /* a sink stuck on a full pipe gets what fits in its queue, the rest is dropped */
+    CuAssertIntEquals( tc, 0, pipe( pipeFds ) );
+
+    pipeSink = IOChannel_new();
+    CuAssertPtrNotNull( tc, pipeSink );
+    IOChannel_init( pipeSink );
+
+    CuAssertTrue( tc, IOChannel_open( pipeSink, "Fd://", IOCHANNEL_MODE_W_ONLY,
+                                      IOCHANNEL_PERMISSIONS_ALL, pipeFds[1] ) );
+    CuAssertTrue( tc, IOChannel_openFromString( tee, "stream=Tee policy=buffer limit=1024 threads=1" ) );
+    CuAssertTrue( tc, IOChannel_setProperty( tee, "AddSink", pipeSink ) );
+
+    block = (char *)ANY_BALLOC( 128 * 1024 );
+    CuAssertPtrNotNull( tc, block );
+
+    CuAssertIntEquals( tc, 128 * 1024, IOChannel_write( tee, block, 128 * 1024 ) );
+    CuAssertIntEquals( tc, 512, IOChannel_write( tee, block, 512 ) );
+
+    while( received < 128 * 1024 )
+    {
+        nBytes = read( pipeFds[0], block, 128 * 1024 );
+        CuAssertTrue( tc, nBytes > 0 );
+        received += nBytes;
+    }
+
+    CuAssertTrue( tc, IOChannel_flush( tee ) != -1 );
+
+    dropped = (long *)IOChannel_getProperty( tee, "DroppedBytes" );
+    CuAssertPtrNotNull( tc, dropped );
+    CuAssertIntEquals( tc, 512, *dropped );
+
+    CuAssertTrue( tc, IOChannel_close( tee ) );
+    CuAssertTrue( tc, IOChannel_close( pipeSink ) );
+
+    close( pipeFds[0] );
+    ANY_FREE( block );
+
+    IOChannel_clear( pipeSink );
+    IOChannel_delete( pipeSink );
+
+    for( i = 0; i < 2; i++ )
+    {
+        IOChannel_clear( sinks[i] );
+        IOChannel_delete( sinks[i] );
+    }
+
+    IOChannel_clear( tee );
+    IOChannel_delete( tee );
+}
+
+
 void Test_NameResolv( CuTest *tc )
 {
     IOChannel    *stream                          = (IOChannel *)NULL;
@@ -3378,6 +4926,21 @@ int main( void )
     SUITE_ADD_TEST( suite, Test_Berkeley_Data );
     SUITE_ADD_TEST( suite, Test_IOChannel_openTcp );
     SUITE_ADD_TEST( suite, Test_IOChannel_printf );
+    SUITE_ADD_TEST( suite, Test_IOChannel_readBuffering );
+    SUITE_ADD_TEST( suite, Test_IOChannel_writevReadv );
+    SUITE_ADD_TEST( suite, Test_IOChannel_asyncIO );
+    SUITE_ADD_TEST( suite, Test_IOChannel_growableMemMapFd );
+    SUITE_ADD_TEST( suite, Test_IOChannel_shmRingBuffer );
+    SUITE_ADD_TEST( suite, Test_IOChannel_shmBroadcast );
+    SUITE_ADD_TEST( suite, Test_IOChannel_transfer );
+    SUITE_ADD_TEST( suite, Test_BerkeleySocketServer_eventLoop );
+    SUITE_ADD_TEST( suite, Test_IOChannel_udpBatch );
+    SUITE_ADD_TEST( suite, Test_IOChannel_udpFragment );
+    SUITE_ADD_TEST( suite, Test_IOChannel_unixSocket );
+    SUITE_ADD_TEST( suite, Test_IOChannel_pipeCmd );
+    SUITE_ADD_TEST( suite, Test_IOChannel_stats );
+    SUITE_ADD_TEST( suite, Test_IOChannel_filter );
+    SUITE_ADD_TEST( suite, Test_IOChannel_tee );
     SUITE_ADD_TEST( suite, Test_NameResolv );
 
     CuSuiteRun( suite );
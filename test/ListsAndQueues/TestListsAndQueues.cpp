@@ -30,6 +30,7 @@
 #include <MTQueue.h>
 #include <PQueue.h>
 #include <PQueueArray.h>
+#include <SPSCQueue.h>
 #include <Threads.h>
 #include <ToolBOSLib.h>
 
@@ -164,6 +165,150 @@ void Test_MTList_main( CuTest *tc )
 }
 
 
+#define READMOSTLY_READERS    4
+#define READMOSTLY_ROUNDS     20000
+
+
+typedef struct ReadMostlyData
+{
+    MTList *list;
+    AnyAtomic stop;
+    AnyAtomic misses;
+}
+ReadMostlyData;
+
+
+static int ReadMostly_cmp( void *element, void *searched )
+{
+    return *(long *)element == *(long *)searched ? 0 : 1;
+}
+
+
+static int ReadMostly_check( void *element )
+{
+    /* the removed elements must stay readable until no reader sees them */
+    ANY_REQUIRE( *(long *)element >= 0 && *(long *)element < 2 * NUMELEMENTS );
+
+    return 1;
+}
+
+
+static void *ReadMostly_reader( void *arg )
+{
+    ReadMostlyData *data = (ReadMostlyData *)arg;
+    long key = 0;
+
+    while( !Atomic_get( &data->stop ))
+    {
+        /* the even keys are never removed */
+        for( key = 0; key < NUMELEMENTS; key += 2 )
+        {
+            if( !MTList_search( data->list, ReadMostly_cmp, &key ))
+            {
+                Atomic_inc( &data->misses );
+            }
+        }
+
+        MTList_iterate( data->list, ReadMostly_check, MTLIST_ITERATE_FOR_READ );
+
+        /* nested read sections */
+        MTLIST_FOREACH_BEGIN( data->list, MTLIST_ITERATE_FOR_READ )
+                    {
+                        key = *(long *)MTLIST_FOREACH_ELEMENTPTR;
+
+                        if( !MTList_search( data->list, ReadMostly_cmp, &key ) && key % 2 == 0 )
+                        {
+                            Atomic_inc( &data->misses );
+                        }
+                    }
+        MTLIST_FOREACH_END;
+    }
+
+    return NULL;
+}
+
+
+void Test_MTList_readMostly( CuTest *tc )
+{
+    Threads *readers[READMOSTLY_READERS];
+    ReadMostlyData data;
+    MTListElement *ptr = NULL;
+    long *value = NULL;
+    long key = 0;
+    long count = 0;
+    int i = 0;
+
+    data.list = MTList_new();
+    CuAssertPtrNotNull( tc, data.list );
+    CuAssertTrue( tc, MTList_initReadMostly( data.list ));
+
+    data.stop = 0;
+    data.misses = 0;
+
+    for( i = 0; i < NUMELEMENTS; i++ )
+    {
+        value = ANY_TALLOC( long );
+        *value = i;
+        MTList_add( data.list, value );
+    }
+
+    for( i = 0; i < READMOSTLY_READERS; i++ )
+    {
+        readers[i] = Threads_new();
+        Threads_init( readers[i], true );
+        Threads_start( readers[i], ReadMostly_reader, &data );
+    }
+
+    /* the odd keys come and go, their data freed by the list */
+    for( i = 0; i < READMOSTLY_ROUNDS; i++ )
+    {
+        key = 1 + 2 * ( i % ( NUMELEMENTS / 2 ));
+
+        CuAssertTrue( tc, MTList_remove( data.list, ReadMostly_cmp, &key ));
+
+        value = ANY_TALLOC( long );
+        *value = key;
+
+        if( i % 2 )
+        {
+            MTList_add( data.list, value );
+        }
+        else
+        {
+            MTList_insert( data.list, value );
+        }
+    }
+
+    Atomic_set( &data.stop, 1 );
+
+    for( i = 0; i < READMOSTLY_READERS; i++ )
+    {
+        Threads_join( readers[i], NULL );
+        Threads_clear( readers[i] );
+        Threads_delete( readers[i] );
+    }
+
+    CuAssertIntEquals( tc, 0, Atomic_get( &data.misses ));
+    CuAssertIntEquals( tc, NUMELEMENTS, MTList_numElements( data.list ));
+
+    MTList_synchronize( data.list );
+
+    MTList_beginRead( data.list );
+
+    for( ptr = MTList_getNextElement( data.list, NULL ); ptr; ptr = MTList_getNextElement( data.list, ptr ))
+    {
+        count += *(long *)MTList_getElementData( data.list, ptr );
+    }
+
+    MTList_endRead( data.list );
+
+    CuAssertIntEquals( tc, NUMELEMENTS * ( NUMELEMENTS - 1 ) / 2, count );
+
+    MTList_clear( data.list );
+    MTList_delete( data.list );
+}
+
+
 /*---------------------------------------------------------------------------*/
 /* MTQueue                                                                   */
 /*---------------------------------------------------------------------------*/
@@ -272,6 +417,364 @@ void Test_MTQueue( CuTest *tc )
 }
 
 
+void Test_MTQueue_pushMany( CuTest *tc )
+{
+    MTQueue *queue = NULL;
+    long values[5] = { 1, 2, 3, 4, 5 };
+    void *data[4];
+    int i = 0;
+
+    for( i = 0; i < 4; i++ )
+    {
+        data[i] = &values[i + 1];
+    }
+
+    /* FIFO: the batch comes after what was already queued, in order */
+    queue = MTQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+    MTQueue_init( queue, MTQUEUE_FIFO, true );
+
+    MTQueue_push( queue, &values[0], MTQUEUE_NOCLASS );
+    MTQueue_pushMany( queue, data, 4, MTQUEUE_NOCLASS );
+    CuAssertIntEquals( tc, 5, MTQueue_numElements( queue ));
+
+    for( i = 0; i < 5; i++ )
+    {
+        CuAssertIntEquals( tc, i + 1, *(long *)MTQueue_pop( queue, NULL ));
+    }
+
+    CuAssertPtrEquals( tc, NULL, MTQueue_pop( queue, NULL ));
+
+    MTQueue_clear( queue );
+    MTQueue_delete( queue );
+
+    /* LIFO: as if pushed one by one */
+    queue = MTQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+    MTQueue_init( queue, MTQUEUE_LIFO, true );
+
+    MTQueue_push( queue, &values[0], MTQUEUE_NOCLASS );
+    MTQueue_pushMany( queue, data, 4, MTQUEUE_NOCLASS );
+    CuAssertIntEquals( tc, 5, MTQueue_numElements( queue ));
+
+    for( i = 0; i < 5; i++ )
+    {
+        CuAssertIntEquals( tc, 5 - i, *(long *)MTQueue_pop( queue, NULL ));
+    }
+
+    MTQueue_clear( queue );
+    MTQueue_delete( queue );
+}
+
+
+#define BOUNDED_PRODUCERS   4
+#define BOUNDED_CONSUMERS   4
+#define BOUNDED_PER_THREAD  20000
+
+
+typedef struct BoundedData
+{
+    MTQueue *queue;
+    long values[BOUNDED_PER_THREAD + 1];
+    AnyAtomic popped;
+    AnyAtomic sum;
+}
+BoundedData;
+
+
+static void *Bounded_producer( void *arg )
+{
+    BoundedData *data = (BoundedData *)arg;
+    int i = 0;
+
+    for( i = 1; i <= BOUNDED_PER_THREAD; i++ )
+    {
+        MTQueue_push( data->queue, &data->values[i], MTQUEUE_NOCLASS );
+    }
+
+    return NULL;
+}
+
+
+static void *Bounded_consumer( void *arg )
+{
+    BoundedData *data = (BoundedData *)arg;
+    long *value = NULL;
+
+    /* values[0] is the end marker */
+    while( ( value = (long *)MTQueue_popWait( data->queue, NULL, 0 ) ) != &data->values[0] )
+    {
+        if( value )
+        {
+            Atomic_add( &data->sum, *value );
+            Atomic_inc( &data->popped );
+        }
+    }
+
+    return NULL;
+}
+
+
+static void *Bounded_pushToFull( void *arg )
+{
+    MTQueue *queue = (MTQueue *)arg;
+    static long value = 5;
+
+    MTQueue_push( queue, &value, MTQUEUE_NOCLASS );
+
+    return NULL;
+}
+
+
+void Test_MTQueue_bounded( CuTest *tc )
+{
+    Threads *producers[BOUNDED_PRODUCERS];
+    Threads *consumers[BOUNDED_CONSUMERS];
+    BoundedData *data = NULL;
+    MTQueue *queue = NULL;
+    long values[4] = { 1, 2, 3, 4 };
+    MTQueueUserClass userClass = 0;
+    int i = 0;
+
+    /* FIFO order and the user class, the capacity is rounded up to 4 */
+    queue = MTQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+    CuAssertIntEquals( tc, 0, MTQueue_initBounded( queue, 3 ));
+
+    for( i = 0; i < 4; i++ )
+    {
+        MTQueue_push( queue, &values[i], i + 10 );
+    }
+
+    CuAssertIntEquals( tc, 4, MTQueue_numElements( queue ));
+
+    for( i = 0; i < 4; i++ )
+    {
+        CuAssertIntEquals( tc, i + 1, *(long *)MTQueue_pop( queue, &userClass ));
+        CuAssertIntEquals( tc, i + 10, userClass );
+    }
+
+    CuAssertPtrEquals( tc, NULL, MTQueue_pop( queue, NULL ));
+    CuAssertPtrEquals( tc, NULL, MTQueue_popWait( queue, NULL, 1000 ));
+
+    /* quitting releases a push blocked on the full queue */
+    for( i = 0; i < 4; i++ )
+    {
+        MTQueue_push( queue, &values[i], MTQUEUE_NOCLASS );
+    }
+
+    producers[0] = Threads_new();
+    Threads_init( producers[0], true );
+    Threads_start( producers[0], Bounded_pushToFull, queue );
+
+    Any_sleepMilliSeconds( 100 );
+    MTQueue_setQuit( queue, true );
+
+    Threads_join( producers[0], NULL );
+    Threads_clear( producers[0] );
+    Threads_delete( producers[0] );
+
+    CuAssertIntEquals( tc, 4, MTQueue_numElements( queue ));
+
+    MTQueue_clear( queue );
+    MTQueue_delete( queue );
+
+    /* a small ring, so both the pushes and the pops have to wait */
+    data = ANY_TALLOC( BoundedData );
+    CuAssertPtrNotNull( tc, data );
+
+    for( i = 0; i <= BOUNDED_PER_THREAD; i++ )
+    {
+        data->values[i] = i;
+    }
+
+    data->queue = MTQueue_new();
+    CuAssertPtrNotNull( tc, data->queue );
+    MTQueue_initBounded( data->queue, 16 );
+
+    for( i = 0; i < BOUNDED_CONSUMERS; i++ )
+    {
+        consumers[i] = Threads_new();
+        Threads_init( consumers[i], true );
+        Threads_start( consumers[i], Bounded_consumer, data );
+    }
+
+    for( i = 0; i < BOUNDED_PRODUCERS; i++ )
+    {
+        producers[i] = Threads_new();
+        Threads_init( producers[i], true );
+        Threads_start( producers[i], Bounded_producer, data );
+    }
+
+    for( i = 0; i < BOUNDED_PRODUCERS; i++ )
+    {
+        Threads_join( producers[i], NULL );
+        Threads_clear( producers[i] );
+        Threads_delete( producers[i] );
+    }
+
+    for( i = 0; i < BOUNDED_CONSUMERS; i++ )
+    {
+        MTQueue_push( data->queue, &data->values[0], MTQUEUE_NOCLASS );
+    }
+
+    for( i = 0; i < BOUNDED_CONSUMERS; i++ )
+    {
+        Threads_join( consumers[i], NULL );
+        Threads_clear( consumers[i] );
+        Threads_delete( consumers[i] );
+    }
+
+    CuAssertIntEquals( tc, BOUNDED_PRODUCERS * BOUNDED_PER_THREAD, Atomic_get( &data->popped ));
+    CuAssertTrue( tc, Atomic_get( &data->sum ) ==
+                      BOUNDED_PRODUCERS * ( (long)BOUNDED_PER_THREAD * ( BOUNDED_PER_THREAD + 1 ) / 2 ));
+    CuAssertIntEquals( tc, 0, MTQueue_numElements( data->queue ));
+
+    MTQueue_clear( data->queue );
+    MTQueue_delete( data->queue );
+
+    ANY_FREE( data );
+}
+
+
+/*---------------------------------------------------------------------------*/
+/* SPSCQueue                                                                 */
+/*---------------------------------------------------------------------------*/
+
+
+#define SPSC_NUMELEMENTS  200000
+
+
+static void *SPSC_producer( void *arg )
+{
+    SPSCQueue *queue = (SPSCQueue *)arg;
+    void *batch[7];
+    long i = 1;
+    long n = 0;
+    unsigned long pushed = 0;
+
+    /* single pushes and batches of different sizes, in order */
+    while( i <= SPSC_NUMELEMENTS )
+    {
+        if( i % 3 )
+        {
+            SPSCQueue_pushWait( queue, (void *)i, 0 );
+            i++;
+            continue;
+        }
+
+        for( n = 0; n < 7 && i + n <= SPSC_NUMELEMENTS; n++ )
+        {
+            batch[n] = (void *)( i + n );
+        }
+
+        pushed = 0;
+
+        while( pushed < (unsigned long)n )
+        {
+            pushed += SPSCQueue_pushMany( queue, batch + pushed, n - pushed );
+        }
+
+        i += n;
+    }
+
+    return NULL;
+}
+
+
+void Test_SPSCQueue( CuTest *tc )
+{
+    SPSCQueue *queue = NULL;
+    Threads *producer = NULL;
+    void *batch[5];
+    long values[4] = { 1, 2, 3, 4 };
+    long expected = 1;
+    unsigned long n = 0;
+    unsigned long i = 0;
+    void *data = NULL;
+
+    /* the capacity is rounded up to 4 */
+    queue = SPSCQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+    CuAssertTrue( tc, SPSCQueue_init( queue, 3 ));
+    CuAssertIntEquals( tc, 4, SPSCQueue_capacity( queue ));
+
+    CuAssertTrue( tc, SPSCQueue_push( queue, &values[0] ));
+    CuAssertIntEquals( tc, 0, SPSCQueue_pushMany( queue, batch, 0 ));
+
+    batch[0] = &values[1];
+    batch[1] = &values[2];
+    batch[2] = &values[3];
+    batch[3] = &values[0];
+
+    /* only 3 fit */
+    CuAssertIntEquals( tc, 3, SPSCQueue_pushMany( queue, batch, 4 ));
+    CuAssertTrue( tc, !SPSCQueue_push( queue, &values[0] ));
+    CuAssertTrue( tc, !SPSCQueue_pushWait( queue, &values[0], 1000 ));
+    CuAssertIntEquals( tc, 4, SPSCQueue_numElements( queue ));
+
+    CuAssertIntEquals( tc, 1, *(long *)SPSCQueue_pop( queue ));
+    CuAssertIntEquals( tc, 3, SPSCQueue_popMany( queue, batch, 5 ));
+
+    for( i = 0; i < 3; i++ )
+    {
+        CuAssertIntEquals( tc, i + 2, *(long *)batch[i] );
+    }
+
+    CuAssertPtrEquals( tc, NULL, SPSCQueue_pop( queue ));
+    CuAssertPtrEquals( tc, NULL, SPSCQueue_popWait( queue, 1000 ));
+    CuAssertIntEquals( tc, 0, SPSCQueue_numElements( queue ));
+
+    SPSCQueue_clear( queue );
+
+    /* a small ring between two threads, so both sides have to wait */
+    CuAssertTrue( tc, SPSCQueue_init( queue, 16 ));
+
+    producer = Threads_new();
+    Threads_init( producer, true );
+    Threads_start( producer, SPSC_producer, queue );
+
+    while( expected <= SPSC_NUMELEMENTS )
+    {
+        if( expected % 2 )
+        {
+            data = SPSCQueue_popWait( queue, 0 );
+            CuAssertTrue( tc, (long)data == expected );
+            expected++;
+            continue;
+        }
+
+        n = SPSCQueue_popMany( queue, batch, 5 );
+
+        /* nothing there yet, wait instead of polling */
+        if( n == 0 )
+        {
+            batch[0] = SPSCQueue_popWait( queue, 0 );
+            n = 1;
+        }
+
+        for( i = 0; i < n; i++ )
+        {
+            CuAssertTrue( tc, (long)batch[i] == expected );
+            expected++;
+        }
+    }
+
+    Threads_join( producer, NULL );
+    Threads_clear( producer );
+    Threads_delete( producer );
+
+    CuAssertIntEquals( tc, 0, SPSCQueue_numElements( queue ));
+
+    /* quit makes a waiting pop return */
+    SPSCQueue_setQuit( queue, true );
+    CuAssertPtrEquals( tc, NULL, SPSCQueue_popWait( queue, 0 ));
+
+    SPSCQueue_clear( queue );
+    SPSCQueue_delete( queue );
+}
+
+
 /*---------------------------------------------------------------------------*/
 /* PQueue                                                                    */
 /*---------------------------------------------------------------------------*/
@@ -594,7 +1097,11 @@ int main( void )
 
     SUITE_ADD_TEST( suite, Test_MTList_lifecycle );
     SUITE_ADD_TEST( suite, Test_MTList_main );
+    SUITE_ADD_TEST( suite, Test_MTList_readMostly );
     SUITE_ADD_TEST( suite, Test_MTQueue );
+    SUITE_ADD_TEST( suite, Test_MTQueue_pushMany );
+    SUITE_ADD_TEST( suite, Test_MTQueue_bounded );
+    SUITE_ADD_TEST( suite, Test_SPSCQueue );
 //     SUITE_ADD_TEST( suite, Test_MTMessageQueue );
     SUITE_ADD_TEST( suite, Test_PQueue );
     SUITE_ADD_TEST( suite, Test_PQueueArray );
@@ -28,7 +28,9 @@
 #include <Any.h>
 #include <Atomic.h>
 #include <Cond.h>
+#include <LockProfile.h>
 #include <MThreadKey.h>
+#include <Mutex.h>
 #include <RWLock.h>
 #include <Threads.h>
 
@@ -215,6 +217,150 @@ void Test_RWLock( CuTest *tc )
 }
 
 
+/*---------------------------------------------------------------------------*/
+/* Lock profiling                                                            */
+/*---------------------------------------------------------------------------*/
+
+
+#define PROFILE_THREADS   4
+#define PROFILE_ROUNDS    20000
+
+
+typedef struct ProfileData
+{
+    Mutex *mutex;
+    long counter;
+}
+ProfileData;
+
+
+static void *Profile_threadMain( void *instance )
+{
+    ProfileData *data = (ProfileData *)instance;
+    int status = 0;
+    int i = 0;
+
+    for( i = 0; i < PROFILE_ROUNDS; i++ )
+    {
+        status = Mutex_lock( data->mutex );
+        ANY_REQUIRE( status == 0 );
+
+        data->counter++;
+
+        status = Mutex_unlock( data->mutex );
+        ANY_REQUIRE( status == 0 );
+    }
+
+    return ( 0 );
+}
+
+
+void Test_LockProfile( CuTest *tc )
+{
+    Threads threads[PROFILE_THREADS];
+    ProfileData data;
+    LockProfileStats stats;
+    RWLock *rwlock = (RWLock *)NULL;
+    FILE *stream = (FILE *)NULL;
+    char buffer[4096];
+    size_t length = 0;
+    unsigned long long waits = 0;
+    int i = 0;
+
+    /* an adaptive mutex hammered by a few threads */
+    data.mutex = Mutex_new();
+    CuAssertPtrNotNull( tc, data.mutex );
+    CuAssertTrue( tc, Mutex_init( data.mutex, MUTEX_PRIVATE | MUTEX_ADAPTIVE ));
+    Mutex_enableProfiling( data.mutex, "test mutex" );
+    data.counter = 0;
+
+    for( i = 0; i < PROFILE_THREADS; i++ )
+    {
+        CuAssertTrue( tc, Threads_init( &threads[ i ], true ));
+        CuAssertIntEquals( tc, 0, Threads_start( &threads[ i ], Profile_threadMain, &data ));
+    }
+
+    for( i = 0; i < PROFILE_THREADS; i++ )
+    {
+        Threads_join( &threads[ i ], NULL );
+        Threads_clear( &threads[ i ] );
+    }
+
+    CuAssertIntEquals( tc, PROFILE_THREADS * PROFILE_ROUNDS, data.counter );
+
+    CuAssertIntEquals( tc, 0, Mutex_lock( data.mutex ));
+    CuAssertIntEquals( tc, EBUSY, Mutex_tryLock( data.mutex ));
+    CuAssertIntEquals( tc, 0, Mutex_unlock( data.mutex ));
+
+    Mutex_getStats( data.mutex, &stats );
+    CuAssertTrue( tc, stats.acquired == PROFILE_THREADS * PROFILE_ROUNDS + 1 );
+    CuAssertTrue( tc, stats.contended <= stats.acquired );
+    CuAssertTrue( tc, stats.failedTries == 1 );
+    CuAssertTrue( tc, stats.maxWaitTime <= stats.totalWaitTime );
+
+    for( i = 0; i < LOCKPROFILE_NUM_BUCKETS; i++ )
+    {
+        waits += stats.waitTimes[ i ];
+    }
+
+    CuAssertTrue( tc, waits == stats.contended );
+
+    /* the readers and the writers of a rwlock */
+    rwlock = RWLock_new();
+    CuAssertPtrNotNull( tc, rwlock );
+    CuAssertTrue( tc, RWLock_init( rwlock, RWLOCK_PRIVATE ));
+    RWLock_enableProfiling( rwlock, "test rwlock" );
+
+    CuAssertIntEquals( tc, 0, RWLock_readLock( rwlock ));
+    CuAssertIntEquals( tc, 0, RWLock_tryReadLock( rwlock ));
+    CuAssertIntEquals( tc, EBUSY, RWLock_tryWriteLock( rwlock ));
+    CuAssertIntEquals( tc, 0, RWLock_unlock( rwlock ));
+    CuAssertIntEquals( tc, 0, RWLock_unlock( rwlock ));
+    CuAssertIntEquals( tc, 0, RWLock_writeLock( rwlock ));
+    CuAssertIntEquals( tc, 0, RWLock_unlock( rwlock ));
+
+    RWLock_getStats( rwlock, &stats );
+    CuAssertTrue( tc, stats.acquired == 3 );
+    CuAssertTrue( tc, stats.contended == 0 );
+    CuAssertTrue( tc, stats.failedTries == 1 );
+
+    /* both show up in the dump until they are cleared */
+    stream = tmpfile();
+    CuAssertPtrNotNull( tc, stream );
+
+    LockProfile_dump( stream );
+    rewind( stream );
+    length = fread( buffer, 1, sizeof( buffer ) - 1, stream );
+    buffer[ length ] = '\0';
+    fclose( stream );
+
+    CuAssertTrue( tc, Any_strstr( buffer, "Mutex 'test mutex'" ) != NULL );
+    CuAssertTrue( tc, Any_strstr( buffer, "RWLock 'test rwlock': 3 acquired" ) != NULL );
+
+    LockProfile_resetAll();
+    RWLock_getStats( rwlock, &stats );
+    CuAssertTrue( tc, stats.acquired == 0 );
+
+    RWLock_clear( rwlock );
+    RWLock_delete( rwlock );
+
+    Mutex_clear( data.mutex );
+    Mutex_delete( data.mutex );
+
+    stream = tmpfile();
+    CuAssertPtrNotNull( tc, stream );
+
+    LockProfile_dump( stream );
+    rewind( stream );
+    length = fread( buffer, 1, sizeof( buffer ) - 1, stream );
+    buffer[ length ] = '\0';
+    fclose( stream );
+
+    CuAssertTrue( tc, Any_strstr( buffer, "test mutex" ) == NULL );
+    CuAssertTrue( tc, Any_strstr( buffer, "test rwlock" ) == NULL );
+}
+
+
 /*---------------------------------------------------------------------------*/
 /* Setting thread priority                                                   */
 /*---------------------------------------------------------------------------*/
@@ -239,6 +385,96 @@ void Test_setPriority( CuTest *tc )
 }
 
 
+/*---------------------------------------------------------------------------*/
+/* Affinity and naming                                                       */
+/*---------------------------------------------------------------------------*/
+
+
+struct AffinityResult
+{
+    int cpu;
+    char name[THREADS_NAME_MAXLEN];
+};
+
+
+static void *Affinity_threadFn( void *arg )
+{
+    struct AffinityResult *result = (struct AffinityResult *)arg;
+
+    result->cpu = Threads_getCurrentCpu();
+    pthread_getname_np( pthread_self(), result->name, sizeof( result->name ) );
+
+    return NULL;
+}
+
+
+void Test_Affinity( CuTest *tc )
+{
+    ThreadsCpuSet available;
+    ThreadsCpuSet cpus;
+    struct AffinityResult result;
+    Threads *t;
+    int cpu;
+    int node;
+
+    /* the set itself */
+    ThreadsCpuSet_zero( &cpus );
+    CuAssertIntEquals( tc, 0, ThreadsCpuSet_count( &cpus ) );
+
+    ThreadsCpuSet_add( &cpus, 3 );
+    ThreadsCpuSet_add( &cpus, 70 );
+    ThreadsCpuSet_add( &cpus, 71 );
+    ThreadsCpuSet_remove( &cpus, 71 );
+
+    CuAssertIntEquals( tc, 2, ThreadsCpuSet_count( &cpus ) );
+    CuAssertTrue( tc, ThreadsCpuSet_contains( &cpus, 70 ) );
+    CuAssertTrue( tc, !ThreadsCpuSet_contains( &cpus, 71 ) );
+    CuAssertIntEquals( tc, 3, ThreadsCpuSet_getNth( &cpus, 0 ) );
+    CuAssertIntEquals( tc, 70, ThreadsCpuSet_getNth( &cpus, 1 ) );
+    CuAssertIntEquals( tc, -1, ThreadsCpuSet_getNth( &cpus, 2 ) );
+
+    /* the topology */
+    CuAssertTrue( tc, Threads_getAvailableCpus( &available ) );
+    CuAssertTrue( tc, ThreadsCpuSet_count( &available ) > 0 );
+
+    CuAssertTrue( tc, Threads_getNumNumaNodes() >= 1 );
+    CuAssertTrue( tc, !Threads_getNumaNodeCpus( Threads_getNumNumaNodes(), &cpus ) );
+
+    cpu = 0;
+
+    for( node = 0; node < Threads_getNumNumaNodes(); node++ )
+    {
+        CuAssertTrue( tc, Threads_getNumaNodeCpus( node, &cpus ) );
+        cpu += ThreadsCpuSet_count( &cpus );
+    }
+
+    CuAssertTrue( tc, cpu >= ThreadsCpuSet_count( &available ) );
+
+    /* a thread pinned to the last available CPU */
+    cpu = ThreadsCpuSet_getNth( &available, ThreadsCpuSet_count( &available ) - 1 );
+
+    ThreadsCpuSet_zero( &cpus );
+    ThreadsCpuSet_add( &cpus, cpu );
+
+    t = Threads_new();
+    CuAssertPtrNotNull( tc, t );
+    Threads_init( t, true );
+
+    CuAssertIntEquals( tc, 0, Threads_setAffinity( t, &cpus ) );
+    CuAssertIntEquals( tc, 0, Threads_setStackSize( t, 256 * 1024 ) );
+    CuAssertIntEquals( tc, 0, Threads_setName( t, "TestAffinity-with-a-long-name" ) );
+
+    CuAssertIntEquals( tc, 0, Threads_start( t, Affinity_threadFn, &result ) );
+    CuAssertIntEquals( tc, 0, Threads_join( t, NULL ) );
+
+    CuAssertIntEquals( tc, cpu, result.cpu );
+    CuAssertStrEquals( tc, "TestAffinity-wi", result.name );
+
+    Threads_clear( t );
+    Threads_delete( t );
+}
+
+
 /*---------------------------------------------------------------------------*/
 /* Main program                                                              */
 /*---------------------------------------------------------------------------*/
@@ -268,7 +504,9 @@ int main( void )
     SUITE_ADD_TEST( suite, Test_Condition );
     SUITE_ADD_TEST( suite, Test_MThreadKey );
     SUITE_ADD_TEST( suite, Test_RWLock );
+    SUITE_ADD_TEST( suite, Test_LockProfile );
     SUITE_ADD_TEST( suite, Test_setPriority );
+    SUITE_ADD_TEST( suite, Test_Affinity );
 
     CuSuiteRun( suite );
     CuSuiteSummary( suite, output );
@@ -168,7 +168,7 @@ void WorkQueue_OneTaskWithCallback_callback( WorkQueueTaskStatus status, WorkQue
     Cond_signal( data->cond );
 
     istatus = Mutex_unlock( data->mutex );
-    ANY_REQUIRE( istatus );
+    ANY_REQUIRE( istatus == 0 );
 }
 
 WorkQueueTaskStatus WorkQueue_OneTaskWithCallback_taskFn( void *instance, void *userData )
@@ -297,6 +297,632 @@ void Test_WorkQueue_SomeTasks( CuTest *tc )
     ANY_LOG( 0, "WaitOneTask End", ANY_LOG_INFO );
 }
 
+struct WorkStealingData {
+    WorkQueue *queue;
+    WorkQueueTask **children;
+    int nChildren;
+    AnyAtomic executed;
+};
+
+WorkQueueTaskStatus WorkStealing_childFn( void *instance, void *userData )
+{
+    struct WorkStealingData *data = (struct WorkStealingData *)instance;
+
+    Atomic_inc( &data->executed );
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+WorkQueueTaskStatus WorkStealing_spawnFn( void *instance, void *userData )
+{
+    struct WorkStealingData *data = (struct WorkStealingData *)instance;
+    int i;
+
+    /* enqueued from a worker, so they go to its own deque */
+    for ( i = 0; i < data->nChildren; i++ )
+    {
+        WorkQueue_enqueue( data->queue, data->children[ i ] );
+    }
+
+    Atomic_inc( &data->executed );
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+void Test_WorkQueue_WorkStealing( CuTest *tc )
+{
+    struct WorkStealingData data;
+    WorkQueueTask *spawner;
+    WorkQueue *queue;
+    int nChildren = 1000;
+    int i;
+
+    queue = WorkQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+
+    CuAssertTrue( tc, WorkQueue_initScheduler( queue, 0, 4, WORKQUEUE_SCHEDULER_WORKSTEALING ) );
+
+    data.queue = queue;
+    data.nChildren = nChildren;
+    data.executed = 0;
+    data.children = ANY_NTALLOC( nChildren, WorkQueueTask* );
+    ANY_REQUIRE( data.children );
+
+    for ( i = 0; i < nChildren; i++ )
+    {
+        data.children[ i ] = WorkQueue_getTask( queue );
+        CuAssertPtrNotNull( tc, data.children[ i ] );
+        CuAssertTrue( tc, WorkQueueTask_init( data.children[ i ], WorkStealing_childFn, &data,
+                                              NULL, NULL ));
+    }
+
+    spawner = WorkQueue_getTask( queue );
+    CuAssertPtrNotNull( tc, spawner );
+    CuAssertTrue( tc, WorkQueueTask_init( spawner, WorkStealing_spawnFn, &data, NULL, NULL ));
+
+    WorkQueue_enqueue( queue, spawner );
+
+    WorkQueueTask_wait( spawner );
+
+    for ( i = 0; i < nChildren; i++ )
+    {
+        WorkQueueTask_wait( data.children[ i ] );
+    }
+
+    CuAssertIntEquals( tc, nChildren + 1, Atomic_get( &data.executed ) );
+
+    WorkQueue_disposeTask( queue, spawner );
+
+    for ( i = 0; i < nChildren; i++ )
+    {
+        WorkQueue_disposeTask( queue, data.children[ i ] );
+    }
+
+    WorkQueue_clear( queue );
+    WorkQueue_delete( queue );
+
+    ANY_FREE( data.children );
+}
+
+void Test_WorkQueue_EnqueueMany( CuTest *tc )
+{
+    long long i;
+    int nTasks = 20;
+    bool taskExecuted[20];
+    WorkQueueTask *tasks[20];
+    WorkQueue *queue;
+
+    queue = WorkQueue_new();
+    CuAssertPtrNotNull( tc, queue );
+
+    CuAssertTrue( tc, WorkQueue_init( queue, 0, 4 ) );
+
+    for ( i = 0; i < nTasks; i++ )
+    {
+        taskExecuted[ i ] = false;
+        tasks[ i ] = WorkQueue_getTask( queue );
+        CuAssertPtrNotNull( tc, tasks[ i ] );
+        CuAssertTrue( tc, WorkQueueTask_init( tasks[ i ], SomeTasks_TaskFn, taskExecuted,
+                                              (void *)i, NULL ));
+    }
+
+    WorkQueue_enqueueMany( queue, tasks, nTasks );
+
+    for ( i = 0; i < nTasks; i++ )
+    {
+        WorkQueueTask_wait( tasks[ i ] );
+        CuAssertTrue( tc, taskExecuted[ i ] );
+    }
+
+    for ( i = 0; i < nTasks; i++ )
+    {
+        WorkQueue_disposeTask( queue, tasks[ i ] );
+    }
+
+    WorkQueue_clear( queue );
+    WorkQueue_delete( queue );
+}
+
+struct ParallelForData {
+    WorkQueue *queue;
+    long *values;
+    AnyAtomic calls;
+};
+
+void ParallelFor_rangeFn( long begin, long end, void *context )
+{
+    struct ParallelForData *data = (struct ParallelForData *)context;
+    long i;
+
+    for ( i = begin; i < end; i++ )
+    {
+        data->values[ i ] += i;
+    }
+
+    Atomic_inc( &data->calls );
+}
+
+void ParallelFor_nestedFn( long begin, long end, void *context )
+{
+    struct ParallelForData *data = (struct ParallelForData *)context;
+
+    /* from inside a worker, every worker possibly busy in this loop */
+    WorkQueue_parallelFor( data->queue, begin * 100, end * 100, 10, ParallelFor_rangeFn, data );
+}
+
+void Test_WorkQueue_ParallelFor( CuTest *tc )
+{
+    struct ParallelForData data;
+    WorkQueueScheduler schedulers[2] = { WORKQUEUE_SCHEDULER_SHARED,
+                                         WORKQUEUE_SCHEDULER_WORKSTEALING };
+    WorkQueue *queue;
+    long nValues = 10000;
+    long i;
+    int s;
+
+    data.values = ANY_NTALLOC( nValues, long );
+    ANY_REQUIRE( data.values );
+
+    for ( s = 0; s < 2; s++ )
+    {
+        queue = WorkQueue_new();
+        CuAssertPtrNotNull( tc, queue );
+        CuAssertTrue( tc, WorkQueue_initScheduler( queue, 4, 4, schedulers[ s ] ) );
+
+        data.queue = queue;
+
+        /* explicit grain: one call per chunk, the last one shorter */
+        Any_memset( data.values, 0, nValues * sizeof( long ) );
+        data.calls = 0;
+
+        WorkQueue_parallelFor( queue, 0, nValues, 64, ParallelFor_rangeFn, &data );
+
+        CuAssertIntEquals( tc, ( nValues + 63 ) / 64, data.calls );
+
+        for ( i = 0; i < nValues; i++ )
+        {
+            CuAssertIntEquals( tc, i, data.values[ i ] );
+        }
+
+        /* chosen grain, and an empty range */
+        WorkQueue_parallelFor( queue, 0, nValues, 0, ParallelFor_rangeFn, &data );
+        WorkQueue_parallelFor( queue, 5, 5, 0, ParallelFor_rangeFn, &data );
+
+        for ( i = 0; i < nValues; i++ )
+        {
+            CuAssertIntEquals( tc, 2 * i, data.values[ i ] );
+        }
+
+        /* nested in the tasks of another one */
+        Any_memset( data.values, 0, nValues * sizeof( long ) );
+
+        WorkQueue_parallelFor( queue, 0, nValues / 100, 1, ParallelFor_nestedFn, &data );
+
+        for ( i = 0; i < nValues; i++ )
+        {
+            CuAssertIntEquals( tc, i, data.values[ i ] );
+        }
+
+        WorkQueue_clear( queue );
+        WorkQueue_delete( queue );
+    }
+
+    ANY_FREE( data.values );
+}
+
+struct DependenciesData {
+    AnyAtomic clock;
+    long stamps[64];
+};
+
+WorkQueueTaskStatus Dependencies_taskFn( void *instance, void *userData )
+{
+    struct DependenciesData *data = (struct DependenciesData *)instance;
+    long long index = (long long)userData;
+
+    data->stamps[ index ] = Atomic_inc( &data->clock );
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+void Test_WorkQueue_Dependencies( CuTest *tc )
+{
+    struct DependenciesData data;
+    WorkQueueScheduler schedulers[2] = { WORKQUEUE_SCHEDULER_SHARED,
+                                         WORKQUEUE_SCHEDULER_WORKSTEALING };
+    WorkQueueTask *tasks[64];
+    WorkQueue *queue;
+    /* a diamond (0 -> 1..8 -> 9) followed by a chain (10..63) */
+    int nMiddle = 8;
+    int sink = 9;
+    int nTasks = 64;
+    long long i;
+    int s;
+
+    for ( s = 0; s < 2; s++ )
+    {
+        queue = WorkQueue_new();
+        CuAssertPtrNotNull( tc, queue );
+
+        /* few workers: waiting in the tasks instead would stall the pool */
+        CuAssertTrue( tc, WorkQueue_initScheduler( queue, 2, 2, schedulers[ s ] ) );
+
+        data.clock = 0;
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            data.stamps[ i ] = 0;
+            tasks[ i ] = WorkQueue_getTask( queue );
+            CuAssertPtrNotNull( tc, tasks[ i ] );
+            CuAssertTrue( tc, WorkQueueTask_init( tasks[ i ], Dependencies_taskFn, &data,
+                                                  (void *)i, NULL ));
+        }
+
+        for ( i = 1; i <= nMiddle; i++ )
+        {
+            CuAssertTrue( tc, WorkQueueTask_addDependency( tasks[ i ], tasks[ 0 ] ) );
+            CuAssertTrue( tc, WorkQueueTask_addDependency( tasks[ sink ], tasks[ i ] ) );
+        }
+
+        for ( i = sink + 1; i < nTasks; i++ )
+        {
+            CuAssertTrue( tc, WorkQueueTask_addDependency( tasks[ i ], tasks[ i - 1 ] ) );
+        }
+
+        /* the successors first, they must wait anyway */
+        for ( i = nTasks - 1; i > sink; i-- )
+        {
+            WorkQueue_enqueue( queue, tasks[ i ] );
+        }
+
+        WorkQueue_enqueueMany( queue, tasks, sink + 1 );
+
+        WorkQueueTask_wait( tasks[ nTasks - 1 ] );
+
+        for ( i = 1; i <= nMiddle; i++ )
+        {
+            CuAssertTrue( tc, data.stamps[ 0 ] < data.stamps[ i ] );
+            CuAssertTrue( tc, data.stamps[ i ] < data.stamps[ sink ] );
+        }
+
+        for ( i = sink + 1; i < nTasks; i++ )
+        {
+            CuAssertTrue( tc, data.stamps[ i - 1 ] < data.stamps[ i ] );
+        }
+
+        CuAssertIntEquals( tc, nTasks, data.clock );
+
+        /* a predecessor already done does not hold its successor back */
+        for ( i = 0; i < nTasks; i++ )
+        {
+            WorkQueueTask_wait( tasks[ i ] );
+            WorkQueue_disposeTask( queue, tasks[ i ] );
+        }
+
+        tasks[ 0 ] = WorkQueue_getTask( queue );
+        tasks[ 1 ] = WorkQueue_getTask( queue );
+        CuAssertTrue( tc, WorkQueueTask_init( tasks[ 0 ], Dependencies_taskFn, &data,
+                                              (void *)0, NULL ));
+        CuAssertTrue( tc, WorkQueueTask_init( tasks[ 1 ], Dependencies_taskFn, &data,
+                                              (void *)1, NULL ));
+
+        WorkQueue_enqueue( queue, tasks[ 0 ] );
+        WorkQueueTask_wait( tasks[ 0 ] );
+
+        CuAssertTrue( tc, WorkQueueTask_addDependency( tasks[ 1 ], tasks[ 0 ] ) );
+        WorkQueue_enqueue( queue, tasks[ 1 ] );
+        WorkQueueTask_wait( tasks[ 1 ] );
+
+        CuAssertTrue( tc, data.stamps[ 0 ] < data.stamps[ 1 ] );
+
+        WorkQueue_disposeTask( queue, tasks[ 0 ] );
+        WorkQueue_disposeTask( queue, tasks[ 1 ] );
+
+        WorkQueue_clear( queue );
+        WorkQueue_delete( queue );
+    }
+}
+
+struct PrioritiesGate {
+    AnyAtomic started;
+    AnyAtomic open;
+};
+
+WorkQueueTaskStatus Priorities_gateFn( void *instance, void *userData )
+{
+    struct PrioritiesGate *gate = (struct PrioritiesGate *)instance;
+
+    Atomic_set( &gate->started, true );
+
+    while( !Atomic_get( &gate->open ) )
+    {
+        Any_sleepMilliSeconds( 1 );
+    }
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+void Test_WorkQueue_Priorities( CuTest *tc )
+{
+    struct DependenciesData data;
+    struct PrioritiesGate gate;
+    WorkQueueScheduler schedulers[2] = { WORKQUEUE_SCHEDULER_SHARED,
+                                         WORKQUEUE_SCHEDULER_WORKSTEALING };
+    WorkQueueTask *tasks[32];
+    WorkQueueTask *gateTask;
+    WorkQueueStats stats;
+    WorkQueue *queue;
+    int nTasks;
+    long long i;
+    int s;
+
+    for ( s = 0; s < 2; s++ )
+    {
+        queue = WorkQueue_new();
+        CuAssertPtrNotNull( tc, queue );
+
+        /* a single worker, kept busy while the others are enqueued */
+        CuAssertTrue( tc, WorkQueue_initScheduler( queue, 1, 1, schedulers[ s ] ) );
+
+        /* two tasks per priority, enqueued from the lowest to the highest */
+        nTasks = 2 * WORKQUEUE_NUM_PRIORITIES;
+        data.clock = 0;
+        gate.started = false;
+        gate.open = false;
+
+        gateTask = WorkQueue_getTask( queue );
+        CuAssertTrue( tc, WorkQueueTask_init( gateTask, Priorities_gateFn, &gate, NULL, NULL ));
+        WorkQueue_enqueue( queue, gateTask );
+
+        while ( !Atomic_get( &gate.started ) )
+        {
+            Any_sleepMilliSeconds( 1 );
+        }
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            tasks[ i ] = WorkQueue_getTask( queue );
+            CuAssertTrue( tc, WorkQueueTask_init( tasks[ i ], Dependencies_taskFn, &data,
+                                                  (void *)i, NULL ));
+            WorkQueueTask_setPriority( tasks[ i ], (WorkQueuePriority)
+                                       ( WORKQUEUE_NUM_PRIORITIES - 1 - i / 2 ) );
+            WorkQueue_enqueue( queue, tasks[ i ] );
+        }
+
+        WorkQueue_getStats( queue, WORKQUEUE_PRIORITY_LOW, &stats );
+        CuAssertIntEquals( tc, 2, stats.queued );
+        CuAssertIntEquals( tc, 0, stats.started );
+
+        Atomic_set( &gate.open, true );
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            WorkQueueTask_wait( tasks[ i ] );
+        }
+
+        /* each pair before the pair of the next lower priority, enqueued earlier */
+        for ( i = 2; i < nTasks; i++ )
+        {
+            CuAssertTrue( tc, data.stamps[ i ] < data.stamps[ ( i / 2 ) * 2 - 1 ] );
+            CuAssertTrue( tc, data.stamps[ i ] < data.stamps[ ( i / 2 ) * 2 - 2 ] );
+        }
+
+        WorkQueue_getStats( queue, WORKQUEUE_PRIORITY_LOW, &stats );
+        CuAssertIntEquals( tc, 0, stats.queued );
+        CuAssertIntEquals( tc, 2, stats.maxQueued );
+        CuAssertIntEquals( tc, 2, stats.enqueued );
+        CuAssertIntEquals( tc, 2, stats.started );
+        CuAssertTrue( tc, stats.maxWaitTime > 0 );
+        CuAssertTrue( tc, stats.totalWaitTime >= stats.maxWaitTime );
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            WorkQueue_disposeTask( queue, tasks[ i ] );
+        }
+
+        /* a background task is not starved by a stream of realtime ones */
+        nTasks = 32;
+        data.clock = 0;
+        gate.open = false;
+        gate.started = false;
+
+        WorkQueue_disposeTask( queue, gateTask );
+        gateTask = WorkQueue_getTask( queue );
+        CuAssertTrue( tc, WorkQueueTask_init( gateTask, Priorities_gateFn, &gate, NULL, NULL ));
+        WorkQueue_enqueue( queue, gateTask );
+
+        while ( !Atomic_get( &gate.started ) )
+        {
+            Any_sleepMilliSeconds( 1 );
+        }
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            tasks[ i ] = WorkQueue_getTask( queue );
+            CuAssertTrue( tc, WorkQueueTask_init( tasks[ i ], Dependencies_taskFn, &data,
+                                                  (void *)i, NULL ));
+            WorkQueueTask_setPriority( tasks[ i ], i == 0 ? WORKQUEUE_PRIORITY_BACKGROUND :
+                                                   WORKQUEUE_PRIORITY_REALTIME );
+            WorkQueue_enqueue( queue, tasks[ i ] );
+        }
+
+        Atomic_set( &gate.open, true );
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            WorkQueueTask_wait( tasks[ i ] );
+        }
+
+        CuAssertTrue( tc, data.stamps[ 0 ] > 1 );
+        CuAssertTrue( tc, data.stamps[ 0 ] < nTasks / 2 );
+
+        for ( i = 0; i < nTasks; i++ )
+        {
+            WorkQueue_disposeTask( queue, tasks[ i ] );
+        }
+
+        WorkQueue_disposeTask( queue, gateTask );
+
+        WorkQueue_clear( queue );
+        WorkQueue_delete( queue );
+    }
+}
+
+struct PinningData {
+    ThreadsCpuSet cpus;
+    char name[THREADS_NAME_MAXLEN];
+};
+
+WorkQueueTaskStatus Pinning_taskFn( void *instance, void *userData )
+{
+    struct PinningData *data = (struct PinningData *)instance;
+    cpu_set_t cpuSet;
+    int i;
+
+    pthread_getname_np( pthread_self(), data->name, sizeof( data->name ) );
+
+    ThreadsCpuSet_zero( &data->cpus );
+    pthread_getaffinity_np( pthread_self(), sizeof( cpu_set_t ), &cpuSet );
+
+    for ( i = 0; i < CPU_SETSIZE; i++ )
+    {
+        if ( CPU_ISSET( i, &cpuSet ) )
+        {
+            ThreadsCpuSet_add( &data->cpus, i );
+        }
+    }
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+void Test_WorkQueue_Pinning( CuTest *tc )
+{
+    WorkQueuePinning pinnings[2] = { WORKQUEUE_PINNING_CPU, WORKQUEUE_PINNING_NUMANODE };
+    WorkQueueScheduler schedulers[2] = { WORKQUEUE_SCHEDULER_SHARED,
+                                         WORKQUEUE_SCHEDULER_WORKSTEALING };
+    struct PinningData data;
+    ThreadsCpuSet available;
+    ThreadsCpuSet node;
+    WorkQueueTask *task;
+    WorkQueue *queue;
+    int p;
+
+    Threads_getAvailableCpus( &available );
+
+    for ( p = 0; p < 2; p++ )
+    {
+        queue = WorkQueue_new();
+        CuAssertPtrNotNull( tc, queue );
+        CuAssertTrue( tc, WorkQueue_initPinned( queue, 1, 1, schedulers[ p ], pinnings[ p ],
+                                                "wqtest" ) );
+
+        task = WorkQueue_getTask( queue );
+        CuAssertTrue( tc, WorkQueueTask_init( task, Pinning_taskFn, &data, NULL, NULL ));
+        WorkQueue_enqueue( queue, task );
+        WorkQueueTask_wait( task );
+
+        CuAssertStrEquals( tc, "wqtest/0", data.name );
+
+        if ( pinnings[ p ] == WORKQUEUE_PINNING_CPU )
+        {
+            /* the first worker on the first CPU */
+            CuAssertIntEquals( tc, 1, ThreadsCpuSet_count( &data.cpus ) );
+            CuAssertIntEquals( tc, ThreadsCpuSet_getNth( &available, 0 ),
+                               ThreadsCpuSet_getNth( &data.cpus, 0 ) );
+        }
+        else
+        {
+            /* on the first node */
+            Threads_getNumaNodeCpus( 0, &node );
+            ThreadsCpuSet_intersect( &node, &available );
+            CuAssertIntEquals( tc, ThreadsCpuSet_count( &node ), ThreadsCpuSet_count( &data.cpus ) );
+            ThreadsCpuSet_intersect( &node, &data.cpus );
+            CuAssertIntEquals( tc, ThreadsCpuSet_count( &node ), ThreadsCpuSet_count( &data.cpus ) );
+        }
+
+        WorkQueue_disposeTask( queue, task );
+
+        WorkQueue_clear( queue );
+        WorkQueue_delete( queue );
+    }
+}
+
+WorkQueueTaskStatus Recycling_taskFn( void *instance, void *userData )
+{
+    AnyAtomic *done = (AnyAtomic *)instance;
+
+    Atomic_inc( done );
+
+    return WORKQUEUE_TASK_SUCCESS;
+}
+
+void Test_WorkQueue_TaskRecycling( CuTest *tc )
+{
+    WorkQueueScheduler schedulers[2] = { WORKQUEUE_SCHEDULER_SHARED,
+                                         WORKQUEUE_SCHEDULER_WORKSTEALING };
+    WorkQueueTask *seen[64];
+    WorkQueueTask *tasks[8];
+    WorkQueue *queue;
+    AnyAtomic done;
+    int numSeen;
+    int round;
+    int p;
+    int i;
+    int j;
+
+    for ( p = 0; p < 2; p++ )
+    {
+        queue = WorkQueue_new();
+        CuAssertPtrNotNull( tc, queue );
+        CuAssertTrue( tc, WorkQueue_initScheduler( queue, 2, 2, schedulers[ p ] ) );
+
+        numSeen = 0;
+
+        for ( round = 0; round < 500; round++ )
+        {
+            done = 0;
+
+            for ( i = 0; i < 8; i++ )
+            {
+                tasks[ i ] = WorkQueue_getTask( queue );
+                CuAssertTrue( tc, WorkQueueTask_init( tasks[ i ], Recycling_taskFn, &done,
+                                                      NULL, NULL ));
+
+                for ( j = 0; j < numSeen && seen[ j ] != tasks[ i ]; j++ )
+                {
+                }
+
+                if ( j == numSeen )
+                {
+                    /* a few more than in flight, the tasks must be reused */
+                    CuAssertTrue( tc, numSeen < 24 );
+                    seen[ numSeen++ ] = tasks[ i ];
+                }
+            }
+
+            WorkQueue_enqueueMany( queue, tasks, 8 );
+
+            /* half disposed while maybe still running, recycled once done */
+            for ( i = 0; i < 4; i++ )
+            {
+                WorkQueue_disposeTask( queue, tasks[ i ] );
+            }
+
+            for ( i = 4; i < 8; i++ )
+            {
+                WorkQueueTask_wait( tasks[ i ] );
+                WorkQueue_disposeTask( queue, tasks[ i ] );
+            }
+
+            while ( Atomic_get( &done ) < 8 )
+            {
+                Threads_yield();
+            }
+        }
+
+        WorkQueue_clear( queue );
+        WorkQueue_delete( queue );
+    }
+}
+
 void dump( void *arg )
 {
     Traps_callTrace();
@@ -330,6 +956,13 @@ int main( void )
     SUITE_ADD_TEST( suite, Test_WorkQueue_OneTaskWithCallback_01 );
     SUITE_ADD_TEST( suite, Test_WorkQueue_SomeTasks );
     SUITE_ADD_TEST( suite, Test_WorkQueue_NewInitClearDelete_01 );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_WorkStealing );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_EnqueueMany );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_ParallelFor );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_Dependencies );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_Priorities );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_Pinning );
+    SUITE_ADD_TEST( suite, Test_WorkQueue_TaskRecycling );
 
     CuSuiteRun( suite );
     CuSuiteSummary( suite, output );